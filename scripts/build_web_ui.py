@@ -0,0 +1,135 @@
+"""Minifikuje a gzipuje webové UI (web/) do hlavičky s PROGMEM poli.
+
+app.js se jen gzipuje: zdroj je psaný kompaktně a bezpečná minifikace JS
+(ASI, regex literály, šablony) potřebuje skutečný parser, který build nemá.
+
+Spouští se automaticky před buildem (extra_scripts v platformio.ini), nebo ručně:
+    python scripts/build_web_ui.py [výstupní adresář]
+
+index.html se servíruje s "Cache-Control: no-cache" a revaliduje přes ETag (304),
+app.css/app.js mají v URL verzi podle obsahu, takže je prohlížeč může cachovat natrvalo.
+"""
+
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+ASSETS = [
+    # (URL, soubor, content-type, immutable)
+    ("/app.css", "app.css", "text/css; charset=utf-8", True),
+    ("/app.js", "app.js", "application/javascript; charset=utf-8", True),
+    ("/", "index.html", "text/html; charset=utf-8", False),
+]
+
+
+def minify_css(text):
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"\s+", " ", text)
+    text = re.sub(r"\s*([{}:;,>])\s*", r"\1", text)
+    return text.replace(";}", "}").strip()
+
+
+def minify_html(text):
+    text = re.sub(r"<!--.*?-->", "", text, flags=re.S)
+    text = re.sub(r">\s+<", "><", text)
+    return "\n".join(line.strip() for line in text.splitlines() if line.strip())
+
+
+def gzip_bytes(data):
+    # mtime=0 -> deterministický výstup, ETag se mění jen se změnou obsahu
+    return gzip.compress(data, compresslevel=9, mtime=0)
+
+
+def c_array(name, data):
+    rows = []
+    for i in range(0, len(data), 20):
+        rows.append("  " + ", ".join("0x%02x" % b for b in data[i:i + 20]) + ",")
+    return "static const uint8_t %s[] PROGMEM = {\n%s\n};\n" % (name, "\n".join(rows))
+
+
+def write_if_changed(path, text):
+    # Přepsat jen při změně, ať se main.cpp zbytečně nepřekládá
+    if os.path.exists(path):
+        with open(path) as f:
+            if f.read() == text:
+                return
+    with open(path, "w") as f:
+        f.write(text)
+
+
+def build(project_dir, out_dir):
+    web_dir = os.path.join(project_dir, "web")
+    minifiers = {".css": minify_css, ".html": minify_html}
+    versions = {}
+    entries = []
+    total_raw = 0
+    total_gz = 0
+
+    for url, filename, content_type, immutable in ASSETS:
+        with open(os.path.join(web_dir, filename), encoding="utf-8") as f:
+            source = f.read()
+        if filename == "index.html":
+            for asset_url, version in versions.items():
+                source = source.replace('"%s"' % asset_url, '"%s?v=%s"' % (asset_url, version))
+
+        raw = source.encode("utf-8")
+        minify = minifiers.get(os.path.splitext(filename)[1])
+        minified = (minify(source) if minify else source).encode("utf-8")
+        packed = gzip_bytes(minified)
+        digest = hashlib.sha1(packed).hexdigest()[:16]
+        versions[url] = digest[:8]
+
+        symbol = "WEB_" + re.sub(r"[^A-Z0-9]", "_", filename.upper()) + "_GZ"
+        entries.append((url, content_type, '\\"%s\\"' % digest, symbol, len(packed), immutable))
+        total_raw += len(raw)
+        total_gz += len(packed)
+        print("WEB UI: %-10s %6d B -> min %6d B -> gzip %6d B" % (filename, len(raw), len(minified), len(packed)))
+
+        write_if_changed(os.path.join(out_dir, symbol + ".inc"), c_array(symbol, packed))
+
+    print("WEB UI: celkem %d B -> %d B (%.1f %%)" % (total_raw, total_gz, 100.0 * total_gz / total_raw))
+
+    lines = [
+        "// Vygenerováno scripts/build_web_ui.py z web/ - neupravovat ručně",
+        "#pragma once",
+        "",
+        "#include <Arduino.h>",
+        "",
+        "struct WebAsset {",
+        "  const char* path;",
+        "  const char* contentType;",
+        "  const char* etag;",
+        "  const uint8_t* data;  // gzip",
+        "  size_t length;",
+        "  bool immutable;       // verze v URL -> dlouhodobá cache",
+        "};",
+        "",
+    ]
+    for entry in entries:
+        lines.append('#include "%s.inc"' % entry[3])
+    lines.append("")
+    lines.append("static const WebAsset WEB_ASSETS[] = {")
+    for url, content_type, etag, symbol, length, immutable in entries:
+        lines.append('  {"%s", "%s", "%s", %s, %d, %s},' % (
+            url, content_type, etag, symbol, length, "true" if immutable else "false"))
+    lines.append("};")
+    lines.append("")
+    lines.append("static const size_t WEB_ASSET_COUNT = sizeof(WEB_ASSETS) / sizeof(WEB_ASSETS[0]);")
+
+    write_if_changed(os.path.join(out_dir, "WebUiAssets.h"), "\n".join(lines) + "\n")
+
+
+if __name__ == "__main__":
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    out = sys.argv[1] if len(sys.argv) > 1 else os.path.join(root, ".pio", "web_ui")
+    os.makedirs(out, exist_ok=True)
+    build(root, out)
+else:
+    Import("env")  # noqa: F821 - poskytuje PlatformIO/SCons
+
+    out = os.path.join(env.subst("$PROJECT_BUILD_DIR"), env.subst("$PIOENV"), "web_ui")  # noqa: F821
+    os.makedirs(out, exist_ok=True)
+    build(env.subst("$PROJECT_DIR"), out)  # noqa: F821
+    env.Append(CPPPATH=[out])  # noqa: F821
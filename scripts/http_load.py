@@ -0,0 +1,122 @@
+"""Zátěžový test web serveru panelu (HttpServer nad esp_http_server).
+
+Několik klientů současně dotazuje API (každý přes vlastní keep-alive spojení)
+a skript na konci vypíše latence po routách a rozdíl čítačů http.server
+z /api/metrics: počet požadavků, průměrnou a nejdelší dobu handleru a
+nejdelší čekání na zámek stavu, který drží loop(). Volitelně během testu
+spouští ruční odeslání na TMEP, ať je vidět, že neblokuje ostatní dotazy.
+Bez závislostí mimo standardní knihovnu:
+    python scripts/http_load.py --host 192.168.1.50 --clients 3 --seconds 30 --tmep-every 5
+
+Čítače handlerMaxUs a lockWaitMaxUs jsou maxima od startu zařízení, pro
+čisté číslo je vhodné panel před měřením restartovat.
+"""
+
+import argparse
+import http.client
+import json
+import threading
+import time
+
+ROUTES = ["/api/data", "/api/config", "/api/metrics", "/"]
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100.0))]
+
+
+def metrics(host, port):
+    conn = http.client.HTTPConnection(host, port, timeout=10)
+    conn.request("GET", "/api/metrics")
+    data = json.loads(conn.getresponse().read())
+    conn.close()
+    return data["http"]["server"]
+
+
+def client(host, port, deadline, results, lock, errors):
+    conn = http.client.HTTPConnection(host, port, timeout=10)
+    i = 0
+    while time.monotonic() < deadline:
+        route = ROUTES[i % len(ROUTES)]
+        i += 1
+        start = time.monotonic()
+        try:
+            conn.request("GET", route, headers={"Accept-Encoding": "gzip"})
+            resp = conn.getresponse()
+            resp.read()
+            ok = resp.status in (200, 304)
+        except (OSError, http.client.HTTPException):
+            conn.close()
+            conn = http.client.HTTPConnection(host, port, timeout=10)
+            ok = False
+        elapsed = (time.monotonic() - start) * 1000.0
+        with lock:
+            if ok:
+                results.setdefault(route, []).append(elapsed)
+            else:
+                errors[route] = errors.get(route, 0) + 1
+    conn.close()
+
+
+def tmep_trigger(host, port, deadline, every, results, lock, errors):
+    while time.monotonic() + every < deadline:
+        time.sleep(every)
+        conn = http.client.HTTPConnection(host, port, timeout=10)
+        start = time.monotonic()
+        try:
+            conn.request("POST", "/api/tmep/send")
+            status = conn.getresponse().status
+        except (OSError, http.client.HTTPException):
+            # Plné sloty serveru: LRU zavře nejdéle nečinné spojení, i to nové
+            with lock:
+                errors["POST /api/tmep/send"] = errors.get("POST /api/tmep/send", 0) + 1
+            continue
+        finally:
+            conn.close()
+        with lock:
+            results.setdefault("POST /api/tmep/send (%d)" % status, []).append((time.monotonic() - start) * 1000.0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--host", required=True)
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--clients", type=int, default=4)
+    parser.add_argument("--seconds", type=float, default=30.0)
+    parser.add_argument("--tmep-every", type=float, default=0.0, help="s mezi ručními odesláními na TMEP (0 = ne)")
+    args = parser.parse_args()
+
+    before = metrics(args.host, args.port)
+    deadline = time.monotonic() + args.seconds
+    results, errors, lock = {}, {}, threading.Lock()
+    threads = [threading.Thread(target=client, args=(args.host, args.port, deadline, results, lock, errors))
+               for _ in range(args.clients)]
+    if args.tmep_every > 0:
+        threads.append(threading.Thread(target=tmep_trigger,
+                                        args=(args.host, args.port, deadline, args.tmep_every, results, lock,
+                                              errors)))
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    after = metrics(args.host, args.port)
+
+    total = sum(len(v) for v in results.values())
+    print("%d klientu, %.0f s, %d odpovedi (%.1f/s), chyb %d" % (
+        args.clients, args.seconds, total, total / args.seconds, sum(errors.values())))
+    for route in sorted(results):
+        values = results[route]
+        print("  %-32s n=%5d  p50 %6.1f ms  p95 %6.1f ms  max %6.1f ms" % (
+            route, len(values), percentile(values, 50), percentile(values, 95), max(values)))
+    for route in sorted(errors):
+        print("  %-32s chyb %d" % (route, errors[route]))
+    print("http.server: pozadavku +%d, odmitnuto +%d, handler avg %d us max %d us, zamek max %d us" % (
+        after["requests"] - before["requests"], after["rejected"] - before["rejected"],
+        after["handlerAvgUs"], after["handlerMaxUs"], after["lockWaitMaxUs"]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,126 @@
+"""Vytvoří deltu firmware pro OTA (formát viz src/DeltaPatch.h).
+
+Delta obsahuje jen to, co se mezi běžícím a novým image změnilo; zbytek
+si zařízení zkopíruje z běžícího oddílu. Platí jen proti přesně tomu image,
+ze kterého vznikla (zařízení kontroluje jeho SHA-256):
+    python scripts/make_delta.py novy.bin --source stary.bin -o firmware.sdlt
+
+Výstup se ověří zpětnou aplikací a vypíše se SHA-256 nového image, který
+je potřeba poslat spolu s URL (POST /api/ota nebo MQTT sharp/ota). Bez
+--source vypíše jen hash image pro aktualizaci celým souborem. S --key
+hash rovnou podepíše (ota_sign.py) a trigger obsahuje i pole "sig".
+"""
+
+import argparse
+import hashlib
+import json
+import struct
+
+from ota_sign import sign_digest
+
+MAGIC = b"SDLT"
+VERSION = 1
+HEADER = struct.Struct("<4sB3xII32s")
+OP_END, OP_COPY, OP_DATA = 0x00, 0x01, 0x02
+BLOCK = 16      # zdroj se indexuje po blocích této délky
+MIN_COPY = 24   # kratší shoda se nevyplatí (COPY stojí 9 B)
+
+
+def diff(source, target):
+    index = {}
+    for j in range(0, len(source) - BLOCK + 1, BLOCK):
+        index.setdefault(source[j:j + BLOCK], j)
+
+    ops = []
+    literal = 0
+    i = 0
+    while i <= len(target) - BLOCK:
+        j = index.get(target[i:i + BLOCK])
+        if j is None:
+            i += 1
+            continue
+        s, d = j, i
+        while s > 0 and d > literal and source[s - 1] == target[d - 1]:
+            s -= 1
+            d -= 1
+        e, k = i + BLOCK, j + BLOCK
+        while e < len(target) and k < len(source) and source[k] == target[e]:
+            e += 1
+            k += 1
+        if e - d < MIN_COPY:
+            i += 1
+            continue
+        if d > literal:
+            ops.append((OP_DATA, target[literal:d]))
+        ops.append((OP_COPY, s, e - d))
+        i = literal = e
+    if literal < len(target):
+        ops.append((OP_DATA, target[literal:]))
+    return ops
+
+
+def encode(source, target, ops):
+    out = bytearray(HEADER.pack(MAGIC, VERSION, len(source), len(target), hashlib.sha256(source).digest()))
+    for op in ops:
+        if op[0] == OP_COPY:
+            out += struct.pack("<BII", OP_COPY, op[1], op[2])
+        else:
+            out += struct.pack("<BI", OP_DATA, len(op[1])) + op[1]
+    out.append(OP_END)
+    return bytes(out)
+
+
+def apply(source, delta):
+    magic, version, source_size, target_size, source_sha = HEADER.unpack_from(delta)
+    assert magic == MAGIC and version == VERSION
+    assert hashlib.sha256(source[:source_size]).digest() == source_sha
+    out = bytearray()
+    pos = HEADER.size
+    while delta[pos] != OP_END:
+        op = delta[pos]
+        if op == OP_COPY:
+            offset, length = struct.unpack_from("<II", delta, pos + 1)
+            out += source[offset:offset + length]
+            pos += 9
+        else:
+            (length,) = struct.unpack_from("<I", delta, pos + 1)
+            out += delta[pos + 5:pos + 5 + length]
+            pos += 5 + length
+    assert len(out) == target_size
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("target", help="nový image (.pio/build/<env>/firmware.bin)")
+    parser.add_argument("--source", help="image, který na zařízení právě běží")
+    parser.add_argument("-o", "--output", help="výstupní delta (s --source)")
+    parser.add_argument("--url", help="URL, ze které si zařízení soubor stáhne (vypíše JSON pro trigger)")
+    parser.add_argument("--key", help="soukromý klíč pro podpis (ota_sign.py keygen)")
+    args = parser.parse_args()
+
+    with open(args.target, "rb") as f:
+        target = f.read()
+    sha = hashlib.sha256(target).hexdigest()
+
+    if args.source and args.output:
+        with open(args.source, "rb") as f:
+            source = f.read()
+        delta = encode(source, target, diff(source, target))
+        if apply(source, delta) != target:
+            raise SystemExit("delta nesouhlasi s cilovym image")
+        with open(args.output, "wb") as f:
+            f.write(delta)
+        print("delta %d B (image %d B, %.1f %%)" % (len(delta), len(target), 100.0 * len(delta) / len(target)))
+
+    print("sha256 %s" % sha)
+    trigger = {"url": args.url, "sha256": sha}
+    if args.key:
+        trigger["sig"] = sign_digest(bytes.fromhex(sha), args.key)
+        print("sig %s" % trigger["sig"])
+    if args.url:
+        print(json.dumps(trigger))
+
+
+if __name__ == "__main__":
+    main()
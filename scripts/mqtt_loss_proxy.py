@@ -0,0 +1,231 @@
+"""TCP proxy mezi panelem a MQTT brokerem se ztrátou paketů (test QoS 1).
+
+Proxy rozebírá proud na rámce MQTT a podle nastavení zahazuje PUBLISH
+směrem k brokeru a PUBACK směrem k panelu, zpožďuje oba směry (emulace
+RTT) a periodicky přeruší spojení. TCP samo ztrátu nezpůsobí, takže
+zahozený rámec odpovídá zprávě, která se ztratila u brokeru nebo při
+výpadku spojení - přesně případ, který musí MqttOutbox (src/MqttOutbox.cpp)
+pokrýt opakováním. Bez závislostí mimo standardní knihovnu:
+    python scripts/mqtt_loss_proxy.py --broker 192.168.0.10 --drop-publish 0.1 --delay 40 --cut-every 60
+
+Na panelu pak jako MQTT server nastavit adresu počítače s proxy (port
+--listen). Průběžně a na konci (Ctrl+C) vypíše počet zpráv, kolik z nich
+broker dostal aspoň jednou (delivered rate), duplicity, opakování (DUP)
+a latenci od prvního odeslání do PUBACK, který dorazil na panel.
+"""
+
+import argparse
+import asyncio
+import random
+import struct
+import time
+
+PUBLISH = 3
+PUBACK = 4
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100.0))]
+
+
+class Stats:
+    def __init__(self):
+        self.messages = {}  # packet id -> stav zprávy QoS 1 (čísla se v okně neopakují)
+        self.originals = 0
+        self.dup_frames = 0
+        self.delivered = 0
+        self.duplicates = 0
+        self.acked = 0
+        self.dropped_publish = 0
+        self.dropped_puback = 0
+        self.qos0 = 0
+        self.cuts = 0
+        self.latencies = []
+
+    def summary(self):
+        rate = self.delivered / self.originals if self.originals else 0.0
+        return ("zprav %d, u brokeru %d (%.1f %%), potvrzeno %d, DUP %d, duplicity %d, "
+                "zahozeno PUBLISH %d / PUBACK %d, preruseni %d, QoS0 %d, "
+                "latence p50 %.0f ms p95 %.0f ms max %.0f ms" % (
+                    self.originals, self.delivered, rate * 100, self.acked, self.dup_frames,
+                    self.duplicates, self.dropped_publish, self.dropped_puback, self.cuts, self.qos0,
+                    percentile(self.latencies, 50), percentile(self.latencies, 95),
+                    max(self.latencies) if self.latencies else 0.0))
+
+
+async def read_frame(reader):
+    """Celý rámec MQTT; None = spojení skončilo."""
+    try:
+        return await read_frame_raw(reader)
+    except (asyncio.IncompleteReadError, ConnectionError):
+        return None
+
+
+async def read_frame_raw(reader):
+    header = (await reader.readexactly(1))[0]
+    length, multiplier = 0, 1
+    raw = bytearray([header])
+    while True:
+        b = (await reader.readexactly(1))[0]
+        raw.append(b)
+        length += (b & 0x7F) * multiplier
+        multiplier *= 128
+        if not b & 0x80:
+            break
+    body = await reader.readexactly(length)
+    return header, body, bytes(raw) + body
+
+
+def publish_packet_id(header, body):
+    if (header >> 1) & 3 == 0:
+        return None
+    topic_length = struct.unpack(">H", body[:2])[0]
+    return struct.unpack(">H", body[2 + topic_length:4 + topic_length])[0]
+
+
+class Pipe:
+    """Jeden směr spojení; konstantní zpoždění zachová pořadí rámců."""
+
+    def __init__(self, writer, delay):
+        self.writer = writer
+        self.delay = delay
+        self.queue = asyncio.Queue()
+        self.task = asyncio.ensure_future(self.run())
+
+    def send(self, data):
+        self.queue.put_nowait((time.monotonic() + self.delay, data))
+
+    async def run(self):
+        while True:
+            due, data = await self.queue.get()
+            wait = due - time.monotonic()
+            if wait > 0:
+                await asyncio.sleep(wait)
+            try:
+                self.writer.write(data)
+                await self.writer.drain()
+            except ConnectionError:
+                return
+
+
+class Session:
+    def __init__(self, args, stats, device_reader, device_writer):
+        self.args = args
+        self.stats = stats
+        self.device_reader = device_reader
+        self.device_writer = device_writer
+
+    async def run(self):
+        try:
+            broker_reader, broker_writer = await asyncio.open_connection(self.args.broker, self.args.broker_port)
+        except OSError as e:
+            print("broker nedostupny: %s" % e)
+            self.device_writer.close()
+            return
+        delay = self.args.delay / 1000.0
+        to_broker = Pipe(broker_writer, delay)
+        to_device = Pipe(self.device_writer, delay)
+        tasks = [asyncio.ensure_future(self.upstream(to_broker)),
+                 asyncio.ensure_future(self.downstream(broker_reader, to_device))]
+        if self.args.cut_every > 0:
+            tasks.append(asyncio.ensure_future(asyncio.sleep(self.args.cut_every)))
+        done, pending = await asyncio.wait(tasks, return_when=asyncio.FIRST_COMPLETED)
+        if self.args.cut_every > 0 and tasks[-1] in done:
+            self.stats.cuts += 1
+            print("preruseni spojeni")
+        for task in list(pending) + [to_broker.task, to_device.task]:
+            task.cancel()
+        broker_writer.close()
+        self.device_writer.close()
+
+    async def upstream(self, to_broker):
+        stats = self.stats
+        while True:
+            frame = await read_frame(self.device_reader)
+            if frame is None:
+                return
+            header, body, raw = frame
+            if header >> 4 == PUBLISH:
+                packet_id = publish_packet_id(header, body)
+                if packet_id is None:
+                    stats.qos0 += 1
+                    to_broker.send(raw)
+                    continue
+                message = stats.messages.get(packet_id)
+                if header & 0x08:
+                    stats.dup_frames += 1
+                if message is None or (not header & 0x08 and message["acked"]):
+                    message = {"sent": time.monotonic(), "delivered": False, "acked": False}
+                    stats.messages[packet_id] = message
+                    stats.originals += 1
+                if random.random() < self.args.drop_publish:
+                    stats.dropped_publish += 1
+                    continue
+                if message["delivered"]:
+                    stats.duplicates += 1
+                else:
+                    message["delivered"] = True
+                    stats.delivered += 1
+            to_broker.send(raw)
+
+    async def downstream(self, broker_reader, to_device):
+        stats = self.stats
+        while True:
+            frame = await read_frame(broker_reader)
+            if frame is None:
+                return
+            header, body, raw = frame
+            if header >> 4 == PUBACK:
+                if random.random() < self.args.drop_puback:
+                    stats.dropped_puback += 1
+                    continue
+                message = stats.messages.get(struct.unpack(">H", body[:2])[0])
+                if message and not message["acked"]:
+                    message["acked"] = True
+                    stats.acked += 1
+                    # PUBACK dorazí na panel po dalším zpoždění
+                    stats.latencies.append((time.monotonic() - message["sent"]) * 1000 + self.args.delay)
+            to_device.send(raw)
+
+
+async def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--listen", type=int, default=1884, help="port pro panel")
+    parser.add_argument("--broker", default="127.0.0.1")
+    parser.add_argument("--broker-port", type=int, default=1883)
+    parser.add_argument("--drop-publish", type=float, default=0.0, help="pravděpodobnost zahození PUBLISH")
+    parser.add_argument("--drop-puback", type=float, default=0.0, help="pravděpodobnost zahození PUBACK")
+    parser.add_argument("--delay", type=float, default=0.0, help="zpoždění každého směru v ms (RTT = 2x)")
+    parser.add_argument("--cut-every", type=float, default=0.0, help="přerušit spojení každých N s")
+    parser.add_argument("--report", type=float, default=10.0, help="průběžný výpis každých N s")
+    parser.add_argument("--duration", type=float, default=0.0, help="skončit po N s (0 = Ctrl+C)")
+    parser.add_argument("--seed", type=int)
+    args = parser.parse_args()
+    if args.seed is not None:
+        random.seed(args.seed)
+
+    stats = Stats()
+
+    async def accept(reader, writer):
+        await Session(args, stats, reader, writer).run()
+
+    server = await asyncio.start_server(accept, "0.0.0.0", args.listen)
+    print("proxy :%d -> %s:%d" % (args.listen, args.broker, args.broker_port))
+    started = time.monotonic()
+    try:
+        while not args.duration or time.monotonic() - started < args.duration:
+            await asyncio.sleep(args.report)
+            print(stats.summary(), flush=True)
+    finally:
+        server.close()
+        print("celkem: " + stats.summary(), flush=True)
+
+
+if __name__ == "__main__":
+    try:
+        asyncio.run(main())
+    except KeyboardInterrupt:
+        pass
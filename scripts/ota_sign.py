@@ -0,0 +1,97 @@
+"""Podpis OTA aktualizací (ECDSA P-256 nad SHA-256 image).
+
+Zařízení spustí aktualizaci jen s podpisem hashe nového image, který sedí
+na veřejný klíč zakompilovaný ve firmware (src/OtaSigningKey.h). Jednou se
+vygeneruje pár klíčů; soukromý klíč zůstává mimo repozitář:
+    python scripts/ota_sign.py keygen ~/.config/sharp-ota.pem
+
+Pak se každý image podepíše a skript vypíše JSON pro trigger:
+    python scripts/ota_sign.py sign .pio/build/<env>/firmware.bin --key ~/.config/sharp-ota.pem \\
+        --url http://192.168.0.5:8000/firmware.bin
+
+Podepisuje se hash výsledného image, takže stejný podpis platí i pro deltu
+(make_delta.py --key). Potřebuje jen příkaz openssl.
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import subprocess
+import tempfile
+
+HEADER_PATH = os.path.join(os.path.dirname(__file__), "..", "src", "OtaSigningKey.h")
+
+
+def openssl(*args, data=None):
+    result = subprocess.run(["openssl", *args], input=data, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    if result.returncode != 0:
+        raise SystemExit("openssl %s: %s" % (args[0], result.stderr.decode().strip()))
+    return result.stdout
+
+
+def sign_digest(digest, key_path):
+    """DER podpis ECDSA P-256 hashe (32 B) jako hex pro pole "sig" triggeru."""
+    with tempfile.NamedTemporaryFile(suffix=".bin") as f:
+        f.write(digest)
+        f.flush()
+        signature = openssl("pkeyutl", "-sign", "-inkey", key_path, "-in", f.name)
+        # Kontrola proti veřejné části, ať se nepošle podpis, který zařízení odmítne
+        public = openssl("ec", "-in", key_path, "-pubout", data=b"")
+        with tempfile.NamedTemporaryFile(suffix=".pem") as pub, tempfile.NamedTemporaryFile(suffix=".sig") as sig:
+            pub.write(public)
+            pub.flush()
+            sig.write(signature)
+            sig.flush()
+            openssl("pkeyutl", "-verify", "-pubin", "-inkey", pub.name, "-in", f.name, "-sigfile", sig.name)
+    return signature.hex()
+
+
+def write_header(public_pem):
+    lines = public_pem.decode().strip().splitlines()
+    body = "\n".join('    "%s\\n"' % line for line in lines)
+    with open(HEADER_PATH, "w") as f:
+        f.write("// Vygenerováno scripts/ota_sign.py keygen - při změně klíče přepsat skriptem\n")
+        f.write("#pragma once\n\n")
+        f.write("// Veřejný klíč ECDSA P-256 (PEM), kterým se ověřuje podpis SHA-256 nového\n")
+        f.write("// image v triggeru OTA. Soukromý klíč zůstává u toho, kdo firmware vydává,\n")
+        f.write("// mimo repozitář. Prázdný klíč = firmware nepřijme žádnou aktualizaci.\n")
+        f.write("constexpr char OTA_SIGNING_KEY[] =\n%s;\n" % body)
+
+
+def keygen(args):
+    if os.path.exists(args.key):
+        raise SystemExit("%s uz existuje - stary klic by prestal platit" % args.key)
+    openssl("ecparam", "-name", "prime256v1", "-genkey", "-noout", "-out", args.key)
+    os.chmod(args.key, 0o600)
+    write_header(openssl("ec", "-in", args.key, "-pubout", data=b""))
+    print("soukromy klic %s, verejny klic zapsan do src/OtaSigningKey.h" % args.key)
+
+
+def sign(args):
+    with open(args.image, "rb") as f:
+        sha = hashlib.sha256(f.read()).digest()
+    signature = sign_digest(sha, args.key)
+    print("sha256 %s" % sha.hex())
+    print("sig %s" % signature)
+    if args.url:
+        print(json.dumps({"url": args.url, "sha256": sha.hex(), "sig": signature}))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    commands = parser.add_subparsers(dest="command", required=True)
+    p = commands.add_parser("keygen", help="nový pár klíčů, veřejný do src/OtaSigningKey.h")
+    p.add_argument("key", help="kam uložit soukromý klíč (PEM)")
+    p.set_defaults(run=keygen)
+    p = commands.add_parser("sign", help="podepsat image a vypsat trigger")
+    p.add_argument("image", help="nový image (.pio/build/<env>/firmware.bin)")
+    p.add_argument("--key", required=True, help="soukromý klíč z keygen")
+    p.add_argument("--url", help="URL, ze které si zařízení soubor stáhne (vypíše JSON pro trigger)")
+    p.set_defaults(run=sign)
+    args = parser.parse_args()
+    args.run(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,77 @@
+"""Pošle obrázek na displej přes MQTT (topic sharp/display/bitmap).
+
+Obrázek se převede na 1bpp, zkomprimuje PackBits a rozdělí na bloky, které se
+vejdou do MQTT bufferu zařízení. Vyžaduje Pillow a paho-mqtt:
+    python scripts/send_bitmap.py obrazek.png --host 192.168.1.10 [--x 0 --y 0] [--duration 60]
+
+Oblast menší než displej (--x/--y a menší obrázek) přepíše jen odpovídající řádky.
+"""
+
+import argparse
+import struct
+
+from PIL import Image
+import paho.mqtt.publish as publish
+
+TOPIC = "sharp/display/bitmap"
+HEADER = struct.Struct("<2sBBHHHHHH")
+FLAG_FIRST, FLAG_LAST, FLAG_PACKBITS = 0x01, 0x02, 0x04
+
+
+def packbits(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        run = 1
+        while i + run < len(data) and run < 128 and data[i + run] == data[i]:
+            run += 1
+        if run >= 2:
+            out += bytes([(257 - run) & 0xFF, data[i]])
+            i += run
+            continue
+        start = i
+        while i < len(data) and i - start < 128:
+            if i + 1 < len(data) and data[i + 1] == data[i]:
+                break
+            i += 1
+        if i == start:
+            i += 1
+        out.append(i - start - 1)
+        out += data[start:i]
+    return bytes(out)
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("image")
+    parser.add_argument("--host", required=True)
+    parser.add_argument("--port", type=int, default=1883)
+    parser.add_argument("--x", type=int, default=0)
+    parser.add_argument("--y", type=int, default=0)
+    parser.add_argument("--duration", type=int, default=0, help="s, 0 = výchozí doba zařízení")
+    parser.add_argument("--chunk", type=int, default=2048, help="max. dat v jedné zprávě")
+    parser.add_argument("--frame-id", type=int, default=1)
+    args = parser.parse_args()
+
+    image = Image.open(args.image).convert("1")  # 1 = bílá, MSB first, řádky na celé bajty
+    raw = image.tobytes()
+    packed = packbits(raw)
+    print("%dx%d: %d B -> PackBits %d B" % (image.width, image.height, len(raw), len(packed)))
+
+    messages = []
+    chunks = [packed[i:i + args.chunk] for i in range(0, len(packed), args.chunk)] or [b""]
+    for index, chunk in enumerate(chunks):
+        flags = FLAG_PACKBITS
+        if index == 0:
+            flags |= FLAG_FIRST
+        if index == len(chunks) - 1:
+            flags |= FLAG_LAST
+        header = HEADER.pack(b"SB", flags, args.frame_id & 0xFF, index, args.x, args.y,
+                             image.width, image.height, args.duration)
+        messages.append({"topic": TOPIC, "payload": header + chunk})
+
+    publish.multiple(messages, hostname=args.host, port=args.port)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,236 @@
+"""Stopy surových čtení SEN66 (formát viz src/SensorTrace.h).
+
+Vytvoření referenčních stop, jejich výpis a přenos do/ze zařízení:
+    python scripts/sensor_trace.py synth cooking traces/cooking.bin
+    python scripts/sensor_trace.py dump traces/cooking.bin > cooking.csv
+    python scripts/sensor_trace.py upload traces/cooking.bin --host 192.168.1.50 --replay 20
+    python scripts/sensor_trace.py record --host 192.168.1.50 --max-bytes 262144
+    python scripts/sensor_trace.py download --host 192.168.1.50 -o zaznam.bin
+
+Přehrání běží na zařízení celou pipeline (alarmy, AQI okna, MQTT, displej);
+čas vzorků se posouvá podle stopy, takže výsledek nezávisí na rychlosti.
+"""
+
+import argparse
+import json
+import math
+import random
+import struct
+import sys
+import urllib.request
+
+MAGIC = b"STRC"
+VERSION = 1
+HEADER = struct.Struct("<4sBBHII")
+RECORD = struct.Struct("<Ih4H4hH")
+U16_NAN = 0xFFFF
+I16_NAN = 0x7FFF
+UPLOAD_CHUNK = 4000  # HttpServer::MAX_BODY je 4096
+
+# Chybové kódy knihovny Sensirion (HighLevelError | LowLevelError)
+ERR_READ_CRC = 0x0201
+ERR_READ_NACK = 0x0205
+
+
+def scale_unsigned(v, s):
+    if v is None or math.isnan(v):
+        return U16_NAN
+    return max(0, min(U16_NAN - 1, round(v * s)))
+
+
+def scale_signed(v, s):
+    if v is None or math.isnan(v):
+        return I16_NAN
+    return max(-32768, min(I16_NAN - 1, round(v * s)))
+
+
+def encode(t_ms, error, pm1, pm25, pm4, pm10, hum, temp, voc, nox, co2):
+    return RECORD.pack(t_ms, error,
+                       scale_unsigned(pm1, 10), scale_unsigned(pm25, 10),
+                       scale_unsigned(pm4, 10), scale_unsigned(pm10, 10),
+                       scale_signed(hum, 100), scale_signed(temp, 200),
+                       scale_signed(voc, 10), scale_signed(nox, 10),
+                       U16_NAN if co2 is None else max(0, min(U16_NAN, int(round(co2)))))
+
+
+def decode(data):
+    magic, version, record_size, interval, start, _ = HEADER.unpack_from(data)
+    if magic != MAGIC or version != VERSION or record_size != RECORD.size:
+        raise SystemExit("neplatna hlavicka stopy")
+    records = []
+    for off in range(HEADER.size, len(data) - RECORD.size + 1, RECORD.size):
+        t, err, pm1, pm25, pm4, pm10, hum, temp, voc, nox, co2 = RECORD.unpack_from(data, off)
+        u = lambda v, s: None if v == U16_NAN else v / s
+        i = lambda v, s: None if v == I16_NAN else v / s
+        records.append((t, err, u(pm1, 10), u(pm25, 10), u(pm4, 10), u(pm10, 10),
+                        i(hum, 100), i(temp, 200), i(voc, 10), i(nox, 10), None if co2 == U16_NAN else co2))
+    return interval, start, records
+
+
+# --- Referenční scénáře (deterministické, pevný seed) ---
+
+def pm_split(pm25):
+    """PM1/PM4/PM10 odvozené od PM2.5 jako u jemného aerosolu."""
+    return pm25 * 0.92, pm25 * 1.04, pm25 * 1.08
+
+
+def envelope(t, start, stop, tau_rise, tau_decay):
+    """0 před událostí, exponenciální náběh během ní a pokles po ní."""
+    if t < start:
+        return 0.0
+    if t < stop:
+        return 1 - math.exp(-(t - start) / tau_rise)
+    return (1 - math.exp(-(stop - start) / tau_rise)) * math.exp(-(t - stop) / tau_decay)
+
+
+def scenario_cooking(rng):
+    """Smažení 10.-18. minutu: prudký nárůst PM, VOC a NOx, pomalý pokles po skončení."""
+    for k in range(45 * 30):
+        t = k * 2.0
+        pm25 = 6.0 + 180.0 * envelope(t, 600, 1080, 120, 480)
+        pm25 = max(0.0, pm25 + rng.gauss(0, 0.8 + pm25 * 0.04))
+        voc = 100 + 250 * envelope(t, 600, 1080, 180, 900) + rng.gauss(0, 3)
+        nox = 1 + 40 * envelope(t, 600, 1080, 90, 300) + rng.gauss(0, 0.5)
+        co2 = 650 + 650 * envelope(t, 600, 1080, 300, 1500) + rng.gauss(0, 8)
+        temp = 22.0 + 1.5 * envelope(t, 600, 1080, 300, 900) + rng.gauss(0, 0.03)
+        hum = 45.0 + 8.0 * envelope(t, 600, 1080, 120, 600) + rng.gauss(0, 0.2)
+        pm1, pm4, pm10 = pm_split(pm25)
+        yield int(t * 1000), 0, pm1, pm25, pm4, pm10, hum, temp, max(voc, 1), max(nox, 1), co2
+
+
+def scenario_window(rng):
+    """Vyvětrání: okno otevřené 5.-25. minutu, CO2 a teplota klesají, PM z venku mírně roste."""
+    for k in range(40 * 30):
+        t = k * 2.0
+        mix = envelope(t, 300, 1500, 240, 1200)
+        co2 = 1800 - 1350 * envelope(t, 300, 1500, 240, 1e9) + 300 * envelope(t, 1500, 1e9, 1800, 1) \
+            + rng.gauss(0, 10)
+        temp = 22.5 - 5.5 * mix + rng.gauss(0, 0.03)
+        hum = 55.0 - 12.0 * mix + rng.gauss(0, 0.3)
+        pm25 = max(0.0, 8.0 + 10.0 * mix + rng.gauss(0, 0.6))
+        voc = 160 - 70 * mix + rng.gauss(0, 2)
+        nox = 2 + 6 * mix + rng.gauss(0, 0.4)
+        pm1, pm4, pm10 = pm_split(pm25)
+        yield int(t * 1000), 0, pm1, pm25, pm4, pm10, hum, temp, max(voc, 1), max(nox, 1), co2
+
+
+def scenario_fault(rng):
+    """Poruchy: NaN po startu, výpadek I2C, chyby CRC, nesmyslné hodnoty a zotavení."""
+    for k in range(20 * 30):
+        t = k * 2.0
+        pm25 = 12.0 + rng.gauss(0, 0.7)
+        pm1, pm4, pm10 = pm_split(pm25)
+        rec = [int(t * 1000), 0, pm1, pm25, pm4, pm10,
+               48.0 + rng.gauss(0, 0.2), 23.0 + rng.gauss(0, 0.03),
+               110 + rng.gauss(0, 2), 1.0, 820 + rng.gauss(0, 6)]
+        if k < 6:                                   # SEN66 po startu ještě nemá hodnoty
+            rec[2:] = [None] * 9
+        elif k < 30:                                # VOC/NOx algoritmus se teprve rozbíhá
+            rec[8] = rec[9] = None
+        elif 180 <= t < 210:                        # odpojený senzor - NACK adresy
+            rec[1] = ERR_READ_NACK
+            rec[2:] = [0.0] * 8 + [0]
+        elif 300 <= t < 420 and k % 7 == 0:         # rušení na sběrnici - CRC
+            rec[1] = ERR_READ_CRC
+        elif t in (480.0, 482.0):                   # nesmyslná teplota a vlhkost
+            rec[6], rec[7] = 112.0, 130.0
+        elif t == 540.0:
+            rec[10] = 0                             # CO2 mimo rozsah
+        elif 600 <= t < 720:                        # skutečná událost po zotavení
+            rec[3] += 60 * (1 - math.exp(-(t - 600) / 30.0))
+        yield tuple(rec)
+
+
+SCENARIOS = {"cooking": scenario_cooking, "window": scenario_window, "fault": scenario_fault}
+
+
+def synth(name, path):
+    rng = random.Random(name)
+    out = bytearray(HEADER.pack(MAGIC, VERSION, RECORD.size, 2000, 0, 0))
+    count = 0
+    for rec in SCENARIOS[name](rng):
+        out += encode(*rec)
+        count += 1
+    with open(path, "wb") as f:
+        f.write(out)
+    print("%s: %d zaznamu, %d B" % (path, count, len(out)), file=sys.stderr)
+
+
+def dump(path):
+    with open(path, "rb") as f:
+        interval, start, records = decode(f.read())
+    print("# interval_ms=%d start=%d records=%d" % (interval, start, len(records)))
+    print("t_ms,error,pm1,pm25,pm4,pm10,hum,temp,voc,nox,co2")
+    fmt = lambda v: "" if v is None else ("%g" % v)
+    for r in records:
+        print("%d,0x%04x,%s" % (r[0], r[1] & 0xFFFF, ",".join(fmt(v) for v in r[2:])))
+
+
+def request(host, path, body=None, content_type="application/json"):
+    req = urllib.request.Request("http://%s%s" % (host, path), data=body, method="POST" if body is not None else "GET")
+    if body is not None:
+        req.add_header("Content-Type", content_type)
+    with urllib.request.urlopen(req, timeout=15) as resp:
+        return resp.read()
+
+
+def control(host, action, **params):
+    params["action"] = action
+    reply = json.loads(request(host, "/api/trace", json.dumps(params).encode()))
+    print("%s: %s" % (action, reply.get("message")), file=sys.stderr)
+    return reply.get("ok", False)
+
+
+def upload(host, path):
+    with open(path, "rb") as f:
+        data = f.read()
+    decode(data)  # kontrola hlavičky před odesláním
+    for off in range(0, len(data), UPLOAD_CHUNK):
+        request(host, "/api/trace/upload?offset=%d" % off, data[off:off + UPLOAD_CHUNK], "application/octet-stream")
+    print("nahrano %d B" % len(data), file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    p = sub.add_parser("synth", help="vytvori referencni stopu")
+    p.add_argument("scenario", choices=sorted(SCENARIOS))
+    p.add_argument("output")
+    p = sub.add_parser("dump", help="vypise stopu jako CSV")
+    p.add_argument("trace")
+    p = sub.add_parser("upload", help="nahraje stopu do zarizeni")
+    p.add_argument("trace")
+    p.add_argument("--host", required=True)
+    p.add_argument("--replay", type=int, metavar="SPEED", help="po nahrani spusti prehravani (1-100x)")
+    p = sub.add_parser("download", help="stahne zaznamenanou stopu")
+    p.add_argument("--host", required=True)
+    p.add_argument("-o", "--output", required=True)
+    p = sub.add_parser("record", help="spusti zaznam na zarizeni")
+    p.add_argument("--host", required=True)
+    p.add_argument("--max-bytes", type=int, default=256 * 1024)
+    p = sub.add_parser("stop", help="ukonci zaznam nebo prehravani")
+    p.add_argument("--host", required=True)
+    args = parser.parse_args()
+
+    if args.cmd == "synth":
+        synth(args.scenario, args.output)
+    elif args.cmd == "dump":
+        dump(args.trace)
+    elif args.cmd == "upload":
+        upload(args.host, args.trace)
+        if args.replay and not control(args.host, "replay", speed=args.replay):
+            sys.exit(1)
+    elif args.cmd == "download":
+        data = request(args.host, "/api/trace")
+        decode(data)
+        with open(args.output, "wb") as f:
+            f.write(data)
+        print("stazeno %d B" % len(data), file=sys.stderr)
+    elif args.cmd == "record":
+        sys.exit(0 if control(args.host, "record", maxBytes=args.max_bytes) else 1)
+    elif args.cmd == "stop":
+        sys.exit(0 if control(args.host, "stop") else 1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,161 @@
+#include "AirQuality.h"
+
+namespace {
+constexpr uint8_t NOWCAST_HOURS = 12;
+constexpr uint8_t DAY_MIN_HOURS = 18;  // EPA: 24h průměr platí při 75 % pokrytí
+
+struct Breakpoint {
+  float low;
+  float high;
+  uint16_t indexLow;
+  uint16_t indexHigh;
+};
+
+// US EPA PM2.5 (µg/m³) - stejné hranice jako dřívější okamžité hodnocení
+const Breakpoint PM25_BREAKPOINTS[] = {
+    {0.0f, 12.0f, 0, 50},       {12.1f, 35.4f, 51, 100},   {35.5f, 55.4f, 101, 150},
+    {55.5f, 150.4f, 151, 200},  {150.5f, 250.4f, 201, 300}, {250.5f, 500.4f, 301, 500},
+};
+
+// CO2 (ppm): do 800 výborné, nad 1000 vydýchaný vzduch, nad 2000 únava a bolest hlavy
+const Breakpoint CO2_BREAKPOINTS[] = {
+    {0.0f, 800.0f, 0, 50},        {800.0f, 1000.0f, 51, 100},  {1000.0f, 1400.0f, 101, 150},
+    {1400.0f, 2000.0f, 151, 200}, {2000.0f, 5000.0f, 201, 300}, {5000.0f, 40000.0f, 301, 500},
+};
+
+// Sensirion VOC index (1-500, 100 = běžný průměr prostředí)
+const Breakpoint VOC_BREAKPOINTS[] = {
+    {0.0f, 100.0f, 0, 50},     {100.0f, 150.0f, 51, 100}, {150.0f, 250.0f, 101, 150},
+    {250.0f, 400.0f, 151, 200}, {400.0f, 500.0f, 201, 300},
+};
+
+template <size_t N>
+uint16_t toIndex(const Breakpoint (&table)[N], float value) {
+  if (value <= 0) return 0;
+  for (size_t i = 0; i < N; i++) {
+    const Breakpoint& bp = table[i];
+    if (value > bp.high) continue;
+    if (value < bp.low) value = bp.low;  // mezera mezi pásmy po zaokrouhlení (12.0-12.1)
+    float index = bp.indexLow + (value - bp.low) * (bp.indexHigh - bp.indexLow) / (bp.high - bp.low);
+    return (uint16_t)(index + 0.5f);
+  }
+  return table[N - 1].indexHigh;
+}
+}  // namespace
+
+AirQualityEngine::AirQualityEngine() : pm25Hours_(3600), co2Minutes_(60), vocHour_(300) {}
+
+void AirQualityEngine::update(uint32_t nowS, const float* pm25, const float* co2, const float* voc) {
+  if (pm25) {
+    pm25Hours_.add(*pm25, nowS);
+  } else {
+    pm25Hours_.advance(nowS);
+  }
+  if (co2) {
+    co2Minutes_.add(*co2, nowS);
+  } else {
+    co2Minutes_.advance(nowS);
+  }
+  if (voc) {
+    vocHour_.add(*voc, nowS);
+  } else {
+    vocHour_.advance(nowS);
+  }
+  stats_.samples++;
+}
+
+// EPA NowCast: hodinové průměry za 12 h vážené w^i, kde w = min/max
+// (aspoň 0.5); při rychlé změně převáží poslední hodiny. Potřebuje data
+// aspoň ze 2 ze 3 posledních hodin (rozpracovaná hodina se počítá).
+bool AirQualityEngine::nowCast(float& out) const {
+  float hourly[NOWCAST_HOURS];
+  bool present[NOWCAST_HOURS];
+  uint8_t recent = 0;
+  float minimum = 0, maximum = 0;
+  bool any = false;
+  for (uint8_t i = 0; i < NOWCAST_HOURS; i++) {
+    present[i] = pm25Hours_.bucketMean(i, hourly[i]);
+    if (!present[i]) continue;
+    if (i < 3) recent++;
+    if (!any || hourly[i] < minimum) minimum = hourly[i];
+    if (!any || hourly[i] > maximum) maximum = hourly[i];
+    any = true;
+  }
+  if (recent < 2) return false;
+
+  float weight = maximum > 0 ? minimum / maximum : 1.0f;
+  if (weight < 0.5f) weight = 0.5f;
+
+  float factor = 1.0f, numerator = 0, denominator = 0;
+  for (uint8_t i = 0; i < NOWCAST_HOURS; i++) {
+    if (present[i]) {
+      numerator += factor * hourly[i];
+      denominator += factor;
+    }
+    factor *= weight;
+  }
+  out = numerator / denominator;
+  return true;
+}
+
+AirQualityIndex AirQualityEngine::compute() const {
+  AirQualityIndex result;
+  if (nowCast(result.pm25NowCast)) {
+    result.nowCastValid = true;
+    result.aqiNowCast = pm25ToAqi(result.pm25NowCast);
+  }
+  if (pm25Hours_.filledBuckets() >= DAY_MIN_HOURS && pm25Hours_.mean(result.pm25Day)) {
+    result.dayValid = true;
+    result.aqiDay = pm25ToAqi(result.pm25Day);
+  }
+  if (co2Minutes_.mean(result.co2Mean)) {
+    result.co2Valid = true;
+    result.co2Index = toIndex(CO2_BREAKPOINTS, result.co2Mean);
+  }
+  if (vocHour_.mean(result.vocMean)) {
+    result.vocValid = true;
+    result.vocIndex = toIndex(VOC_BREAKPOINTS, result.vocMean);
+  }
+
+  auto consider = [&](bool valid, uint16_t index, AirQualityPollutant pollutant) {
+    if (valid && (result.dominant == AQ_NONE || index > result.overall)) {
+      result.overall = index;
+      result.dominant = pollutant;
+    }
+  };
+  consider(result.nowCastValid, result.aqiNowCast, AQ_PM25);
+  consider(result.co2Valid, result.co2Index, AQ_CO2);
+  consider(result.vocValid, result.vocIndex, AQ_VOC);
+  return result;
+}
+
+uint16_t AirQualityEngine::pm25ToAqi(float pm25) {
+  return toIndex(PM25_BREAKPOINTS, pm25);
+}
+
+const char* AirQualityEngine::categoryLabel(uint16_t index) {
+  if (index <= 50) return "VYNIKAJICI";
+  if (index <= 100) return "DOBRE";
+  if (index <= 150) return "PRIJATELNE";
+  if (index <= 200) return "SPATNE";
+  if (index <= 300) return "VELMI SPATNE";
+  return "NEBEZPECNE";
+}
+
+const char* AirQualityEngine::pollutantName(AirQualityPollutant pollutant) {
+  switch (pollutant) {
+    case AQ_PM25:
+      return "PM2.5";
+    case AQ_CO2:
+      return "CO2";
+    case AQ_VOC:
+      return "VOC";
+    default:
+      return "---";
+  }
+}
+
+void AirQualityEngine::setUpdateTime(uint32_t us) {
+  stats_.lastUpdateUs = us;
+  if (us > stats_.maxUpdateUs) stats_.maxUpdateUs = us;
+}
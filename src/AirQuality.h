@@ -0,0 +1,147 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Klouzavý průměr přes pevný počet košů (např. 24 × 1 h). Vzorek se jen
+// přičte do aktuálního koše a do běžícího součtu; při posunu času se
+// vypadlé koše z běžícího součtu odečtou. Cena vzorku je tedy O(1) a paměť
+// nezávisí na frekvenci vzorků - surové hodnoty se neukládají.
+template <uint8_t BUCKETS>
+class RollingMean {
+ public:
+  explicit RollingMean(uint32_t bucketSeconds) : bucketSeconds_(bucketSeconds) {}
+
+  void add(float value, uint32_t nowS) {
+    advance(nowS);
+    Bucket& bucket = buckets_[slot_ % BUCKETS];
+    bucket.sum += value;
+    bucket.count++;
+    sum_ += value;
+    count_++;
+  }
+
+  // Posun okna i bez vzorků (výpadek senzoru) - staré koše vypadnou
+  void advance(uint32_t nowS) {
+    uint32_t slot = nowS / bucketSeconds_;
+    if (!started_) {
+      started_ = true;
+      slot_ = slot;
+      return;
+    }
+    if (slot <= slot_) return;
+    uint32_t steps = slot - slot_;
+    if (steps >= BUCKETS) {
+      for (Bucket& bucket : buckets_) bucket = Bucket();
+      sum_ = 0;
+      count_ = 0;
+    } else {
+      for (uint32_t i = 1; i <= steps; i++) {
+        Bucket& bucket = buckets_[(slot_ + i) % BUCKETS];
+        sum_ -= bucket.sum;
+        count_ -= bucket.count;
+        bucket = Bucket();
+      }
+    }
+    slot_ = slot;
+  }
+
+  bool mean(float& out) const {
+    if (count_ == 0) return false;
+    out = (float)(sum_ / count_);
+    return true;
+  }
+
+  // Průměr koše podle stáří (0 = rozpracovaný, 1 = předchozí, ...)
+  bool bucketMean(uint8_t age, float& out) const {
+    if (age >= BUCKETS || !started_) return false;
+    const Bucket& bucket = buckets_[(slot_ + BUCKETS - age) % BUCKETS];
+    if (bucket.count == 0) return false;
+    out = (float)(bucket.sum / bucket.count);
+    return true;
+  }
+
+  uint8_t filledBuckets() const {
+    uint8_t filled = 0;
+    for (const Bucket& bucket : buckets_) filled += bucket.count ? 1 : 0;
+    return filled;
+  }
+
+  static constexpr uint8_t bucketCount() { return BUCKETS; }
+
+ private:
+  struct Bucket {
+    double sum = 0;
+    uint32_t count = 0;
+  };
+
+  uint32_t bucketSeconds_;
+  Bucket buckets_[BUCKETS];
+  uint32_t slot_ = 0;  // absolutní číslo aktuálního koše (nowS / bucketSeconds_)
+  bool started_ = false;
+  double sum_ = 0;     // double - opakované přičítání/odečítání nesmí driftovat
+  uint32_t count_ = 0;
+};
+
+enum AirQualityPollutant : uint8_t {
+  AQ_NONE = 0,
+  AQ_PM25,
+  AQ_CO2,
+  AQ_VOC,
+};
+
+struct AirQualityIndex {
+  bool nowCastValid = false;  // NowCast PM2.5 (vážené hodinové průměry za 12 h)
+  float pm25NowCast = 0;
+  uint16_t aqiNowCast = 0;
+
+  bool dayValid = false;      // 24h průměr PM2.5, aspoň 18 z 24 hodin s daty
+  float pm25Day = 0;
+  uint16_t aqiDay = 0;
+
+  bool co2Valid = false;      // 15min průměr CO2
+  float co2Mean = 0;
+  uint16_t co2Index = 0;
+
+  bool vocValid = false;      // hodinový průměr VOC indexu
+  float vocMean = 0;
+  uint16_t vocIndex = 0;
+
+  // Nejhorší z krátkodobých indexů (NowCast, CO2, VOC) - ten se zobrazuje
+  uint16_t overall = 0;
+  AirQualityPollutant dominant = AQ_NONE;
+};
+
+struct AirQualityStats {
+  uint32_t samples = 0;
+  uint32_t lastUpdateUs = 0;
+  uint32_t maxUpdateUs = 0;
+};
+
+// Indexy kvality vzduchu z klouzavých oken místo okamžité hodnoty, takže
+// popisek na displeji neskáče s každým krátkým výkyvem. Stupnice 0-500
+// podle US EPA (PM2.5), CO2 a VOC mají vlastní pásma na stejné stupnici.
+// Nezávisí na Arduino API, čas dodává volající v sekundách.
+class AirQualityEngine {
+ public:
+  AirQualityEngine();
+
+  // Hodnoty jednoho vzorku; chybějící kanál = nullptr
+  void update(uint32_t nowS, const float* pm25, const float* co2, const float* voc);
+  AirQualityIndex compute() const;
+
+  static const char* categoryLabel(uint16_t index);  // "DOBRE", ...
+  static const char* pollutantName(AirQualityPollutant pollutant);
+  static uint16_t pm25ToAqi(float pm25);
+
+  void setUpdateTime(uint32_t us);  // měří volající (host nemá micros())
+  AirQualityStats getStats() const { return stats_; }
+
+ private:
+  bool nowCast(float& out) const;
+
+  RollingMean<24> pm25Hours_;   // 24 × 1 h: NowCast (12 h) i denní průměr
+  RollingMean<15> co2Minutes_;  // 15 × 1 min
+  RollingMean<12> vocHour_;     // 12 × 5 min
+  AirQualityStats stats_;
+};
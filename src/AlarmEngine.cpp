@@ -0,0 +1,161 @@
+#include "AlarmEngine.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+constexpr size_t MAX_RULE_TEXT = 64;
+
+bool isSeparator(char c) {
+  return c == ';' || c == ',';
+}
+
+// Číslo musí zabrat celý úsek až po ':' nebo konec
+bool parseNumber(const char*& p, float& value) {
+  char* end;
+  value = strtof(p, &end);
+  if (end == p) return false;
+  p = end;
+  return *p == ':' || *p == '\0';
+}
+}  // namespace
+
+bool AlarmEngine::parseRule(const char* text, size_t length, AlarmRule& rule) {
+  char buf[MAX_RULE_TEXT];
+  // Mezery se zahazují, "co2 > 1200 : 1000" je totéž jako "co2>1200:1000"
+  size_t n = 0;
+  for (size_t i = 0; i < length; i++) {
+    if (text[i] == ' ') continue;
+    if (n + 1 >= sizeof(buf)) return false;
+    buf[n++] = text[i];
+  }
+  buf[n] = '\0';
+  if (n == 0) return false;
+
+  const char* op = strpbrk(buf, "<>");
+  if (!op || op == buf || (size_t)(op - buf) >= sizeof(rule.key)) return false;
+  memcpy(rule.key, buf, op - buf);
+  rule.key[op - buf] = '\0';
+  rule.above = *op == '>';
+
+  const char* p = op + 1;
+  if (!parseNumber(p, rule.onThreshold)) return false;
+  rule.offThreshold = rule.onThreshold;
+  float dwellS = 0;
+  if (*p == ':') {
+    p++;
+    if (!parseNumber(p, rule.offThreshold)) return false;
+    if (*p == ':') {
+      p++;
+      if (!parseNumber(p, dwellS) || *p != '\0') return false;
+    }
+  }
+
+  // Hystereze musí jít proti směru alarmu, jinak by pravidlo kmitalo
+  if (rule.above ? rule.offThreshold > rule.onThreshold : rule.offThreshold < rule.onThreshold) return false;
+  if (dwellS < 0 || dwellS > 86400) return false;
+  rule.dwellMs = (uint32_t)(dwellS * 1000);
+  return true;
+}
+
+bool AlarmEngine::validate(const char* spec) {
+  // Jen syntaxe - kanály jsou známé až po startu senzorů
+  AlarmEngine probe;
+  return probe.compile(spec, [](const char*) { return 0; });
+}
+
+bool AlarmEngine::compile(const char* spec, const ChannelResolver& resolve) {
+  ruleCount_ = 0;
+  activeMask_ = 0;
+  eventHead_ = 0;
+  eventCount_ = 0;
+  bool ok = true;
+
+  const char* start = spec;
+  while (*start) {
+    const char* end = start;
+    while (*end && !isSeparator(*end)) end++;
+    bool blank = strspn(start, " ") >= (size_t)(end - start);
+    if (!blank) {
+      AlarmRule rule;
+      if (ruleCount_ >= MAX_RULES || !parseRule(start, end - start, rule)) {
+        ok = false;
+      } else {
+        rule.channel = (int8_t)resolve(rule.key);
+        if (rule.channel < 0) ok = false;  // pravidlo zůstává, jen se nevyhodnocuje
+        rules_[ruleCount_++] = rule;
+      }
+    }
+    start = *end ? end + 1 : end;
+  }
+  return ok;
+}
+
+uint32_t AlarmEngine::evaluate(const float* values, uint32_t validMask, uint32_t now) {
+  uint32_t changed = 0;
+  stats_.evaluations++;
+
+  for (uint8_t i = 0; i < ruleCount_; i++) {
+    AlarmRule& rule = rules_[i];
+    if (rule.channel < 0 || !(validMask & (1UL << rule.channel))) continue;
+
+    float value = values[rule.channel];
+    rule.lastValue = value;
+    bool wantsChange = rule.active
+        ? (rule.above ? value < rule.offThreshold : value > rule.offThreshold)
+        : (rule.above ? value > rule.onThreshold : value < rule.onThreshold);
+
+    if (!wantsChange) {
+      rule.pending = false;
+      continue;
+    }
+    if (!rule.pending) {
+      rule.pending = true;
+      rule.pendingSince = now;
+    }
+    if (now - rule.pendingSince < rule.dwellMs) continue;
+
+    rule.pending = false;
+    rule.active = !rule.active;
+    if (rule.active) {
+      activeMask_ |= 1UL << i;
+    } else {
+      activeMask_ &= ~(1UL << i);
+    }
+    changed |= 1UL << i;
+    stats_.transitions++;
+    pushEvent(i);
+  }
+  return changed;
+}
+
+void AlarmEngine::pushEvent(uint8_t index) {
+  // Plná fronta: zahodí se nejstarší přechod, poslední stav pravidla zůstane
+  if (eventCount_ == EVENT_QUEUE) {
+    eventHead_ = (eventHead_ + 1) % EVENT_QUEUE;
+    eventCount_--;
+    stats_.droppedEvents++;
+  }
+  const AlarmRule& rule = rules_[index];
+  AlarmEvent& event = events_[(eventHead_ + eventCount_) % EVENT_QUEUE];
+  event.rule = index;
+  event.active = rule.active;
+  event.value = rule.lastValue;
+  event.threshold = rule.active ? rule.onThreshold : rule.offThreshold;
+  eventCount_++;
+}
+
+const AlarmEvent* AlarmEngine::peekEvent() const {
+  return eventCount_ ? &events_[eventHead_] : nullptr;
+}
+
+void AlarmEngine::popEvent() {
+  if (!eventCount_) return;
+  eventHead_ = (eventHead_ + 1) % EVENT_QUEUE;
+  eventCount_--;
+}
+
+void AlarmEngine::setEvalTime(uint32_t us) {
+  stats_.lastEvalUs = us;
+  if (us > stats_.maxEvalUs) stats_.maxEvalUs = us;
+}
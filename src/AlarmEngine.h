@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+
+// Jedno pravidlo, např. "co2>1200:1000:60": alarm při CO2 nad 1200, konec
+// pod 1000 (hystereze), obojí musí trvat aspoň 60 s (dwell)
+struct AlarmRule {
+  char key[24] = {0};
+  int8_t channel = -1;      // index kanálu v registru, -1 = kanál chybí
+  bool above = true;        // '>' = alarm nad prahem, '<' = pod prahem
+  float onThreshold = 0;
+  float offThreshold = 0;
+  uint32_t dwellMs = 0;
+
+  bool active = false;
+  bool pending = false;     // podmínka přechodu splněna, běží dwell
+  uint32_t pendingSince = 0;
+  float lastValue = 0;
+};
+
+// Jeden přechod pravidla tak, jak nastal - hodnota a práh v okamžiku změny
+struct AlarmEvent {
+  uint8_t rule = 0;
+  bool active = false;
+  float value = 0;
+  float threshold = 0;
+};
+
+struct AlarmStats {
+  uint32_t evaluations = 0;
+  uint32_t transitions = 0;
+  uint32_t droppedEvents = 0;  // nejstarší přechody přepsané v plné frontě
+  uint32_t lastEvalUs = 0;
+  uint32_t maxEvalUs = 0;
+};
+
+// Pravidla se přeloží z konfigurace jednou při startu do pevné tabulky
+// s předem dohledanými indexy kanálů; vyhodnocení vzorku je pak jen
+// průchod tabulkou bez alokací a hledání. Nezávisí na Arduino API, takže
+// jde spustit i na PC nad nahranými průběhy hodnot.
+class AlarmEngine {
+ public:
+  static constexpr uint8_t MAX_RULES = 8;
+  static constexpr uint8_t EVENT_QUEUE = 16;
+  typedef std::function<int(const char* key)> ChannelResolver;  // -1 = neznámý klíč
+
+  // "co2>1200:1000:60; pm25>35:25:120; temperature<16" - práh[:konec[:dwell s]]
+  bool compile(const char* spec, const ChannelResolver& resolve);
+  static bool validate(const char* spec);
+
+  // Vrací bitovou masku pravidel, která změnila stav; každý přechod jde
+  // navíc do fronty událostí, takže se za výpadku MQTT neztratí ani
+  // krátký alarm, který mezitím začal i skončil
+  uint32_t evaluate(const float* values, uint32_t validMask, uint32_t now);
+
+  // Nejstarší neodeslaný přechod; pop až po úspěšném odeslání
+  const AlarmEvent* peekEvent() const;
+  void popEvent();
+  uint8_t pendingEvents() const { return eventCount_; }
+
+  uint8_t ruleCount() const { return ruleCount_; }
+  const AlarmRule& rule(uint8_t index) const { return rules_[index]; }
+  uint32_t activeMask() const { return activeMask_; }
+
+  void setEvalTime(uint32_t us);  // měří volající (host nemá micros())
+  AlarmStats getStats() const { return stats_; }
+
+ private:
+  static bool parseRule(const char* text, size_t length, AlarmRule& rule);
+  void pushEvent(uint8_t index);
+
+  AlarmRule rules_[MAX_RULES];
+  uint8_t ruleCount_ = 0;
+  uint32_t activeMask_ = 0;
+  AlarmEvent events_[EVENT_QUEUE];
+  uint8_t eventHead_ = 0;  // nejstarší událost
+  uint8_t eventCount_ = 0;
+  AlarmStats stats_;
+};
@@ -0,0 +1,129 @@
+#include "BitmapReceiver.h"
+
+#include "Log.h"
+
+namespace {
+constexpr uint8_t FLAG_FIRST = 0x01;
+constexpr uint8_t FLAG_LAST = 0x02;
+constexpr uint8_t FLAG_PACKBITS = 0x04;
+
+uint16_t readU16(const uint8_t* p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+}  // namespace
+
+BitmapChunkResult BitmapReceiver::fail(const char* reason) {
+  LOGW(DISP, "snimek %u zahozen (%s)", frameId_, reason);
+  if (active_) display_.discardChanges();
+  active_ = false;
+  stats_.errors++;
+  return BITMAP_CHUNK_ERROR;
+}
+
+bool BitmapReceiver::startFrame(const uint8_t* header) {
+  frameId_ = header[3];
+  x_ = (int16_t)readU16(header + 6);
+  y_ = (int16_t)readU16(header + 8);
+  w_ = readU16(header + 10);
+  h_ = readU16(header + 12);
+  durationS_ = readU16(header + 14);
+
+  rowBytes_ = (w_ + 7) / 8;
+  if (w_ == 0 || h_ == 0 || rowBytes_ > MAX_ROW_BYTES || x_ + w_ > display_.width() || y_ + h_ > display_.height()) {
+    return false;
+  }
+
+  active_ = true;
+  nextChunk_ = 0;
+  row_ = 0;
+  rowFill_ = 0;
+  literalLeft_ = 0;
+  repeatLeft_ = 0;
+  repeatPending_ = false;
+  frameBytes_ = 0;
+  frameDecodeUs_ = 0;
+  return true;
+}
+
+bool BitmapReceiver::emit(uint8_t value) {
+  if (row_ >= h_) return false;  // víc dat, než oblast pojme
+  rowBuffer_[rowFill_++] = value;
+  if (rowFill_ == rowBytes_) {
+    display_.writeRow(x_, y_ + row_, rowBuffer_, w_);
+    row_++;
+    rowFill_ = 0;
+  }
+  return true;
+}
+
+bool BitmapReceiver::decode(const uint8_t* data, size_t length, bool packBits) {
+  if (!packBits) {
+    for (size_t i = 0; i < length; i++) {
+      if (!emit(data[i])) return false;
+    }
+    return true;
+  }
+
+  // PackBits: n 0..127 = n+1 doslovných bajtů, n -127..-1 = další bajt 1-n krát, -128 = nic
+  for (size_t i = 0; i < length; i++) {
+    uint8_t b = data[i];
+    if (literalLeft_ > 0) {
+      literalLeft_--;
+      if (!emit(b)) return false;
+    } else if (repeatPending_) {
+      repeatPending_ = false;
+      for (uint8_t r = 0; r < repeatLeft_; r++) {
+        if (!emit(b)) return false;
+      }
+      repeatLeft_ = 0;
+    } else {
+      int8_t n = (int8_t)b;
+      if (n >= 0) {
+        literalLeft_ = (uint8_t)n + 1;
+      } else if (n != -128) {
+        repeatLeft_ = (uint8_t)(1 - n);
+        repeatPending_ = true;
+      }
+    }
+  }
+  return true;
+}
+
+void BitmapReceiver::expire(unsigned long now) {
+  if (active_ && now - lastChunkAt_ > CHUNK_TIMEOUT_MS) fail("timeout");
+}
+
+BitmapChunkResult BitmapReceiver::handleChunk(const uint8_t* data, size_t length) {
+  stats_.chunks++;
+  if (length < HEADER_SIZE || data[0] != 'S' || data[1] != 'B') return fail("hlavicka");
+
+  uint8_t flags = data[2];
+  uint16_t chunk = readU16(data + 4);
+
+  if (flags & FLAG_FIRST) {
+    if (active_) fail("nedokonceny predchozi");
+    if (chunk != 0 || !startFrame(data)) return fail("oblast");
+  } else if (!active_ || data[3] != frameId_ || chunk != nextChunk_) {
+    return fail("chybi blok");
+  }
+  nextChunk_ = chunk + 1;
+  lastChunkAt_ = millis();
+
+  uint32_t startUs = micros();
+  size_t payloadLength = length - HEADER_SIZE;
+  bool ok = decode(data + HEADER_SIZE, payloadLength, flags & FLAG_PACKBITS);
+  frameDecodeUs_ += micros() - startUs;
+  frameBytes_ += payloadLength;
+  stats_.bytesReceived += payloadLength;
+  if (!ok) return fail("prebytecna data");
+
+  if (!(flags & FLAG_LAST)) return BITMAP_CHUNK_PENDING;
+
+  if (row_ != h_ || literalLeft_ || repeatPending_) return fail("neuplna data");
+  active_ = false;
+  stats_.frames++;
+  stats_.bytesDecoded += (uint32_t)rowBytes_ * h_;
+  stats_.lastFrameBytes = frameBytes_;
+  stats_.lastDecodeUs = frameDecodeUs_;
+  return BITMAP_CHUNK_COMPLETE;
+}
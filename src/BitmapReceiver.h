@@ -0,0 +1,86 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "SharpDisplay.h"
+
+struct BitmapReceiverStats {
+  uint32_t frames = 0;          // kompletně přijaté snímky/oblasti
+  uint32_t chunks = 0;
+  uint32_t errors = 0;          // chybná hlavička, chybějící blok, špatná délka dat
+  uint32_t bytesReceived = 0;   // komprimovaná data
+  uint32_t bytesDecoded = 0;
+  uint32_t lastFrameBytes = 0;  // komprimovaná velikost posledního snímku
+  uint32_t lastDecodeUs = 0;    // součet dekódování přes všechny bloky snímku
+};
+
+enum BitmapChunkResult : uint8_t {
+  BITMAP_CHUNK_PENDING = 0,  // čeká se na další blok
+  BITMAP_CHUNK_COMPLETE,     // oblast je celá v bufferu displeje
+  BITMAP_CHUNK_ERROR,        // snímek zahozen, buffer vrácen na obsah panelu
+};
+
+// Příjem 1bpp bitmap z MQTT (sharp/display/bitmap). Každá zpráva nese
+// 16B hlavičku a navazující kus dat; data se dekódují (PackBits nebo
+// nekomprimovaně) rovnou do řádků framebufferu přes jeden řádkový buffer,
+// takže snímek může být větší než buffer PubSubClient.
+//
+// Hlavička (little-endian):
+//   0  'S' 'B'
+//   2  flags: bit0 první blok, bit1 poslední blok, bit2 PackBits
+//   3  id snímku
+//   4  u16 pořadí bloku (0, 1, ...)
+//   6  u16 x, u16 y, u16 w, u16 h - oblast na displeji
+//   14 u16 doba zobrazení v s (0 = výchozí)
+// Řádky jsou zarovnané na celé bajty, MSB first, 1 = bílá.
+class BitmapReceiver {
+ public:
+  static constexpr size_t HEADER_SIZE = 16;
+  static constexpr uint16_t MAX_ROW_BYTES = 64;
+  static constexpr unsigned long CHUNK_TIMEOUT_MS = 3000;
+
+  explicit BitmapReceiver(SharpDisplay& display) : display_(display) {}
+
+  BitmapChunkResult handleChunk(const uint8_t* data, size_t length);
+
+  // Rozpracovaný snímek - buffer displeje se nesmí překreslit
+  bool receiving() const { return active_; }
+  // Zahodí snímek, jehož další blok nepřišel včas
+  void expire(unsigned long now);
+
+  // Platné po BITMAP_CHUNK_COMPLETE
+  uint16_t durationS() const { return durationS_; }
+
+  BitmapReceiverStats getStats() const { return stats_; }
+
+ private:
+  BitmapChunkResult fail(const char* reason);
+  bool startFrame(const uint8_t* header);
+  bool decode(const uint8_t* data, size_t length, bool packBits);
+  bool emit(uint8_t value);
+
+  SharpDisplay& display_;
+
+  bool active_ = false;
+  uint8_t frameId_ = 0;
+  uint16_t nextChunk_ = 0;
+  unsigned long lastChunkAt_ = 0;
+  int16_t x_ = 0;
+  int16_t y_ = 0;
+  uint16_t w_ = 0;
+  uint16_t h_ = 0;
+  uint16_t durationS_ = 0;
+  uint16_t rowBytes_ = 0;
+  uint16_t row_ = 0;        // aktuální řádek oblasti
+  uint16_t rowFill_ = 0;    // bajtů v rowBuffer_
+  uint8_t rowBuffer_[MAX_ROW_BYTES];
+
+  // Stav PackBits mezi bloky (běh může pokračovat v další zprávě)
+  uint8_t literalLeft_ = 0;
+  uint8_t repeatLeft_ = 0;
+  bool repeatPending_ = false;  // čeká se na bajt k opakování
+
+  uint32_t frameBytes_ = 0;
+  uint32_t frameDecodeUs_ = 0;
+  BitmapReceiverStats stats_;
+};
@@ -0,0 +1,124 @@
+#include "DeltaPatch.h"
+
+#include <string.h>
+
+namespace {
+constexpr uint8_t OP_END = 0x00;
+constexpr uint8_t OP_COPY = 0x01;
+constexpr uint8_t OP_DATA = 0x02;
+constexpr size_t COPY_CHUNK = 256;  // kus zdroje čtený najednou při COPY
+
+uint32_t readU32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+}  // namespace
+
+bool DeltaPatcher::isDelta(const uint8_t* data, size_t length) {
+  return length >= 4 && memcmp(data, "SDLT", 4) == 0;
+}
+
+bool DeltaPatcher::fail(const char* message) {
+  error_ = message;
+  state_ = STATE_ERROR;
+  return false;
+}
+
+bool DeltaPatcher::parseHeader() {
+  if (!isDelta(header_, HEADER_BYTES)) return fail("delta: spatna hlavicka");
+  if (header_[4] != VERSION) return fail("delta: nepodporovana verze");
+  sourceSize_ = readU32(header_ + 8);
+  targetSize_ = readU32(header_ + 12);
+  if (targetSize_ == 0) return fail("delta: prazdny cil");
+  if (!check_(sourceSize_, header_ + 16)) return fail("delta: bezici firmware neodpovida zdroji delty");
+  state_ = STATE_OP;
+  return true;
+}
+
+bool DeltaPatcher::emit(const uint8_t* data, size_t length) {
+  if (written_ + length > targetSize_) return fail("delta: cil delsi nez hlavicka");
+  if (!write_(data, length)) return fail("delta: zapis selhal");
+  written_ += length;
+  return true;
+}
+
+bool DeltaPatcher::runCopy(uint32_t offset, uint32_t length) {
+  if (offset > sourceSize_ || length > sourceSize_ - offset) return fail("delta: COPY mimo zdroj");
+  uint8_t chunk[COPY_CHUNK];
+  while (length > 0) {
+    size_t n = length < COPY_CHUNK ? length : COPY_CHUNK;
+    if (!read_(offset, chunk, n)) return fail("delta: cteni zdroje selhalo");
+    if (!emit(chunk, n)) return false;
+    offset += n;
+    length -= n;
+    copied_ += n;
+  }
+  return true;
+}
+
+bool DeltaPatcher::feed(const uint8_t* data, size_t length) {
+  while (length > 0) {
+    switch (state_) {
+      case STATE_HEADER: {
+        size_t n = HEADER_BYTES - headerFill_;
+        if (n > length) n = length;
+        memcpy(header_ + headerFill_, data, n);
+        headerFill_ += n;
+        data += n;
+        length -= n;
+        if (headerFill_ == HEADER_BYTES && !parseHeader()) return false;
+        break;
+      }
+
+      case STATE_OP:
+        op_ = *data++;
+        length--;
+        if (op_ == OP_END) {
+          if (written_ != targetSize_) return fail("delta: cil kratsi nez hlavicka");
+          state_ = STATE_DONE;
+        } else if (op_ == OP_COPY || op_ == OP_DATA) {
+          argsNeeded_ = op_ == OP_COPY ? 8 : 4;
+          argsFill_ = 0;
+          state_ = STATE_ARGS;
+        } else {
+          return fail("delta: neznama operace");
+        }
+        break;
+
+      case STATE_ARGS: {
+        size_t n = argsNeeded_ - argsFill_;
+        if (n > length) n = length;
+        memcpy(args_ + argsFill_, data, n);
+        argsFill_ += n;
+        data += n;
+        length -= n;
+        if (argsFill_ < argsNeeded_) break;
+        if (op_ == OP_COPY) {
+          if (!runCopy(readU32(args_), readU32(args_ + 4))) return false;
+          state_ = STATE_OP;
+        } else {
+          dataRemaining_ = readU32(args_);
+          state_ = dataRemaining_ ? STATE_DATA : STATE_OP;
+        }
+        break;
+      }
+
+      case STATE_DATA: {
+        size_t n = dataRemaining_ < length ? dataRemaining_ : length;
+        if (!emit(data, n)) return false;
+        data += n;
+        length -= n;
+        dataRemaining_ -= n;
+        if (dataRemaining_ == 0) state_ = STATE_OP;
+        break;
+      }
+
+      case STATE_DONE:
+        return fail("delta: data za koncem");
+
+      case STATE_ERROR:
+      default:
+        return false;
+    }
+  }
+  return state_ != STATE_ERROR;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+
+// Streamovaný delta formát firmware (scripts/make_delta.py), little-endian:
+//
+//   hlavička (48 B): "SDLT", verze 1, 3 B rezerva, u32 velikost zdroje,
+//                    u32 velikost cíle, 32 B SHA-256 zdroje
+//   operace:         0x01 COPY  u32 offset, u32 délka - bajty z běžícího image
+//                    0x02 DATA  u32 délka, pak bajty - nová data
+//                    0x00 END
+//
+// Patcher dostává data po libovolných kusech (jak přijdou z HTTP) a cíl
+// vydává rovnou do zapisovače; paměť je konstantní - žádný buffer na celý
+// image ani na celou operaci. Nezávisí na Arduino/IDF API.
+class DeltaPatcher {
+ public:
+  static constexpr size_t HEADER_BYTES = 48;
+  static constexpr uint8_t VERSION = 1;
+
+  typedef std::function<bool(uint32_t sourceSize, const uint8_t* sourceSha256)> SourceCheck;
+  typedef std::function<bool(uint32_t offset, uint8_t* data, size_t length)> SourceReader;
+  typedef std::function<bool(const uint8_t* data, size_t length)> TargetWriter;
+
+  DeltaPatcher(const SourceCheck& check, const SourceReader& read, const TargetWriter& write)
+      : check_(check), read_(read), write_(write) {}
+
+  static bool isDelta(const uint8_t* data, size_t length);
+
+  // false = chyba (viz error()); po chybě další data ignoruje
+  bool feed(const uint8_t* data, size_t length);
+  bool finished() const { return state_ == STATE_DONE; }
+  const char* error() const { return error_; }
+  uint32_t targetSize() const { return targetSize_; }
+  uint32_t written() const { return written_; }
+  uint32_t copiedBytes() const { return copied_; }
+
+ private:
+  enum State : uint8_t {
+    STATE_HEADER = 0,
+    STATE_OP,
+    STATE_ARGS,
+    STATE_DATA,
+    STATE_DONE,
+    STATE_ERROR,
+  };
+
+  bool fail(const char* message);
+  bool parseHeader();
+  bool runCopy(uint32_t offset, uint32_t length);
+  bool emit(const uint8_t* data, size_t length);
+
+  SourceCheck check_;
+  SourceReader read_;
+  TargetWriter write_;
+
+  State state_ = STATE_HEADER;
+  uint8_t header_[HEADER_BYTES];
+  size_t headerFill_ = 0;
+  uint8_t op_ = 0;
+  uint8_t args_[8];
+  size_t argsFill_ = 0;
+  size_t argsNeeded_ = 0;
+  uint32_t dataRemaining_ = 0;
+
+  uint32_t sourceSize_ = 0;
+  uint32_t targetSize_ = 0;
+  uint32_t written_ = 0;
+  uint32_t copied_ = 0;
+  const char* error_ = "";
+};
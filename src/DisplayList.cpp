@@ -0,0 +1,349 @@
+#include "DisplayList.h"
+
+#include "Log.h"
+
+namespace {
+constexpr const char* STORAGE_PATH = "/display.json";
+
+const char* const TYPE_NAMES[] = {"text", "line", "rect", "bitmap", "value"};
+
+bool parseType(const char* name, DisplayElementType& type) {
+  if (!name) return false;
+  for (uint8_t i = 0; i < sizeof(TYPE_NAMES) / sizeof(TYPE_NAMES[0]); i++) {
+    if (strcmp(name, TYPE_NAMES[i]) == 0) {
+      type = (DisplayElementType)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+int8_t hexNibble(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+void copyString(char* dst, size_t size, const char* src) {
+  strncpy(dst, src ? src : "", size - 1);
+  dst[size - 1] = '\0';
+}
+}  // namespace
+
+DisplayList::~DisplayList() {
+  for (uint8_t i = 0; i < count_; i++) freeBitmap(elements_[i]);
+}
+
+void DisplayList::freeBitmap(DisplayElement& el) {
+  free(el.bitmap);
+  el.bitmap = nullptr;
+  el.bitmapBytes = 0;
+}
+
+int DisplayList::findIndex(const char* id) const {
+  for (uint8_t i = 0; i < count_; i++) {
+    if (strcmp(elements_[i].id, id) == 0) return i;
+  }
+  return -1;
+}
+
+bool DisplayList::parseElement(JsonObjectConst obj, DisplayElement& el) const {
+  if (!parseType(obj["type"] | (const char*)nullptr, el.type)) {
+    LOGW(DISP, "prvek bez platneho typu");
+    return false;
+  }
+
+  el.x = obj["x"] | 0;
+  el.y = obj["y"] | 0;
+  el.color = (obj["color"] | 0) ? 1 : 0;
+  el.size = constrain((int)(obj["size"] | 1), 1, 8);
+
+  switch (el.type) {
+    case DISPLAY_ELEM_TEXT:
+      copyString(el.text, sizeof(el.text), obj["text"] | "");
+      break;
+
+    case DISPLAY_ELEM_LINE:
+      el.x = obj["x1"] | 0;
+      el.y = obj["y1"] | 0;
+      el.x2 = obj["x2"] | 0;
+      el.y2 = obj["y2"] | 0;
+      break;
+
+    case DISPLAY_ELEM_RECT:
+      el.w = obj["w"] | 0;
+      el.h = obj["h"] | 0;
+      el.fill = obj["fill"] | false;
+      if (el.w <= 0 || el.h <= 0) return false;
+      break;
+
+    case DISPLAY_ELEM_BITMAP: {
+      el.w = obj["w"] | 0;
+      el.h = obj["h"] | 0;
+      const char* hex = obj["data"] | "";
+      size_t expected = (size_t)((el.w + 7) / 8) * (el.h > 0 ? el.h : 0);
+      if (el.w <= 0 || el.h <= 0 || expected > MAX_BITMAP_BYTES || strlen(hex) != expected * 2) {
+        LOGW(DISP, "bitmapa ma spatny rozmer nebo data");
+        return false;
+      }
+      el.bitmap = (uint8_t*)malloc(expected);
+      if (!el.bitmap) return false;
+      for (size_t i = 0; i < expected; i++) {
+        int8_t hi = hexNibble(hex[i * 2]);
+        int8_t lo = hexNibble(hex[i * 2 + 1]);
+        if (hi < 0 || lo < 0) {
+          free(el.bitmap);
+          el.bitmap = nullptr;
+          return false;
+        }
+        el.bitmap[i] = (uint8_t)((hi << 4) | lo);
+      }
+      el.bitmapBytes = expected;
+      break;
+    }
+
+    case DISPLAY_ELEM_VALUE:
+      copyString(el.key, sizeof(el.key), obj["key"] | "");
+      copyString(el.text, sizeof(el.text), obj["label"] | "");
+      el.decimals = constrain((int)(obj["decimals"] | -1), -1, 3);
+      el.showUnit = obj["unit"] | false;
+      if (!el.key[0]) return false;
+      break;
+  }
+  return true;
+}
+
+bool DisplayList::set(JsonObjectConst obj) {
+  DisplayElement el;
+  const char* id = obj["id"] | "";
+  if (id[0]) {
+    copyString(el.id, sizeof(el.id), id);
+  } else {
+    snprintf(el.id, sizeof(el.id), "_%u", autoId_++);
+  }
+  if (!parseElement(obj, el)) return false;
+
+  int index = findIndex(el.id);
+  if (index >= 0) {
+    freeBitmap(elements_[index]);
+    elements_[index] = el;  // nahrazení drží pořadí vykreslování
+    return true;
+  }
+  if (count_ >= MAX_ELEMENTS) {
+    LOGW(DISP, "seznam prvku je plny");
+    free(el.bitmap);
+    return false;
+  }
+  elements_[count_++] = el;
+  return true;
+}
+
+bool DisplayList::remove(const char* id) {
+  int index = findIndex(id);
+  if (index < 0) return false;
+  freeBitmap(elements_[index]);
+  for (uint8_t i = index; i + 1 < count_; i++) elements_[i] = elements_[i + 1];
+  elements_[--count_] = DisplayElement();
+  return true;
+}
+
+void DisplayList::clear() {
+  for (uint8_t i = 0; i < count_; i++) {
+    freeBitmap(elements_[i]);
+    elements_[i] = DisplayElement();
+  }
+  count_ = 0;
+  autoId_ = 0;
+}
+
+bool DisplayList::apply(JsonVariantConst command) {
+  bool changed = false;
+
+  if (command["clear_elements"] | false) {
+    changed = count_ > 0;
+    clear();
+  }
+
+  for (JsonVariantConst id : command["remove"].as<JsonArrayConst>()) {
+    changed |= remove(id.as<const char*>());
+  }
+
+  for (JsonVariantConst element : command["elements"].as<JsonArrayConst>()) {
+    changed |= set(element.as<JsonObjectConst>());
+  }
+
+  if (!command["persist"].isNull()) {
+    setPersistent(command["persist"] | false);
+  } else if (changed && persistent_) {
+    save();
+  }
+  return changed;
+}
+
+void DisplayList::render(Adafruit_GFX& gfx, const SensorRegistry& registry, const SensorSample& sample,
+                         const SampleText& text) const {
+  for (uint8_t i = 0; i < count_; i++) {
+    const DisplayElement& el = elements_[i];
+    switch (el.type) {
+      case DISPLAY_ELEM_TEXT:
+        gfx.setTextSize(el.size);
+        gfx.setTextColor(el.color);
+        gfx.setCursor(el.x, el.y);
+        gfx.print(el.text);
+        break;
+
+      case DISPLAY_ELEM_LINE:
+        gfx.drawLine(el.x, el.y, el.x2, el.y2, el.color);
+        break;
+
+      case DISPLAY_ELEM_RECT:
+        if (el.fill) {
+          gfx.fillRect(el.x, el.y, el.w, el.h, el.color);
+        } else {
+          gfx.drawRect(el.x, el.y, el.w, el.h, el.color);
+        }
+        break;
+
+      case DISPLAY_ELEM_BITMAP:
+        gfx.drawBitmap(el.x, el.y, el.bitmap, el.w, el.h, el.color);
+        break;
+
+      case DISPLAY_ELEM_VALUE: {
+        char buf[64];
+        int written = snprintf(buf, sizeof(buf), "%s", el.text);
+        int channelIndex = -1;
+        for (uint8_t c = 0; c < registry.channelCount(); c++) {
+          if (strcmp(registry.channel(c).key, el.key) == 0) {
+            channelIndex = c;
+            break;
+          }
+        }
+        if (channelIndex >= 0 && sample.isValid(channelIndex)) {
+          const ChannelKindInfo& info = channelKindInfo(registry.channel(channelIndex).kind);
+          if (el.decimals >= 0) {
+            written += formatFixed(sample.values[channelIndex], el.decimals, buf + written, sizeof(buf) - written);
+          } else {
+            written += snprintf(buf + written, sizeof(buf) - written, "%s", text.display(channelIndex));
+          }
+          if (el.showUnit && info.unit[0] && written < (int)sizeof(buf)) {
+            snprintf(buf + written, sizeof(buf) - written, " %s", info.unit);
+          }
+        } else {
+          snprintf(buf + written, sizeof(buf) - written, "--");
+        }
+        gfx.setTextSize(el.size);
+        gfx.setTextColor(el.color);
+        gfx.setCursor(el.x, el.y);
+        gfx.print(buf);
+        break;
+      }
+    }
+  }
+}
+
+void DisplayList::serializeElement(const DisplayElement& el, JsonObject out) const {
+  out["id"] = el.id;
+  out["type"] = TYPE_NAMES[el.type];
+  if (el.color) out["color"] = 1;
+
+  switch (el.type) {
+    case DISPLAY_ELEM_TEXT:
+      out["x"] = el.x;
+      out["y"] = el.y;
+      out["size"] = el.size;
+      out["text"] = el.text;
+      break;
+
+    case DISPLAY_ELEM_LINE:
+      out["x1"] = el.x;
+      out["y1"] = el.y;
+      out["x2"] = el.x2;
+      out["y2"] = el.y2;
+      break;
+
+    case DISPLAY_ELEM_RECT:
+      out["x"] = el.x;
+      out["y"] = el.y;
+      out["w"] = el.w;
+      out["h"] = el.h;
+      if (el.fill) out["fill"] = true;
+      break;
+
+    case DISPLAY_ELEM_BITMAP: {
+      out["x"] = el.x;
+      out["y"] = el.y;
+      out["w"] = el.w;
+      out["h"] = el.h;
+      String hex;
+      hex.reserve(el.bitmapBytes * 2);
+      char byteHex[3];
+      for (uint16_t i = 0; i < el.bitmapBytes; i++) {
+        snprintf(byteHex, sizeof(byteHex), "%02x", el.bitmap[i]);
+        hex += byteHex;
+      }
+      out["data"] = hex;
+      break;
+    }
+
+    case DISPLAY_ELEM_VALUE:
+      out["x"] = el.x;
+      out["y"] = el.y;
+      out["size"] = el.size;
+      out["key"] = el.key;
+      if (el.text[0]) out["label"] = el.text;
+      if (el.decimals >= 0) out["decimals"] = el.decimals;
+      if (el.showUnit) out["unit"] = true;
+      break;
+  }
+}
+
+void DisplayList::begin(fs::FS& fs) {
+  fs_ = &fs;
+  if (!fs_->exists(STORAGE_PATH)) return;
+
+  File file = fs_->open(STORAGE_PATH, FILE_READ);
+  if (!file) return;
+  JsonDocument doc;
+  DeserializationError err = deserializeJson(doc, file);
+  file.close();
+  if (err) {
+    LOGW(DISP, "%s je poskozeny (%s)", STORAGE_PATH, err.c_str());
+    return;
+  }
+
+  for (JsonVariantConst element : doc["elements"].as<JsonArrayConst>()) {
+    set(element.as<JsonObjectConst>());
+  }
+  autoId_ = doc["next_auto_id"] | 0;
+  persistent_ = true;
+  LOGI(DISP, "obnoveno %u prvku", count_);
+}
+
+bool DisplayList::save() {
+  if (!fs_) return false;
+  JsonDocument doc;
+  JsonArray out = doc["elements"].to<JsonArray>();
+  for (uint8_t i = 0; i < count_; i++) {
+    serializeElement(elements_[i], out.add<JsonObject>());
+  }
+  doc["next_auto_id"] = autoId_;
+
+  File file = fs_->open(STORAGE_PATH, FILE_WRITE);
+  if (!file) {
+    LOGW(DISP, "nelze ulozit seznam prvku");
+    return false;
+  }
+  serializeJson(doc, file);
+  file.close();
+  return true;
+}
+
+void DisplayList::setPersistent(bool persistent) {
+  persistent_ = persistent;
+  if (persistent_) {
+    save();
+  } else if (fs_ && fs_->exists(STORAGE_PATH)) {
+    fs_->remove(STORAGE_PATH);
+  }
+}
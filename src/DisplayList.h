@@ -0,0 +1,80 @@
+#pragma once
+
+#include <Adafruit_GFX.h>
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <FS.h>
+
+#include "SampleText.h"
+#include "SensorRegistry.h"
+
+enum DisplayElementType : uint8_t {
+  DISPLAY_ELEM_TEXT = 0,
+  DISPLAY_ELEM_LINE,
+  DISPLAY_ELEM_RECT,
+  DISPLAY_ELEM_BITMAP,
+  DISPLAY_ELEM_VALUE,  // živá hodnota kanálu podle klíče ("co2", "pm25_sen66_2")
+};
+
+struct DisplayElement {
+  char id[16] = {0};
+  DisplayElementType type = DISPLAY_ELEM_TEXT;
+  int16_t x = 0;
+  int16_t y = 0;
+  int16_t x2 = 0;  // line
+  int16_t y2 = 0;
+  int16_t w = 0;   // rect, bitmap
+  int16_t h = 0;
+  uint8_t size = 1;
+  uint8_t color = 0;  // 0 = černá, 1 = bílá
+  bool fill = false;
+  int8_t decimals = -1;  // value: -1 = podle kanálu
+  bool showUnit = false;
+  char text[48] = {0};   // text, u value popisek před hodnotou
+  char key[24] = {0};
+  uint8_t* bitmap = nullptr;  // 1 bpp, MSB first, řádky zarovnané na bajt
+  uint16_t bitmapBytes = 0;
+};
+
+// Trvalý seznam prvků kreslených přes aktuální obrazovku (dashboard i
+// override). MQTT příkazy prvky přidávají, nahrazují a mažou podle id;
+// změna se projeví jedním překreslením, ve kterém se na panel pošlou
+// jen změněné řádky.
+class DisplayList {
+ public:
+  static constexpr uint8_t MAX_ELEMENTS = 32;
+  static constexpr uint16_t MAX_BITMAP_BYTES = 1024;
+
+  ~DisplayList();
+
+  // {"elements":[{...}]}, {"remove":["id"]}, {"clear_elements":true}, {"persist":true}
+  // Vrací true, pokud se seznam změnil
+  bool apply(JsonVariantConst command);
+  bool set(JsonObjectConst element);
+  bool remove(const char* id);
+  void clear();
+
+  // Hodnoty kanálů s výchozí přesností bere z hotových textů vzorku (SampleText)
+  void render(Adafruit_GFX& gfx, const SensorRegistry& registry, const SensorSample& sample,
+              const SampleText& text) const;
+
+  // Načte uložený seznam; další změny se ukládají, jen pokud je zapnuté persist
+  void begin(fs::FS& fs);
+  bool persistent() const { return persistent_; }
+
+  uint8_t size() const { return count_; }
+
+ private:
+  bool save();
+  void setPersistent(bool persistent);
+  int findIndex(const char* id) const;
+  bool parseElement(JsonObjectConst obj, DisplayElement& el) const;
+  void serializeElement(const DisplayElement& el, JsonObject out) const;
+  static void freeBitmap(DisplayElement& el);
+
+  DisplayElement elements_[MAX_ELEMENTS];
+  uint8_t count_ = 0;
+  uint16_t autoId_ = 0;
+  fs::FS* fs_ = nullptr;
+  bool persistent_ = false;
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Řetězec s pevnou kapacitou uloženou přímo v objektu - žádná alokace na
+// heapu, takže dlouhý běh nefragmentuje paměť jako Arduino String.
+// Zápisy jsou kontrolované: co se nevejde, vrátí false a obsah nezmění
+// (append/appendf připojí, co se vejde, a vrátí false).
+template <size_t N>
+class FixedString {
+ public:
+  static_assert(N > 0 && N < 65535, "FixedString: kapacita 1..65534");
+
+  FixedString() { data_[0] = '\0'; }
+  explicit FixedString(const char* s) {
+    data_[0] = '\0';
+    assign(s);
+  }
+
+  bool assign(const char* s) { return assign(s, s ? strlen(s) : 0); }
+  bool assign(const char* s, size_t length) {
+    if (length > N) return false;
+    if (length) memmove(data_, s, length);
+    data_[length] = '\0';
+    length_ = (uint16_t)length;
+    return true;
+  }
+
+  bool append(const char* s) { return append(s, s ? strlen(s) : 0); }
+  bool append(const char* s, size_t length) {
+    size_t room = N - length_;
+    bool fits = length <= room;
+    if (!fits) length = room;
+    memcpy(data_ + length_, s, length);
+    length_ += (uint16_t)length;
+    data_[length_] = '\0';
+    return fits;
+  }
+  bool append(char c) { return append(&c, 1); }
+
+  bool appendf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(data_ + length_, N + 1 - length_, format, args);
+    va_end(args);
+    if (written < 0) {
+      data_[length_] = '\0';
+      return false;
+    }
+    bool fits = (size_t)written <= N - length_;
+    length_ = fits ? length_ + written : N;
+    return fits;
+  }
+
+  bool assignf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+    char buffer[N + 1];
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (written < 0 || (size_t)written > N) return false;
+    return assign(buffer, written);
+  }
+
+  void clear() {
+    length_ = 0;
+    data_[0] = '\0';
+  }
+
+  const char* c_str() const { return data_; }
+  size_t length() const { return length_; }
+  bool isEmpty() const { return length_ == 0; }
+  static constexpr size_t capacity() { return N; }
+
+  bool operator==(const char* s) const { return s && strcmp(data_, s) == 0; }
+  bool operator!=(const char* s) const { return !(*this == s); }
+
+ private:
+  uint16_t length_ = 0;
+  char data_[N + 1];
+};
@@ -0,0 +1,289 @@
+#include "HttpServer.h"
+
+#include "Log.h"
+
+namespace {
+constexpr uint16_t MAX_OPEN_SOCKETS = 4;
+constexpr uint16_t SOCKET_TIMEOUT_S = 5;
+constexpr uint32_t BODY_DEADLINE_MS = 10000;  // celé tělo, i když klient posílá po bajtech
+constexpr size_t TASK_STACK_BYTES = 10240;
+
+const char* statusText(int code) {
+  switch (code) {
+    case 200: return "200 OK";
+    case 202: return "202 Accepted";
+    case 204: return "204 No Content";
+    case 302: return "302 Found";
+    case 304: return "304 Not Modified";
+    case 400: return "400 Bad Request";
+    case 404: return "404 Not Found";
+    case 408: return "408 Request Timeout";
+    case 413: return "413 Payload Too Large";
+    case 503: return "503 Service Unavailable";
+    default:  return "500 Internal Server Error";
+  }
+}
+
+void urlDecode(char* s) {
+  char* out = s;
+  for (char* in = s; *in; in++) {
+    if (*in == '+') {
+      *out++ = ' ';
+    } else if (*in == '%' && isxdigit((unsigned char)in[1]) && isxdigit((unsigned char)in[2])) {
+      char hex[3] = {in[1], in[2], 0};
+      *out++ = (char)strtol(hex, nullptr, 16);
+      in += 2;
+    } else {
+      *out++ = *in;
+    }
+  }
+  *out = '\0';
+}
+}  // namespace
+
+HttpServer* HttpServer::instance_ = nullptr;
+
+void HttpServer::on(const char* uri, httpd_method_t method, THandlerFunction handler) {
+  if (routeCount_ >= MAX_ROUTES) {
+    LOGW(WEB, "prilis mnoho rout, %s vynechana", uri);
+    return;
+  }
+  Route& route = routes_[routeCount_++];
+  route.uri = uri;
+  route.method = method;
+  route.handler = handler;
+}
+
+void HttpServer::onAny(const char* uri, THandlerFunction handler) {
+  on(uri, HTTP_GET, handler);
+  on(uri, HTTP_POST, handler);
+}
+
+bool HttpServer::begin() {
+  instance_ = this;
+
+  httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+  config.server_port = port_;
+  config.stack_size = TASK_STACK_BYTES;
+  config.max_open_sockets = MAX_OPEN_SOCKETS;
+  config.max_uri_handlers = MAX_ROUTES;
+  config.lru_purge_enable = true;  // plné sloty -> zavřít nejdéle nečinné spojení
+  config.recv_wait_timeout = SOCKET_TIMEOUT_S;
+  config.send_wait_timeout = SOCKET_TIMEOUT_S;
+
+  esp_err_t err = httpd_start(&handle_, &config);
+  if (err != ESP_OK) {
+    LOGE(WEB, "httpd_start selhal (%s)", esp_err_to_name(err));
+    return false;
+  }
+
+  for (uint8_t i = 0; i < routeCount_; i++) {
+    httpd_uri_t uri = {};
+    uri.uri = routes_[i].uri;
+    uri.method = routes_[i].method;
+    uri.handler = dispatch;
+    uri.user_ctx = &routes_[i];
+    httpd_register_uri_handler(handle_, &uri);
+  }
+  httpd_register_err_handler(handle_, HTTPD_404_NOT_FOUND, dispatchNotFound);
+  return true;
+}
+
+esp_err_t HttpServer::dispatch(httpd_req_t* req) {
+  const Route* route = (const Route*)req->user_ctx;
+  return instance_->run(req, route->handler);
+}
+
+esp_err_t HttpServer::dispatchNotFound(httpd_req_t* req, httpd_err_code_t error) {
+  instance_->notFoundCount_++;
+  if (!instance_->notFound_) {
+    httpd_resp_send_err(req, error, "Not found");
+    return ESP_OK;
+  }
+  return instance_->run(req, instance_->notFound_);
+}
+
+esp_err_t HttpServer::run(httpd_req_t* req, const THandlerFunction& handler) {
+  uint32_t startUs = micros();
+  requests_++;
+
+  req_ = req;
+  headerCount_ = 0;
+  contentType_ = "";
+  chunked_ = false;
+  headersSent_ = false;
+  responded_ = false;
+  body_ = "";
+  query_[0] = '\0';
+
+  size_t queryLen = httpd_req_get_url_query_len(req);
+  if (queryLen > 0 && queryLen < sizeof(query_)) {
+    httpd_req_get_url_query_str(req, query_, sizeof(query_));
+  }
+
+  // Tělo se čte celé předem, ale jen do limitu
+  if (req->content_len > MAX_BODY) {
+    rejected_++;
+    httpd_resp_set_status(req, statusText(413));
+    httpd_resp_send(req, "Request too large", HTTPD_RESP_USE_STRLEN);
+    req_ = nullptr;
+    return ESP_OK;
+  }
+  if (req->content_len > 0) {
+    char buf[256];
+    size_t remaining = req->content_len;
+    uint32_t bodyStartMs = millis();
+    body_.reserve(req->content_len);
+    while (remaining > 0) {
+      int received = httpd_req_recv(req, buf, remaining < sizeof(buf) ? remaining : sizeof(buf));
+      if (received == HTTPD_SOCK_ERR_TIMEOUT) {
+        if (millis() - bodyStartMs < BODY_DEADLINE_MS) continue;
+        // Klient tělo nedoposlal: slot serveru se nesmí držet donekonečna
+        rejected_++;
+        httpd_resp_set_status(req, statusText(408));
+        httpd_resp_send(req, "Request timeout", HTTPD_RESP_USE_STRLEN);
+        req_ = nullptr;
+        return ESP_FAIL;
+      }
+      if (received <= 0) {
+        rejected_++;
+        req_ = nullptr;
+        return ESP_FAIL;  // server zavře spojení
+      }
+      body_.concat(buf, received);
+      remaining -= received;
+    }
+  }
+
+  uint32_t lockStartUs = micros();
+  lockState();
+  uint32_t lockWaitUs = micros() - lockStartUs;
+  if (lockWaitUs > lockWaitMaxUs_) lockWaitMaxUs_ = lockWaitUs;
+
+  handler();
+
+  if (chunked_ && headersSent_ && !responded_) {
+    sendContent("", 0);
+  } else if (!responded_) {
+    send(500, "text/plain", "Handler bez odpovedi");
+  }
+  unlockState();
+
+  req_ = nullptr;
+  uint32_t elapsed = micros() - startUs;
+  handlerUsTotal_ += elapsed;
+  if (elapsed > handlerMaxUs_) handlerMaxUs_ = elapsed;
+  return ESP_OK;
+}
+
+void HttpServer::lockState() {
+  if (lock_) xSemaphoreTake(lock_, portMAX_DELAY);
+}
+
+void HttpServer::unlockState() {
+  if (lock_) xSemaphoreGive(lock_);
+}
+
+String HttpServer::arg(const char* name) const {
+  if (strcmp(name, "plain") == 0) return body_;
+  char value[128];
+  if (httpd_query_key_value(query_, name, value, sizeof(value)) != ESP_OK) return String();
+  urlDecode(value);
+  return String(value);
+}
+
+bool HttpServer::hasArg(const char* name) const {
+  if (strcmp(name, "plain") == 0) return body_.length() > 0;
+  char value[128];
+  return httpd_query_key_value(query_, name, value, sizeof(value)) == ESP_OK;
+}
+
+String HttpServer::header(const char* name) const {
+  if (!req_) return String();
+  char value[128];
+  size_t len = httpd_req_get_hdr_value_len(req_, name);
+  if (len == 0 || len >= sizeof(value)) return String();
+  if (httpd_req_get_hdr_value_str(req_, name, value, sizeof(value)) != ESP_OK) return String();
+  return String(value);
+}
+
+String HttpServer::uri() const {
+  if (!req_) return String();
+  String path = req_->uri;
+  int q = path.indexOf('?');
+  return q >= 0 ? path.substring(0, q) : path;
+}
+
+void HttpServer::sendHeader(const String& name, const String& value, bool first) {
+  (void)first;
+  if (headerCount_ >= MAX_HEADERS) return;
+  headerNames_[headerCount_] = name;
+  headerValues_[headerCount_] = value;
+  headerCount_++;
+}
+
+void HttpServer::setContentLength(size_t length) {
+  chunked_ = length == CONTENT_LENGTH_UNKNOWN;
+}
+
+void HttpServer::beginResponse(int code, const char* contentType) {
+  // esp_http_server si drží jen ukazatele - řetězce musí žít do odeslání
+  httpd_resp_set_status(req_, statusText(code));
+  if (contentType && *contentType) {
+    contentType_ = contentType;
+    httpd_resp_set_type(req_, contentType_.c_str());
+  }
+  for (uint8_t i = 0; i < headerCount_; i++) {
+    httpd_resp_set_hdr(req_, headerNames_[i].c_str(), headerValues_[i].c_str());
+  }
+}
+
+void HttpServer::send(int code, const char* contentType, const String& content) {
+  if (!req_ || responded_ || headersSent_) return;
+  beginResponse(code, contentType);
+
+  if (chunked_) {
+    // Hlavičky odejdou s prvním blokem
+    headersSent_ = true;
+    if (content.length()) sendContent(content.c_str(), content.length());
+    return;
+  }
+
+  unlockState();
+  httpd_resp_send(req_, content.c_str(), content.length());
+  lockState();
+  responded_ = true;
+}
+
+void HttpServer::send_P(int code, const char* contentType, const char* content, size_t length) {
+  if (!req_ || responded_ || headersSent_) return;
+  beginResponse(code, contentType);
+  unlockState();
+  httpd_resp_send(req_, content, length);
+  lockState();
+  responded_ = true;
+}
+
+void HttpServer::sendContent(const char* content, size_t length) {
+  if (!req_ || !chunked_ || responded_) return;
+  headersSent_ = true;
+  unlockState();
+  httpd_resp_send_chunk(req_, length ? content : nullptr, length);
+  lockState();
+  if (length == 0) responded_ = true;
+}
+
+void HttpServer::sendContent(const String& content) {
+  sendContent(content.c_str(), content.length());
+}
+
+HttpServerStats HttpServer::getStats() const {
+  HttpServerStats stats;
+  stats.requests = requests_;
+  stats.rejected = rejected_;
+  stats.notFound = notFoundCount_;
+  stats.handlerAvgUs = requests_ ? (uint32_t)(handlerUsTotal_ / requests_) : 0;
+  stats.handlerMaxUs = handlerMaxUs_;
+  stats.lockWaitMaxUs = lockWaitMaxUs_;
+  return stats;
+}
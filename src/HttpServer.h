@@ -0,0 +1,105 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_http_server.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include <functional>
+
+#ifndef CONTENT_LENGTH_UNKNOWN
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#endif
+
+struct HttpServerStats {
+  uint32_t requests = 0;
+  uint32_t rejected = 0;      // příliš velké tělo / chyba nebo timeout příjmu
+  uint32_t notFound = 0;
+  uint32_t handlerAvgUs = 0;  // čas v handleru včetně zápisu do socketu
+  uint32_t handlerMaxUs = 0;
+  uint32_t lockWaitMaxUs = 0; // jak dlouho požadavek čekal, než loop() uvolnil stav
+};
+
+// HTTP server nad esp_http_server. Běží ve vlastním FreeRTOS tasku a drží
+// několik spojení najednou (omezený počet slotů, LRU uvolnění, timeouty
+// socketu, limit velikosti těla), takže pomalý klient neblokuje loop().
+// API kopíruje podmnožinu WebServer, kterou používá main.cpp.
+//
+// Handlery běží postupně v tasku serveru se zamčeným sdíleným stavem
+// (setStateLock); zámek se uvolňuje jen během zápisu do socketu.
+class HttpServer {
+ public:
+  typedef std::function<void(void)> THandlerFunction;
+
+  explicit HttpServer(uint16_t port) : port_(port) {}
+
+  void setStateLock(SemaphoreHandle_t lock) { lock_ = lock; }
+  void on(const char* uri, httpd_method_t method, THandlerFunction handler);
+  void onAny(const char* uri, THandlerFunction handler);  // GET i POST
+  void onNotFound(THandlerFunction handler) { notFound_ = handler; }
+  bool begin();
+
+  // Jen uvnitř handleru - vztahuje se k aktuálnímu požadavku
+  String arg(const char* name) const;  // "plain" = tělo požadavku
+  bool hasArg(const char* name) const;
+  String header(const char* name) const;
+  String uri() const;
+
+  void sendHeader(const String& name, const String& value, bool first = false);
+  void setContentLength(size_t length);
+  void send(int code, const char* contentType = nullptr, const String& content = String());
+  void send_P(int code, const char* contentType, const char* content, size_t length);
+  void sendContent(const char* content, size_t length);
+  void sendContent(const String& content);
+
+  HttpServerStats getStats() const;
+
+ private:
+  static constexpr uint8_t MAX_ROUTES = 32;
+  static constexpr uint8_t MAX_HEADERS = 6;
+  static constexpr size_t MAX_BODY = 4096;
+  static constexpr size_t MAX_QUERY = 256;
+
+  struct Route {
+    const char* uri = nullptr;
+    httpd_method_t method = HTTP_GET;
+    THandlerFunction handler;
+  };
+
+  static esp_err_t dispatch(httpd_req_t* req);
+  static esp_err_t dispatchNotFound(httpd_req_t* req, httpd_err_code_t error);
+
+  esp_err_t run(httpd_req_t* req, const THandlerFunction& handler);
+  void beginResponse(int code, const char* contentType);
+  void lockState();
+  void unlockState();
+
+  static HttpServer* instance_;
+
+  uint16_t port_;
+  httpd_handle_t handle_ = nullptr;
+  SemaphoreHandle_t lock_ = nullptr;
+
+  Route routes_[MAX_ROUTES];
+  uint8_t routeCount_ = 0;
+  THandlerFunction notFound_;
+
+  // Stav aktuálního požadavku
+  httpd_req_t* req_ = nullptr;
+  char query_[MAX_QUERY] = {0};
+  String body_;
+  String headerNames_[MAX_HEADERS];
+  String headerValues_[MAX_HEADERS];
+  uint8_t headerCount_ = 0;
+  String contentType_;
+  bool chunked_ = false;
+  bool headersSent_ = false;
+  bool responded_ = false;
+
+  uint32_t requests_ = 0;
+  uint32_t rejected_ = 0;
+  uint32_t notFoundCount_ = 0;
+  uint64_t handlerUsTotal_ = 0;
+  uint32_t handlerMaxUs_ = 0;
+  uint32_t lockWaitMaxUs_ = 0;
+};
@@ -0,0 +1,64 @@
+#include "JsonPool.h"
+
+#include <string.h>
+
+void* JsonPool::allocate(size_t size) {
+  size_t rounded = (size + ALIGN - 1) & ~(ALIGN - 1);
+  if (size == 0 || size > CAPACITY || HEADER + rounded > CAPACITY - top_) {
+    failures_++;
+    return nullptr;
+  }
+  uint8_t* block = buffer_ + top_;
+  memcpy(block, &rounded, sizeof(rounded));
+  lastBlock_ = top_;
+  top_ += HEADER + rounded;
+  if (top_ > peak_) peak_ = top_;
+  live_++;
+  allocations_++;
+  return block + HEADER;
+}
+
+size_t JsonPool::blockSize(void* p) const {
+  size_t size;
+  memcpy(&size, (uint8_t*)p - HEADER, sizeof(size));
+  return size;
+}
+
+void JsonPool::deallocate(void* p) {
+  if (!p || live_ == 0) return;
+  // Poslední blok vrátit hned (ArduinoJson tak zkracuje řetězce a pooly)
+  if ((uint8_t*)p - HEADER == buffer_ + lastBlock_ && top_ == lastBlock_ + HEADER + blockSize(p)) top_ = lastBlock_;
+  if (--live_ == 0) top_ = 0;
+}
+
+void* JsonPool::reallocate(void* p, size_t size) {
+  if (!p) return allocate(size);
+  size_t old = blockSize(p);
+  size_t rounded = (size + ALIGN - 1) & ~(ALIGN - 1);
+  // Poslední blok roste nebo se zmenšuje na místě
+  if ((uint8_t*)p - HEADER == buffer_ + lastBlock_ && top_ == lastBlock_ + HEADER + old) {
+    if (size == 0 || size > CAPACITY || HEADER + rounded > CAPACITY - lastBlock_) {
+      failures_++;
+      return nullptr;
+    }
+    memcpy(buffer_ + lastBlock_, &rounded, sizeof(rounded));
+    top_ = lastBlock_ + HEADER + rounded;
+    if (top_ > peak_) peak_ = top_;
+    return p;
+  }
+  // Zmenšení uprostřed poolu: místo zůstane do uvolnění celého poolu
+  if (rounded <= old && size > 0) return p;
+  void* moved = allocate(size);
+  if (!moved) return nullptr;  // původní blok zůstává platný
+  memcpy(moved, p, old);
+  deallocate(p);
+  return moved;
+}
+
+JsonPoolStats JsonPool::getStats() const {
+  JsonPoolStats stats;
+  stats.allocations = allocations_;
+  stats.failures = failures_;
+  stats.peakBytes = (uint32_t)peak_;
+  return stats;
+}
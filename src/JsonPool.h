@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct JsonPoolStats {
+  uint32_t allocations = 0;
+  uint32_t failures = 0;  // pool plný - dokument je přetečený a odpověď se nepošle
+  uint32_t peakBytes = 0;
+};
+
+// Pevný pool pro dokumenty ArduinoJson (přes Allocator v main.cpp), takže
+// sestavení odpovědí API nejde na heap. Přiděluje se od začátku bufferu;
+// uvolní se jen poslední blok a celý pool, jakmile nic nežije - dokumenty
+// jsou krátké a žijí jeden handler. Není vláknově bezpečný: používá se jen
+// se zámkem stavu (loop() a web handlery).
+class JsonPool {
+ public:
+  static constexpr size_t CAPACITY = 6144;  // /api/data s TMEP URL ~2.5 KB, /api/config ~3 KB
+
+  void* allocate(size_t size);
+  void deallocate(void* p);
+  void* reallocate(void* p, size_t size);
+
+  size_t used() const { return top_; }
+  uint16_t live() const { return live_; }
+  JsonPoolStats getStats() const;
+
+ private:
+  static constexpr size_t ALIGN = 8;
+  static constexpr size_t HEADER = ALIGN;  // délka bloku před daty (kvůli reallocate)
+
+  size_t blockSize(void* p) const;
+
+  alignas(ALIGN) uint8_t buffer_[CAPACITY];
+  size_t top_ = 0;
+  size_t lastBlock_ = 0;  // offset hlavičky posledního bloku
+  uint16_t live_ = 0;
+
+  uint32_t allocations_ = 0;
+  uint32_t failures_ = 0;
+  size_t peak_ = 0;
+};
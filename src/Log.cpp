@@ -0,0 +1,274 @@
+#include "Log.h"
+
+Logger logger;
+
+namespace {
+constexpr uint32_t TASK_STACK_BYTES = 4096;
+constexpr uint8_t MQTT_QUEUE_DEPTH = 8;
+constexpr size_t MQTT_LINE_BYTES = 128;
+
+const char* const MODULE_TAGS[LOG_MODULE_COUNT] = {
+    "MAIN", "CFG", "SENS", "MQTT", "HA", "TMEP", "WEB", "WIFI", "DISP", "HIST", "POWER", "ALARM", "OTA",
+};
+const char LEVEL_CHARS[] = {'-', 'E', 'W', 'I', 'D'};
+
+// Formátuje záznam podle jeho formátu: každá konverze se předá snprintf
+// zvlášť s hodnotou správného typu vytaženou z args[]
+size_t formatRecord(const LogRecord& record, char* out, size_t size) {
+  size_t pos = 0;
+  uint8_t arg = 0;
+  auto next32 = [&]() -> uint32_t { return arg < record.argCount ? record.args[arg++] : 0; };
+  auto append = [&](int written) {
+    if (written > 0) pos += (size_t)written < size - pos ? (size_t)written : size - pos - 1;
+  };
+
+  for (const char* p = record.format; *p && pos + 1 < size; p++) {
+    if (*p != '%') {
+      out[pos++] = *p;
+      continue;
+    }
+    if (p[1] == '%') {
+      out[pos++] = '%';
+      p++;
+      continue;
+    }
+
+    // %[flags][width][.precision][length]conversion
+    char spec[24] = "%";
+    size_t specLen = 1;
+    bool wide = false;
+    p++;
+    while (*p && strchr("-+ #0", *p) && specLen < 8) spec[specLen++] = *p++;
+    for (int part = 0; part < 2; part++) {
+      if (part == 1) {
+        if (*p != '.') break;
+        spec[specLen++] = *p++;
+      }
+      if (*p == '*') {
+        specLen += snprintf(spec + specLen, sizeof(spec) - specLen, "%d", (int)next32());
+        p++;
+      }
+      while (isdigit((unsigned char)*p) && specLen < 16) spec[specLen++] = *p++;
+    }
+    while (*p && strchr("hlLzjt", *p)) {
+      if (*p == 'l' && p[1] == 'l') wide = true;
+      p++;
+    }
+    if (!*p) break;
+
+    // Délkové modifikátory se zahazují; 64bit hodnoty se předávají jako long long
+    char conversion = *p;
+    wide = wide && strchr("diuxXo", conversion);
+    if (wide) {
+      spec[specLen++] = 'l';
+      spec[specLen++] = 'l';
+    }
+    spec[specLen++] = conversion;
+    spec[specLen] = '\0';
+
+    switch (conversion) {
+      case 'd':
+      case 'i':
+        if (wide) {
+          uint64_t lo = next32();
+          int64_t value = (int64_t)(lo | ((uint64_t)next32() << 32));
+          append(snprintf(out + pos, size - pos, spec, (long long)value));
+        } else {
+          append(snprintf(out + pos, size - pos, spec, (int)next32()));
+        }
+        break;
+      case 'u':
+      case 'x':
+      case 'X':
+      case 'o':
+      case 'c':
+        if (wide) {
+          uint64_t lo = next32();
+          uint64_t value = lo | ((uint64_t)next32() << 32);
+          append(snprintf(out + pos, size - pos, spec, (unsigned long long)value));
+        } else {
+          append(snprintf(out + pos, size - pos, spec, (unsigned)next32()));
+        }
+        break;
+      case 'f':
+      case 'F':
+      case 'e':
+      case 'E':
+      case 'g':
+      case 'G': {
+        uint32_t bits = next32();
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        append(snprintf(out + pos, size - pos, spec, (double)value));
+        break;
+      }
+      case 's': {
+        uint32_t offset = next32();
+        const char* s = offset < record.textLength ? record.text + offset : "";
+        append(snprintf(out + pos, size - pos, spec, s));
+        break;
+      }
+      case 'p':
+        append(snprintf(out + pos, size - pos, spec, (void*)(uintptr_t)next32()));
+        break;
+      default:
+        break;
+    }
+  }
+  out[pos] = '\0';
+  return pos;
+}
+}  // namespace
+
+void LogPacker::putString(const char* s) {
+  if (!s) s = "(null)";
+  uint8_t offset = record_.textLength;
+  if (offset >= LOG_TEXT_BYTES) {
+    put32(LOG_TEXT_BYTES);  // mimo text[] = prázdný řetězec
+    return;
+  }
+  size_t room = LOG_TEXT_BYTES - offset - 1;
+  size_t length = strnlen(s, room);
+  memcpy(record_.text + offset, s, length);
+  record_.text[offset + length] = '\0';
+  record_.textLength = offset + length + 1;
+  put32(offset);
+}
+
+Logger::Logger() {
+  for (uint32_t i = 0; i < RING_SLOTS; i++) slots_[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+void Logger::begin() {
+  if (task_) return;
+  tailLock_ = xSemaphoreCreateMutex();
+  mqttQueue_ = xQueueCreate(MQTT_QUEUE_DEPTH, MQTT_LINE_BYTES);
+  // Stejná priorita jako loop(): výstup na Serial blokuje jen tento task
+  xTaskCreate(drainTask, "log", TASK_STACK_BYTES, this, tskIDLE_PRIORITY + 1, &task_);
+}
+
+// Vyukovova omezená fronta: slot je volný, když jeho sekvence == pozice zápisu
+Logger::Slot* Logger::claim() {
+  uint32_t pos = head_.load(std::memory_order_relaxed);
+  for (;;) {
+    Slot* slot = &slots_[pos & (RING_SLOTS - 1)];
+    int32_t diff = (int32_t)(slot->sequence.load(std::memory_order_acquire) - pos);
+    if (diff == 0) {
+      if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return slot;
+    } else if (diff < 0) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    } else {
+      pos = head_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+void Logger::commit(Slot* slot, uint32_t startCycles) {
+  uint32_t pos = slot->sequence.load(std::memory_order_relaxed);
+  slot->sequence.store(pos + 1, std::memory_order_release);
+  if (task_) xTaskNotifyGive(task_);
+
+  uint32_t cycles = ESP.getCycleCount() - startCycles;
+  records_.fetch_add(1, std::memory_order_relaxed);
+  // Jen orientační měření - občasná ztráta při souběhu dvou zapisovatelů nevadí
+  writeCyclesTotal_ += cycles;
+  if (cycles > writeMaxCycles_) writeMaxCycles_ = cycles;
+}
+
+bool Logger::drainOne() {
+  Slot* slot = &slots_[tail_ & (RING_SLOTS - 1)];
+  if (slot->sequence.load(std::memory_order_acquire) != tail_ + 1) return false;
+
+  uint32_t startUs = micros();
+  const LogRecord& record = slot->record;
+  char line[LINE_BYTES];
+  size_t length = snprintf(line, sizeof(line), "[%5lu.%03lu] %c %s: ", (unsigned long)(record.timestamp / 1000),
+                           (unsigned long)(record.timestamp % 1000), LEVEL_CHARS[record.level <= LOG_LEVEL_DEBUG ? record.level : 0],
+                           record.module < LOG_MODULE_COUNT ? MODULE_TAGS[record.module] : "?");
+  length += formatRecord(record, line + length, sizeof(line) - length - 1);
+  uint8_t level = record.level;
+
+  // Slot je přečtený - uvolnit ho zapisovatelům ještě před pomalým výstupem
+  slot->sequence.store(tail_ + RING_SLOTS, std::memory_order_release);
+  tail_++;
+
+  line[length++] = '\n';
+  Serial.write((const uint8_t*)line, length);
+  appendTail(line, length);
+  if (level <= LOG_MQTT_LEVEL && mqttQueue_) {
+    char mqttLine[MQTT_LINE_BYTES];
+    size_t mqttLength = length - 1 < sizeof(mqttLine) - 1 ? length - 1 : sizeof(mqttLine) - 1;
+    memcpy(mqttLine, line, mqttLength);
+    mqttLine[mqttLength] = '\0';
+    xQueueSend(mqttQueue_, mqttLine, 0);  // plná fronta = řádek jen na Serial a do /api/log
+  }
+
+  uint32_t elapsed = micros() - startUs;
+  drainUsTotal_ += elapsed;
+  drainCount_++;
+  if (elapsed > drainMaxUs_) drainMaxUs_ = elapsed;
+  return true;
+}
+
+void Logger::drainTask(void* arg) {
+  Logger* self = (Logger*)arg;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    while (self->drainOne()) {
+    }
+
+    uint32_t dropped = self->dropped_.load(std::memory_order_relaxed);
+    if (dropped != self->reportedDropped_) {
+      char line[64];
+      size_t length = snprintf(line, sizeof(line), "LOG: zahozeno %lu zaznamu (plny kruh)\n",
+                               (unsigned long)(dropped - self->reportedDropped_));
+      self->reportedDropped_ = dropped;
+      Serial.write((const uint8_t*)line, length);
+      self->appendTail(line, length);
+    }
+  }
+}
+
+void Logger::appendTail(const char* line, size_t length) {
+  if (!tailLock_) return;
+  xSemaphoreTake(tailLock_, portMAX_DELAY);
+  for (size_t i = 0; i < length; i++) tailBuffer_[(tailWritten_ + i) % TAIL_BYTES] = line[i];
+  tailWritten_ += length;
+  xSemaphoreGive(tailLock_);
+}
+
+void Logger::readTail(const std::function<void(const char* data, size_t length)>& sink) {
+  if (!tailLock_) return;
+  // Kopie kvůli zámku - sink může zapisovat do socketu
+  static char copy[TAIL_BYTES];
+  xSemaphoreTake(tailLock_, portMAX_DELAY);
+  size_t length = tailWritten_ < TAIL_BYTES ? tailWritten_ : TAIL_BYTES;
+  size_t start = tailWritten_ - length;
+  for (size_t i = 0; i < length; i++) copy[i] = tailBuffer_[(start + i) % TAIL_BYTES];
+  xSemaphoreGive(tailLock_);
+
+  // Začít na celém řádku
+  size_t skip = 0;
+  if (tailWritten_ > TAIL_BYTES) {
+    while (skip < length && copy[skip] != '\n') skip++;
+    if (skip < length) skip++;
+  }
+  sink(copy + skip, length - skip);
+}
+
+bool Logger::takeMqttLine(char* line, size_t size) {
+  if (!mqttQueue_ || size < MQTT_LINE_BYTES) return false;
+  return xQueueReceive(mqttQueue_, line, 0) == pdTRUE;
+}
+
+LogStats Logger::getStats() const {
+  LogStats stats;
+  stats.records = records_.load(std::memory_order_relaxed);
+  stats.dropped = dropped_.load(std::memory_order_relaxed);
+  stats.writeAvgCycles = stats.records ? (uint32_t)(writeCyclesTotal_ / stats.records) : 0;
+  stats.writeMaxCycles = writeMaxCycles_;
+  stats.drainAvgUs = drainCount_ ? (uint32_t)(drainUsTotal_ / drainCount_) : 0;
+  stats.drainMaxUs = drainMaxUs_;
+  return stats;
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <functional>
+#include <type_traits>
+
+// Úroveň a moduly se filtrují při překladu (build_flags -DLOG_LEVEL=..,
+// -DLOG_MODULES=..): vypnutý LOGx() je konstantně nepravdivá podmínka
+// a překladač ho i s formátovacím řetězcem zahodí.
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Bitová maska povolených modulů (bit = LogModule)
+#ifndef LOG_MODULES
+#define LOG_MODULES 0xFFFFFFFFUL
+#endif
+
+// Záznamy s touto nebo vážnější úrovní jdou i do MQTT (sharp/log)
+#ifndef LOG_MQTT_LEVEL
+#define LOG_MQTT_LEVEL LOG_LEVEL_WARN
+#endif
+
+enum LogModule : uint8_t {
+  LOG_MOD_MAIN = 0,
+  LOG_MOD_CFG,
+  LOG_MOD_SENS,
+  LOG_MOD_MQTT,
+  LOG_MOD_HA,
+  LOG_MOD_TMEP,
+  LOG_MOD_WEB,
+  LOG_MOD_WIFI,
+  LOG_MOD_DISP,
+  LOG_MOD_HIST,
+  LOG_MOD_POWER,
+  LOG_MOD_ALARM,
+  LOG_MOD_OTA,
+  LOG_MODULE_COUNT,
+};
+
+// Jen kvůli kontrole formátu překladačem (-Wformat); nikdy se nevolá
+void logFormatCheck(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+#define LOG_AT(level, module, format, ...)                                        \
+  do {                                                                            \
+    if ((level) <= LOG_LEVEL && ((LOG_MODULES >> LOG_MOD_##module) & 1)) {        \
+      if (false) logFormatCheck(format, ##__VA_ARGS__);                           \
+      logger.write(LOG_MOD_##module, (level), "" format, ##__VA_ARGS__);          \
+    }                                                                             \
+  } while (0)
+
+#define LOGE(module, format, ...) LOG_AT(LOG_LEVEL_ERROR, module, format, ##__VA_ARGS__)
+#define LOGW(module, format, ...) LOG_AT(LOG_LEVEL_WARN, module, format, ##__VA_ARGS__)
+#define LOGI(module, format, ...) LOG_AT(LOG_LEVEL_INFO, module, format, ##__VA_ARGS__)
+#define LOGD(module, format, ...) LOG_AT(LOG_LEVEL_DEBUG, module, format, ##__VA_ARGS__)
+
+constexpr uint8_t LOG_MAX_ARGS = 8;
+constexpr uint8_t LOG_TEXT_BYTES = 64;
+
+// Záznam s neformátovanými argumenty; formát je vždy řetězcový literál,
+// řetězcové argumenty se kopírují (ukazatel by do vyprázdnění neplatil)
+struct LogRecord {
+  uint32_t timestamp;
+  const char* format;
+  uint8_t module;
+  uint8_t level;
+  uint8_t argCount;
+  uint8_t textLength;
+  uint32_t args[LOG_MAX_ARGS];  // 64bit celá čísla zabírají dva
+  char text[LOG_TEXT_BYTES];
+};
+
+struct LogStats {
+  uint32_t records = 0;
+  uint32_t dropped = 0;        // plný kruh - záznam zahozen, zapisovatel nečeká
+  uint32_t writeAvgCycles = 0; // cena LOGx() v loop()/handleru
+  uint32_t writeMaxCycles = 0;
+  uint32_t drainAvgUs = 0;     // formátování + výstup jednoho záznamu v tasku logu
+  uint32_t drainMaxUs = 0;
+};
+
+class LogPacker;
+
+// Kruh záznamů bez zámků pro více zapisovatelů (loop, task web serveru,
+// Wi-Fi události) a jednoho čtenáře - task s nízkou prioritou, který
+// záznamy formátuje a posílá na Serial, do paměti pro /api/log a
+// vybrané úrovně do fronty pro MQTT.
+class Logger {
+ public:
+  static constexpr uint16_t RING_SLOTS = 64;  // mocnina 2
+  static constexpr size_t TAIL_BYTES = 4096;
+  static constexpr size_t LINE_BYTES = 160;
+
+  Logger();
+  void begin();
+
+  template <typename... Args>
+  void write(LogModule module, uint8_t level, const char* format, const Args&... args);
+
+  // Formátované řádky v paměti od nejstaršího (pro /api/log)
+  void readTail(const std::function<void(const char* data, size_t length)>& sink);
+  // Řádek čekající na odeslání do MQTT; volá loop()
+  bool takeMqttLine(char* line, size_t size);
+
+  LogStats getStats() const;
+
+ private:
+  struct Slot {
+    std::atomic<uint32_t> sequence;
+    LogRecord record;
+  };
+
+  Slot* claim();
+  void commit(Slot* slot, uint32_t startCycles);
+  static void drainTask(void* arg);
+  bool drainOne();
+  void appendTail(const char* line, size_t length);
+
+  Slot slots_[RING_SLOTS];
+  std::atomic<uint32_t> head_{0};
+  uint32_t tail_ = 0;  // jen task logu
+  std::atomic<uint32_t> dropped_{0};
+  uint32_t reportedDropped_ = 0;
+
+  TaskHandle_t task_ = nullptr;
+  QueueHandle_t mqttQueue_ = nullptr;
+  SemaphoreHandle_t tailLock_ = nullptr;
+  char tailBuffer_[TAIL_BYTES];
+  size_t tailWritten_ = 0;  // celkem zapsáno, pozice = tailWritten_ % TAIL_BYTES
+
+  std::atomic<uint32_t> records_{0};
+  uint64_t writeCyclesTotal_ = 0;
+  uint32_t writeMaxCycles_ = 0;
+  uint64_t drainUsTotal_ = 0;
+  uint32_t drainCount_ = 0;
+  uint32_t drainMaxUs_ = 0;
+};
+
+extern Logger logger;
+
+class LogPacker {
+ public:
+  explicit LogPacker(LogRecord& record) : record_(record) {}
+
+  void put32(uint32_t value) {
+    if (record_.argCount < LOG_MAX_ARGS) record_.args[record_.argCount++] = value;
+  }
+
+  void putString(const char* s);
+
+  template <typename T>
+  typename std::enable_if<(std::is_integral<T>::value || std::is_enum<T>::value) && sizeof(T) <= 4>::type
+  pack(T value) {
+    put32((uint32_t)value);
+  }
+
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value && sizeof(T) == 8>::type pack(T value) {
+    put32((uint32_t)value);
+    put32((uint32_t)((uint64_t)value >> 32));
+  }
+
+  // float i double se ukládají jako float - pro log stačí
+  void pack(double value) {
+    float f = (float)value;
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    put32(bits);
+  }
+
+  void pack(const char* s) { putString(s); }
+  void pack(const void* p) { put32((uint32_t)(uintptr_t)p); }
+
+ private:
+  LogRecord& record_;
+};
+
+template <typename... Args>
+void Logger::write(LogModule module, uint8_t level, const char* format, const Args&... args) {
+  uint32_t startCycles = ESP.getCycleCount();
+  Slot* slot = claim();
+  if (!slot) return;
+
+  LogRecord& record = slot->record;
+  record.timestamp = millis();
+  record.format = format;
+  record.module = module;
+  record.level = level;
+  record.argCount = 0;
+  record.textLength = 0;
+  LogPacker packer(record);
+  int expand[] = {0, (packer.pack(args), 0)...};
+  (void)expand;
+  commit(slot, startCycles);
+}
@@ -0,0 +1,67 @@
+#include "MqttClientTap.h"
+
+namespace {
+constexpr uint8_t TYPE_PUBACK = 4;
+}  // namespace
+
+void MqttClientTap::reset() {
+  state_ = PARSE_HEADER;
+  remaining_ = 0;
+  bodyIndex_ = 0;
+}
+
+int MqttClientTap::connect(IPAddress ip, uint16_t port) {
+  reset();
+  return inner_.connect(ip, port);
+}
+
+int MqttClientTap::connect(const char* host, uint16_t port) {
+  reset();
+  return inner_.connect(host, port);
+}
+
+void MqttClientTap::stop() {
+  reset();
+  inner_.stop();
+}
+
+int MqttClientTap::read() {
+  int b = inner_.read();
+  if (b >= 0) track((uint8_t)b);
+  return b;
+}
+
+int MqttClientTap::read(uint8_t* buf, size_t size) {
+  int n = inner_.read(buf, size);
+  for (int i = 0; i < n; i++) track(buf[i]);
+  return n;
+}
+
+// Stavový automat přes hranice rámců MQTT: hlavička, délka (varint), tělo
+void MqttClientTap::track(uint8_t b) {
+  switch (state_) {
+    case PARSE_HEADER:
+      type_ = b >> 4;
+      remaining_ = 0;
+      multiplier_ = 1;
+      bodyIndex_ = 0;
+      state_ = PARSE_LENGTH;
+      break;
+
+    case PARSE_LENGTH:
+      remaining_ += (b & 0x7F) * multiplier_;
+      multiplier_ *= 128;
+      if (b & 0x80) break;
+      state_ = remaining_ ? PARSE_BODY : PARSE_HEADER;
+      break;
+
+    case PARSE_BODY:
+      if (type_ == TYPE_PUBACK && bodyIndex_ < sizeof(body_)) body_[bodyIndex_++] = b;
+      if (--remaining_ > 0) break;
+      state_ = PARSE_HEADER;
+      if (type_ == TYPE_PUBACK && bodyIndex_ == sizeof(body_) && onPuback_) {
+        onPuback_(((uint16_t)body_[0] << 8) | body_[1]);
+      }
+      break;
+  }
+}
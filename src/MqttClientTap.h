@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Client.h>
+
+#include <functional>
+
+// Průchozí Client mezi PubSubClient a WiFiClient. Sleduje rámce příchozího
+// proudu, jak je PubSubClient čte, a vytáhne z nich PUBACK - ten PubSubClient
+// sám zahazuje, ale MqttOutbox (QoS 1) ho potřebuje. Odchozí pakety outboxu
+// jdou stejným spojením přes write(); vše běží v loop(), takže se nepromíchají.
+class MqttClientTap : public Client {
+ public:
+  typedef std::function<void(uint16_t packetId)> PubackHandler;
+
+  explicit MqttClientTap(Client& inner) : inner_(inner) {}
+  void onPuback(PubackHandler handler) { onPuback_ = handler; }
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char* host, uint16_t port) override;
+  size_t write(uint8_t b) override { return inner_.write(b); }
+  size_t write(const uint8_t* buf, size_t size) override { return inner_.write(buf, size); }
+  int available() override { return inner_.available(); }
+  int read() override;
+  int read(uint8_t* buf, size_t size) override;
+  int peek() override { return inner_.peek(); }
+  void flush() override { inner_.flush(); }
+  void stop() override;
+  uint8_t connected() override { return inner_.connected(); }
+  operator bool() override { return (bool)inner_; }
+
+ private:
+  enum ParseState : uint8_t { PARSE_HEADER = 0, PARSE_LENGTH, PARSE_BODY };
+
+  void track(uint8_t b);
+  void reset();
+
+  Client& inner_;
+  PubackHandler onPuback_;
+  ParseState state_ = PARSE_HEADER;
+  uint8_t type_ = 0;
+  uint32_t remaining_ = 0;
+  uint32_t multiplier_ = 1;
+  uint8_t bodyIndex_ = 0;
+  uint8_t body_[2];  // packet id PUBACK
+};
@@ -0,0 +1,193 @@
+#include "MqttOutbox.h"
+
+#include <string.h>
+
+namespace {
+constexpr uint8_t PUBLISH_QOS1 = 0x32;
+constexpr uint8_t FLAG_RETAIN = 0x01;
+constexpr uint8_t FLAG_DUP = 0x08;
+constexpr uint32_t RTO_INITIAL_MS = 3000;
+constexpr uint32_t RTO_MIN_MS = 2000;  // PUBACK chodí po TCP, kratší RTO by jen zdvojovalo zprávy
+constexpr uint32_t RTO_MAX_MS = 30000;
+constexpr uint8_t RTO_BACKOFF_MAX = 4;  // RTO se u opakování zdvojuje nejvýš 16x
+}  // namespace
+
+bool MqttOutbox::allocate(size_t length, uint16_t& offset) {
+  if (count_ == 0) bufferHead_ = bufferTail_ = 0;
+  if (count_ == 0 || bufferTail_ > bufferHead_) {
+    // Živá data v [head, tail): volno na konci, případně od začátku před head
+    if (BUFFER_BYTES - bufferTail_ >= length) {
+      offset = bufferTail_;
+    } else if (bufferHead_ >= length) {
+      offset = 0;
+    } else {
+      return false;
+    }
+  } else {
+    // Zabaleno: volno jen v [tail, head)
+    if ((size_t)(bufferHead_ - bufferTail_) < length) return false;
+    offset = bufferTail_;
+  }
+  bufferTail_ = offset + length;
+  bytesUsed_ += length;
+  return true;
+}
+
+void MqttOutbox::release() {
+  while (count_ > 0 && slotAt(0).state == SLOT_ACKED) {
+    bytesUsed_ -= slotAt(0).length;
+    head_ = (head_ + 1) % MAX_MESSAGES;
+    count_--;
+    if (count_ > 0) bufferHead_ = slotAt(0).offset;
+  }
+}
+
+uint16_t MqttOutbox::nextPacketId() {
+  // Horní polovina rozsahu - PubSubClient čísluje SUBSCRIBE od 1
+  packetId_ = (packetId_ + 1) & 0x7FFF;
+  return 0x8000 | packetId_;
+}
+
+bool MqttOutbox::publish(const char* topic, const uint8_t* payload, size_t length, bool retain, uint32_t sequence,
+                         uint32_t sampleAt) {
+  size_t topicLength = strlen(topic);
+  size_t remaining = 2 + topicLength + 2 + length;
+  size_t lengthBytes = remaining < 128 ? 1 : remaining < 16384 ? 2 : 3;
+  size_t total = 1 + lengthBytes + remaining;
+  uint16_t offset = 0;
+  if (topicLength > 0xFFFF || total > BUFFER_BYTES || count_ >= MAX_MESSAGES || !allocate(total, offset)) {
+    dropped_++;
+    return false;
+  }
+
+  uint8_t* p = buffer_ + offset;
+  *p++ = PUBLISH_QOS1 | (retain ? FLAG_RETAIN : 0);
+  size_t n = remaining;
+  do {
+    uint8_t digit = n % 128;
+    n /= 128;
+    *p++ = digit | (n ? 0x80 : 0);
+  } while (n);
+  *p++ = topicLength >> 8;
+  *p++ = topicLength & 0xFF;
+  memcpy(p, topic, topicLength);
+  p += topicLength;
+
+  Slot& slot = slotAt(count_);
+  slot.offset = offset;
+  slot.length = (uint16_t)total;
+  slot.packetId = nextPacketId();
+  *p++ = slot.packetId >> 8;
+  *p++ = slot.packetId & 0xFF;
+  memcpy(p, payload, length);
+
+  slot.state = SLOT_QUEUED;
+  slot.sends = 0;
+  slot.sendSeq = 0;
+  slot.firstSentAt = slot.lastSentAt = 0;
+  slot.sequence = sequence;
+  slot.sampleAt = sampleAt;
+  if (count_ == 0) bufferHead_ = offset;
+  count_++;
+  accepted_++;
+  return true;
+}
+
+bool MqttOutbox::send(Slot& slot, uint32_t now) {
+  if (slot.sends > 0) buffer_[slot.offset] |= FLAG_DUP;
+  if (!writer_(buffer_ + slot.offset, slot.length)) return false;
+  if (slot.state == SLOT_QUEUED) {
+    slot.state = SLOT_IN_FLIGHT;
+    inFlight_++;
+  }
+  if (slot.sends == 0) {
+    slot.firstSentAt = now;
+  } else {
+    retransmits_++;
+  }
+  if (slot.sends < 255) slot.sends++;
+  slot.sendSeq = ++sendSeq_;
+  slot.lastSentAt = now;
+  return true;
+}
+
+void MqttOutbox::process(uint32_t now, bool connected) {
+  if (!connected || !writer_ || count_ == 0) return;
+  if (rtoMs_ == 0) rtoMs_ = RTO_INITIAL_MS;
+
+  for (uint8_t i = 0; i < count_; i++) {
+    Slot& slot = slotAt(i);
+    if (slot.state != SLOT_IN_FLIGHT) continue;
+    bool overtaken = slot.sendSeq < ackedSeq_;
+    uint8_t backoff = slot.sends - 1 < RTO_BACKOFF_MAX ? slot.sends - 1 : RTO_BACKOFF_MAX;
+    if (!overtaken && now - slot.lastSentAt < (rtoMs_ << backoff)) continue;
+    if (!send(slot, now)) return;
+    if (overtaken) fastRetransmits_++;
+  }
+
+  for (uint8_t i = 0; i < count_ && inFlight_ < WINDOW; i++) {
+    Slot& slot = slotAt(i);
+    if (slot.state == SLOT_QUEUED && !send(slot, now)) return;
+  }
+}
+
+void MqttOutbox::onPuback(uint16_t packetId, uint32_t now) {
+  for (uint8_t i = 0; i < count_; i++) {
+    Slot& slot = slotAt(i);
+    if (slot.state != SLOT_IN_FLIGHT || slot.packetId != packetId) continue;
+
+    slot.state = SLOT_ACKED;
+    inFlight_--;
+    if (slot.sendSeq > ackedSeq_) ackedSeq_ = slot.sendSeq;
+    delivered_++;
+    uint32_t ackMs = now - slot.firstSentAt;
+    ackTotalMs_ += ackMs;
+    if (ackMs > ackMaxMs_) ackMaxMs_ = ackMs;
+
+    // RTT jen z jednou odeslaných zpráv (Karn), RTO podle RFC 6298
+    if (slot.sends == 1) {
+      uint32_t rtt = now - slot.lastSentAt;
+      if (srttMs_ == 0) {
+        srttMs_ = rtt;
+        rttVarMs_ = rtt / 2;
+      } else {
+        uint32_t diff = srttMs_ > rtt ? srttMs_ - rtt : rtt - srttMs_;
+        rttVarMs_ = (3 * rttVarMs_ + diff) / 4;
+        srttMs_ = (7 * srttMs_ + rtt) / 8;
+      }
+      uint32_t rto = srttMs_ + 4 * rttVarMs_;
+      rtoMs_ = rto < RTO_MIN_MS ? RTO_MIN_MS : rto > RTO_MAX_MS ? RTO_MAX_MS : rto;
+    }
+    if (slot.sequence && onDelivered_) onDelivered_(slot.sequence, now - slot.sampleAt);
+    release();
+    return;
+  }
+}
+
+void MqttOutbox::onConnected() {
+  for (uint8_t i = 0; i < count_; i++) {
+    Slot& slot = slotAt(i);
+    if (slot.state == SLOT_IN_FLIGHT) slot.state = SLOT_QUEUED;
+  }
+  inFlight_ = 0;
+}
+
+MqttOutboxStats MqttOutbox::getStats() const {
+  MqttOutboxStats stats;
+  stats.accepted = accepted_;
+  stats.delivered = delivered_;
+  stats.dropped = dropped_;
+  stats.retransmits = retransmits_;
+  stats.fastRetransmits = fastRetransmits_;
+  stats.inFlight = inFlight_;
+  for (uint8_t i = 0; i < count_; i++) {
+    if (slots_[(head_ + i) % MAX_MESSAGES].state == SLOT_QUEUED) stats.queued++;
+  }
+  stats.window = WINDOW;
+  stats.bytesUsed = bytesUsed_;
+  stats.srttMs = srttMs_;
+  stats.rtoMs = rtoMs_ ? rtoMs_ : RTO_INITIAL_MS;
+  stats.ackAvgMs = delivered_ ? (uint32_t)(ackTotalMs_ / delivered_) : 0;
+  stats.ackMaxMs = ackMaxMs_;
+  return stats;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <functional>
+
+struct MqttOutboxStats {
+  uint32_t accepted = 0;     // zprávy přijaté do fronty
+  uint32_t delivered = 0;    // potvrzené PUBACK
+  uint32_t dropped = 0;      // plná fronta nebo zpráva větší než buffer
+  uint32_t retransmits = 0;  // opakovaná odeslání (DUP) po RTO nebo reconnectu
+  uint32_t fastRetransmits = 0;  // z toho hned po PUBACK pozdější zprávy
+  uint8_t inFlight = 0;
+  uint8_t queued = 0;        // čeká na místo v okně
+  uint8_t window = 0;
+  uint16_t bytesUsed = 0;
+  uint32_t srttMs = 0;       // vyhlazený RTT (jen nepřeposlané zprávy, Karn)
+  uint32_t rtoMs = 0;
+  uint32_t ackAvgMs = 0;     // první odeslání -> PUBACK, včetně opakování
+  uint32_t ackMaxMs = 0;
+};
+
+// QoS 1 publikace s pipeliningem: až WINDOW zpráv čeká na PUBACK současně,
+// takže propustnost neklesne na jednu zprávu za round-trip. Zakódované
+// PUBLISH pakety leží v pevném kruhovém bufferu, dokud je broker nepotvrdí;
+// nepotvrzené se po RTO a po každém novém spojení pošlou znovu s příznakem DUP.
+// Broker potvrzuje v pořadí příjmu (MQTT 3.1.1, 4.6), takže PUBACK pozdější
+// zprávy znamená ztrátu dřívějších - ty jdou znovu hned, bez čekání na RTO.
+// Bez závislosti na Arduinu - odesílání i čas dodává volající.
+class MqttOutbox {
+ public:
+  static constexpr size_t BUFFER_BYTES = 4096;
+  static constexpr uint8_t MAX_MESSAGES = 32;
+  static constexpr uint8_t WINDOW = 8;
+
+  // Zapíše celý paket do spojení; false = spojení nefunguje
+  typedef std::function<bool(const uint8_t* data, size_t length)> Writer;
+  // PUBACK zprávy se vzorkem: sekvence a stáří vzorku v okamžiku potvrzení
+  typedef std::function<void(uint32_t sequence, uint32_t ageMs)> DeliveryHandler;
+
+  void begin(Writer writer) { writer_ = writer; }
+  void onDelivered(DeliveryHandler handler) { onDelivered_ = handler; }
+
+  // Zařadí zprávu; false = nevejde se (počítá se do dropped). Zpráva se
+  // vzorkem nese jeho sekvenci (0 = bez vzorku) a millis() jeho přečtení.
+  bool publish(const char* topic, const uint8_t* payload, size_t length, bool retain, uint32_t sequence = 0,
+               uint32_t sampleAt = 0);
+  // Odešle čekající zprávy do okna a přepošle ty, kterým vypršel RTO
+  void process(uint32_t now, bool connected);
+  // PUBACK z příchozího proudu (MqttClientTap)
+  void onPuback(uint16_t packetId, uint32_t now);
+  // Nové spojení: nepotvrzené zprávy půjdou znovu (clean session je zapomněl)
+  void onConnected();
+
+  bool idle() const { return count_ == 0; }
+  MqttOutboxStats getStats() const;
+
+ private:
+  enum SlotState : uint8_t { SLOT_QUEUED = 0, SLOT_IN_FLIGHT, SLOT_ACKED };
+
+  struct Slot {
+    uint16_t offset;
+    uint16_t length;
+    uint16_t packetId;
+    SlotState state;
+    uint8_t sends;
+    uint32_t sendSeq;  // pořadí posledního odeslání
+    uint32_t firstSentAt;
+    uint32_t lastSentAt;
+    uint32_t sequence;  // vzorek pro latenci doručení, 0 = bez vzorku
+    uint32_t sampleAt;
+  };
+
+  bool allocate(size_t length, uint16_t& offset);
+  void release();
+  bool send(Slot& slot, uint32_t now);
+  uint16_t nextPacketId();
+  Slot& slotAt(uint8_t index) { return slots_[(head_ + index) % MAX_MESSAGES]; }
+
+  Writer writer_;
+  DeliveryHandler onDelivered_;
+  uint8_t buffer_[BUFFER_BYTES];
+  uint16_t bufferHead_ = 0;  // nejstarší živý paket
+  uint16_t bufferTail_ = 0;  // místo pro další paket
+  uint16_t bytesUsed_ = 0;
+
+  Slot slots_[MAX_MESSAGES];
+  uint8_t head_ = 0;
+  uint8_t count_ = 0;
+  uint8_t inFlight_ = 0;
+  uint16_t packetId_ = 0;
+  uint32_t sendSeq_ = 0;
+  uint32_t ackedSeq_ = 0;  // nejpozdější potvrzené odeslání
+
+  uint32_t srttMs_ = 0;
+  uint32_t rttVarMs_ = 0;
+  uint32_t rtoMs_ = 0;
+  uint64_t ackTotalMs_ = 0;
+  uint32_t ackMaxMs_ = 0;
+
+  uint32_t accepted_ = 0;
+  uint32_t delivered_ = 0;
+  uint32_t dropped_ = 0;
+  uint32_t retransmits_ = 0;
+  uint32_t fastRetransmits_ = 0;
+};
@@ -0,0 +1,28 @@
+#include "MqttPacing.h"
+
+void ReconnectBackoff::schedule(uint32_t now, bool failed, uint32_t random) {
+  if (failed) backoffMs_ = backoffMs_ * 2 > MAX_MS ? MAX_MS : backoffMs_ * 2;
+  nextAttemptAt_ = now + backoffMs_ / 2 + random % (backoffMs_ / 2 + 1);
+}
+
+void DiscoveryPacer::start(uint32_t at) {
+  cursor_ = 0;
+  nextAt_ = at;
+}
+
+int16_t DiscoveryPacer::due(uint32_t now, uint16_t total) {
+  if (cursor_ < 0 || (int32_t)(now - nextAt_) < 0) return -1;
+  if (cursor_ >= (int16_t)total) {  // entit mezitím ubylo
+    cursor_ = -1;
+    return -1;
+  }
+  return cursor_;
+}
+
+bool DiscoveryPacer::sent(uint32_t now, bool ok, uint16_t total) {
+  nextAt_ = now + PACE_MS;
+  if (!ok) return false;  // plný buffer klienta - stejná entita v dalším kroku
+  if (++cursor_ < (int16_t)total) return false;
+  cursor_ = -1;
+  return true;
+}
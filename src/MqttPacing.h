@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Termíny pokusů o připojení k brokeru. Equal jitter: čekání náhodně
+// v <backoff/2, backoff>, po neúspěchu se backoff zdvojnásobí až po strop.
+// Flotila po výpadku brokeru se tak nepřipojuje ve vlnách. Nezávisí na
+// Arduino API - čas i náhodné číslo dodává volající, takže stejný kód
+// běží i v simulaci flotily na PC (test/test_fleet_sim).
+class ReconnectBackoff {
+ public:
+  static constexpr uint32_t BASE_MS = 5000;   // první pokus po ztrátě spojení za 2.5-5 s
+  static constexpr uint32_t MAX_MS = 120000;  // strop backoffu
+
+  void schedule(uint32_t now, bool failed, uint32_t random);
+  void reset() { backoffMs_ = BASE_MS; }
+  bool due(uint32_t now) const { return (int32_t)(now - nextAttemptAt_) >= 0; }
+
+  uint32_t backoffMs() const { return backoffMs_; }
+  uint32_t nextAttemptAt() const { return nextAttemptAt_; }
+
+ private:
+  uint32_t backoffMs_ = BASE_MS;
+  uint32_t nextAttemptAt_ = 0;
+};
+
+// Rozestup HA discovery: jedna entita za průchod loop() nejdřív PACE_MS po
+// předchozí, po birth zprávě HA se začátek náhodně posune o až JITTER_MS.
+// Volající entity jen posílá, kurzor a termíny drží tady.
+class DiscoveryPacer {
+ public:
+  static constexpr uint32_t PACE_MS = 100;
+  static constexpr uint32_t JITTER_MS = 10000;
+
+  void start(uint32_t at);
+  void startJittered(uint32_t now, uint32_t random) { start(now + random % JITTER_MS); }
+  bool pending() const { return cursor_ >= 0; }
+  uint32_t nextAt() const { return nextAt_; }
+
+  // Index entity, kterou je teď čas poslat; -1 = nic nečeká nebo ještě ne
+  int16_t due(uint32_t now, uint16_t total);
+  // Výsledek odeslání entity z due(); true = tím byla odeslána poslední
+  bool sent(uint32_t now, bool ok, uint16_t total);
+
+ private:
+  int16_t cursor_ = -1;
+  uint32_t nextAt_ = 0;
+};
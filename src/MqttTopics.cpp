@@ -0,0 +1,114 @@
+#include "MqttTopics.h"
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+constexpr const char* HA_PREFIX = "homeassistant";
+constexpr const char* LEGACY_DEVICE_ID = "sharp_sen66_esp32c3";
+
+// Přípony pevných topiců za <base>, pořadí podle MqttTopicId
+const char* const SUFFIXES[MQTT_T_COUNT] = {
+  "/display/text", "/display/clear", "/display/command", "/display/brightness", "/display/bitmap", "/ota",
+  nullptr,  // homeassistant/status
+  "/status", "/sensor", "/alarm", "/log", "/ota/status", "/replay/sensor", "/replay/alarm",
+};
+
+uint32_t fnv1a(const char* data, size_t length) {
+  uint32_t hash = 2166136261UL;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (uint8_t)data[i];
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+}  // namespace
+
+bool MqttTopics::validBaseTopic(const char* topic) {
+  size_t length = strlen(topic);
+  if (length == 0 || length > BASE_MAX || topic[0] == '/' || topic[length - 1] == '/') return false;
+  for (size_t i = 0; i < length; i++) {
+    char c = topic[i];
+    if (c == '+' || c == '#' || !isprint((unsigned char)c) || c == ' ') return false;
+    if (c == '/' && topic[i + 1] == '/') return false;
+  }
+  return true;
+}
+
+bool MqttTopics::validDeviceId(const char* id) {
+  size_t length = strlen(id);
+  if (length > DEVICE_ID_MAX) return false;
+  // HA přijme v node_id/object_id jen [a-zA-Z0-9_-]
+  for (size_t i = 0; i < length; i++) {
+    if (!isalnum((unsigned char)id[i]) && id[i] != '_' && id[i] != '-') return false;
+  }
+  return true;
+}
+
+int32_t MqttTopics::appendf(const char* format, ...) {
+  if (used_ >= POOL_BYTES) return -1;
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(pool_ + used_, POOL_BYTES - used_, format, args);
+  va_end(args);
+  if (n < 0 || used_ + n + 1 > POOL_BYTES) {
+    pool_[used_] = '\0';  // useknutý zápis zahodit
+    return -1;
+  }
+  int32_t offset = (int32_t)used_;
+  used_ += n + 1;
+  return offset;
+}
+
+bool MqttTopics::begin(const char* baseTopic, const char* deviceId) {
+  used_ = 0;
+  entityCount_ = 0;
+
+  for (uint8_t id = 0; id < MQTT_T_COUNT; id++) {
+    int32_t offset = SUFFIXES[id] ? appendf("%s%s", baseTopic, SUFFIXES[id]) : appendf("%s/status", HA_PREFIX);
+    if (offset < 0) return false;
+    offsets_[id] = (uint16_t)offset;
+    if (id < MQTT_T_SUBSCRIBE_COUNT) {
+      size_t length = strlen(pool_ + offset);
+      lengths_[id] = (uint8_t)length;
+      hashes_[id] = fnv1a(pool_ + offset, length);
+    }
+  }
+
+  int32_t identifier = appendf("%s", *deviceId ? deviceId : LEGACY_DEVICE_ID);
+  int32_t prefix = *deviceId ? appendf("%s_", deviceId) : appendf("");
+  if (identifier < 0 || prefix < 0) return false;
+  deviceIdentifier_ = (uint16_t)identifier;
+  uidPrefix_ = (uint16_t)prefix;
+  return true;
+}
+
+int16_t MqttTopics::addEntity(const char* key, const char* uid) {
+  if (entityCount_ >= MAX_ENTITIES) return -1;
+  size_t mark = used_;
+  int32_t state = appendf("%s/%s", topic(MQTT_T_SENSOR), key);
+  int32_t uniqueId = appendf("%s%s", pool_ + uidPrefix_, uid);
+  int32_t discovery = uniqueId < 0 ? -1 : appendf("%s/sensor/%s/config", HA_PREFIX, pool_ + uniqueId);
+  if (state < 0 || uniqueId < 0 || discovery < 0) {
+    used_ = mark;
+    return -1;
+  }
+  Entity& entity = entities_[entityCount_];
+  entity.state = (uint16_t)state;
+  entity.uid = (uint16_t)uniqueId;
+  entity.discovery = (uint16_t)discovery;
+  return entityCount_++;
+}
+
+int8_t MqttTopics::match(const char* topic) const {
+  size_t length = strlen(topic);
+  uint32_t hash = fnv1a(topic, length);
+  for (uint8_t id = 0; id < MQTT_T_SUBSCRIBE_COUNT; id++) {
+    if (lengths_[id] == length && hashes_[id] == hash && memcmp(pool_ + offsets_[id], topic, length) == 0) {
+      return (int8_t)id;
+    }
+  }
+  return MQTT_T_UNKNOWN;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Pevné topicy zařízení; příjem (subscribe) je na začátku kvůli dispatchi
+enum MqttTopicId : uint8_t {
+  MQTT_T_TEXT = 0,      // <base>/display/text
+  MQTT_T_CLEAR,         // <base>/display/clear
+  MQTT_T_COMMAND,       // <base>/display/command
+  MQTT_T_BRIGHTNESS,    // <base>/display/brightness
+  MQTT_T_BITMAP,        // <base>/display/bitmap
+  MQTT_T_OTA,           // <base>/ota
+  MQTT_T_HA_STATUS,     // homeassistant/status (společný pro všechna zařízení)
+  MQTT_T_SUBSCRIBE_COUNT,
+
+  MQTT_T_STATUS = MQTT_T_SUBSCRIBE_COUNT,  // <base>/status (LWT)
+  MQTT_T_SENSOR,        // <base>/sensor
+  MQTT_T_ALARM,         // <base>/alarm
+  MQTT_T_LOG,           // <base>/log
+  MQTT_T_OTA_STATUS,    // <base>/ota/status
+  MQTT_T_REPLAY_SENSOR, // <base>/replay/sensor (JSON vzorku z přehrávané stopy)
+  MQTT_T_REPLAY_ALARM,  // <base>/replay/alarm (přechody alarmů při přehrávání)
+  MQTT_T_COUNT,
+};
+
+constexpr int8_t MQTT_T_UNKNOWN = -1;
+
+// Všechny topicy zařízení (pevné, stavové topicy entit a HA discovery)
+// sestavené jednou po načtení konfigurace do jednoho souvislého bufferu.
+// Publikace ani callback pak topic neskládají; příchozí topic se hledá
+// podle délky a FNV-1a hashe, shoda se jen potvrdí jedním memcmp.
+class MqttTopics {
+ public:
+  static constexpr uint8_t MAX_ENTITIES = 40;
+  static constexpr size_t BASE_MAX = 31;
+  static constexpr size_t DEVICE_ID_MAX = 23;
+
+  // deviceId prázdné = původní identifikátory HA (jediné zařízení na brokeru)
+  bool begin(const char* baseTopic, const char* deviceId);
+  // Entita HA: stavový topic <base>/sensor/<key>, unique_id a discovery topic; vrací index nebo -1
+  int16_t addEntity(const char* key, const char* uid);
+
+  const char* topic(MqttTopicId id) const { return pool_ + offsets_[id]; }
+  int8_t match(const char* topic) const;  // MqttTopicId z příjmu, MQTT_T_UNKNOWN = cizí
+
+  uint8_t entityCount() const { return entityCount_; }
+  const char* stateTopic(uint8_t entity) const { return pool_ + entities_[entity].state; }
+  const char* uniqueId(uint8_t entity) const { return pool_ + entities_[entity].uid; }
+  const char* discoveryTopic(uint8_t entity) const { return pool_ + entities_[entity].discovery; }
+
+  const char* deviceIdentifier() const { return pool_ + deviceIdentifier_; }
+  size_t poolUsed() const { return used_; }
+
+  static bool validBaseTopic(const char* topic);
+  static bool validDeviceId(const char* id);
+
+ private:
+  // Výchozí sestava (SEN66 + indexy AQI) zabere ~1.5 kB; při přetečení addEntity vrátí -1
+  static constexpr size_t POOL_BYTES = 4096;
+
+  struct Entity {
+    uint16_t state;
+    uint16_t uid;
+    uint16_t discovery;
+  };
+
+  int32_t appendf(const char* format, ...);
+
+  char pool_[POOL_BYTES];
+  size_t used_ = 0;
+  uint16_t offsets_[MQTT_T_COUNT] = {0};
+  uint8_t lengths_[MQTT_T_SUBSCRIBE_COUNT] = {0};
+  uint32_t hashes_[MQTT_T_SUBSCRIBE_COUNT] = {0};
+  Entity entities_[MAX_ENTITIES];
+  uint8_t entityCount_ = 0;
+  uint16_t deviceIdentifier_ = 0;
+  uint16_t uidPrefix_ = 0;  // "<deviceId>_" nebo ""
+};
@@ -0,0 +1,7 @@
+// Vygenerováno scripts/ota_sign.py keygen - při změně klíče přepsat skriptem
+#pragma once
+
+// Veřejný klíč ECDSA P-256 (PEM), kterým se ověřuje podpis SHA-256 nového
+// image v triggeru OTA. Soukromý klíč zůstává u toho, kdo firmware vydává,
+// mimo repozitář. Prázdný klíč = firmware nepřijme žádnou aktualizaci.
+constexpr char OTA_SIGNING_KEY[] = "";
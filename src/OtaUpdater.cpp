@@ -0,0 +1,377 @@
+#include "OtaUpdater.h"
+#include "Log.h"
+
+#include <HTTPClient.h>
+#include <WiFi.h>
+#include <esp_image_format.h>
+#include <esp_partition.h>
+#include <mbedtls/pk.h>
+#include <string.h>
+
+#include "DeltaPatch.h"
+#include "OtaSigningKey.h"
+
+namespace {
+constexpr uint32_t TASK_STACK_BYTES = 8192;
+constexpr uint32_t HTTP_TIMEOUT_MS = 10000;   // bez dat déle než tohle = spojení mrtvé
+constexpr size_t SOURCE_CHUNK = 512;          // kus běžícího image při ověřování hashe
+constexpr uint8_t ESP_IMAGE_MAGIC = 0xE9;
+constexpr unsigned long CONFIRM_AFTER_MS = 60000UL;     // nový image musí běžet aspoň minutu
+constexpr unsigned long ROLLBACK_AFTER_MS = 300000UL;   // bez zdravého stavu do 5 min = návrat
+
+// Sudý počet hex znaků, nejvýš maxBytes bajtů
+bool parseHex(const char* hex, uint8_t* out, size_t maxBytes, size_t& length) {
+  size_t chars = hex ? strlen(hex) : 0;
+  if (chars == 0 || chars % 2 != 0 || chars / 2 > maxBytes) return false;
+  length = chars / 2;
+  for (size_t i = 0; i < length; i++) {
+    uint8_t byte = 0;
+    for (uint8_t j = 0; j < 2; j++) {
+      char c = hex[i * 2 + j];
+      uint8_t nibble;
+      if (c >= '0' && c <= '9') {
+        nibble = c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        nibble = c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        nibble = c - 'A' + 10;
+      } else {
+        return false;
+      }
+      byte = (byte << 4) | nibble;
+    }
+    out[i] = byte;
+  }
+  return true;
+}
+
+bool parseSha256(const char* hex, uint8_t* out) {
+  size_t length;
+  return parseHex(hex, out, 32, length) && length == 32;
+}
+
+// Podpis ECDSA P-256 nad SHA-256 image klíčem z OtaSigningKey.h
+bool signatureValid(const uint8_t* sha256, const uint8_t* signature, size_t length) {
+  mbedtls_pk_context key;
+  mbedtls_pk_init(&key);
+  bool ok = mbedtls_pk_parse_public_key(&key, (const unsigned char*)OTA_SIGNING_KEY, sizeof(OTA_SIGNING_KEY)) == 0 &&
+            mbedtls_pk_can_do(&key, MBEDTLS_PK_ECDSA) &&
+            mbedtls_pk_verify(&key, MBEDTLS_MD_SHA256, sha256, 32, signature, length) == 0;
+  mbedtls_pk_free(&key);
+  return ok;
+}
+}  // namespace
+
+// Arduino jádro jinak nový image potvrdí hned při startu; potvrzuje
+// až OtaUpdater::confirmBoot() po zdravém běhu
+extern "C" bool verifyRollbackLater() {
+  return true;
+}
+
+void OtaUpdater::begin() {
+  const esp_partition_t* running = esp_ota_get_running_partition();
+  esp_ota_img_states_t imageState;
+  pendingVerify_ = running && esp_ota_get_state_partition(running, &imageState) == ESP_OK &&
+                   imageState == ESP_OTA_IMG_PENDING_VERIFY;
+  if (pendingVerify_) {
+    LOGW(OTA, "bezi novy firmware z oddilu %s, ceka na potvrzeni", running->label);
+  }
+}
+
+bool OtaUpdater::start(const char* url, const char* sha256Hex, const char* signatureHex, const char*& message) {
+  if (busy()) {
+    message = "Aktualizace uz probiha";
+    return false;
+  }
+  if (state() == OTA_READY) {
+    message = "Novy firmware ceka na restart";
+    return false;
+  }
+  if (pendingVerify_) {
+    message = "Bezici firmware jeste neni potvrzeny";
+    return false;
+  }
+  if (!url || strncmp(url, "http://", 7) != 0 || !url_.assign(url)) {
+    message = "Neplatna URL (jen http://, max 159 znaku)";
+    return false;
+  }
+  if (!parseSha256(sha256Hex, expectedSha_)) {
+    message = "Chybi nebo je neplatny sha256 (64 hex znaku)";
+    return false;
+  }
+  // Hash i URL přicházejí ze stejné zprávy - image pravý je jen s podpisem
+  if (!OTA_SIGNING_KEY[0]) {
+    rejectedSignatures_++;
+    message = "Firmware nema klic pro podpis OTA";
+    return false;
+  }
+  uint8_t signature[MAX_SIGNATURE];
+  size_t signatureLength = 0;
+  if (!parseHex(signatureHex, signature, sizeof(signature), signatureLength) ||
+      !signatureValid(expectedSha_, signature, signatureLength)) {
+    rejectedSignatures_++;
+    message = "Chybi nebo je neplatny podpis (sig)";
+    return false;
+  }
+  if (WiFi.status() != WL_CONNECTED) {
+    message = "WiFi neni pripojena";
+    return false;
+  }
+
+  received_.store(0, std::memory_order_relaxed);
+  total_.store(0, std::memory_order_relaxed);
+  written_.store(0, std::memory_order_relaxed);
+  copied_.store(0, std::memory_order_relaxed);
+  delta_ = false;
+  error_.clear();
+  attempts_++;
+  state_.store(OTA_DOWNLOADING, std::memory_order_release);
+  // Stejná priorita jako loop(): stahování se střídá s displejem a senzory
+  if (xTaskCreate(taskEntry, "ota", TASK_STACK_BYTES, this, tskIDLE_PRIORITY + 1, &task_) != pdPASS) {
+    failures_++;
+    error_.assign("nelze spustit task");
+    state_.store(OTA_FAILED, std::memory_order_release);
+    message = "Nelze spustit task aktualizace";
+    return false;
+  }
+  LOGI(OTA, "start: %s", url_.c_str());
+  message = "Aktualizace spustena";
+  return true;
+}
+
+void OtaUpdater::taskEntry(void* arg) {
+  static_cast<OtaUpdater*>(arg)->run();
+  vTaskDelete(nullptr);
+}
+
+void OtaUpdater::run() {
+  uint32_t startMs = millis();
+  mbedtls_sha256_init(&sha_);
+  mbedtls_sha256_starts_ret(&sha_, 0);
+  bool ok = download();
+  mbedtls_sha256_free(&sha_);
+  if (handleOpen_) {
+    esp_ota_abort(handle_);
+    handleOpen_ = false;
+  }
+  task_ = nullptr;
+  if (!ok) {
+    failures_++;
+    LOGE(OTA, "CHYBA: %s (prijato %u/%u B)", error_.c_str(), received_.load(), total_.load());
+    state_.store(OTA_FAILED, std::memory_order_release);
+    return;
+  }
+  durationMs_ = millis() - startMs;
+  LOGI(OTA, "%s OK: %u B za %u ms, zapsano %u B do %s", delta_ ? "delta" : "image", total_.load(),
+       durationMs_, written_.load(), target_->label);
+  state_.store(OTA_READY, std::memory_order_release);
+}
+
+bool OtaUpdater::fail(const char* message) {
+  error_.assign(message);
+  return false;
+}
+
+bool OtaUpdater::download() {
+  target_ = esp_ota_get_next_update_partition(nullptr);
+  if (!target_) return fail("chybi OTA oddil");
+  if (runningImageMatches()) return fail("tento firmware uz bezi");
+
+  HTTPClient http;
+  http.setTimeout(HTTP_TIMEOUT_MS);
+  if (!http.begin(url_.c_str())) return fail("nelze inicializovat HTTP");
+  int httpCode = http.GET();
+  if (httpCode != HTTP_CODE_OK) {
+    http.end();
+    error_.assignf("HTTP %d", httpCode);
+    return false;
+  }
+  int length = http.getSize();
+  if (length <= 0) {
+    http.end();
+    return fail("server neposlal Content-Length");
+  }
+  total_.store(length, std::memory_order_relaxed);
+
+  const esp_partition_t* running = esp_ota_get_running_partition();
+  DeltaPatcher patcher(
+      [this](uint32_t sourceSize, const uint8_t* sourceSha256) { return checkSource(sourceSize, sourceSha256); },
+      [running](uint32_t offset, uint8_t* data, size_t size) {
+        return esp_partition_read(running, offset, data, size) == ESP_OK;
+      },
+      [this, &patcher](const uint8_t* data, size_t size) { return writeTarget(data, size, patcher.targetSize()); });
+
+  WiFiClient* stream = http.getStreamPtr();
+  uint32_t received = 0;
+  uint32_t lastDataMs = millis();
+  bool ok = true;
+  while (ok && received < (uint32_t)length) {
+    size_t available = stream->available();
+    // Typ obsahu rozhodují první 4 bajty - počkat, až jsou všechny
+    size_t wanted = received == 0 ? (length < 4 ? length : 4) : 1;
+    if (available < wanted) {
+      if (!stream->connected()) {
+        ok = fail("spojeni preruseno");
+      } else if (millis() - lastDataMs > HTTP_TIMEOUT_MS) {
+        ok = fail("timeout stahovani");
+      } else {
+        vTaskDelay(pdMS_TO_TICKS(5));
+      }
+      continue;
+    }
+    size_t chunk = available < BUFFER_BYTES ? available : BUFFER_BYTES;
+    if (chunk > (uint32_t)length - received) chunk = length - received;
+    int n = stream->read(buffer_, chunk);
+    if (n <= 0) continue;
+    if (received == 0) {
+      delta_ = DeltaPatcher::isDelta(buffer_, n);
+      if (!delta_ && buffer_[0] != ESP_IMAGE_MAGIC) {
+        ok = fail("data nejsou image ani delta");
+        break;
+      }
+      LOGI(OTA, "%s, %d B", delta_ ? "delta" : "cely image", length);
+    }
+    received += n;
+    received_.store(received, std::memory_order_relaxed);
+    lastDataMs = millis();
+
+    if (delta_) {
+      if (!patcher.feed(buffer_, n)) {
+        // Chyba zápisu už je v error_, jinak chyba formátu delty
+        if (error_.isEmpty()) fail(patcher.error());
+        ok = false;
+      }
+      copied_.store(patcher.copiedBytes(), std::memory_order_relaxed);
+    } else {
+      ok = writeTarget(buffer_, n, length);
+    }
+  }
+  http.end();
+  if (!ok) return false;
+  if (delta_ && !patcher.finished()) return fail("delta neni kompletni");
+
+  uint8_t digest[32];
+  mbedtls_sha256_finish_ret(&sha_, digest);
+  if (memcmp(digest, expectedSha_, sizeof(digest)) != 0) return fail("SHA-256 image nesouhlasi");
+
+  // esp_ota_end() navíc ověří strukturu a kontrolní součet image
+  handleOpen_ = false;
+  esp_err_t err = esp_ota_end(handle_);
+  if (err != ESP_OK) {
+    error_.assignf("image neplatny (%s)", esp_err_to_name(err));
+    return false;
+  }
+  err = esp_ota_set_boot_partition(target_);
+  if (err != ESP_OK) {
+    error_.assignf("nelze nastavit boot (%s)", esp_err_to_name(err));
+    return false;
+  }
+  return true;
+}
+
+bool OtaUpdater::writeTarget(const uint8_t* data, size_t length, uint32_t imageSize) {
+  if (!handleOpen_) {
+    if (imageSize > target_->size) return fail("image je vetsi nez OTA oddil");
+    // Mazání po sektorech během zápisu - smazání celého oddílu předem by
+    // na několik sekund zastavilo běh z flash (displej, senzory)
+#ifdef OTA_WITH_SEQUENTIAL_WRITES
+    esp_err_t err = esp_ota_begin(target_, OTA_WITH_SEQUENTIAL_WRITES, &handle_);
+#else
+    esp_err_t err = esp_ota_begin(target_, imageSize, &handle_);
+#endif
+    if (err != ESP_OK) {
+      error_.assignf("esp_ota_begin: %s", esp_err_to_name(err));
+      return false;
+    }
+    handleOpen_ = true;
+  }
+  esp_err_t err = esp_ota_write(handle_, data, length);
+  if (err != ESP_OK) {
+    error_.assignf("esp_ota_write: %s", esp_err_to_name(err));
+    return false;
+  }
+  mbedtls_sha256_update_ret(&sha_, data, length);
+  written_.fetch_add(length, std::memory_order_relaxed);
+  return true;
+}
+
+// Delta platí jen proti přesně tomu image, ze kterého vznikla
+bool OtaUpdater::checkSource(uint32_t sourceSize, const uint8_t* sourceSha256) {
+  const esp_partition_t* running = esp_ota_get_running_partition();
+  if (!running || sourceSize == 0 || sourceSize > running->size) return false;
+
+  mbedtls_sha256_context sha;
+  mbedtls_sha256_init(&sha);
+  mbedtls_sha256_starts_ret(&sha, 0);
+  uint8_t chunk[SOURCE_CHUNK];
+  bool ok = true;
+  for (uint32_t offset = 0; ok && offset < sourceSize; offset += SOURCE_CHUNK) {
+    size_t n = sourceSize - offset < SOURCE_CHUNK ? sourceSize - offset : SOURCE_CHUNK;
+    ok = esp_partition_read(running, offset, chunk, n) == ESP_OK;
+    if (ok) mbedtls_sha256_update_ret(&sha, chunk, n);
+  }
+  uint8_t digest[32];
+  mbedtls_sha256_finish_ret(&sha, digest);
+  mbedtls_sha256_free(&sha);
+  return ok && memcmp(digest, sourceSha256, sizeof(digest)) == 0;
+}
+
+// Retained trigger v MQTT by jinak po každém připojení stahoval stejný image znovu
+bool OtaUpdater::runningImageMatches() {
+  const esp_partition_t* running = esp_ota_get_running_partition();
+  if (!running) return false;
+  esp_partition_pos_t position = {running->address, running->size};
+  esp_image_metadata_t metadata;
+  if (esp_image_get_metadata(&position, &metadata) != ESP_OK) return false;
+  return checkSource(metadata.image_len, expectedSha_);
+}
+
+void OtaUpdater::confirmBoot(bool healthy, unsigned long now) {
+  if (!pendingVerify_) return;
+  if (healthy && now >= CONFIRM_AFTER_MS) {
+    if (esp_ota_mark_app_valid_cancel_rollback() == ESP_OK) {
+      LOGI(OTA, "novy firmware potvrzen");
+    }
+    pendingVerify_ = false;
+  } else if (now >= ROLLBACK_AFTER_MS) {
+    LOGE(OTA, "novy firmware neni zdravy, navrat na predchozi");
+    esp_ota_mark_app_invalid_rollback_and_reboot();
+  }
+}
+
+uint8_t OtaUpdater::progressPercent() const {
+  uint32_t total = total_.load(std::memory_order_relaxed);
+  if (total == 0) return 0;
+  return (uint8_t)((uint64_t)received_.load(std::memory_order_relaxed) * 100 / total);
+}
+
+OtaStats OtaUpdater::getStats() const {
+  OtaStats stats;
+  stats.state = state();
+  stats.delta = delta_;
+  stats.pendingVerify = pendingVerify_;
+  stats.received = received_.load(std::memory_order_relaxed);
+  stats.total = total_.load(std::memory_order_relaxed);
+  stats.written = written_.load(std::memory_order_relaxed);
+  stats.copied = copied_.load(std::memory_order_relaxed);
+  stats.durationMs = durationMs_;
+  stats.attempts = attempts_;
+  stats.failures = failures_;
+  stats.rejectedSignatures = rejectedSignatures_;
+  stats.bufferBytes = BUFFER_BYTES;
+  if (stats.state == OTA_FAILED) stats.error = error_;
+  return stats;
+}
+
+const char* OtaUpdater::stateText(OtaState state) {
+  switch (state) {
+    case OTA_DOWNLOADING:
+      return "downloading";
+    case OTA_READY:
+      return "ready";
+    case OTA_FAILED:
+      return "failed";
+    default:
+      return "idle";
+  }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <Arduino.h>
+#include <esp_ota_ops.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <mbedtls/sha256.h>
+
+#include <atomic>
+
+#include "FixedString.h"
+
+enum OtaState : uint8_t {
+  OTA_IDLE = 0,
+  OTA_DOWNLOADING,
+  OTA_READY,   // image ověřen a nastaven pro boot, čeká se na restart
+  OTA_FAILED,
+};
+
+struct OtaStats {
+  OtaState state = OTA_IDLE;
+  bool delta = false;
+  bool pendingVerify = false;  // běží nový firmware, který ještě nebyl potvrzen
+  uint32_t received = 0;       // bajty staženo z HTTP
+  uint32_t total = 0;          // Content-Length
+  uint32_t written = 0;        // bajty zapsané do neaktivního oddílu
+  uint32_t copied = 0;         // z toho převzato z běžícího image (delta)
+  uint32_t durationMs = 0;     // poslední dokončená aktualizace
+  uint32_t attempts = 0;
+  uint32_t failures = 0;
+  uint32_t rejectedSignatures = 0;  // trigger bez podpisu nebo s neplatným podpisem
+  uint32_t bufferBytes = 0;    // pevný buffer stahování
+  FixedString<63> error;
+};
+
+// Stahuje firmware (celý image nebo deltu, DeltaPatch.h) z HTTP ve vlastním
+// tasku po kusech přímo do neaktivního OTA oddílu, takže loop() s displejem,
+// senzory a MQTT běží dál. Paměť je konstantní: jeden buffer na příjem
+// a jeden na kopírování z běžícího image. Trigger musí nést podpis SHA-256
+// nového image klíčem, jehož veřejná část je ve firmware (OtaSigningKey.h);
+// po stažení se image ověří proti podepsanému hashi a bootloader ho po
+// restartu vrátí, pokud ho firmware nepotvrdí.
+class OtaUpdater {
+ public:
+  static constexpr size_t BUFFER_BYTES = 1024;
+  static constexpr size_t MAX_SIGNATURE = 72;  // ECDSA P-256 v DER
+
+  // Zjistí, jestli běží nepotvrzený image z předchozí aktualizace
+  void begin();
+  // Spustí stahování; sha256Hex = očekávaný hash výsledného image (64 hex znaků),
+  // signatureHex = jeho podpis ECDSA P-256 (DER v hex, scripts/ota_sign.py)
+  bool start(const char* url, const char* sha256Hex, const char* signatureHex, const char*& message);
+  // Volá loop(): potvrdí nový image po zdravém startu, nebo ho po limitu vrátí
+  void confirmBoot(bool healthy, unsigned long now);
+
+  OtaState state() const { return (OtaState)state_.load(std::memory_order_acquire); }
+  bool busy() const { return state() == OTA_DOWNLOADING; }
+  uint8_t progressPercent() const;
+  OtaStats getStats() const;
+  static const char* stateText(OtaState state);
+
+ private:
+  static void taskEntry(void* arg);
+  void run();
+  bool download();
+  bool writeTarget(const uint8_t* data, size_t length, uint32_t imageSize);
+  bool checkSource(uint32_t sourceSize, const uint8_t* sourceSha256);
+  bool runningImageMatches();
+  bool fail(const char* message);
+
+  FixedString<159> url_;
+  uint8_t expectedSha_[32];
+  uint8_t buffer_[BUFFER_BYTES];
+
+  TaskHandle_t task_ = nullptr;
+  const esp_partition_t* target_ = nullptr;
+  esp_ota_handle_t handle_ = 0;
+  bool handleOpen_ = false;
+  mbedtls_sha256_context sha_;  // hash zapisovaného image, jen task stahování
+
+  std::atomic<uint8_t> state_{OTA_IDLE};
+  std::atomic<uint32_t> received_{0};
+  std::atomic<uint32_t> total_{0};
+  std::atomic<uint32_t> written_{0};
+  std::atomic<uint32_t> copied_{0};
+  bool delta_ = false;
+  bool pendingVerify_ = false;
+  uint32_t durationMs_ = 0;
+  uint32_t attempts_ = 0;
+  uint32_t failures_ = 0;
+  uint32_t rejectedSignatures_ = 0;
+  FixedString<63> error_;  // platné ve stavu OTA_FAILED
+};
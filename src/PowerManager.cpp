@@ -0,0 +1,115 @@
+#include "PowerManager.h"
+
+#include "Log.h"
+
+#include <WiFi.h>
+#include <esp_err.h>
+#include <esp_idf_version.h>
+#include <esp_pm.h>
+
+namespace {
+constexpr unsigned long DEFAULT_IDLE_MS = 10;  // původní chování loop() bez úsporného režimu
+
+// Hrubý model spotřeby ESP32-C3 (mA) pro odhad průměrného proudu
+constexpr float CURRENT_ACTIVE_MA = 24.0f;
+constexpr float CURRENT_IDLE_NO_PM_MA = 16.0f;
+constexpr float CURRENT_LIGHT_SLEEP_MA = 1.5f;  // light sleep + modem sleep (DTIM beacony)
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+typedef esp_pm_config_t PmConfig;
+#else
+typedef esp_pm_config_esp32c3_t PmConfig;
+#endif
+
+esp_err_t configurePm(bool lightSleep) {
+  PmConfig cfg = {};
+  cfg.max_freq_mhz = 160;
+  cfg.min_freq_mhz = 40;
+  cfg.light_sleep_enable = lightSleep;
+  return esp_pm_configure(&cfg);
+}
+}  // namespace
+
+void PowerManager::begin(bool lowPower, unsigned long wakeLatencyBudgetMs) {
+  lowPower_ = lowPower;
+  wakeLatencyBudgetMs_ = wakeLatencyBudgetMs > 0 ? wakeLatencyBudgetMs : 1;
+  loopStartUs_ = micros();
+  if (!lowPower_) return;
+
+  // Modem sleep mezi DTIM beacony; uplatní se při startu STA
+  WiFi.setSleep(WIFI_PS_MIN_MODEM);
+
+  esp_err_t err = configurePm(true);
+  lightSleepEnabled_ = err == ESP_OK;
+  if (!lightSleepEnabled_) {
+    // Framework bez tickless idle - aspoň dynamické snižování frekvence
+    LOGW(POWER, "light sleep nedostupny (%s), pouze DFS", esp_err_to_name(err));
+    configurePm(false);
+  }
+  LOGI(POWER, "usporny rezim, light sleep=%s, wake budget=%lu ms",
+       lightSleepEnabled_ ? "ano" : "ne", wakeLatencyBudgetMs_);
+}
+
+void PowerManager::addDeadline(unsigned long at) {
+  if (!haveDeadline_ || (long)(at - nextDeadline_) < 0) {
+    nextDeadline_ = at;
+    haveDeadline_ = true;
+  }
+}
+
+void PowerManager::idle() {
+  uint32_t idleStartUs = micros();
+  awakeUs_ += idleStartUs - loopStartUs_;
+
+  unsigned long sleepMs = DEFAULT_IDLE_MS;
+  if (lowPower_) {
+    // Spát do nejbližšího termínu, nejdéle wake budget (příchozí MQTT/HTTP čeká nanejvýš tak dlouho)
+    sleepMs = wakeLatencyBudgetMs_;
+    if (haveDeadline_) {
+      long untilDeadline = (long)(nextDeadline_ - millis());
+      if (untilDeadline <= 0) {
+        sleepMs = 0;
+      } else if ((unsigned long)untilDeadline < sleepMs) {
+        sleepMs = (unsigned long)untilDeadline;
+      }
+    }
+  }
+  haveDeadline_ = false;
+
+  if (sleepMs == 0) {
+    yield();
+  } else {
+    delay(sleepMs);
+  }
+
+  uint32_t wokeUs = micros();
+  uint32_t sleptUs = wokeUs - idleStartUs;
+  idleUs_ += sleptUs;
+  loopStartUs_ = wokeUs;
+
+  if (sleepMs > 0) {
+    uint32_t plannedUs = sleepMs * 1000UL;
+    uint32_t latencyUs = sleptUs > plannedUs ? sleptUs - plannedUs : 0;
+    wakeCount_++;
+    wakeLatencySumUs_ += latencyUs;
+    if (latencyUs > wakeLatencyMaxUs_) wakeLatencyMaxUs_ = latencyUs;
+  }
+}
+
+PowerStats PowerManager::getStats() const {
+  PowerStats stats;
+  stats.lowPowerActive = lowPower_;
+  stats.lightSleepEnabled = lightSleepEnabled_;
+  stats.idleMs = idleUs_ / 1000ULL;
+  stats.awakeMs = awakeUs_ / 1000ULL;
+  stats.wakeCount = wakeCount_;
+  stats.wakeLatencyAvgUs = wakeCount_ ? (uint32_t)(wakeLatencySumUs_ / wakeCount_) : 0;
+  stats.wakeLatencyMaxUs = wakeLatencyMaxUs_;
+
+  uint64_t totalUs = idleUs_ + awakeUs_;
+  if (totalUs > 0) {
+    float idleCurrent = lightSleepEnabled_ ? CURRENT_LIGHT_SLEEP_MA : CURRENT_IDLE_NO_PM_MA;
+    stats.avgCurrentMa = (CURRENT_ACTIVE_MA * (float)awakeUs_ + idleCurrent * (float)idleUs_) / (float)totalUs;
+  }
+  return stats;
+}
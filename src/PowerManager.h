@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Arduino.h>
+
+struct PowerStats {
+  bool lowPowerActive = false;
+  bool lightSleepEnabled = false;   // automatický light sleep (esp_pm) se podařilo zapnout
+  uint64_t idleMs = 0;              // čas předaný idle tasku (light sleep, pokud je povolen)
+  uint64_t awakeMs = 0;             // čas strávený prací v loop()
+  uint32_t wakeCount = 0;
+  uint32_t wakeLatencyAvgUs = 0;    // zpoždění mezi plánovaným probuzením a návratem do loop()
+  uint32_t wakeLatencyMaxUs = 0;
+  float avgCurrentMa = 0.0f;        // odhad z modelu spotřeby MCU (bez senzoru a displeje)
+};
+
+// Plánuje spánek mezi termíny práce v loop(). Každý průchod loop() nahlásí
+// nejbližší termíny přes addDeadline() a na konci zavolá idle().
+class PowerManager {
+ public:
+  void begin(bool lowPower, unsigned long wakeLatencyBudgetMs);
+  void addDeadline(unsigned long at);
+  void idle();
+
+  PowerStats getStats() const;
+
+ private:
+  bool lowPower_ = false;
+  bool lightSleepEnabled_ = false;
+  unsigned long wakeLatencyBudgetMs_ = 50;
+
+  bool haveDeadline_ = false;
+  unsigned long nextDeadline_ = 0;
+
+  uint32_t loopStartUs_ = 0;
+  uint64_t idleUs_ = 0;
+  uint64_t awakeUs_ = 0;
+  uint32_t wakeCount_ = 0;
+  uint64_t wakeLatencySumUs_ = 0;
+  uint32_t wakeLatencyMaxUs_ = 0;
+};
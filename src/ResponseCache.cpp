@@ -0,0 +1,49 @@
+#include "ResponseCache.h"
+
+namespace {
+uint32_t fnv1a(const char* data, size_t length) {
+  uint32_t hash = 2166136261UL;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (uint8_t)data[i];
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+}  // namespace
+
+bool ResponseCache::store(uint64_t version, const char* body, size_t length, uint32_t buildUs) {
+  if (length >= MAX_BODY) {
+    // Useknuté tělo by byl neplatný JSON; starý obsah už neplatí (ETag by vedl na chybné 304)
+    valid_ = false;
+    oversized_++;
+    return false;
+  }
+  memcpy(body_, body, length);
+  body_[length] = '\0';
+  length_ = length;
+  version_ = version;
+  valid_ = true;
+
+  // ETag z obsahu - stejná data po restartu mají stejný ETag
+  snprintf(etag_, sizeof(etag_), "\"%08lx-%x\"", (unsigned long)fnv1a(body_, length_), (unsigned)(length_ & 0xFFF));
+
+  misses_++;
+  buildUsTotal_ += buildUs;
+  return true;
+}
+
+bool ResponseCache::matches(const String& ifNoneMatch) const {
+  if (!valid_ || ifNoneMatch.length() == 0) return false;
+  // If-None-Match může obsahovat seznam ETagů nebo "*"
+  return ifNoneMatch == "*" || strstr(ifNoneMatch.c_str(), etag_) != nullptr;
+}
+
+ResponseCacheStats ResponseCache::getStats() const {
+  ResponseCacheStats stats;
+  stats.hits = hits_;
+  stats.misses = misses_;
+  stats.notModified = notModified_;
+  stats.oversized = oversized_;
+  stats.buildAvgUs = misses_ ? (uint32_t)(buildUsTotal_ / misses_) : 0;
+  return stats;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <Arduino.h>
+
+struct ResponseCacheStats {
+  uint32_t hits = 0;         // odpověď z předserializovaného bufferu
+  uint32_t misses = 0;       // nové sestavení JSON
+  uint32_t notModified = 0;  // 304 na podmíněný GET
+  uint32_t oversized = 0;    // tělo větší než MAX_BODY, posláno mimo cache
+  uint32_t buildAvgUs = 0;
+};
+
+// Předserializovaná odpověď API s verzí a silným ETagem (hash obsahu).
+// Volající určí verzi (např. pořadí vzorku + generace stavu); dokud se
+// nezmění, opakované dotazy jen posílají hotový buffer nebo 304.
+class ResponseCache {
+ public:
+  static constexpr size_t MAX_BODY = 2048;  // /api/data s TMEP URL, /api/config s plnými textovými poli
+
+  bool isFresh(uint64_t version) const { return valid_ && version_ == version; }
+  // false = tělo se nevejde (délka se kontroluje dřív, než se body čte); nic se
+  // neuloží, předchozí obsah se zneplatní a volající pošle odpověď mimo cache
+  bool store(uint64_t version, const char* body, size_t length, uint32_t buildUs);
+
+  bool matches(const String& ifNoneMatch) const;
+  void countHit() { hits_++; }
+  void countNotModified() { notModified_++; }
+
+  const char* etag() const { return etag_; }
+  const char* body() const { return body_; }
+  size_t length() const { return length_; }
+  ResponseCacheStats getStats() const;
+
+ private:
+  bool valid_ = false;
+  uint64_t version_ = 0;
+  char body_[MAX_BODY];
+  size_t length_ = 0;
+  char etag_[20] = {0};
+
+  uint32_t hits_ = 0;
+  uint32_t misses_ = 0;
+  uint32_t notModified_ = 0;
+  uint32_t oversized_ = 0;
+  uint64_t buildUsTotal_ = 0;
+};
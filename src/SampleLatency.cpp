@@ -0,0 +1,36 @@
+#include "SampleLatency.h"
+
+// Vzorky chodí po ~2 s, MQTT a TMEP běží na vlastních intervalech (10 s, 60 s)
+const uint32_t LatencyHistogram::UPPER_MS[BUCKETS] = {
+    10, 50, 100, 250, 500, 1000, 2000, 5000, 10000, 30000, 60000, UINT32_MAX,
+};
+
+void LatencyTracker::record(LatencyConsumer consumer, uint32_t sequence, uint32_t ageMs) {
+  if (consumer >= LAT_CONSUMER_COUNT || sequence == 0) return;
+  LatencyHistogram& h = histograms_[consumer];
+  if (sequence == h.lastSequence) return;
+  h.lastSequence = sequence;
+
+  uint8_t bucket = 0;
+  while (bucket < LatencyHistogram::BUCKETS - 1 && ageMs > LatencyHistogram::UPPER_MS[bucket]) bucket++;
+  h.counts[bucket]++;
+  h.deliveries++;
+  h.totalMs += ageMs;
+  h.lastMs = ageMs;
+  if (ageMs > h.maxMs) h.maxMs = ageMs;
+}
+
+const char* LatencyTracker::consumerName(LatencyConsumer consumer) {
+  switch (consumer) {
+    case LAT_DISPLAY:
+      return "display";
+    case LAT_MQTT:
+      return "mqtt";
+    case LAT_TMEP:
+      return "tmep";
+    case LAT_WEB:
+      return "web";
+    default:
+      return "?";
+  }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Odběratelé vzorku, u kterých se měří stáří hodnoty při doručení
+enum LatencyConsumer : uint8_t {
+  LAT_DISPLAY = 0,  // snímek odeslán na panel
+  LAT_MQTT,         // JSON potvrzen brokerem (PUBACK; u QoS 0 předán do spojení)
+  LAT_TMEP,         // HTTP request na TMEP potvrzen
+  LAT_WEB,          // /api/data odeslané prohlížeči
+  LAT_CONSUMER_COUNT,
+};
+
+struct LatencyHistogram {
+  static constexpr uint8_t BUCKETS = 12;
+  static const uint32_t UPPER_MS[BUCKETS];  // horní mez koše, poslední = bez omezení
+
+  uint32_t counts[BUCKETS] = {0};
+  uint32_t deliveries = 0;
+  uint64_t totalMs = 0;
+  uint32_t maxMs = 0;
+  uint32_t lastMs = 0;
+  uint32_t lastSequence = 0;
+
+  uint32_t avgMs() const { return deliveries ? (uint32_t)(totalMs / deliveries) : 0; }
+};
+
+// Stáří vzorku (od načtení z I2C) v okamžiku, kdy ho odběratel poprvé
+// doručil. Každý vzorek se u odběratele započítá jen jednou - překreslení
+// displeje kvůli stavu Wi-Fi nebo opakovaný dotaz webu histogram nezkreslí.
+// Nezávisí na Arduino API; stáří počítá volající.
+class LatencyTracker {
+ public:
+  void record(LatencyConsumer consumer, uint32_t sequence, uint32_t ageMs);
+  const LatencyHistogram& histogram(LatencyConsumer consumer) const { return histograms_[consumer]; }
+  static const char* consumerName(LatencyConsumer consumer);
+
+ private:
+  LatencyHistogram histograms_[LAT_CONSUMER_COUNT];
+};
@@ -0,0 +1,496 @@
+#include "SampleLog.h"
+
+#include "Log.h"
+
+namespace {
+constexpr const char* LOG_DIR = "/log";
+constexpr uint32_t SEGMENT_MAGIC = 0x31474C53;  // "SLG1"
+constexpr uint8_t SEGMENT_VERSION = 1;
+constexpr uint16_t BLOCK_MAGIC = 0xB10C;
+constexpr uint32_t SEGMENT_BYTES = 32 * 1024;
+
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t len) {
+  crc = ~crc;
+  while (len--) {
+    crc ^= *data++;
+    for (uint8_t k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+int32_t channelScale(uint8_t kind) {
+  return channelKindInfo((ChannelKind)kind).decimals == 1 ? 10 : 1;
+}
+
+// --- Bitový zápis/čtení (MSB first) ---
+
+void writeBits(uint8_t* buf, uint32_t& pos, uint32_t value, uint8_t bits) {
+  for (int8_t i = bits - 1; i >= 0; i--) {
+    uint32_t byteIdx = pos >> 3;
+    uint8_t mask = 0x80 >> (pos & 7);
+    if (value & (1UL << i)) {
+      buf[byteIdx] |= mask;
+    } else {
+      buf[byteIdx] &= ~mask;
+    }
+    pos++;
+  }
+}
+
+bool readBits(const uint8_t* buf, uint32_t limitBits, uint32_t& pos, uint8_t bits, uint32_t& value) {
+  if (pos + bits > limitBits) return false;
+  value = 0;
+  for (uint8_t i = 0; i < bits; i++) {
+    value = (value << 1) | ((buf[pos >> 3] >> (7 - (pos & 7))) & 1);
+    pos++;
+  }
+  return true;
+}
+
+// Gorilla bucket kódování: 0 | 10+7b | 110+9b | 1110+12b | 1111+32b
+void writeSigned(uint8_t* buf, uint32_t& pos, int32_t v) {
+  if (v == 0) {
+    writeBits(buf, pos, 0, 1);
+  } else if (v >= -63 && v <= 64) {
+    writeBits(buf, pos, 0b10, 2);
+    writeBits(buf, pos, (uint32_t)(v + 63), 7);
+  } else if (v >= -255 && v <= 256) {
+    writeBits(buf, pos, 0b110, 3);
+    writeBits(buf, pos, (uint32_t)(v + 255), 9);
+  } else if (v >= -2047 && v <= 2048) {
+    writeBits(buf, pos, 0b1110, 4);
+    writeBits(buf, pos, (uint32_t)(v + 2047), 12);
+  } else {
+    writeBits(buf, pos, 0b1111, 4);
+    writeBits(buf, pos, (uint32_t)v, 32);
+  }
+}
+
+bool readSigned(const uint8_t* buf, uint32_t limitBits, uint32_t& pos, int32_t& v) {
+  uint32_t bit = 0;
+  uint8_t ones = 0;
+  while (ones < 4) {
+    if (!readBits(buf, limitBits, pos, 1, bit)) return false;
+    if (bit == 0) break;
+    ones++;
+  }
+  uint32_t raw = 0;
+  switch (ones) {
+    case 0: v = 0; return true;
+    case 1: if (!readBits(buf, limitBits, pos, 7, raw)) return false; v = (int32_t)raw - 63; return true;
+    case 2: if (!readBits(buf, limitBits, pos, 9, raw)) return false; v = (int32_t)raw - 255; return true;
+    case 3: if (!readBits(buf, limitBits, pos, 12, raw)) return false; v = (int32_t)raw - 2047; return true;
+    default: if (!readBits(buf, limitBits, pos, 32, raw)) return false; v = (int32_t)raw; return true;
+  }
+}
+
+// Dekóduje jeden blok; vrací false, pokud visitor požádal o ukončení
+bool decodeBlock(const uint8_t* payload, uint16_t payloadBytes, uint16_t sampleCount, uint32_t firstTs,
+                 const uint8_t* kinds, uint8_t channelCount, uint32_t from, uint32_t to,
+                 const std::function<bool(const LoggedSample&)>& visitor, size_t& visited) {
+  uint32_t limit = (uint32_t)payloadBytes * 8;
+  uint32_t pos = 0;
+  uint32_t ts = firstTs;
+  int32_t delta = 0;
+  uint32_t mask = 0;
+  int32_t values[MAX_CHANNELS] = {0};
+
+  LoggedSample sample;
+  sample.channelCount = channelCount;
+  sample.kinds = kinds;
+
+  for (uint16_t n = 0; n < sampleCount; n++) {
+    if (n > 0) {
+      int32_t dod = 0;
+      if (!readSigned(payload, limit, pos, dod)) return true;
+      delta += dod;
+      ts += delta;
+    }
+    uint32_t changed = 0;
+    if (!readBits(payload, limit, pos, 1, changed)) return true;
+    if (changed && !readBits(payload, limit, pos, channelCount, mask)) return true;
+
+    for (uint8_t c = 0; c < channelCount; c++) {
+      if (!(mask & (1UL << (channelCount - 1 - c)))) continue;
+      int32_t d = 0;
+      if (!readSigned(payload, limit, pos, d)) return true;
+      values[c] += d;
+    }
+
+    if (ts < from) continue;
+    if (ts > to) return false;
+
+    sample.timestamp = ts;
+    sample.validMask = mask;
+    for (uint8_t c = 0; c < channelCount; c++) {
+      sample.values[c] = (float)values[c] / (float)channelScale(kinds[c]);
+    }
+    visited++;
+    if (!visitor(sample)) return false;
+  }
+  return true;
+}
+}  // namespace
+
+bool SampleLog::begin(fs::FS& fs, uint32_t budgetBytes) {
+  fs_ = &fs;
+  budgetBytes_ = budgetBytes;
+  if (!fs_->exists(LOG_DIR) && !fs_->mkdir(LOG_DIR)) {
+    LOGW(HIST, "nelze vytvorit adresar /log");
+    return false;
+  }
+
+  mounted_ = true;
+  resetEncoder();
+  scanSegments();
+  recoverLastSegment();
+  enforceBudget();
+
+  SampleLogStats stats = getStats();
+  LOGI(HIST, "%u segmentu, %lu B, opraveno %lu bloku", stats.segments,
+       (unsigned long)stats.bytesOnFlash, (unsigned long)recoveredTornBlocks_);
+  return true;
+}
+
+void SampleLog::segmentPath(uint32_t id, char* out, size_t size) const {
+  snprintf(out, size, "%s/%08lx.slg", LOG_DIR, (unsigned long)id);
+}
+
+void SampleLog::resetEncoder() {
+  bitPos_ = 0;
+  blockSamples_ = 0;
+  blockFirstTs_ = 0;
+  prevTs_ = 0;
+  prevDelta_ = 0;
+  prevMask_ = 0;
+  memset(prevValues_, 0, sizeof(prevValues_));
+  memset(block_, 0, sizeof(block_));
+}
+
+void SampleLog::scanSegments() {
+  firstSegmentId_ = 0;
+  lastSegmentId_ = 0;
+
+  File dir = fs_->open(LOG_DIR);
+  if (!dir) return;
+  File f = dir.openNextFile();
+  while (f) {
+    const char* name = f.name();
+    const char* slash = strrchr(name, '/');
+    if (slash) name = slash + 1;
+    uint32_t id = strtoul(name, nullptr, 16);
+    if (id > 0) {
+      if (firstSegmentId_ == 0 || id < firstSegmentId_) firstSegmentId_ = id;
+      if (id > lastSegmentId_) lastSegmentId_ = id;
+    }
+    f.close();
+    f = dir.openNextFile();
+  }
+  dir.close();
+}
+
+void SampleLog::recoverLastSegment() {
+  segmentOpen_ = false;
+  if (lastSegmentId_ == 0) return;
+
+  char path[32];
+  segmentPath(lastSegmentId_, path, sizeof(path));
+  File f = fs_->open(path, FILE_READ);
+  if (!f) return;
+
+  SegmentHeader hdr;
+  if (f.read((uint8_t*)&hdr, sizeof(hdr)) != sizeof(hdr) || hdr.magic != SEGMENT_MAGIC ||
+      hdr.version != SEGMENT_VERSION || hdr.channelCount > MAX_CHANNELS) {
+    // Segment bez platné hlavičky (výpadek hned po založení)
+    f.close();
+    fs_->remove(path);
+    if (lastSegmentId_ == firstSegmentId_) {
+      firstSegmentId_ = lastSegmentId_ = 0;
+    } else {
+      lastSegmentId_--;
+    }
+    recoveredTornBlocks_++;
+    return;
+  }
+
+  // Projít bloky a ověřit CRC - rozepsaný konec znamená, že do segmentu už nepřipisujeme
+  uint32_t offset = sizeof(hdr);
+  size_t fileSize = f.size();
+  bool intact = true;
+  while (offset < fileSize) {
+    BlockHeader bh;
+    if (f.read((uint8_t*)&bh, sizeof(bh)) != sizeof(bh) || bh.magic != BLOCK_MAGIC ||
+        bh.payloadBytes > BLOCK_BYTES || offset + sizeof(bh) + bh.payloadBytes > fileSize ||
+        f.read(block_, bh.payloadBytes) != bh.payloadBytes) {
+      intact = false;
+      break;
+    }
+    uint32_t crc = bh.crc;
+    bh.crc = 0;
+    if (crc32Update(crc32Update(0, (const uint8_t*)&bh, sizeof(bh)), block_, bh.payloadBytes) != crc) {
+      intact = false;
+      break;
+    }
+    offset += sizeof(bh) + bh.payloadBytes;
+  }
+  f.close();
+  memset(block_, 0, sizeof(block_));
+  segmentBytes_ = offset;
+
+  if (!intact) {
+    recoveredTornBlocks_++;
+    LOGW(HIST, "poskozeny konec segmentu %s na offsetu %lu", path, (unsigned long)offset);
+    return;
+  }
+
+  if (offset < SEGMENT_BYTES) {
+    segmentHeader_ = hdr;
+    segmentOpen_ = true;
+  }
+}
+
+bool SampleLog::openSegmentForAppend(const uint8_t* kinds, uint8_t channelCount) {
+  uint32_t id = lastSegmentId_ + 1;
+  char path[32];
+  segmentPath(id, path, sizeof(path));
+
+  SegmentHeader hdr = {};
+  hdr.magic = SEGMENT_MAGIC;
+  hdr.version = SEGMENT_VERSION;
+  hdr.channelCount = channelCount;
+  memcpy(hdr.kinds, kinds, channelCount);
+
+  File f = fs_->open(path, FILE_WRITE);
+  if (!f) return false;
+  bool ok = f.write((const uint8_t*)&hdr, sizeof(hdr)) == sizeof(hdr);
+  f.close();
+  if (!ok) {
+    fs_->remove(path);
+    return false;
+  }
+
+  if (firstSegmentId_ == 0) firstSegmentId_ = id;
+  lastSegmentId_ = id;
+  segmentHeader_ = hdr;
+  segmentBytes_ = sizeof(hdr);
+  segmentOpen_ = true;
+  return true;
+}
+
+bool SampleLog::append(uint32_t timestamp, const SensorRegistry& registry, const SensorSample& sample) {
+  if (!mounted_) return false;
+  uint32_t startUs = micros();
+
+  uint8_t channelCount = registry.channelCount();
+  uint8_t kinds[MAX_CHANNELS];
+  for (uint8_t c = 0; c < channelCount; c++) kinds[c] = registry.channel(c).kind;
+
+  // Změna sestavy senzorů = nový segment
+  if (segmentOpen_ && (segmentHeader_.channelCount != channelCount ||
+                       memcmp(segmentHeader_.kinds, kinds, channelCount) != 0)) {
+    flush();
+    segmentOpen_ = false;
+  }
+  if (!segmentOpen_ && !openSegmentForAppend(kinds, channelCount)) return false;
+
+  if (blockSamples_ > 0 && timestamp <= prevTs_) return false;
+
+  // Nejhorší případ: 36 b čas + maska + 36 b na kanál
+  uint32_t worstBits = 36 + 1 + channelCount + channelCount * 36UL;
+  if (bitPos_ + worstBits > BLOCK_BYTES * 8UL) flush();
+
+  if (blockSamples_ == 0) {
+    blockFirstTs_ = timestamp;
+  } else {
+    int32_t delta = (int32_t)(timestamp - prevTs_);
+    writeSigned(block_, bitPos_, delta - prevDelta_);
+    prevDelta_ = delta;
+  }
+  prevTs_ = timestamp;
+
+  uint32_t mask = 0;
+  for (uint8_t c = 0; c < channelCount; c++) {
+    if (sample.isValid(c)) mask |= 1UL << (channelCount - 1 - c);
+  }
+  if (blockSamples_ == 0 || mask != prevMask_) {
+    writeBits(block_, bitPos_, 1, 1);
+    writeBits(block_, bitPos_, mask, channelCount);
+    prevMask_ = mask;
+  } else {
+    writeBits(block_, bitPos_, 0, 1);
+  }
+
+  // Hodnoty kvantované na publikovanou přesnost, delta vůči předchozímu vzorku
+  for (uint8_t c = 0; c < channelCount; c++) {
+    if (!(mask & (1UL << (channelCount - 1 - c)))) continue;
+    int32_t q = (int32_t)lroundf(sample.values[c] * (float)channelScale(kinds[c]));
+    writeSigned(block_, bitPos_, q - prevValues_[c]);
+    prevValues_[c] = q;
+  }
+
+  blockSamples_++;
+  samplesWritten_++;
+  rawBytesWritten_ += 4 + 4UL * channelCount;
+
+  uint32_t elapsed = micros() - startUs;
+  appendUsTotal_ += elapsed;
+  if (elapsed > appendMaxUs_) appendMaxUs_ = elapsed;
+
+  if (blockSamples_ >= BLOCK_MAX_SAMPLES) flush();
+  return true;
+}
+
+void SampleLog::flush() {
+  if (!mounted_ || blockSamples_ == 0 || !segmentOpen_) return;
+  uint32_t startUs = micros();
+
+  BlockHeader bh;
+  bh.magic = BLOCK_MAGIC;
+  bh.payloadBytes = (uint16_t)((bitPos_ + 7) / 8);
+  bh.sampleCount = blockSamples_;
+  bh.reserved = 0;
+  bh.firstTimestamp = blockFirstTs_;
+  bh.crc = 0;
+  bh.crc = crc32Update(crc32Update(0, (const uint8_t*)&bh, sizeof(bh)), block_, bh.payloadBytes);
+
+  char path[32];
+  segmentPath(lastSegmentId_, path, sizeof(path));
+  File f = fs_->open(path, FILE_APPEND);
+  if (f) {
+    // Hlavička i data v jednom zápisu; LittleFS je potvrdí až při close()
+    f.write((const uint8_t*)&bh, sizeof(bh));
+    f.write(block_, bh.payloadBytes);
+    f.close();
+    segmentBytes_ += sizeof(bh) + bh.payloadBytes;
+    encodedBytesWritten_ += sizeof(bh) + bh.payloadBytes;
+  } else {
+    LOGW(HIST, "nelze otevrit %s, blok zahozen", path);
+  }
+
+  resetEncoder();
+  if (segmentBytes_ >= SEGMENT_BYTES) segmentOpen_ = false;
+  enforceBudget();
+
+  flushCount_++;
+  flushUsTotal_ += micros() - startUs;
+}
+
+void SampleLog::enforceBudget() {
+  if (firstSegmentId_ == 0) return;
+  // Segmenty kromě aktuálního mají ~SEGMENT_BYTES, nejstarší se mažou jako v kruhu
+  while (lastSegmentId_ > firstSegmentId_ &&
+         (lastSegmentId_ - firstSegmentId_ + 1) * SEGMENT_BYTES > budgetBytes_) {
+    char path[32];
+    segmentPath(firstSegmentId_, path, sizeof(path));
+    fs_->remove(path);
+    firstSegmentId_++;
+  }
+}
+
+size_t SampleLog::query(uint32_t from, uint32_t to, const std::function<bool(const LoggedSample&)>& visitor) {
+  size_t visited = 0;
+  if (!mounted_) return 0;
+  uint32_t startUs = micros();
+  size_t result = queryStored(from, to, visitor, visited);
+  lastQuerySamples_ = visited;
+  lastQueryUs_ = micros() - startUs;
+  return result;
+}
+
+size_t SampleLog::queryStored(uint32_t from, uint32_t to, const std::function<bool(const LoggedSample&)>& visitor,
+                              size_t& visited) {
+  // Visitor posílá data klientovi a web server přitom pouští zámek stavu, takže
+  // loop() může mezi bloky připsat vzorek, zapsat blok, založit segment nebo
+  // smazat nejstarší. Dotaz proto čte stav z okamžiku začátku: segmenty jen do
+  // délky, kterou měly, a blok z RAM si zkopíruje. Segment smazaný během dotazu
+  // se přeskočí (nebo dočte jen po poslední přečtený blok).
+  const uint32_t lastId = lastSegmentId_;
+  const uint32_t lastBytes = segmentBytes_;
+  const bool tailPending = blockSamples_ > 0 && segmentOpen_;
+  const uint16_t tailBytes = (uint16_t)((bitPos_ + 7) / 8);
+  const uint16_t tailSamples = blockSamples_;
+  const uint32_t tailFirstTs = blockFirstTs_;
+  SegmentHeader tailHeader = segmentHeader_;
+  uint8_t tail[BLOCK_BYTES];
+  if (tailPending) memcpy(tail, block_, tailBytes);
+
+  uint8_t payload[BLOCK_BYTES];
+  char path[32];
+
+  for (uint32_t id = firstSegmentId_; id != 0 && id <= lastId; id++) {
+    if (id < firstSegmentId_) continue;
+    // Přeskočit segment, pokud už následující začíná před "from"
+    if (id < lastSegmentId_) {
+      segmentPath(id + 1, path, sizeof(path));
+      File next = fs_->open(path, FILE_READ);
+      if (next) {
+        BlockHeader nb;
+        bool skip = next.seek(sizeof(SegmentHeader)) && next.read((uint8_t*)&nb, sizeof(nb)) == sizeof(nb) &&
+                    nb.magic == BLOCK_MAGIC && nb.firstTimestamp <= from;
+        next.close();
+        if (skip) continue;
+      }
+    }
+
+    segmentPath(id, path, sizeof(path));
+    File f = fs_->open(path, FILE_READ);
+    if (!f) continue;
+
+    SegmentHeader hdr;
+    if (f.read((uint8_t*)&hdr, sizeof(hdr)) != sizeof(hdr) || hdr.magic != SEGMENT_MAGIC ||
+        hdr.channelCount > MAX_CHANNELS) {
+      f.close();
+      continue;
+    }
+
+    // Poslední segment jen po délku ze začátku dotazu - novější bloky jsou v kopii z RAM
+    uint32_t limit = id == lastId ? lastBytes : UINT32_MAX;
+    uint32_t offset = sizeof(hdr);
+    while (id >= firstSegmentId_) {
+      BlockHeader bh;
+      if (offset + sizeof(bh) > limit || f.read((uint8_t*)&bh, sizeof(bh)) != sizeof(bh) ||
+          bh.magic != BLOCK_MAGIC || bh.payloadBytes > BLOCK_BYTES || offset + sizeof(bh) + bh.payloadBytes > limit ||
+          f.read(payload, bh.payloadBytes) != bh.payloadBytes) {
+        break;
+      }
+      offset += sizeof(bh) + bh.payloadBytes;
+      uint32_t crc = bh.crc;
+      bh.crc = 0;
+      if (crc32Update(crc32Update(0, (const uint8_t*)&bh, sizeof(bh)), payload, bh.payloadBytes) != crc) break;
+      if (bh.firstTimestamp > to) {
+        f.close();
+        return visited;
+      }
+      if (!decodeBlock(payload, bh.payloadBytes, bh.sampleCount, bh.firstTimestamp, hdr.kinds, hdr.channelCount,
+                       from, to, visitor, visited)) {
+        f.close();
+        return visited;
+      }
+    }
+    f.close();
+  }
+
+  // Blok, který byl na začátku dotazu ještě jen v RAM
+  if (tailPending) {
+    decodeBlock(tail, tailBytes, tailSamples, tailFirstTs, tailHeader.kinds, tailHeader.channelCount, from, to,
+                visitor, visited);
+  }
+  return visited;
+}
+
+SampleLogStats SampleLog::getStats() const {
+  SampleLogStats stats;
+  stats.mounted = mounted_;
+  stats.segments = firstSegmentId_ ? (uint16_t)(lastSegmentId_ - firstSegmentId_ + 1) : 0;
+  stats.bytesOnFlash = stats.segments ? (stats.segments - 1) * SEGMENT_BYTES + segmentBytes_ : 0;
+  stats.samplesWritten = samplesWritten_;
+  stats.rawBytesWritten = rawBytesWritten_;
+  stats.encodedBytesWritten = encodedBytesWritten_ + (bitPos_ + 7) / 8;
+  stats.appendAvgUs = samplesWritten_ ? (uint32_t)(appendUsTotal_ / samplesWritten_) : 0;
+  stats.appendMaxUs = appendMaxUs_;
+  stats.flushAvgUs = flushCount_ ? (uint32_t)(flushUsTotal_ / flushCount_) : 0;
+  stats.recoveredTornBlocks = recoveredTornBlocks_;
+  stats.lastQuerySamples = lastQuerySamples_;
+  stats.lastQueryUs = lastQueryUs_;
+  return stats;
+}
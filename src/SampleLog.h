@@ -0,0 +1,109 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include <functional>
+
+#include "SensorRegistry.h"
+
+// Jeden dekódovaný vzorek z logu
+struct LoggedSample {
+  uint32_t timestamp = 0;  // unix čas (s)
+  uint8_t channelCount = 0;
+  uint32_t validMask = 0;          // kanál c = bit (channelCount - 1 - c)
+  const uint8_t* kinds = nullptr;  // ChannelKind pro každý kanál segmentu
+  float values[MAX_CHANNELS];
+};
+
+struct SampleLogStats {
+  bool mounted = false;
+  uint16_t segments = 0;
+  uint32_t bytesOnFlash = 0;
+  uint32_t samplesWritten = 0;    // od bootu
+  uint32_t rawBytesWritten = 0;   // velikost stejných vzorků bez komprese
+  uint32_t encodedBytesWritten = 0;
+  uint32_t appendAvgUs = 0;
+  uint32_t appendMaxUs = 0;
+  uint32_t flushAvgUs = 0;
+  uint32_t recoveredTornBlocks = 0;
+  uint32_t lastQuerySamples = 0;
+  uint32_t lastQueryUs = 0;
+};
+
+// Append-only log vzorků na LittleFS. Vzorky se komprimují po blocích
+// (delta-of-delta časů, delta kvantovaných hodnot s Gorilla bucket kódováním)
+// a každý blok nese CRC, takže rozepsaný blok po výpadku napájení se při
+// bootu i při čtení jen zahodí. Segmenty tvoří kruh s pevným rozpočtem flash.
+class SampleLog {
+ public:
+  bool begin(fs::FS& fs, uint32_t budgetBytes);
+  bool append(uint32_t timestamp, const SensorRegistry& registry, const SensorSample& sample);
+  void flush();
+
+  // Projde vzorky v rozsahu [from, to]; visitor vrací false pro ukončení
+  size_t query(uint32_t from, uint32_t to, const std::function<bool(const LoggedSample&)>& visitor);
+
+  SampleLogStats getStats() const;
+
+ private:
+  static constexpr uint16_t BLOCK_BYTES = 768;
+  static constexpr uint16_t BLOCK_MAX_SAMPLES = 30;
+
+  struct SegmentHeader {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t channelCount;
+    uint8_t reserved[2];
+    uint8_t kinds[MAX_CHANNELS];
+  };
+
+  struct BlockHeader {
+    uint16_t magic;
+    uint16_t payloadBytes;
+    uint16_t sampleCount;
+    uint16_t reserved;
+    uint32_t firstTimestamp;
+    uint32_t crc;
+  };
+
+  bool openSegmentForAppend(const uint8_t* kinds, uint8_t channelCount);
+  void scanSegments();
+  void recoverLastSegment();
+  void enforceBudget();
+  void segmentPath(uint32_t id, char* out, size_t size) const;
+  void resetEncoder();
+  size_t queryStored(uint32_t from, uint32_t to, const std::function<bool(const LoggedSample&)>& visitor,
+                     size_t& visited);
+
+  fs::FS* fs_ = nullptr;
+  uint32_t budgetBytes_ = 0;
+  bool mounted_ = false;
+
+  uint32_t firstSegmentId_ = 0;
+  uint32_t lastSegmentId_ = 0;
+  bool segmentOpen_ = false;
+  uint32_t segmentBytes_ = 0;
+  SegmentHeader segmentHeader_ = {};
+
+  // Stav kodéru aktuálního bloku
+  uint8_t block_[BLOCK_BYTES];
+  uint32_t bitPos_ = 0;
+  uint16_t blockSamples_ = 0;
+  uint32_t blockFirstTs_ = 0;
+  uint32_t prevTs_ = 0;
+  int32_t prevDelta_ = 0;
+  uint32_t prevMask_ = 0;
+  int32_t prevValues_[MAX_CHANNELS];
+
+  uint32_t samplesWritten_ = 0;
+  uint32_t rawBytesWritten_ = 0;
+  uint32_t encodedBytesWritten_ = 0;
+  uint64_t appendUsTotal_ = 0;
+  uint32_t appendMaxUs_ = 0;
+  uint32_t flushCount_ = 0;
+  uint64_t flushUsTotal_ = 0;
+  uint32_t recoveredTornBlocks_ = 0;
+  uint32_t lastQuerySamples_ = 0;
+  uint32_t lastQueryUs_ = 0;
+};
@@ -0,0 +1,233 @@
+#include "SamplePayload.h"
+
+JsonWriter::JsonWriter(char* out, size_t size) : out_(out), size_(size) {
+  put('{');
+}
+
+void JsonWriter::put(const char* s, size_t length) {
+  if (overflowed_) return;
+  // Místo pro uzavírací '}' a nulu držet vždy volné
+  if (length_ + length + 2 > size_) {
+    overflowed_ = true;
+    return;
+  }
+  memcpy(out_ + length_, s, length);
+  length_ += length;
+}
+
+void JsonWriter::quoted(const char* s) {
+  put('"');
+  for (const char* p = s; *p; p++) {
+    char c = *p;
+    if (c == '"' || c == '\\') {
+      char escaped[2] = {'\\', c};
+      put(escaped, 2);
+    } else if ((uint8_t)c < 0x20) {
+      char escaped[7];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned)c);
+      put(escaped, 6);
+    } else {
+      put(c);
+    }
+  }
+  put('"');
+}
+
+void JsonWriter::key(const char* name) {
+  if (!first_) put(',');
+  first_ = false;
+  if (!name) return;  // prvek pole
+  quoted(name);
+  put(':');
+}
+
+void JsonWriter::raw(const char* name, const char* json) {
+  key(name);
+  put(json, strlen(json));
+}
+
+void JsonWriter::string(const char* name, const char* value) {
+  key(name);
+  quoted(value);
+}
+
+void JsonWriter::integer(const char* name, uint64_t value) {
+  char digits[21];
+  size_t length = snprintf(digits, sizeof(digits), "%llu", (unsigned long long)value);
+  key(name);
+  put(digits, length);
+}
+
+void JsonWriter::fixed(const char* name, float value, uint8_t decimals) {
+  char text[24];
+  size_t length = formatFixed(value, decimals, text, sizeof(text));
+  key(name);
+  put(text, length);
+}
+
+void JsonWriter::number(const char* name, float value) {
+  char text[24];
+  size_t length = snprintf(text, sizeof(text), "%g", value);
+  key(name);
+  put(text, length);
+}
+
+void JsonWriter::boolean(const char* name, bool value) {
+  key(name);
+  put(value ? "true" : "false", value ? 4 : 5);
+}
+
+void JsonWriter::beginArray(const char* name) {
+  key(name);
+  put('[');
+  first_ = true;
+}
+
+void JsonWriter::arrayString(const char* value) {
+  key(nullptr);
+  quoted(value);
+}
+
+void JsonWriter::endArray() {
+  put(']');
+  first_ = false;
+}
+
+size_t JsonWriter::finish() {
+  if (overflowed_) return 0;
+  out_[length_++] = '}';
+  out_[length_] = '\0';
+  return length_;
+}
+
+const AirQualityEntity AIR_QUALITY_ENTITIES[AQE_COUNT] = {
+    {"aqi", "Air Quality Index", nullptr, "aqi", nullptr},
+    {"aqi_nowcast", "PM2.5 AQI (NowCast)", nullptr, "aqi", nullptr},
+    {"pm25_nowcast", "PM2.5 NowCast", "µg/m³", "pm25", nullptr},
+    {"aqi_24h", "PM2.5 AQI (24h)", nullptr, "aqi", nullptr},
+    {"pm25_24h", "PM2.5 24h Average", "µg/m³", "pm25", nullptr},
+    {"co2_15m", "CO2 15min Average", "ppm", "carbon_dioxide", nullptr},
+    {"co2_aqi", "CO2 Comfort Index", nullptr, nullptr, "mdi:molecule-co2"},
+    {"voc_1h", "VOC Index 1h Average", nullptr, nullptr, "mdi:chemical-weapon"},
+    {"voc_aqi", "VOC Comfort Index", nullptr, nullptr, "mdi:air-filter"},
+};
+
+bool airQualityValue(const AirQualityIndex& aq, AirQualityEntityId id, float& value, uint8_t& decimals) {
+  decimals = 0;
+  switch (id) {
+    case AQE_AQI:
+      value = aq.overall;
+      return aq.dominant != AQ_NONE;
+    case AQE_AQI_NOWCAST:
+      value = aq.aqiNowCast;
+      return aq.nowCastValid;
+    case AQE_PM25_NOWCAST:
+      value = aq.pm25NowCast;
+      decimals = 1;
+      return aq.nowCastValid;
+    case AQE_AQI_24H:
+      value = aq.aqiDay;
+      return aq.dayValid;
+    case AQE_PM25_24H:
+      value = aq.pm25Day;
+      decimals = 1;
+      return aq.dayValid;
+    case AQE_CO2_15M:
+      value = aq.co2Mean;
+      return aq.co2Valid;
+    case AQE_CO2_AQI:
+      value = aq.co2Index;
+      return aq.co2Valid;
+    case AQE_VOC_1H:
+      value = aq.vocMean;
+      return aq.vocValid;
+    case AQE_VOC_AQI:
+      value = aq.vocIndex;
+      return aq.vocValid;
+    default:
+      return false;
+  }
+}
+
+size_t buildSensorJson(const SensorRegistry& sensors, const SensorSample& sample, const SampleText& text,
+                       const AirQualityIndex& aq, uint32_t uptimeS, uint32_t ageMs, char* out, size_t size) {
+  JsonWriter json(out, size);
+  for (uint8_t i = 0; i < sensors.channelCount(); i++) {
+    if (sample.isValid(i)) json.raw(sensors.channel(i).key, text.value(i));
+  }
+
+  if (aq.dominant != AQ_NONE) {
+    json.string("quality", AirQualityEngine::categoryLabel(aq.overall));
+    json.string("quality_pollutant", AirQualityEngine::pollutantName(aq.dominant));
+  }
+  for (uint8_t id = 0; id < AQE_COUNT; id++) {
+    float value;
+    uint8_t decimals;
+    if (airQualityValue(aq, (AirQualityEntityId)id, value, decimals)) {
+      json.fixed(AIR_QUALITY_ENTITIES[id].key, value, decimals);
+    }
+  }
+
+  json.integer("uptime", uptimeS);
+  // Razítko vzorku: backend z ts (SNTP) nebo age_ms dopočítá zpoždění přes broker
+  json.integer("seq", sample.sequence);
+  if (sample.unixMs) json.integer("ts", sample.unixMs);
+  json.integer("age_ms", ageMs);
+  if (sample.replayed) json.boolean("replay", true);
+
+  // Kanály, jejichž hodnota je z minulého okna střídy nebo se ještě neustálila
+  uint32_t stale = sensors.staleMask(sample) & sample.validMask;
+  if (stale) {
+    json.beginArray("stale");
+    for (uint8_t i = 0; i < sensors.channelCount(); i++) {
+      if (stale & (1UL << i)) json.arrayString(sensors.channel(i).key);
+    }
+    json.endArray();
+  }
+  return json.finish();
+}
+
+size_t buildAlarmJson(const char* key, bool active, float value, float threshold, char* out, size_t size) {
+  JsonWriter json(out, size);
+  json.string("key", key);
+  json.string("state", active ? "on" : "off");
+  json.fixed("value", value, 1);
+  json.number("threshold", threshold);
+  return json.finish();
+}
+
+namespace {
+// Text kanálu pro token (jméno bez oddělovačů); neplatný nebo neznámý kanál = nullptr
+const char* tokenValue(const SensorRegistry& sensors, const SensorSample& sample, const SampleText& text,
+                       const char* name, size_t nameLength) {
+  for (uint8_t i = 0; i < sensors.channelCount(); i++) {
+    const SensorChannel& ch = sensors.channel(i);
+    if (!sample.isValid(i) || strlen(ch.tmepToken) != nameLength || strncmp(ch.tmepToken, name, nameLength) != 0) {
+      continue;
+    }
+    return text.value(i);
+  }
+  return nullptr;
+}
+}  // namespace
+
+bool buildTmepUrl(const char* domain, const char* params, const SensorRegistry& sensors, const SensorSample& sample,
+                  const SampleText& text, TmepUrl& url) {
+  url.clear();
+  if (!*domain || !*params || !sample.anyValid()) return false;
+  bool fits = url.appendf("http://%s.tmep.cz/?", domain);
+
+  for (const char* p = params; *p && fits;) {
+    char close = *p == '*' ? '*' : (*p == '{' ? '}' : '\0');
+    const char* end = close ? strchr(p + 1, close) : nullptr;
+    const char* value = end ? tokenValue(sensors, sample, text, p + 1, end - p - 1) : nullptr;
+    if (value) {
+      fits = url.append(value);
+      p = end + 1;
+    } else {
+      fits = url.append(*p++);
+    }
+  }
+  if (!fits) url.clear();
+  return fits;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "AirQuality.h"
+#include "FixedString.h"
+#include "SampleText.h"
+#include "SensorRegistry.h"
+
+// JSON objekt zapisovaný rovnou do bufferu volajícího, bez dokumentu a bez
+// heapu. Co se nevejde, označí zápis za přetečený; finish() pak vrátí 0
+// a volající zprávu zahodí (useknutý JSON by odběratelé nepřečetli).
+class JsonWriter {
+ public:
+  JsonWriter(char* out, size_t size);
+
+  void raw(const char* key, const char* json);  // hotový JSON (text čísla ze SampleText, null)
+  void string(const char* key, const char* value);
+  void integer(const char* key, uint64_t value);
+  void fixed(const char* key, float value, uint8_t decimals);  // formatFixed
+  void number(const char* key, float value);                   // nejkratší zápis (%g)
+  void boolean(const char* key, bool value);
+  void beginArray(const char* key);
+  void arrayString(const char* value);
+  void endArray();
+
+  // Uzavře objekt; délka textu bez ukončovací nuly, 0 = nevešel se
+  size_t finish();
+  bool overflowed() const { return overflowed_; }
+
+ private:
+  void put(const char* s, size_t length);
+  void put(char c) { put(&c, 1); }
+  void quoted(const char* s);
+  void key(const char* name);
+
+  char* out_;
+  size_t size_;
+  size_t length_ = 0;
+  bool first_ = true;  // první prvek objektu nebo pole (bez čárky)
+  bool overflowed_ = false;
+};
+
+// Entity indexů kvality vzduchu: hodnoty v JSON senzorových dat, samostatné
+// topicy a discovery HA
+struct AirQualityEntity {
+  const char* key;
+  const char* name;
+  const char* unit;
+  const char* devClass;
+  const char* icon;
+};
+
+// Pořadí odpovídá AIR_QUALITY_ENTITIES
+enum AirQualityEntityId : uint8_t {
+  AQE_AQI = 0,
+  AQE_AQI_NOWCAST,
+  AQE_PM25_NOWCAST,
+  AQE_AQI_24H,
+  AQE_PM25_24H,
+  AQE_CO2_15M,
+  AQE_CO2_AQI,
+  AQE_VOC_1H,
+  AQE_VOC_AQI,
+  AQE_COUNT,
+};
+
+extern const AirQualityEntity AIR_QUALITY_ENTITIES[AQE_COUNT];
+
+// Hodnota entity a její přesnost; false = okno zatím nemá dost dat
+bool airQualityValue(const AirQualityIndex& aq, AirQualityEntityId id, float& value, uint8_t& decimals);
+
+// JSON senzorových dat (<base>/sensor, <base>/replay/sensor): platné kanály
+// textem ze SampleText, indexy kvality vzduchu, razítko vzorku a zastaralé
+// kanály. Délka JSON v out, 0 = nevejde se.
+size_t buildSensorJson(const SensorRegistry& sensors, const SensorSample& sample, const SampleText& text,
+                       const AirQualityIndex& aq, uint32_t uptimeS, uint32_t ageMs, char* out, size_t size);
+
+// JSON přechodu alarmu (<base>/alarm); 0 = nevejde se
+size_t buildAlarmJson(const char* key, bool active, float value, float threshold, char* out, size_t size);
+
+using TmepUrl = FixedString<384>;  // http://<domena>.tmep.cz/? + šablona s dosazenými hodnotami
+
+// Jeden průchod šablonou params (tokeny *NAME* a {NAME}) přímo do bufferu
+// URL; neplatný kanál token nenahradí. false = prázdná konfigurace, žádná
+// platná hodnota nebo URL delší než buffer (url zůstane prázdná).
+bool buildTmepUrl(const char* domain, const char* params, const SensorRegistry& sensors, const SensorSample& sample,
+                  const SampleText& text, TmepUrl& url);
@@ -0,0 +1,85 @@
+#include "SampleText.h"
+
+#include <math.h>
+
+namespace {
+constexpr uint8_t FIXED_DECIMALS_MAX = 3;
+constexpr float FIXED_LIMIT = 1e6f;  // 1e6 * 10^3 se ještě vejde do int32
+const uint32_t SCALE[FIXED_DECIMALS_MAX + 1] = {1, 10, 100, 1000};
+}  // namespace
+
+size_t formatFixed(float value, uint8_t decimals, char* buf, size_t size) {
+  if (size == 0) return 0;
+  if (decimals > FIXED_DECIMALS_MAX || !isfinite(value) || fabsf(value) >= FIXED_LIMIT) {
+    int n = snprintf(buf, size, "%.*f", decimals, value);
+    if (n < 0) n = 0;
+    return (size_t)n < size ? n : size - 1;
+  }
+
+  // Součin v double je přesný, takže rozhoduje skutečná hodnota floatu a
+  // výsledek je stejný jako u printf: přesná půlka na sudou číslici, znaménko
+  // podle floatu (-0.0 i záporná hodnota zaokrouhlená na nulu dají "-0.0")
+  double scaled = fabs((double)value * SCALE[decimals]);
+  uint32_t magnitude = (uint32_t)scaled;
+  double fraction = scaled - magnitude;
+  if (fraction > 0.5 || (fraction == 0.5 && (magnitude & 1))) magnitude++;
+
+  // Číslice odzadu do pomocného bufferu: desetinná místa, tečka, celá část
+  char digits[16];
+  size_t n = 0;
+  for (uint8_t d = 0; d < decimals; d++) {
+    digits[n++] = '0' + magnitude % 10;
+    magnitude /= 10;
+  }
+  if (decimals) digits[n++] = '.';
+  do {
+    digits[n++] = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while (magnitude);
+  if (signbit(value)) digits[n++] = '-';
+
+  size_t length = n < size ? n : size - 1;
+  for (size_t i = 0; i < length; i++) buf[i] = digits[n - 1 - i];
+  buf[length] = '\0';
+  return length;
+}
+
+bool SampleText::update(const SensorRegistry& sensors, const SensorSample& sample) {
+  if (formatted_ && sample.sequence == sequence_) return false;
+
+  uint32_t startUs = micros();
+  uint8_t count = sensors.channelCount();
+  for (uint8_t i = 0; i < count; i++) {
+    if (!sample.isValid(i)) {
+      value_[i][0] = '\0';
+      strcpy(display_[i], "--");
+      continue;
+    }
+    const ChannelKindInfo& info = channelKindInfo(sensors.channel(i).kind);
+    formatFixed(sample.values[i], info.decimals, value_[i], VALUE_SIZE);
+    if (info.displayDecimals == info.decimals) {
+      memcpy(display_[i], value_[i], VALUE_SIZE);
+    } else {
+      formatFixed(sample.values[i], info.displayDecimals, display_[i], VALUE_SIZE);
+      values_++;
+    }
+    values_++;
+  }
+  sequence_ = sample.sequence;
+  formatted_ = true;
+
+  uint32_t elapsedUs = micros() - startUs;
+  samples_++;
+  formatTotalUs_ += elapsedUs;
+  if (elapsedUs > formatMaxUs_) formatMaxUs_ = elapsedUs;
+  return true;
+}
+
+SampleTextStats SampleText::getStats() const {
+  SampleTextStats stats;
+  stats.samples = samples_;
+  stats.values = values_;
+  stats.formatAvgUs = samples_ ? (uint32_t)(formatTotalUs_ / samples_) : 0;
+  stats.formatMaxUs = formatMaxUs_;
+  return stats;
+}
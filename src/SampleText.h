@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "SensorRegistry.h"
+
+// Desetinné číslo s pevným počtem míst bez printf: hodnota se převede na
+// celé číslo v jednotkách poslední číslice a vypíše po číslicích. Text je
+// stejný jako z snprintf("%.*f"). Vrací délku textu; hodnoty od 1e6, více
+// než 3 desetinná místa a NaN/nekonečno jdou přes snprintf.
+size_t formatFixed(float value, uint8_t decimals, char* buf, size_t size);
+
+struct SampleTextStats {
+  uint32_t samples = 0;      // naformátované vzorky
+  uint32_t values = 0;       // naformátované hodnoty (kanál x přesnost)
+  uint32_t formatAvgUs = 0;  // celý vzorek, všechny kanály v obou přesnostech
+  uint32_t formatMaxUs = 0;
+};
+
+// Texty hodnot posledního vzorku. Každý nový vzorek se naformátuje jednou
+// a displej, MQTT, TMEP i web API berou hotové řetězce. Plní se v loop()
+// hned po SensorRegistry::process(), web handlery je čtou pod zámkem stavu.
+class SampleText {
+ public:
+  static constexpr size_t VALUE_SIZE = 12;  // "-123456.789" + nula
+
+  // Přepočítá texty, pokud sample nese jiný vzorek než minule; true = přepočteno
+  bool update(const SensorRegistry& sensors, const SensorSample& sample);
+  uint32_t sequence() const { return sequence_; }
+
+  // Přesnost MQTT, TMEP a web API (ChannelKindInfo::decimals); "" = neplatná hodnota
+  const char* value(uint8_t channel) const { return value_[channel]; }
+  // Totéž pro JSON (serialized): neplatná hodnota = null
+  const char* json(uint8_t channel) const { return value_[channel][0] ? value_[channel] : "null"; }
+  // Přesnost displeje (displayDecimals); "--" = neplatná hodnota
+  const char* display(uint8_t channel) const { return formatted_ ? display_[channel] : "--"; }
+
+  SampleTextStats getStats() const;
+
+ private:
+  char value_[MAX_CHANNELS][VALUE_SIZE] = {};
+  char display_[MAX_CHANNELS][VALUE_SIZE] = {};
+  uint32_t sequence_ = 0;
+  bool formatted_ = false;
+
+  uint32_t samples_ = 0;
+  uint32_t values_ = 0;
+  uint64_t formatTotalUs_ = 0;
+  uint32_t formatMaxUs_ = 0;
+};
@@ -0,0 +1,62 @@
+#include "Scd4xDriver.h"
+
+#include "Log.h"
+
+namespace {
+constexpr uint8_t SCD4X_ADDR = 0x62;
+}  // namespace
+
+ChannelKind Scd4xDriver::channelKind(uint8_t index) const {
+  static const ChannelKind CHANNELS[] = {CH_CO2, CH_TEMPERATURE, CH_HUMIDITY};
+  return CHANNELS[index < 3 ? index : 0];
+}
+
+bool Scd4xDriver::begin() {
+  scd4x_.begin(*bus_.wire, SCD4X_ADDR);
+
+  // Po restartu MCU může senzor stále běžet v periodickém režimu
+  scd4x_.wakeUp();
+  scd4x_.stopPeriodicMeasurement();
+  scd4x_.reinit();
+
+  int16_t error = scd4x_.startPeriodicMeasurement();
+  if (error != 0) {
+    char msg[64];
+    errorToString(error, msg, sizeof(msg));
+    LOGE(SENS, "SCD4X: startPeriodicMeasurement() CHYBA: %s", msg);
+    ready_ = false;
+    return false;
+  }
+
+  ready_ = true;
+  return true;
+}
+
+SensorPollResult Scd4xDriver::poll(float* values) {
+  // Krok 1: dotaz na připravenost dat, krok 2 (další průchod): čtení
+  if (!dataReady_) {
+    bool ready = false;
+    if (scd4x_.getDataReadyStatus(ready) != 0) return SENSOR_POLL_ERROR;
+    if (!ready) return SENSOR_POLL_RETRY;
+    dataReady_ = true;
+    return SENSOR_POLL_CONTINUE;
+  }
+
+  dataReady_ = false;
+  uint16_t co2 = 0;
+  float temp = 0.0f;
+  float hum = 0.0f;
+  int16_t error = scd4x_.readMeasurement(co2, temp, hum);
+  if (error != 0) {
+    char msg[64];
+    errorToString(error, msg, sizeof(msg));
+    LOGE(SENS, "SCD4X: readMeasurement() CHYBA: %s", msg);
+    return SENSOR_POLL_ERROR;
+  }
+  if (co2 == 0) return SENSOR_POLL_ERROR;
+
+  values[0] = co2;
+  values[1] = temp;
+  values[2] = hum;
+  return SENSOR_POLL_SAMPLE;
+}
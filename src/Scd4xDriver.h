@@ -0,0 +1,20 @@
+#pragma once
+
+#include <SensirionI2cScd4x.h>
+
+#include "SensorDriver.h"
+
+// SCD4x v periodickém režimu (nový vzorek každých 5 s)
+class Scd4xDriver : public SensorDriver {
+ public:
+  const char* model() const override { return "SCD4X"; }
+  bool begin() override;
+  uint8_t channelCount() const override { return 3; }
+  ChannelKind channelKind(uint8_t index) const override;
+  unsigned long sampleIntervalMs() const override { return 5000; }
+  SensorPollResult poll(float* values) override;
+
+ private:
+  SensirionI2cScd4x scd4x_;
+  bool dataReady_ = false;
+};
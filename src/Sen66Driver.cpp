@@ -0,0 +1,345 @@
+#include "Sen66Driver.h"
+
+#include "Log.h"
+
+#ifdef NO_ERROR
+#undef NO_ERROR
+#endif
+#define NO_ERROR 0
+
+namespace {
+// Příkazy bez parametrů posílané přímo (střída); knihovna po stopMeasurement()
+// čeká 1 s v delay(), což by zastavilo loop i web
+constexpr uint16_t CMD_START_MEASUREMENT = 0x0021;
+constexpr uint16_t CMD_STOP_MEASUREMENT = 0x0104;
+constexpr unsigned long STOP_EXECUTION_MS = 1000;  // po stopu senzor příkazy nepřijímá
+
+// Ustálení po startu měření: ventilátor a laser (PM), fotoakustické CO2 a
+// vyhřátí MOX senzoru pro indexy VOC/NOx. Teplota a vlhkost platí hned.
+constexpr unsigned long PM_CO2_WARMUP_MS = 30000;
+constexpr unsigned long GAS_WARMUP_MS = 60000;
+
+// Přibližný odběr SEN66 při 3.3 V pro odhad úspory
+constexpr float MEASURE_CURRENT_MA = 70.0f;
+constexpr float IDLE_CURRENT_MA = 2.6f;
+constexpr float SUPPLY_V = 3.3f;
+
+const ChannelKind SEN66_CHANNELS[] = {
+  CH_TEMPERATURE, CH_HUMIDITY, CH_PM1, CH_PM25, CH_PM4, CH_PM10, CH_VOC, CH_NOX, CH_CO2,
+};
+
+// Kontroly po skupinách kanálů; ve střídě se neplatná skupina jen vynechá
+bool climateLooksValid(const float temp, const float hum) {
+  if (isnan(temp) || isnan(hum)) return false;
+  return temp >= -40.0f && temp <= 85.0f && hum >= 0.0f && hum <= 100.0f;
+}
+
+bool pmLooksValid(const float pm1, const float pm25, const float pm4, const float pm10) {
+  if (isnan(pm1) || isnan(pm25) || isnan(pm4) || isnan(pm10)) return false;
+  if (pm1 < 0.0f || pm1 > 1000.0f) return false;
+  if (pm25 < 0.0f || pm25 > 1000.0f) return false;
+  if (pm4 < 0.0f || pm4 > 1000.0f) return false;
+  if (pm10 < 0.0f || pm10 > 1000.0f) return false;
+  return true;
+}
+
+bool gasLooksValid(const float voc, const float nox) {
+  if (isnan(voc) || isnan(nox)) return false;
+  return voc >= 0.0f && voc <= 500.0f && nox >= 0.0f && nox <= 500.0f;
+}
+
+bool co2LooksValid(const uint16_t co2) {
+  return co2 >= 350 && co2 <= 10000;
+}
+
+bool sensorValuesLookValid(const float pm1, const float pm25, const float pm4, const float pm10,
+                           const float hum, const float temp, const float voc, const float nox,
+                           const uint16_t co2) {
+  return climateLooksValid(temp, hum) && pmLooksValid(pm1, pm25, pm4, pm10) && gasLooksValid(voc, nox) &&
+         co2LooksValid(co2);
+}
+}  // namespace
+
+ChannelKind Sen66Driver::channelKind(uint8_t index) const {
+  return SEN66_CHANNELS[index < CHANNELS ? index : 0];
+}
+
+bool Sen66Driver::begin() {
+  sen66_.begin(*bus_.wire, SEN66_I2C_ADDR_6B);
+
+  int16_t error = sen66_.deviceReset();
+  if (error != NO_ERROR) {
+    char msg[64];
+    errorToString(error, msg, sizeof(msg));
+    LOGE(SENS, "SEN66: deviceReset() CHYBA: %s", msg);
+    ready_ = false;
+    return false;
+  }
+
+  delay(1200); // SEN66 potřebuje čas po resetu
+
+  // Přečíst sériové číslo
+  int8_t serialNumber[32] = {0};
+  error = sen66_.getSerialNumber(serialNumber, 32);
+  if (error != NO_ERROR) {
+    char msg[64];
+    errorToString(error, msg, sizeof(msg));
+    LOGE(SENS, "SEN66: getSerialNumber() CHYBA: %s", msg);
+  } else {
+    LOGI(SENS, "SEN66: S/N: %s", (const char*)serialNumber);
+  }
+
+  // Spustit měření
+  error = sen66_.startContinuousMeasurement();
+  if (error != NO_ERROR) {
+    char msg[64];
+    errorToString(error, msg, sizeof(msg));
+    LOGE(SENS, "SEN66: startContinuousMeasurement() CHYBA: %s", msg);
+    ready_ = false;
+    return false;
+  }
+
+  ready_ = true;
+  hardwareReady_ = true;
+  unsigned long now = millis();
+  stateSince_ = measureStartedAt_ = now;
+  sensorOn_ = true;
+  dutyState_ = DUTY_MEASURING;
+  windowEndAt_ = now + windowLengthMs(intervalMs_);  // první okno hned po startu
+  if (dutyPeriodMs_ > 0) {
+    LOGI(SENS, "SEN66: OK, strida %lu s (okno %lu s)", dutyPeriodMs_ / 1000, windowLengthMs(intervalMs_) / 1000);
+  } else {
+    LOGI(SENS, "SEN66: OK, mereni spusteno!");
+  }
+  return true;
+}
+
+unsigned long Sen66Driver::windowLengthMs(unsigned long intervalMs) {
+  return GAS_WARMUP_MS + intervalMs;
+}
+
+bool Sen66Driver::sendCommand(uint16_t command) {
+  bus_.wire->beginTransmission(SEN66_I2C_ADDR_6B);
+  bus_.wire->write((uint8_t)(command >> 8));
+  bus_.wire->write((uint8_t)(command & 0xFF));
+  return bus_.wire->endTransmission() == 0;
+}
+
+void Sen66Driver::setMeasuring(bool on, unsigned long now) {
+  (sensorOn_ ? onMs_ : offMs_) += now - stateSince_;
+  stateSince_ = now;
+  sensorOn_ = on;
+}
+
+// Jeden krok střídy mimo čtení; true = senzor měří a má se přečíst
+bool Sen66Driver::dutyStep(unsigned long now, SensorPollResult& result) {
+  switch (dutyState_) {
+    case DUTY_SAVING_VOC:
+      // VOC index je relativní k průměru prostředí, který se algoritmus učí
+      // hodiny; stop ho smaže. Stav se čte ještě při měření a vrací se před
+      // startem (zápis senzor přijme jen v idle), index pak navazuje.
+      vocStateSaved_ = sen66_.getVocAlgorithmState(vocState_, VOC_STATE_BYTES) == NO_ERROR;
+      if (!vocStateSaved_) {
+        vocStateErrors_++;
+        LOGW(SENS, "SEN66: cteni stavu VOC algoritmu CHYBA");
+      }
+      dutyState_ = DUTY_STOPPING;
+      result = SENSOR_POLL_CONTINUE;  // stop až v další transakci
+      return false;
+
+    case DUTY_STOPPING:
+      if (!sendCommand(CMD_STOP_MEASUREMENT)) {
+        LOGW(SENS, "SEN66: zastaveni mereni CHYBA");
+        result = SENSOR_POLL_RETRY;
+        return false;
+      }
+      setMeasuring(false, now);
+      dutyState_ = DUTY_IDLE;
+      // Další okno o periodu později; po zpoždění (chyba, přehrávání) navazuje hned
+      windowEndAt_ += dutyPeriodMs_;
+      if ((long)(windowEndAt_ - windowLengthMs(intervalMs_) - (now + STOP_EXECUTION_MS)) < 0) {
+        windowEndAt_ = now + STOP_EXECUTION_MS + windowLengthMs(intervalMs_);
+      }
+      result = SENSOR_POLL_IDLE;
+      return false;
+
+    case DUTY_IDLE:
+      if ((long)(now - (windowEndAt_ - windowLengthMs(intervalMs_))) < 0) {
+        result = SENSOR_POLL_IDLE;
+        return false;
+      }
+      if (vocStateSaved_) {
+        vocStateSaved_ = false;  // jeden pokus, při chybě index VOC začne znovu
+        if (sen66_.setVocAlgorithmState(vocState_, VOC_STATE_BYTES) == NO_ERROR) {
+          vocStateRestores_++;
+        } else {
+          vocStateErrors_++;
+          LOGW(SENS, "SEN66: obnova stavu VOC algoritmu CHYBA");
+        }
+        result = SENSOR_POLL_CONTINUE;  // start až v další transakci
+        return false;
+      }
+      if (!sendCommand(CMD_START_MEASUREMENT)) {
+        LOGW(SENS, "SEN66: start mereni CHYBA");
+        result = SENSOR_POLL_RETRY;
+        return false;
+      }
+      setMeasuring(true, now);
+      measureStartedAt_ = now;
+      dutyState_ = DUTY_MEASURING;
+      result = SENSOR_POLL_IDLE;  // první data za interval
+      return false;
+
+    case DUTY_MEASURING:
+    default:
+      return true;
+  }
+}
+
+// Vzorek v okně střídy: kanály, které se od startu ještě neustálily nebo
+// jsou mimo rozsah, jdou jako NaN (registry je označí jako zastaralé)
+SensorPollResult Sen66Driver::dutyValues(unsigned long now, const SensorTraceRecord& rec, float* values) {
+  unsigned long elapsed = now - measureStartedAt_;
+  bool pmCo2Ready = elapsed >= PM_CO2_WARMUP_MS;
+  bool gasReady = elapsed >= GAS_WARMUP_MS;
+
+  bool thValid = climateLooksValid(rec.temp, rec.hum);
+  bool pmValid = pmCo2Ready && pmLooksValid(rec.pm1, rec.pm25, rec.pm4, rec.pm10);
+  bool co2Valid = pmCo2Ready && co2LooksValid(rec.co2);
+  bool gasValid = gasReady && gasLooksValid(rec.voc, rec.nox);
+  if (!thValid && !pmValid && !co2Valid && !gasValid) return SENSOR_POLL_RETRY;
+
+  values[0] = thValid ? rec.temp + temperatureOffset_ : NAN;
+  values[1] = thValid ? rec.hum : NAN;
+  values[2] = pmValid ? rec.pm1 : NAN;
+  values[3] = pmValid ? rec.pm25 : NAN;
+  values[4] = pmValid ? rec.pm4 : NAN;
+  values[5] = pmValid ? rec.pm10 : NAN;
+  values[6] = gasValid ? rec.voc : NAN;
+  values[7] = gasValid ? rec.nox : NAN;
+  values[8] = co2Valid ? rec.co2 : NAN;
+
+  // Okno končí plánovaným vzorkem po ustálení všech kanálů; zastaví se v dalším pollu
+  if (gasReady && (long)(now + intervalMs_ / 2 - windowEndAt_) >= 0) {
+    windowComplete_ = true;
+    dutyState_ = DUTY_SAVING_VOC;
+    windows_++;
+    lastWindowMs_ = elapsed;
+    LOGD(SENS, "SEN66: konec okna po %lu ms", elapsed);
+  }
+  return SENSOR_POLL_SAMPLE;
+}
+
+Sen66DutyStats Sen66Driver::getDutyStats() const {
+  Sen66DutyStats stats;
+  stats.periodMs = dutyPeriodMs_;
+  stats.measuring = measuring();
+  stats.windows = windows_;
+  stats.lastWindowMs = lastWindowMs_;
+  stats.vocStateRestores = vocStateRestores_;
+  stats.vocStateErrors = vocStateErrors_;
+  stats.onMs = onMs_;
+  stats.offMs = offMs_;
+  if (hardwareReady_) (sensorOn_ ? stats.onMs : stats.offMs) += millis() - stateSince_;
+  uint64_t totalMs = stats.onMs + stats.offMs;
+  if (totalMs > 0) {
+    stats.avgCurrentMa = (stats.onMs * MEASURE_CURRENT_MA + stats.offMs * IDLE_CURRENT_MA) / totalMs;
+  }
+  stats.savedMwh = stats.offMs / 3600000.0f * (MEASURE_CURRENT_MA - IDLE_CURRENT_MA) * SUPPLY_V;
+  return stats;
+}
+
+bool Sen66Driver::startReplay(uint16_t speed, const char*& message) {
+  if (!trace_) {
+    message = "stopa neni k dispozici";
+    return false;
+  }
+  if (!trace_->startReplay(speed, message)) return false;
+  ready_ = true;
+  return true;
+}
+
+void Sen66Driver::stopTrace() {
+  if (!trace_) return;
+  trace_->stop();
+  ready_ = hardwareReady_;
+}
+
+unsigned long Sen66Driver::sampleIntervalMs() const {
+  if (trace_ && trace_->replaying()) return trace_->replayIntervalMs();
+  if (!dutyCycling()) return intervalMs_;
+  switch (dutyState_) {
+    case DUTY_SAVING_VOC:
+    case DUTY_STOPPING:
+      return 0;  // hned po posledním vzorku okna
+    case DUTY_IDLE: {
+      long wait = (long)(windowEndAt_ - windowLengthMs(intervalMs_) - millis());
+      return wait > 0 ? wait : 0;
+    }
+    default:
+      return intervalMs_;
+  }
+}
+
+bool Sen66Driver::replayStepMs(uint32_t& stepMs) const {
+  stepMs = replayStepMs_;
+  return replayed_;
+}
+
+SensorPollResult Sen66Driver::poll(float* values) {
+  SensorTraceRecord rec;
+  unsigned long now = millis();
+  replayed_ = false;
+  windowComplete_ = false;
+  bool duty = dutyCycling();
+  if (duty) {
+    SensorPollResult result;
+    if (!dutyStep(now, result)) return result;
+  }
+  if (trace_ && trace_->replaying()) {
+    if (!trace_->next(rec, replayStepMs_)) {
+      stopTrace();
+      return SENSOR_POLL_RETRY;
+    }
+    replayed_ = true;
+  } else {
+    rec.error = sen66_.readMeasuredValues(
+      rec.pm1, rec.pm25, rec.pm4, rec.pm10, rec.hum, rec.temp, rec.voc, rec.nox, rec.co2
+    );
+    if (trace_ && trace_->recording()) trace_->record(now, rec);
+  }
+
+  const float pm1 = rec.pm1, pm25 = rec.pm25, pm4 = rec.pm4, pm10 = rec.pm10;
+  const float hum = rec.hum, temp = rec.temp, voc = rec.voc, nox = rec.nox;
+  const uint16_t co2 = rec.co2;
+  const int16_t error = rec.error;
+
+  if (error != NO_ERROR) {
+    char msg[64];
+    errorToString(error, msg, sizeof(msg));
+    LOGE(SENS, "SEN66: readMeasuredValues() CHYBA: %s", msg);
+    return SENSOR_POLL_ERROR;
+  }
+
+  if (duty) return dutyValues(now, rec, values);
+
+  // Kontrola platnosti (SEN66 vrací NaN/0xFFFF při inicializaci)
+  if (!sensorValuesLookValid(pm1, pm25, pm4, pm10, hum, temp, voc, nox, co2)) {
+    LOGW(SENS, "SEN66: namerena neplatna data, preskakuji");
+    return SENSOR_POLL_ERROR;
+  }
+
+  values[0] = temp + temperatureOffset_;
+  values[1] = hum;
+  values[2] = pm1;
+  values[3] = pm25;
+  values[4] = pm4;
+  values[5] = pm10;
+  values[6] = voc;
+  values[7] = nox;
+  values[8] = co2;
+
+  LOGD(SENS, "SEN66: T(raw)=%.1f T(adj)=%.1f H=%.1f PM2.5=%.1f VOC=%.0f NOx=%.0f CO2=%u",
+       temp, values[0], hum, pm25, voc, nox, co2);
+  return SENSOR_POLL_SAMPLE;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <SensirionI2cSen66.h>
+
+#include "SensorDriver.h"
+#include "SensorTrace.h"
+
+struct Sen66DutyStats {
+  uint32_t periodMs = 0;     // 0 = nepřetržité měření
+  bool measuring = false;
+  uint32_t windows = 0;      // dokončená okna měření
+  uint32_t lastWindowMs = 0; // start měření -> poslední vzorek okna
+  uint64_t onMs = 0;         // ventilátor, laser a topení běží
+  uint64_t offMs = 0;        // zastaveno (idle)
+  float avgCurrentMa = 0.0f; // odhad podle poměru zapnuto/vypnuto
+  float savedMwh = 0.0f;     // odhad úspory proti nepřetržitému měření
+  uint32_t vocStateRestores = 0;  // okna, která navázala na uložený stav VOC algoritmu
+  uint32_t vocStateErrors = 0;    // čtení/zápis stavu selhalo, index VOC se učí znovu
+};
+
+class Sen66Driver : public SensorDriver {
+ public:
+  explicit Sen66Driver(unsigned long intervalMs = 2000) : intervalMs_(intervalMs) {}
+
+  void setTemperatureOffset(float offset) { temperatureOffset_ = offset; }
+
+  // Střída: měření běží jen v okně před koncem každé periody (periodMs, 0 =
+  // nepřetržitě) a mezi okny je zastavené. Okno trvá ustálení nejpomalejších
+  // kanálů plus jeden vzorek; dříve přečtené neustálené kanály jdou jako NaN.
+  void setDutyCycle(unsigned long periodMs) { dutyPeriodMs_ = periodMs; }
+  static unsigned long windowLengthMs(unsigned long intervalMs);
+  Sen66DutyStats getDutyStats() const;
+
+  // Stopa: záznam surových čtení, nebo jejich přehrání místo I2C (i bez připojeného senzoru)
+  void setTrace(SensorTrace* trace) { trace_ = trace; }
+  bool startReplay(uint16_t speed, const char*& message);
+  void stopTrace();
+
+  const char* model() const override { return "SEN66"; }
+  bool begin() override;
+  uint8_t channelCount() const override { return CHANNELS; }
+  ChannelKind channelKind(uint8_t index) const override;
+  unsigned long sampleIntervalMs() const override;
+  SensorPollResult poll(float* values) override;
+  bool replayStepMs(uint32_t& stepMs) const override;
+  bool measuring() const override { return !dutyCycling() || dutyState_ != DUTY_IDLE; }
+  bool windowComplete() const override { return windowComplete_; }
+
+ private:
+  static constexpr uint8_t CHANNELS = 9;
+  static constexpr uint8_t VOC_STATE_BYTES = 8;
+
+  enum DutyState : uint8_t { DUTY_IDLE = 0, DUTY_MEASURING, DUTY_SAVING_VOC, DUTY_STOPPING };
+
+  bool dutyCycling() const { return dutyPeriodMs_ > 0 && !(trace_ && trace_->replaying()); }
+  bool dutyStep(unsigned long now, SensorPollResult& result);
+  SensorPollResult dutyValues(unsigned long now, const SensorTraceRecord& rec, float* values);
+  bool sendCommand(uint16_t command);
+  void setMeasuring(bool on, unsigned long now);
+
+  SensirionI2cSen66 sen66_;
+  unsigned long intervalMs_;
+  float temperatureOffset_ = 0.0f;
+
+  SensorTrace* trace_ = nullptr;
+  bool hardwareReady_ = false;  // výsledek begin(), obnoví se po přehrávání
+  bool replayed_ = false;       // poslední poll() vrátil záznam ze stopy
+  uint32_t replayStepMs_ = 0;
+
+  unsigned long dutyPeriodMs_ = 0;
+  DutyState dutyState_ = DUTY_MEASURING;  // begin() spouští měření
+  bool windowComplete_ = false;
+  bool sensorOn_ = false;
+  unsigned long windowEndAt_ = 0;        // plánovaný konec okna (poslední vzorek)
+  unsigned long measureStartedAt_ = 0;
+  unsigned long stateSince_ = 0;         // začátek aktuálního úseku zapnuto/vypnuto
+  uint64_t onMs_ = 0;
+  uint64_t offMs_ = 0;
+  uint32_t windows_ = 0;
+  uint32_t lastWindowMs_ = 0;
+  uint8_t vocState_[VOC_STATE_BYTES] = {0};
+  bool vocStateSaved_ = false;
+  uint32_t vocStateRestores_ = 0;
+  uint32_t vocStateErrors_ = 0;
+};
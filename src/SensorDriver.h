@@ -0,0 +1,78 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Wire.h>
+
+// Druhy měřených veličin - pořadí určuje rozložení tabulky kanálů
+enum ChannelKind : uint8_t {
+  CH_TEMPERATURE = 0,
+  CH_HUMIDITY,
+  CH_PM1,
+  CH_PM25,
+  CH_PM4,
+  CH_PM10,
+  CH_VOC,
+  CH_NOX,
+  CH_CO2,
+  CH_KIND_COUNT,
+};
+
+struct ChannelKindInfo {
+  const char* key;        // MQTT topic / JSON klíč
+  const char* uidSuffix;  // HA unique_id = <sensor id>_<uidSuffix>
+  const char* name;
+  const char* unit;
+  const char* devClass;
+  const char* icon;
+  const char* tmepToken;
+  uint8_t decimals;         // MQTT, TMEP, web API
+  uint8_t displayDecimals;  // displej
+};
+
+const ChannelKindInfo& channelKindInfo(ChannelKind kind);
+
+// I2C sběrnice senzoru; muxChannel >= 0 = kanál multiplexeru TCA9548A
+// (ESP32-C3 má jediný I2C řadič, dva SEN66 se stejnou adresou jinak nejdou připojit)
+struct I2cBus {
+  TwoWire* wire = &Wire;
+  int8_t muxChannel = -1;
+};
+
+enum SensorPollResult {
+  SENSOR_POLL_SAMPLE = 0,  // values[] obsahuje nový vzorek
+  SENSOR_POLL_CONTINUE,    // transakce proběhla, další krok v příštím průchodu
+  SENSOR_POLL_RETRY,       // data ještě nejsou připravena
+  SENSOR_POLL_ERROR,
+  SENSOR_POLL_IDLE,        // senzor mezi okny měření neměří; další poll po sampleIntervalMs()
+};
+
+// Ovladač senzoru. poll() smí provést nejvýše jednu I2C transakci, aby se
+// senzory na sdílené sběrnici navzájem neblokovaly.
+class SensorDriver {
+ public:
+  virtual ~SensorDriver() {}
+
+  virtual const char* model() const = 0;
+  virtual bool begin() = 0;
+  virtual uint8_t channelCount() const = 0;
+  virtual ChannelKind channelKind(uint8_t index) const = 0;
+  virtual unsigned long sampleIntervalMs() const = 0;
+  // Kanál s NaN v values[] (hodnota se po startu ještě neustálila) si
+  // ponechá předchozí hodnotu a je označený jako zastaralý
+  virtual SensorPollResult poll(float* values) = 0;
+  // Vzorek z přehrávané stopy (SensorTrace): krok času stopy od předchozího
+  // vzorku; registry jím posouvá čas pipeline místo skutečného času
+  virtual bool replayStepMs(uint32_t& /*stepMs*/) const { return false; }
+  // Střída měření: false = senzor mezi okny neměří, hodnoty jeho kanálů jsou
+  // z minulého okna. windowComplete() = poslední vzorek uzavřel okno.
+  virtual bool measuring() const { return true; }
+  virtual bool windowComplete() const { return false; }
+
+  bool isReady() const { return ready_; }
+  const I2cBus& bus() const { return bus_; }
+  void setBus(const I2cBus& bus) { bus_ = bus; }
+
+ protected:
+  bool ready_ = false;
+  I2cBus bus_;
+};
@@ -0,0 +1,256 @@
+#include "SensorRegistry.h"
+
+#include "Log.h"
+
+#include <esp_timer.h>
+#include <sys/time.h>
+
+namespace {
+constexpr uint8_t TCA9548A_ADDR = 0x70;
+constexpr unsigned long RETRY_DELAY_MS = 200;
+constexpr time_t CLOCK_VALID_AFTER = 1600000000;  // dřív SNTP ještě neodpověděl
+
+const ChannelKindInfo KIND_INFO[CH_KIND_COUNT] = {
+  {"temperature", "temp",     "Teplota",   "°C",     "temperature",    "mdi:thermometer",   "TEMP", 1, 1},
+  {"humidity",    "humidity", "Vlhkost",   "%",      "humidity",       "mdi:water-percent", "HUM",  1, 1},
+  {"pm1",         "pm1",      "PM1.0",     "µg/m³",  "pm1",            "mdi:blur",          "PM1",  1, 0},
+  {"pm25",        "pm25",     "PM2.5",     "µg/m³",  "pm25",           "mdi:blur",          "PM2",  1, 0},
+  {"pm4",         "pm4",      "PM4.0",     "µg/m³",  NULL,             "mdi:blur-radial",   "PM4",  1, 0},
+  {"pm10",        "pm10",     "PM10",      "µg/m³",  "pm10",           "mdi:blur-radial",   "PM10", 1, 0},
+  {"voc",         "voc",      "VOC Index", "",       NULL,             "mdi:air-filter",    "VOC",  0, 0},
+  {"nox",         "nox",      "NOx Index", "",       NULL,             "mdi:molecule",      "NOX",  0, 0},
+  {"co2",         "co2",      "CO2",       "ppm",    "carbon_dioxide", "mdi:molecule-co2",  "CO2",  0, 0},
+};
+
+void copyUpper(char* dst, size_t size, const char* src) {
+  size_t i = 0;
+  for (; src[i] && i + 1 < size; i++) dst[i] = (char)toupper((unsigned char)src[i]);
+  dst[i] = '\0';
+}
+}  // namespace
+
+const ChannelKindInfo& channelKindInfo(ChannelKind kind) {
+  return KIND_INFO[kind < CH_KIND_COUNT ? kind : CH_TEMPERATURE];
+}
+
+SensorRegistry::SensorRegistry() {
+  for (uint8_t k = 0; k < CH_KIND_COUNT; k++) primaryIndex_[k] = -1;
+}
+
+bool SensorRegistry::add(SensorDriver* driver, const I2cBus& bus) {
+  if (!driver || sensorCount_ >= MAX_SENSORS) return false;
+
+  Slot& slot = slots_[sensorCount_];
+  slot.driver = driver;
+  driver->setBus(bus);
+
+  // Id z modelu, duplicitní modely dostanou pořadové číslo ("sen66", "sen66_2")
+  char base[8];
+  size_t i = 0;
+  for (const char* m = driver->model(); *m && i + 1 < sizeof(base); m++) base[i++] = (char)tolower((unsigned char)*m);
+  base[i] = '\0';
+  uint8_t sameModel = 0;
+  for (uint8_t s = 0; s < sensorCount_; s++) {
+    if (strcmp(slots_[s].driver->model(), driver->model()) == 0) sameModel++;
+  }
+  if (sameModel == 0) {
+    snprintf(slot.id, sizeof(slot.id), "%s", base);
+  } else {
+    snprintf(slot.id, sizeof(slot.id), "%s_%u", base, sameModel + 1);
+  }
+
+  sensorCount_++;
+  return true;
+}
+
+void SensorRegistry::begin() {
+  channelCount_ = 0;
+
+  for (uint8_t s = 0; s < sensorCount_; s++) {
+    Slot& slot = slots_[s];
+    selectBus(slot.driver->bus());
+    bool ok = slot.driver->begin();
+    LOGI(SENS, "%s (%s) %s", slot.id, slot.driver->model(), ok ? "OK" : "CHYBA");
+    buildChannels(s);
+    slot.nextDueAt = millis();
+  }
+}
+
+void SensorRegistry::buildChannels(uint8_t slotIndex) {
+  Slot& slot = slots_[slotIndex];
+  slot.firstChannel = channelCount_;
+
+  for (uint8_t c = 0; c < slot.driver->channelCount() && channelCount_ < MAX_CHANNELS; c++) {
+    ChannelKind kind = slot.driver->channelKind(c);
+    const ChannelKindInfo& info = channelKindInfo(kind);
+    SensorChannel& ch = channels_[channelCount_];
+    ch.kind = kind;
+    ch.sensorIndex = slotIndex;
+    ch.primary = primaryIndex_[kind] < 0;
+
+    snprintf(ch.uid, sizeof(ch.uid), "%s_%s", slot.id, info.uidSuffix);
+    if (ch.primary) {
+      primaryIndex_[kind] = channelCount_;
+      snprintf(ch.key, sizeof(ch.key), "%s", info.key);
+      snprintf(ch.name, sizeof(ch.name), "%s", info.name);
+      snprintf(ch.tmepToken, sizeof(ch.tmepToken), "%s", info.tmepToken);
+    } else {
+      char upperId[12];
+      copyUpper(upperId, sizeof(upperId), slot.id);
+      snprintf(ch.key, sizeof(ch.key), "%s_%s", info.key, slot.id);
+      snprintf(ch.name, sizeof(ch.name), "%s (%s)", info.name, upperId);
+      snprintf(ch.tmepToken, sizeof(ch.tmepToken), "%s_%s", info.tmepToken, upperId);
+    }
+    channelCount_++;
+  }
+}
+
+void SensorRegistry::selectBus(const I2cBus& bus) {
+  if (bus.muxChannel == activeMuxChannel_) return;
+  if (bus.muxChannel >= 0 || activeMuxChannel_ >= 0) {
+    bus.wire->beginTransmission(TCA9548A_ADDR);
+    bus.wire->write(bus.muxChannel >= 0 ? (uint8_t)(1 << bus.muxChannel) : 0);
+    bus.wire->endTransmission();
+  }
+  activeMuxChannel_ = bus.muxChannel;
+}
+
+bool SensorRegistry::process(unsigned long now) {
+  if (sensorCount_ == 0) return false;
+
+  // Round-robin: rozpracovaný senzor má přednost, jinak první, kterému uplynul interval
+  int8_t chosen = -1;
+  for (uint8_t i = 0; i < sensorCount_; i++) {
+    uint8_t s = (cursor_ + i) % sensorCount_;
+    if (slots_[s].inProgress) {
+      chosen = s;
+      break;
+    }
+  }
+  if (chosen < 0) {
+    for (uint8_t i = 0; i < sensorCount_; i++) {
+      uint8_t s = (cursor_ + i) % sensorCount_;
+      if (slots_[s].driver->isReady() && (long)(now - slots_[s].nextDueAt) >= 0) {
+        chosen = s;
+        break;
+      }
+    }
+  }
+  if (chosen < 0) return false;
+
+  Slot& slot = slots_[chosen];
+  float values[MAX_CHANNELS];
+  selectBus(slot.driver->bus());
+  SensorPollResult result = slot.driver->poll(values);
+
+  switch (result) {
+    case SENSOR_POLL_CONTINUE:
+      slot.inProgress = true;
+      return false;
+
+    case SENSOR_POLL_RETRY:
+      slot.inProgress = false;
+      slot.nextDueAt = now + RETRY_DELAY_MS;
+      return false;
+
+    case SENSOR_POLL_IDLE:
+      slot.inProgress = false;
+      slot.nextDueAt = now + slot.driver->sampleIntervalMs();
+      return false;
+
+    case SENSOR_POLL_ERROR:
+      slot.inProgress = false;
+      slot.errors++;
+      slot.nextDueAt = now + slot.driver->sampleIntervalMs();
+      cursor_ = (chosen + 1) % sensorCount_;
+      return false;
+
+    case SENSOR_POLL_SAMPLE:
+    default:
+      break;
+  }
+
+  slot.inProgress = false;
+  slot.samples++;
+  slot.nextDueAt = now + slot.driver->sampleIntervalMs();
+  cursor_ = (chosen + 1) % sensorCount_;
+
+  for (uint8_t c = 0; c < slot.driver->channelCount(); c++) {
+    uint8_t idx = slot.firstChannel + c;
+    if (idx >= channelCount_) break;
+    if (isnan(values[c])) {
+      working_.staleMask |= 1UL << idx;
+      continue;
+    }
+    working_.values[idx] = values[c];
+    working_.validMask |= 1UL << idx;
+    working_.staleMask &= ~(1UL << idx);
+  }
+  working_.windowEnd = slot.driver->windowComplete();
+  // Čas pipeline: skutečný čas z 64bit časovače, u přehrávané stopy její
+  // vlastní kroky - zrychlené přehrávání tak alarmům i oknům AQI odpovídá realitě
+  uint64_t realMs = esp_timer_get_time() / 1000;
+  uint32_t stepMs = 0;
+  working_.replayed = slot.driver->replayStepMs(stepMs);
+  clockMs_ += working_.replayed ? stepMs : realMs - clockRealMs_;
+  clockRealMs_ = realMs;
+  working_.clockMs = clockMs_;
+  working_.sequence++;
+  working_.timestamp = now;
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  working_.unixMs = tv.tv_sec > CLOCK_VALID_AFTER ? (uint64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000 : 0;
+  published_.write(working_);
+  lastUpdatedSensor_ = chosen;
+  return true;
+}
+
+unsigned long SensorRegistry::nextDeadline() const {
+  unsigned long now = millis();
+  unsigned long next = now + 60000UL;
+  for (uint8_t s = 0; s < sensorCount_; s++) {
+    const Slot& slot = slots_[s];
+    if (slot.inProgress) return now;
+    if (!slot.driver->isReady()) continue;
+    if ((long)(slot.nextDueAt - next) < 0) next = slot.nextDueAt;
+  }
+  return next;
+}
+
+uint32_t SensorRegistry::idleChannelMask() const {
+  uint32_t mask = 0;
+  for (uint8_t s = 0; s < sensorCount_; s++) {
+    const Slot& slot = slots_[s];
+    if (slot.driver->measuring()) continue;
+    for (uint8_t c = 0; c < slot.driver->channelCount() && slot.firstChannel + c < channelCount_; c++) {
+      mask |= 1UL << (slot.firstChannel + c);
+    }
+  }
+  return mask;
+}
+
+uint8_t SensorRegistry::readySensorCount() const {
+  uint8_t ready = 0;
+  for (uint8_t s = 0; s < sensorCount_; s++) {
+    if (slots_[s].driver->isReady()) ready++;
+  }
+  return ready;
+}
+
+const SensorChannel* SensorRegistry::primaryChannel(ChannelKind kind) const {
+  if (kind >= CH_KIND_COUNT || primaryIndex_[kind] < 0) return nullptr;
+  return &channels_[primaryIndex_[kind]];
+}
+
+SensorSample SensorRegistry::snapshot() const {
+  SensorSample sample;
+  published_.read(sample);
+  return sample;
+}
+
+bool SensorRegistry::primaryValue(const SensorSample& sample, ChannelKind kind, float& value) const {
+  int8_t idx = primaryIndex(kind);
+  if (idx < 0 || !sample.isValid(idx)) return false;
+  value = sample.values[idx];
+  return true;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include "SensorDriver.h"
+#include "SeqLock.h"
+
+constexpr uint8_t MAX_SENSORS = 4;
+constexpr uint8_t MAX_CHANNELS = 24;
+
+// Jeden řádek sjednocené tabulky kanálů (MQTT, HA, TMEP, web i displej ji procházejí obecně)
+struct SensorChannel {
+  ChannelKind kind = CH_TEMPERATURE;
+  uint8_t sensorIndex = 0;
+  bool primary = false;     // první senzor dané veličiny - používá původní názvy topiců
+  char key[24] = {0};       // "pm25" / "co2_scd4x"
+  char uid[24] = {0};       // "sen66_pm25"
+  char name[32] = {0};      // "PM2.5" / "CO2 (SCD4X)"
+  char tmepToken[24] = {0}; // "PM2" / "CO2_SCD4X"
+};
+
+// Konzistentní snímek hodnot všech kanálů. Registry ho po každém vzorku
+// publikuje přes seqlock, čtenáři (displej, MQTT, TMEP, web) pracují s kopií.
+struct SensorSample {
+  uint32_t sequence = 0;       // roste s každým novým vzorkem
+  unsigned long timestamp = 0; // millis() vzorku - monotónní, pro stáří vzorku
+  uint64_t unixMs = 0;         // čas vzorku ze SNTP v ms, 0 = hodiny ještě nenastavené
+  uint64_t clockMs = 0;        // čas pipeline (alarmy, AQI): monotónní, při přehrávání stopy běží časem stopy
+  bool replayed = false;       // poslední vzorek pochází z přehrávané stopy
+  uint32_t validMask = 0;      // bit i = kanál i má platnou hodnotu
+  uint32_t staleMask = 0;      // bit i = hodnota kanálu i nepochází z posledního čtení svého senzoru
+  bool windowEnd = false;      // vzorek uzavřel okno měření (střída SEN66) - publikovat hned
+  float values[MAX_CHANNELS] = {0};
+
+  bool isValid(uint8_t channel) const { return validMask & (1UL << channel); }
+  bool anyValid() const { return validMask != 0; }
+};
+
+class SensorRegistry {
+ public:
+  SensorRegistry();
+
+  bool add(SensorDriver* driver, const I2cBus& bus);
+  void begin();
+
+  // Provede nejvýše jednu I2C transakci; true = publikován nový snímek
+  bool process(unsigned long now);
+  unsigned long nextDeadline() const;
+
+  uint8_t sensorCount() const { return sensorCount_; }
+  SensorDriver* sensor(uint8_t index) const { return index < sensorCount_ ? slots_[index].driver : nullptr; }
+  const char* sensorId(uint8_t index) const { return index < sensorCount_ ? slots_[index].id : ""; }
+  uint8_t readySensorCount() const;
+  uint32_t sensorSamples(uint8_t index) const { return index < sensorCount_ ? slots_[index].samples : 0; }
+  uint32_t sensorErrors(uint8_t index) const { return index < sensorCount_ ? slots_[index].errors : 0; }
+
+  uint8_t channelCount() const { return channelCount_; }
+  const SensorChannel& channel(uint8_t index) const { return channels_[index]; }
+
+  // Kopie posledního snímku bez zámku; bezpečné z libovolného tasku
+  SensorSample snapshot() const;
+  uint32_t sampleSequence() const { return published_.version(); }
+
+  // Primární kanál dané veličiny (nullptr, pokud ho žádný senzor nemá)
+  const SensorChannel* primaryChannel(ChannelKind kind) const;
+  int8_t primaryIndex(ChannelKind kind) const { return kind < CH_KIND_COUNT ? primaryIndex_[kind] : -1; }
+  bool primaryValue(const SensorSample& sample, ChannelKind kind, float& value) const;
+  // Zastaralé kanály: neustálené hodnoty ve vzorku a kanály senzorů, které právě neměří
+  uint32_t idleChannelMask() const;
+  uint32_t staleMask(const SensorSample& sample) const { return sample.staleMask | idleChannelMask(); }
+  uint8_t lastUpdatedSensor() const { return lastUpdatedSensor_; }
+
+ private:
+  struct Slot {
+    SensorDriver* driver = nullptr;
+    char id[12] = {0};
+    uint8_t firstChannel = 0;
+    unsigned long nextDueAt = 0;
+    bool inProgress = false;
+    uint32_t samples = 0;
+    uint32_t errors = 0;
+  };
+
+  void selectBus(const I2cBus& bus);
+  void buildChannels(uint8_t slotIndex);
+
+  Slot slots_[MAX_SENSORS];
+  uint8_t sensorCount_ = 0;
+  uint8_t cursor_ = 0;
+  uint8_t lastUpdatedSensor_ = 0;
+
+  SensorChannel channels_[MAX_CHANNELS];
+  uint8_t channelCount_ = 0;
+  int8_t primaryIndex_[CH_KIND_COUNT];
+
+  SensorSample working_;                // jen zapisovatel (process)
+  SeqLock<SensorSample> published_;
+
+  int8_t activeMuxChannel_ = -2;
+  uint64_t clockMs_ = 0;
+  uint64_t clockRealMs_ = 0;  // esp_timer při posledním vzorku
+};
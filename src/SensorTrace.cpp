@@ -0,0 +1,270 @@
+#include "SensorTrace.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "Log.h"
+
+namespace {
+constexpr const char* PATH = "/trace.bin";
+constexpr uint8_t TRACE_VERSION = 1;
+constexpr size_t HEADER_BYTES = 16;
+constexpr uint16_t SPEED_MAX = 100;
+constexpr unsigned long REPLAY_MIN_INTERVAL_MS = 20;
+constexpr uint16_t U16_NAN = 0xFFFF;  // SEN66: hodnota není k dispozici
+constexpr int16_t I16_NAN = 0x7FFF;
+
+void putU16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+void putU32(uint8_t* p, uint32_t v) {
+  for (uint8_t i = 0; i < 4; i++) p[i] = (v >> (8 * i)) & 0xFF;
+}
+
+uint16_t getU16(const uint8_t* p) {
+  return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+uint32_t getU32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint16_t scaleUnsigned(float v, float scale) {
+  if (isnan(v)) return U16_NAN;
+  float s = roundf(v * scale);
+  return s <= 0 ? 0 : s >= U16_NAN - 1 ? U16_NAN - 1 : (uint16_t)s;
+}
+
+int16_t scaleSigned(float v, float scale) {
+  if (isnan(v)) return I16_NAN;
+  float s = roundf(v * scale);
+  return s <= -32768 ? -32768 : s >= I16_NAN - 1 ? I16_NAN - 1 : (int16_t)s;
+}
+
+float unscaleUnsigned(uint16_t v, float scale) {
+  return v == U16_NAN ? NAN : v / scale;
+}
+
+float unscaleSigned(int16_t v, float scale) {
+  return v == I16_NAN ? NAN : v / scale;
+}
+}  // namespace
+
+void SensorTrace::encodeRecord(const SensorTraceRecord& rec, uint8_t* out) {
+  putU32(out, rec.timeMs);
+  putU16(out + 4, (uint16_t)rec.error);
+  putU16(out + 6, scaleUnsigned(rec.pm1, 10));
+  putU16(out + 8, scaleUnsigned(rec.pm25, 10));
+  putU16(out + 10, scaleUnsigned(rec.pm4, 10));
+  putU16(out + 12, scaleUnsigned(rec.pm10, 10));
+  putU16(out + 14, (uint16_t)scaleSigned(rec.hum, 100));
+  putU16(out + 16, (uint16_t)scaleSigned(rec.temp, 200));
+  putU16(out + 18, (uint16_t)scaleSigned(rec.voc, 10));
+  putU16(out + 20, (uint16_t)scaleSigned(rec.nox, 10));
+  putU16(out + 22, rec.co2);
+}
+
+void SensorTrace::decodeRecord(const uint8_t* in, SensorTraceRecord& rec) {
+  rec.timeMs = getU32(in);
+  rec.error = (int16_t)getU16(in + 4);
+  rec.pm1 = unscaleUnsigned(getU16(in + 6), 10);
+  rec.pm25 = unscaleUnsigned(getU16(in + 8), 10);
+  rec.pm4 = unscaleUnsigned(getU16(in + 10), 10);
+  rec.pm10 = unscaleUnsigned(getU16(in + 12), 10);
+  rec.hum = unscaleSigned((int16_t)getU16(in + 14), 100);
+  rec.temp = unscaleSigned((int16_t)getU16(in + 16), 200);
+  rec.voc = unscaleSigned((int16_t)getU16(in + 18), 10);
+  rec.nox = unscaleSigned((int16_t)getU16(in + 20), 10);
+  rec.co2 = getU16(in + 22);
+}
+
+bool SensorTrace::startRecording(uint16_t intervalMs, uint32_t maxBytes, uint32_t unixTime, const char*& message) {
+  if (!fs_) {
+    message = "LittleFS neni pripojeny";
+    return false;
+  }
+  if (state_ != TRACE_IDLE) {
+    message = "zaznam nebo prehravani uz bezi";
+    return false;
+  }
+  file_ = fs_->open(PATH, FILE_WRITE);
+  if (!file_) {
+    message = "soubor stopy nelze vytvorit";
+    return false;
+  }
+
+  uint8_t header[HEADER_BYTES] = {'S', 'T', 'R', 'C', TRACE_VERSION, (uint8_t)RECORD_BYTES};
+  putU16(header + 6, intervalMs);
+  putU32(header + 8, unixTime);
+  if (file_.write(header, sizeof(header)) != sizeof(header)) {
+    file_.close();
+    message = "zapis hlavicky selhal";
+    return false;
+  }
+
+  state_ = TRACE_RECORDING;
+  startMs_ = millis();
+  maxBytes_ = maxBytes < HEADER_BYTES + sizeof(buffer_) ? HEADER_BYTES + sizeof(buffer_) : maxBytes;
+  fileBytes_ = HEADER_BYTES;
+  buffered_ = 0;
+  records_ = errorRecords_ = totalRecords_ = 0;
+  message = "zaznam spusten";
+  LOGI(SENS, "stopa: zaznam spusten (max %lu B)", (unsigned long)maxBytes_);
+  return true;
+}
+
+bool SensorTrace::startReplay(uint16_t speed, const char*& message) {
+  if (!fs_) {
+    message = "LittleFS neni pripojeny";
+    return false;
+  }
+  if (state_ != TRACE_IDLE) {
+    message = "zaznam nebo prehravani uz bezi";
+    return false;
+  }
+  file_ = fs_->open(PATH, FILE_READ);
+  if (!file_) {
+    message = "stopa neexistuje";
+    return false;
+  }
+
+  uint8_t header[HEADER_BYTES];
+  if (file_.read(header, sizeof(header)) != sizeof(header) || memcmp(header, "STRC", 4) != 0 ||
+      header[4] != TRACE_VERSION || header[5] != RECORD_BYTES) {
+    file_.close();
+    message = "neplatna hlavicka stopy";
+    return false;
+  }
+
+  state_ = TRACE_REPLAYING;
+  speed_ = speed < 1 ? 1 : speed > SPEED_MAX ? SPEED_MAX : speed;
+  fileBytes_ = file_.size();
+  totalRecords_ = (fileBytes_ - HEADER_BYTES) / RECORD_BYTES;
+  records_ = errorRecords_ = 0;
+  first_ = true;
+  lastTimeMs_ = 0;
+  havePending_ = readRecord(pending_);
+  message = "prehravani spusteno";
+  LOGI(SENS, "stopa: prehravani %lu zaznamu, rychlost %ux", (unsigned long)totalRecords_, speed_);
+  return true;
+}
+
+void SensorTrace::stop() {
+  if (state_ == TRACE_RECORDING) {
+    flushBuffer();
+    LOGI(SENS, "stopa: zaznam ukoncen, %lu zaznamu (%lu B)", (unsigned long)records_, (unsigned long)fileBytes_);
+  } else if (state_ == TRACE_REPLAYING) {
+    LOGI(SENS, "stopa: prehravani ukonceno po %lu/%lu zaznamech", (unsigned long)records_,
+         (unsigned long)totalRecords_);
+  }
+  if (file_) file_.close();
+  havePending_ = false;
+  state_ = TRACE_IDLE;
+}
+
+bool SensorTrace::flushBuffer() {
+  if (buffered_ == 0) return true;
+  size_t written = file_.write(buffer_, buffered_);
+  file_.flush();
+  bool ok = written == buffered_;
+  if (!ok) writeFailures_++;
+  fileBytes_ += written;
+  buffered_ = 0;
+  return ok;
+}
+
+void SensorTrace::record(uint32_t nowMs, const SensorTraceRecord& rec) {
+  if (state_ != TRACE_RECORDING) return;
+  SensorTraceRecord stamped = rec;
+  stamped.timeMs = nowMs - startMs_;
+  encodeRecord(stamped, buffer_ + buffered_);
+  buffered_ += RECORD_BYTES;
+  records_++;
+  if (rec.error) errorRecords_++;
+
+  if (buffered_ + RECORD_BYTES > sizeof(buffer_) && !flushBuffer()) {
+    LOGE(SENS, "stopa: zapis selhal, zaznam ukoncen");
+    stop();
+    return;
+  }
+  if (fileBytes_ + buffered_ + RECORD_BYTES > maxBytes_) {
+    LOGW(SENS, "stopa: dosazen limit %lu B", (unsigned long)maxBytes_);
+    stop();
+  }
+}
+
+bool SensorTrace::readRecord(SensorTraceRecord& rec) {
+  uint8_t raw[RECORD_BYTES];
+  if (file_.read(raw, sizeof(raw)) != sizeof(raw)) return false;
+  decodeRecord(raw, rec);
+  return true;
+}
+
+bool SensorTrace::next(SensorTraceRecord& rec, uint32_t& stepMs) {
+  if (state_ != TRACE_REPLAYING || !havePending_) return false;
+  rec = pending_;
+  stepMs = first_ || rec.timeMs < lastTimeMs_ ? 0 : rec.timeMs - lastTimeMs_;
+  first_ = false;
+  lastTimeMs_ = rec.timeMs;
+  records_++;
+  if (rec.error) errorRecords_++;
+  havePending_ = readRecord(pending_);
+  return true;
+}
+
+unsigned long SensorTrace::replayIntervalMs() const {
+  if (!havePending_ || pending_.timeMs <= lastTimeMs_) return REPLAY_MIN_INTERVAL_MS;
+  unsigned long interval = (pending_.timeMs - lastTimeMs_) / speed_;
+  return interval < REPLAY_MIN_INTERVAL_MS ? REPLAY_MIN_INTERVAL_MS : interval;
+}
+
+bool SensorTrace::writeChunk(uint32_t offset, const uint8_t* data, size_t length, const char*& message) {
+  if (!fs_) {
+    message = "LittleFS neni pripojeny";
+    return false;
+  }
+  if (state_ != TRACE_IDLE) {
+    message = "zaznam nebo prehravani bezi";
+    return false;
+  }
+  if (offset == 0 && (length < HEADER_BYTES || memcmp(data, "STRC", 4) != 0)) {
+    message = "neplatna hlavicka stopy";
+    return false;
+  }
+
+  File file = fs_->open(PATH, offset == 0 ? FILE_WRITE : FILE_APPEND);
+  if (!file) {
+    message = "soubor stopy nelze otevrit";
+    return false;
+  }
+  if (file.size() != offset) {
+    file.close();
+    message = "offset nenavazuje na nahranou cast";
+    return false;
+  }
+  bool ok = file.write(data, length) == length;
+  fileBytes_ = file.size();
+  file.close();
+  message = ok ? "ok" : "zapis selhal";
+  return ok;
+}
+
+File SensorTrace::openForDownload() {
+  if (!fs_ || state_ == TRACE_RECORDING) return File();
+  return fs_->open(PATH, FILE_READ);
+}
+
+SensorTraceStats SensorTrace::getStats() const {
+  SensorTraceStats stats;
+  stats.state = state_;
+  stats.fileBytes = state_ == TRACE_RECORDING ? fileBytes_ + buffered_ : fileBytes_;
+  stats.records = records_;
+  stats.totalRecords = state_ == TRACE_RECORDING ? records_ : totalRecords_;
+  stats.errorRecords = errorRecords_;
+  stats.traceMs = state_ == TRACE_RECORDING ? millis() - startMs_ : lastTimeMs_;
+  stats.speed = state_ == TRACE_REPLAYING ? speed_ : 0;
+  stats.writeFailures = writeFailures_;
+  return stats;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+// Jeden záznam stopy: surový výsledek SEN66 readMeasuredValues() včetně
+// chybového kódu knihovny, tak jak ho dostal ovladač (NaN = senzor hodnotu nemá)
+struct SensorTraceRecord {
+  uint32_t timeMs = 0;  // od začátku stopy
+  int16_t error = 0;    // kód chyby Sensirion, 0 = OK
+  float pm1 = NAN, pm25 = NAN, pm4 = NAN, pm10 = NAN;
+  float hum = NAN, temp = NAN, voc = NAN, nox = NAN;
+  uint16_t co2 = 0xFFFF;
+};
+
+enum SensorTraceState : uint8_t {
+  TRACE_IDLE = 0,
+  TRACE_RECORDING,
+  TRACE_REPLAYING,
+};
+
+struct SensorTraceStats {
+  SensorTraceState state = TRACE_IDLE;
+  uint32_t fileBytes = 0;
+  uint32_t records = 0;       // zapsané / přehrané záznamy
+  uint32_t totalRecords = 0;  // záznamů v souboru (přehrávání)
+  uint32_t errorRecords = 0;  // z toho s chybovým kódem
+  uint32_t traceMs = 0;       // čas stopy aktuálního záznamu
+  uint16_t speed = 0;
+  uint32_t writeFailures = 0;
+};
+
+// Záznam a deterministické přehrávání surových čtení SEN66 (LittleFS soubor
+// /trace.bin). Formát: 16 B hlavička ("STRC", verze, délka záznamu, nominální
+// interval, unix čas začátku) a záznamy po 24 B little-endian - čas v ms,
+// chybový kód a hodnoty v nativním měřítku SEN66 (PM x10, RH x100, T x200,
+// VOC/NOx x10, CO2), takže převod zpět na float je bezeztrátový.
+// Při přehrávání dostává pipeline záznamy místo I2C čtení, se zrychlením
+// až 100krát; čas vzorků se posouvá podle stopy (SensorDriver::replayStepMs).
+class SensorTrace {
+ public:
+  static constexpr size_t RECORD_BYTES = 24;
+  static constexpr uint32_t DEFAULT_MAX_BYTES = 256 * 1024;  // ~6 h při čtení po 2 s
+
+  void begin(fs::FS& fs) { fs_ = &fs; }
+
+  bool startRecording(uint16_t intervalMs, uint32_t maxBytes, uint32_t unixTime, const char*& message);
+  bool startReplay(uint16_t speed, const char*& message);
+  void stop();
+
+  bool recording() const { return state_ == TRACE_RECORDING; }
+  bool replaying() const { return state_ == TRACE_REPLAYING; }
+
+  // Ovladač při záznamu: čtení s časem millis()
+  void record(uint32_t nowMs, const SensorTraceRecord& rec);
+  // Ovladač při přehrávání: další záznam a krok času stopy od předchozího; false = konec
+  bool next(SensorTraceRecord& rec, uint32_t& stepMs);
+  // Zrychlený interval do dalšího záznamu
+  unsigned long replayIntervalMs() const;
+
+  // Nahrání stopy z hostitele po kusech; offset 0 soubor založí, další kus navazuje
+  bool writeChunk(uint32_t offset, const uint8_t* data, size_t length, const char*& message);
+  File openForDownload();
+
+  SensorTraceStats getStats() const;
+
+  static void encodeRecord(const SensorTraceRecord& rec, uint8_t* out);
+  static void decodeRecord(const uint8_t* in, SensorTraceRecord& rec);
+
+ private:
+  static constexpr size_t BUFFER_RECORDS = 20;
+
+  bool flushBuffer();
+  bool readRecord(SensorTraceRecord& rec);
+
+  fs::FS* fs_ = nullptr;
+  File file_;
+  SensorTraceState state_ = TRACE_IDLE;
+
+  // záznam: bloky po BUFFER_RECORDS, zápis na flash jednou za ~40 s
+  uint8_t buffer_[BUFFER_RECORDS * RECORD_BYTES];
+  size_t buffered_ = 0;
+  uint32_t startMs_ = 0;
+  uint32_t maxBytes_ = 0;
+  uint32_t fileBytes_ = 0;
+
+  // přehrávání: záznam dopředu kvůli intervalu do dalšího vzorku
+  SensorTraceRecord pending_;
+  bool havePending_ = false;
+  bool first_ = true;
+  uint32_t lastTimeMs_ = 0;
+  uint16_t speed_ = 1;
+
+  uint32_t records_ = 0;
+  uint32_t totalRecords_ = 0;
+  uint32_t errorRecords_ = 0;
+  uint32_t writeFailures_ = 0;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <Arduino.h>
+
+#include <atomic>
+#include <type_traits>
+
+// Seqlock pro jednoho zapisovatele a libovolný počet čtenářů. Zapisovatel
+// nikdy nečeká; čtenář si zkopíruje celou hodnotu a kopii zopakuje, pokud
+// mezitím proběhl zápis. T musí jít kopírovat přes memcpy.
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable<T>::value, "SeqLock vyzaduje trivialne kopirovatelny typ");
+
+ public:
+  void write(const T& value) {
+    uint32_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);  // liché = zápis probíhá
+    std::atomic_thread_fence(std::memory_order_release);
+    copyBytes(data_, &value);
+    std::atomic_thread_fence(std::memory_order_release);
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  void read(T& out) const {
+    for (uint8_t attempt = 0;; attempt++) {
+      uint32_t before = seq_.load(std::memory_order_acquire);
+      if ((before & 1) == 0) {
+        copyBytes(&out, data_);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq_.load(std::memory_order_relaxed) == before) return;
+      }
+      // Zapisovatel s nižší prioritou potřebuje čas na dokončení zápisu
+      if (attempt >= 2) delay(1);
+    }
+  }
+
+  // Počet dokončených zápisů
+  uint32_t version() const { return seq_.load(std::memory_order_acquire) >> 1; }
+
+ private:
+  static void copyBytes(volatile void* dst, const volatile void* src) {
+    volatile uint8_t* d = (volatile uint8_t*)dst;
+    const volatile uint8_t* s = (const volatile uint8_t*)src;
+    for (size_t i = 0; i < sizeof(T); i++) d[i] = s[i];
+  }
+
+  std::atomic<uint32_t> seq_{0};
+  volatile uint8_t data_[sizeof(T)] __attribute__((aligned(4))) = {};
+};
@@ -0,0 +1,271 @@
+#include "SharpDisplay.h"
+
+#include "Log.h"
+
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+namespace {
+constexpr uint8_t CMD_WRITE = 0x01;
+constexpr uint8_t CMD_VCOM = 0x02;
+constexpr uint8_t CMD_CLEAR = 0x04;
+constexpr int SPI_CLOCK_HZ = 2000000;  // LS027B7DH01 max. 2 MHz
+
+uint8_t reverseBits(uint8_t b) {
+  b = (uint8_t)((b & 0xF0) >> 4 | (b & 0x0F) << 4);
+  b = (uint8_t)((b & 0xCC) >> 2 | (b & 0x33) << 2);
+  return (uint8_t)((b & 0xAA) >> 1 | (b & 0x55) << 1);
+}
+}  // namespace
+
+SharpDisplay::SharpDisplay(uint8_t clk, uint8_t mosi, uint8_t cs, uint16_t width, uint16_t height)
+    : Adafruit_GFX(width, height), clk_(clk), mosi_(mosi), cs_(cs), bytesPerLine_((width + 7) / 8) {}
+
+bool SharpDisplay::begin(bool doubleBuffer) {
+  if (HEIGHT > LINES_PER_TRANSACTION * MAX_TRANSACTIONS) return false;
+
+  size_t size = (size_t)bytesPerLine_ * HEIGHT;
+  // Každý řádek nese adresu a koncový bajt, každá transakce příkaz a ukončení
+  size_t txSize = (size_t)(bytesPerLine_ + 2) * HEIGHT + 2 * MAX_TRANSACTIONS;
+
+  buffer_ = (uint8_t*)malloc(size);
+  shadow_ = (uint8_t*)malloc(size);
+  if (!buffer_ || !shadow_) return false;
+
+  txCount_ = doubleBuffer ? 2 : 1;
+  for (uint8_t i = 0; i < txCount_; i++) {
+    tx_[i].data = (uint8_t*)heap_caps_malloc(txSize, MALLOC_CAP_DMA);
+    if (!tx_[i].data) {
+      LOGW(DISP, "malo DMA pameti");
+      return false;
+    }
+  }
+  stats_.doubleBuffered = doubleBuffer;
+
+  spi_bus_config_t bus = {};
+  bus.mosi_io_num = mosi_;
+  bus.miso_io_num = -1;  // displej je write-only
+  bus.sclk_io_num = clk_;
+  bus.quadwp_io_num = -1;
+  bus.quadhd_io_num = -1;
+  bus.max_transfer_sz = (bytesPerLine_ + 2) * LINES_PER_TRANSACTION + 2;
+  esp_err_t err = spi_bus_initialize(SPI2_HOST, &bus, SPI_DMA_CH_AUTO);
+  if (err != ESP_OK) {
+    LOGE(DISP, "spi_bus_initialize selhal (%s)", esp_err_to_name(err));
+    return false;
+  }
+
+  spi_device_interface_config_t dev = {};
+  dev.mode = 0;
+  dev.clock_speed_hz = SPI_CLOCK_HZ;
+  dev.spics_io_num = cs_;
+  // Sharp má CS aktivní v HIGH, data LSB first; CS setup 3 us a hold 1 us
+  dev.flags = SPI_DEVICE_POSITIVE_CS | SPI_DEVICE_TXBIT_LSBFIRST | SPI_DEVICE_HALFDUPLEX;
+  dev.cs_ena_pretrans = SPI_CLOCK_HZ / 1000000 * 3;
+  dev.cs_ena_posttrans = SPI_CLOCK_HZ / 1000000;
+  dev.queue_size = MAX_TRANSACTIONS * TX_BUFFERS;
+  dev.post_cb = onTransferDone;
+  err = spi_bus_add_device(SPI2_HOST, &dev, &spi_);
+  if (err != ESP_OK) {
+    LOGE(DISP, "spi_bus_add_device selhal (%s)", esp_err_to_name(err));
+    return false;
+  }
+
+  // Vymazat panel, stín pak odpovídá bílé obrazovce
+  uint8_t clear[2] = {(uint8_t)(CMD_CLEAR | vcom_), 0x00};
+  spi_transaction_t trans = {};
+  trans.length = sizeof(clear) * 8;
+  trans.tx_buffer = clear;
+  spi_device_polling_transmit(spi_, &trans);
+  toggleVcom();
+
+  memset(buffer_, 0xFF, size);
+  memset(shadow_, 0xFF, size);
+  return true;
+}
+
+void SharpDisplay::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  if (!buffer_ || x < 0 || x >= width() || y < 0 || y >= height()) return;
+
+  int16_t t;
+  switch (rotation) {
+    case 1:
+      t = x; x = y; y = t;
+      x = WIDTH - 1 - x;
+      break;
+    case 2:
+      x = WIDTH - 1 - x;
+      y = HEIGHT - 1 - y;
+      break;
+    case 3:
+      t = x; x = y; y = t;
+      y = HEIGHT - 1 - y;
+      break;
+  }
+
+  uint8_t* byte = buffer_ + (size_t)y * bytesPerLine_ + (x >> 3);
+  uint8_t mask = 1 << (x & 7);
+  if (color) {
+    *byte |= mask;
+  } else {
+    *byte &= ~mask;
+  }
+}
+
+void SharpDisplay::fillScreen(uint16_t color) {
+  if (!buffer_) return;
+  memset(buffer_, color ? 0xFF : 0x00, (size_t)bytesPerLine_ * HEIGHT);
+}
+
+void SharpDisplay::clearDisplay() {
+  fillScreen(1);
+}
+
+void SharpDisplay::writeRow(int16_t x, int16_t y, const uint8_t* bits, uint16_t w) {
+  if (!buffer_) return;
+
+  if (rotation != 0 || (x & 7) != 0 || x < 0 || y < 0 || y >= HEIGHT || x + w > WIDTH) {
+    for (uint16_t i = 0; i < w; i++) {
+      drawPixel(x + i, y, (bits[i >> 3] >> (7 - (i & 7))) & 1);
+    }
+    return;
+  }
+
+  // Buffer má levý pixel v bitu 0, příchozí data v bitu 7
+  uint8_t* dst = buffer_ + (size_t)y * bytesPerLine_ + (x >> 3);
+  uint16_t fullBytes = w >> 3;
+  for (uint16_t i = 0; i < fullBytes; i++) dst[i] = reverseBits(bits[i]);
+  uint8_t rest = w & 7;
+  if (rest) {
+    uint8_t mask = (uint8_t)((1 << rest) - 1);
+    dst[fullBytes] = (dst[fullBytes] & ~mask) | (reverseBits(bits[fullBytes]) & mask);
+  }
+}
+
+void SharpDisplay::discardChanges() {
+  if (buffer_) memcpy(buffer_, shadow_, (size_t)bytesPerLine_ * HEIGHT);
+}
+
+void SharpDisplay::toggleVcom() {
+  vcom_ = vcom_ ? 0 : CMD_VCOM;
+}
+
+void IRAM_ATTR SharpDisplay::onTransferDone(spi_transaction_t* trans) {
+  ((TxBuffer*)trans->user)->doneAt = (uint32_t)esp_timer_get_time();
+}
+
+// Vyzvedne výsledky všech transakcí bufferu; pak je možné ho znovu plnit
+void SharpDisplay::collect(TxBuffer& tx) {
+  if (tx.queued == 0) return;
+  for (uint8_t i = 0; i < tx.queued; i++) {
+    spi_transaction_t* done;
+    spi_device_get_trans_result(spi_, &done, portMAX_DELAY);
+  }
+  tx.queued = 0;
+
+  uint32_t transferUs = tx.doneAt - tx.queuedAt;
+  stats_.lastTransferUs = transferUs;
+  if (transferUs > stats_.maxTransferUs) stats_.maxTransferUs = transferUs;
+}
+
+void SharpDisplay::queue(TxBuffer& tx, size_t start, size_t length) {
+  if (tx.queued == 0) tx.queuedAt = (uint32_t)esp_timer_get_time();
+  spi_transaction_t& trans = tx.trans[tx.queued];
+  memset(&trans, 0, sizeof(trans));
+  trans.length = length * 8;
+  trans.tx_buffer = tx.data + start;
+  trans.user = &tx;
+  // Fronta má místo pro všechny transakce obou bufferů, takže se nečeká
+  if (spi_device_queue_trans(spi_, &trans, portMAX_DELAY) == ESP_OK) tx.queued++;
+}
+
+SharpDisplay::TxBuffer& SharpDisplay::nextTxBuffer() {
+  // Transakce se vyzvedávají v pořadí zařazení - nejstarší buffer je ten další na řadě
+  TxBuffer& tx = tx_[txNext_];
+  txNext_ = (txNext_ + 1) % txCount_;
+
+  uint32_t waitStartUs = micros();
+  collect(tx);
+  stats_.lastWaitUs = micros() - waitStartUs;
+  return tx;
+}
+
+void SharpDisplay::sendVcom(TxBuffer& tx) {
+  tx.data[0] = vcom_;
+  tx.data[1] = 0x00;
+  queue(tx, 0, 2);
+  stats_.vcomToggles++;
+  toggleVcom();
+  lastTransferAt_ = millis();
+}
+
+void SharpDisplay::sendLines(bool all) {
+  TxBuffer& tx = nextTxBuffer();
+  uint32_t startUs = micros();
+
+  uint16_t sent = 0;
+  size_t pos = 0;
+  size_t transStart = 0;
+  uint8_t linesInTrans = 0;
+
+  for (uint16_t row = 0; row < HEIGHT; row++) {
+    uint8_t* line = buffer_ + (size_t)row * bytesPerLine_;
+    uint8_t* shadowLine = shadow_ + (size_t)row * bytesPerLine_;
+    if (!all && memcmp(line, shadowLine, bytesPerLine_) == 0) continue;
+
+    if (linesInTrans == 0) {
+      transStart = pos;
+      tx.data[pos++] = CMD_WRITE | vcom_;
+    }
+    tx.data[pos++] = (uint8_t)(row + 1);  // adresy řádků od 1
+    memcpy(tx.data + pos, line, bytesPerLine_);
+    pos += bytesPerLine_;
+    tx.data[pos++] = 0x00;
+    memcpy(shadowLine, line, bytesPerLine_);
+    sent++;
+
+    // Hotovou transakci hned zařadit - DMA začne vysílat, zatímco se skládá další
+    if (++linesInTrans == LINES_PER_TRANSACTION) {
+      tx.data[pos++] = 0x00;
+      queue(tx, transStart, pos - transStart);
+      linesInTrans = 0;
+    }
+  }
+
+  if (linesInTrans > 0) {
+    tx.data[pos++] = 0x00;
+    queue(tx, transStart, pos - transStart);
+  }
+  if (sent == 0) {
+    sendVcom(tx);  // beze změny - jen přepnout VCOM
+  } else {
+    toggleVcom();
+    lastTransferAt_ = millis();
+  }
+
+  uint32_t cpuUs = micros() - startUs;
+  stats_.refreshes++;
+  stats_.linesSent += sent;
+  stats_.lastLinesSent = sent;
+  stats_.lastCpuUs = cpuUs;
+  if (cpuUs > stats_.maxCpuUs) stats_.maxCpuUs = cpuUs;
+}
+
+void SharpDisplay::refresh() {
+  if (spi_) sendLines(false);
+}
+
+void SharpDisplay::refreshAll() {
+  if (spi_) sendLines(true);
+}
+
+void SharpDisplay::maintainVcom(unsigned long now) {
+  // Jen příkaz s bitem VCOM - buffer může obsahovat rozpracovaný snímek
+  if (spi_ && now - lastTransferAt_ >= VCOM_INTERVAL_MS) sendVcom(nextTxBuffer());
+}
+
+void SharpDisplay::waitIdle() {
+  if (!spi_) return;
+  // Vyzvedávat od nejstaršího bufferu, stejně jako sendLines()
+  for (uint8_t i = 0; i < txCount_; i++) collect(tx_[(txNext_ + i) % txCount_]);
+}
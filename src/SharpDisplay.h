@@ -0,0 +1,90 @@
+#pragma once
+
+#include <Adafruit_GFX.h>
+#include <Arduino.h>
+#include <driver/spi_master.h>
+
+struct SharpDisplayStats {
+  uint32_t refreshes = 0;
+  uint32_t linesSent = 0;       // celkem od bootu
+  uint16_t lastLinesSent = 0;   // při posledním refresh()
+  uint32_t lastCpuUs = 0;       // příprava a zařazení přenosu v refresh()
+  uint32_t maxCpuUs = 0;
+  uint32_t lastWaitUs = 0;      // čekání na dokončení předchozího přenosu
+  uint32_t lastTransferUs = 0;  // od zařazení po dokončení DMA (poslední dokončený přenos)
+  uint32_t maxTransferUs = 0;
+  uint32_t vcomToggles = 0;     // přenosy bez dat (jen údržba VCOM)
+  bool doubleBuffered = false;
+};
+
+// Ovladač Sharp Memory LCD (LS027B7DH01) s framebufferem a stínovou kopií
+// obsahu panelu. refresh() posílá jen řádky, které se od posledního přenosu
+// změnily - překreslení beze změny stojí jen přepnutí VCOM.
+//
+// Přenos jde přes SPI2 s DMA: refresh() poskládá změněné řádky do DMA
+// bufferu, zařadí je jako několik transakcí a vrátí se, zatímco data
+// odcházejí na pozadí. S dvojitým bufferem může další refresh() připravit
+// snímek ještě během přenosu předchozího.
+class SharpDisplay : public Adafruit_GFX {
+ public:
+  SharpDisplay(uint8_t clk, uint8_t mosi, uint8_t cs, uint16_t width, uint16_t height);
+
+  bool begin(bool doubleBuffer = false);
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+  void fillScreen(uint16_t color) override;
+
+  void clearDisplay();  // jen buffer, panel se změní při refresh()
+  void refresh();
+  void refreshAll();    // vynutí přenos všech řádků
+  void waitIdle();      // počká na dokončení všech přenosů (před restartem)
+
+  // Panel potřebuje pravidelnou inverzi VCOM (jinak se v něm usadí DC složka).
+  // Každý přenos ji přepne sám; maintainVcom() pošle příkaz bez dat jen tehdy,
+  // když od posledního přenosu uplynul VCOM_INTERVAL_MS.
+  void maintainVcom(unsigned long now);
+  unsigned long nextVcomDue() const { return lastTransferAt_ + VCOM_INTERVAL_MS; }
+
+  // Zapíše řádek 1bpp dat (MSB first, 1 = bílá) od bodu x,y; bez otočení
+  // a při x zarovnaném na 8 se kopírují celé bajty
+  void writeRow(int16_t x, int16_t y, const uint8_t* bits, uint16_t w);
+  void discardChanges();  // vrátí buffer na obsah panelu
+
+  SharpDisplayStats getStats() const { return stats_; }
+
+ private:
+  static constexpr uint8_t LINES_PER_TRANSACTION = 60;
+  static constexpr uint8_t MAX_TRANSACTIONS = 4;  // 240 řádků / 60
+  static constexpr uint8_t TX_BUFFERS = 2;
+  static constexpr unsigned long VCOM_INTERVAL_MS = 1000;
+
+  struct TxBuffer {
+    uint8_t* data = nullptr;  // DMA-capable
+    spi_transaction_t trans[MAX_TRANSACTIONS];
+    uint8_t queued = 0;
+    uint32_t queuedAt = 0;
+    volatile uint32_t doneAt = 0;  // nastaví post_cb v ISR
+  };
+
+  static void IRAM_ATTR onTransferDone(spi_transaction_t* trans);
+
+  TxBuffer& nextTxBuffer();
+  void sendLines(bool all);
+  void sendVcom(TxBuffer& tx);
+  void collect(TxBuffer& tx);
+  void queue(TxBuffer& tx, size_t start, size_t length);
+  void toggleVcom();
+
+  uint8_t clk_;
+  uint8_t mosi_;
+  uint8_t cs_;
+  uint16_t bytesPerLine_;
+  uint8_t* buffer_ = nullptr;
+  uint8_t* shadow_ = nullptr;  // co je právě na panelu (nebo na cestě k němu)
+  spi_device_handle_t spi_ = nullptr;
+  TxBuffer tx_[TX_BUFFERS];
+  uint8_t txCount_ = 1;
+  uint8_t txNext_ = 0;
+  uint8_t vcom_ = 0;
+  unsigned long lastTransferAt_ = 0;
+  SharpDisplayStats stats_;
+};
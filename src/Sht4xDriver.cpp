@@ -0,0 +1,36 @@
+#include "Sht4xDriver.h"
+
+#include "Log.h"
+
+namespace {
+constexpr uint8_t SHT4X_ADDR = 0x44;
+}  // namespace
+
+bool Sht4xDriver::begin() {
+  sht4x_.begin(*bus_.wire, SHT4X_ADDR);
+
+  uint32_t serialNumber = 0;
+  int16_t error = sht4x_.serialNumber(serialNumber);
+  if (error != 0) {
+    char msg[64];
+    errorToString(error, msg, sizeof(msg));
+    LOGE(SENS, "SHT4X: serialNumber() CHYBA: %s", msg);
+    ready_ = false;
+    return false;
+  }
+
+  LOGI(SENS, "SHT4X: S/N: %lu", (unsigned long)serialNumber);
+  ready_ = true;
+  return true;
+}
+
+SensorPollResult Sht4xDriver::poll(float* values) {
+  float temp = 0.0f;
+  float hum = 0.0f;
+  if (sht4x_.measureHighPrecision(temp, hum) != 0) return SENSOR_POLL_ERROR;
+  if (isnan(temp) || isnan(hum)) return SENSOR_POLL_ERROR;
+
+  values[0] = temp;
+  values[1] = hum;
+  return SENSOR_POLL_SAMPLE;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <SensirionI2cSht4x.h>
+
+#include "SensorDriver.h"
+
+class Sht4xDriver : public SensorDriver {
+ public:
+  const char* model() const override { return "SHT4X"; }
+  bool begin() override;
+  uint8_t channelCount() const override { return 2; }
+  ChannelKind channelKind(uint8_t index) const override { return index == 0 ? CH_TEMPERATURE : CH_HUMIDITY; }
+  unsigned long sampleIntervalMs() const override { return 2000; }
+  SensorPollResult poll(float* values) override;
+
+ private:
+  SensirionI2cSht4x sht4x_;
+};
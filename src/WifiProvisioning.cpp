@@ -1,166 +1,430 @@
 #include "WifiProvisioning.h"
 
+#include "Log.h"
+
+#include <Preferences.h>
 #include <WiFi.h>
+#include <time.h>
 
 namespace {
 constexpr byte DNS_PORT = 53;
 constexpr const char* AP_PASSWORD = "";  // open AP for easier onboarding
+constexpr const char* CACHE_NS = "wificache";
+constexpr const char* CACHE_KEY = "last";
+constexpr unsigned long FAST_CONNECT_TIMEOUT_MS = 3000UL;
+constexpr unsigned long RECONNECT_KICK_MS = 5000UL;
+constexpr unsigned long AP_GRACE_MS = 15000UL;  // AP zůstane, aby si UI stihlo přečíst výsledek
+// Uložený lease se bez DHCP použije jen do poloviny hodinového lease (T1),
+// kratší lease běžné routery nedávají; pak rychlé připojení jde přes DHCP
+constexpr uint32_t CACHED_LEASE_MAX_AGE_S = 1800;
+constexpr uint32_t UNIX_TIME_VALID = 1600000000UL;  // menší = RTC nemá čas (studený start bez SNTP)
+
+uint32_t fnv1a(uint32_t hash, const char* text) {
+  while (*text) {
+    hash ^= (uint8_t)*text++;
+    hash *= 16777619UL;
+  }
+  return hash;
+}
 
-String buildApName() {
+bool deadlinePassed(unsigned long now, unsigned long deadline) {
+  return (long)(now - deadline) >= 0;
+}
+
+template <size_t N>
+void buildApName(FixedString<N>& name) {
   uint8_t mac[6];
   WiFi.macAddress(mac);
-  char suffix[7];
-  snprintf(suffix, sizeof(suffix), "%02X%02X%02X", mac[3], mac[4], mac[5]);
-  return String("SharpDisplay-") + suffix;
+  name.assignf("SharpDisplay-%02X%02X%02X", mac[3], mac[4], mac[5]);
 }
 }  // namespace
 
 void WifiProvisioning::begin(AppConfig* config, unsigned long connectTimeoutMs) {
   config_ = config;
   connectTimeoutMs_ = connectTimeoutMs;
+  loadFastConnectCache();
+
+  if (!eventHandlerRegistered_) {
+    WiFi.onEvent([this](arduino_event_id_t event, arduino_event_info_t info) {
+      switch (event) {
+        case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+          postEvent(WIFI_EV_STA_CONNECTED);
+          break;
+        case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+          postEvent(WIFI_EV_STA_GOT_IP);
+          break;
+        case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+          postEvent(WIFI_EV_STA_DISCONNECTED, info.wifi_sta_disconnected.reason);
+          break;
+        case ARDUINO_EVENT_WIFI_STA_LOST_IP:
+          postEvent(WIFI_EV_STA_LOST_IP);
+          break;
+        default:
+          break;
+      }
+    });
+    eventHandlerRegistered_ = true;
+  }
 
   if (!config_ || !hasStoredCredentials()) {
-    Serial.println("WIFI PROV: Chybi ulozene SSID, start AP captive");
+    LOGW(WIFI, "Chybi ulozene SSID, start AP captive");
     startCaptiveMode();
     return;
   }
 
-  if (!connectStaBlocking(connectTimeoutMs_)) {
-    Serial.println("WIFI PROV: STA connect timeout, fallback do captive");
-    startCaptiveMode();
+  startStaConnect(millis());
+}
+
+void WifiProvisioning::postEvent(WifiProvEvent event, uint16_t reason) {
+  uint8_t head = eventHead_.load(std::memory_order_relaxed);
+  uint8_t next = (head + 1) % EVENT_QUEUE_SIZE;
+  if (next == eventTail_.load(std::memory_order_acquire)) {
+    eventOverflow_.store(true, std::memory_order_release);
+    return;
   }
+  events_[head] = {event, reason};
+  eventHead_.store(next, std::memory_order_release);
 }
 
 void WifiProvisioning::process() {
-  if (state_ == WIFI_AP_CAPTIVE && captiveRunning_) {
+  if (captiveRunning_) {
     dnsServer_.processNextRequest();
-    return;
   }
 
-  if (!config_ || !hasStoredCredentials()) return;
+  unsigned long now = millis();
 
-  if (state_ == WIFI_STA_CONNECTED && WiFi.status() != WL_CONNECTED) {
-    state_ = WIFI_STA_CONNECTING;
-    staConnectStartedAt_ = millis();
-    lastReconnectAttemptAt_ = 0;
-    Serial.println("WIFI PROV: Spojeni ztraceno, zkousim reconnect");
+  uint8_t tail = eventTail_.load(std::memory_order_relaxed);
+  while (tail != eventHead_.load(std::memory_order_acquire)) {
+    QueuedEvent ev = events_[tail];
+    tail = (tail + 1) % EVENT_QUEUE_SIZE;
+    eventTail_.store(tail, std::memory_order_release);
+    handleEvent(ev, now);
   }
 
-  if (state_ != WIFI_STA_CONNECTING) return;
+  // Ztracené události nahradit aktuálním stavem driveru
+  if (eventOverflow_.exchange(false)) {
+    handleEvent({WiFi.status() == WL_CONNECTED ? WIFI_EV_STA_GOT_IP : WIFI_EV_STA_DISCONNECTED, 0}, now);
+  }
 
-  if (WiFi.status() == WL_CONNECTED) {
-    state_ = WIFI_STA_CONNECTED;
-    Serial.printf("WIFI PROV: Znovu pripojeno, IP: %s\n", WiFi.localIP().toString().c_str());
-    return;
+  handleTimeouts(now);
+}
+
+void WifiProvisioning::handleEvent(const QueuedEvent& ev, unsigned long now) {
+  switch (state_) {
+    case WIFI_STA_CONNECTING:
+      if (ev.event == WIFI_EV_STA_GOT_IP) {
+        onStaConnected(now);
+      } else if (ev.event == WIFI_EV_STA_DISCONNECTED && phase_ == PHASE_FAST && isFatalDisconnect(ev.reason)) {
+        LOGW(WIFI, "Rychle pripojeni odmitnuto (reason %u), plny sken", ev.reason);
+        clearFastConnectCache();
+        beginScanPhase(now);
+      }
+      break;
+
+    case WIFI_STA_CONNECTED:
+      if (ev.event == WIFI_EV_STA_GOT_IP) {
+        // Adresa z obnoveného DHCP po rychlém připojení (nebo nový lease)
+        storeFastConnectCache();
+      } else if (ev.event == WIFI_EV_STA_DISCONNECTED || ev.event == WIFI_EV_STA_LOST_IP) {
+        state_ = WIFI_STA_CONNECTING;
+        phase_ = PHASE_RECONNECT;
+        staConnectStartedAt_ = now;
+        phaseDeadline_ = now + connectTimeoutMs_;
+        lastReconnectAttemptAt_ = now;
+        LOGW(WIFI, "Spojeni ztraceno, zkousim reconnect");
+      }
+      break;
+
+    case WIFI_AP_STA_TESTING:
+      if (ev.event == WIFI_EV_STA_GOT_IP) {
+        finishCredentialTest(true, nullptr, now);
+      } else if (ev.event == WIFI_EV_STA_DISCONNECTED && isFatalDisconnect(ev.reason)) {
+        finishCredentialTest(false, ev.reason == WIFI_REASON_NO_AP_FOUND ? "SSID nenalezeno" : "Spatne heslo nebo odmitnuto AP", now);
+      }
+      break;
+
+    case WIFI_AP_CAPTIVE:
+    default:
+      break;
   }
+}
 
-  unsigned long now = millis();
-  if (lastReconnectAttemptAt_ == 0 || now - lastReconnectAttemptAt_ >= 5000UL) {
-    lastReconnectAttemptAt_ = now;
-    WiFi.reconnect();
-    Serial.println("WIFI PROV: WiFi.reconnect()");
+void WifiProvisioning::handleTimeouts(unsigned long now) {
+  if (captiveRunning_ && apShutdownAt_ != 0 && deadlinePassed(now, apShutdownAt_)) {
+    apShutdownAt_ = 0;
+    if (state_ == WIFI_STA_CONNECTED) {
+      stopCaptiveMode();
+      WiFi.mode(WIFI_STA);
+      LOGI(WIFI, "Captive AP ukoncen, zustava jen STA");
+    }
   }
 
-  if (now - staConnectStartedAt_ >= connectTimeoutMs_) {
-    Serial.println("WIFI PROV: Reconnect timeout, prepinam do captive");
-    startCaptiveMode();
+  switch (state_) {
+    case WIFI_STA_CONNECTING:
+      if (phase_ == PHASE_RECONNECT && now - lastReconnectAttemptAt_ >= RECONNECT_KICK_MS) {
+        lastReconnectAttemptAt_ = now;
+        WiFi.reconnect();
+        LOGI(WIFI, "WiFi.reconnect()");
+      }
+      if (!deadlinePassed(now, phaseDeadline_)) break;
+      if (phase_ == PHASE_FAST) {
+        // AP se mohl přesunout na jiný kanál nebo lease vypršel - cache už nepoužívat
+        LOGW(WIFI, "Rychle pripojeni selhalo, mazu cache a zkousim plny sken");
+        clearFastConnectCache();
+        WiFi.disconnect(false, false);
+        beginScanPhase(now);
+      } else {
+        LOGW(WIFI, "STA connect timeout, fallback do captive");
+        startCaptiveMode();
+      }
+      break;
+
+    case WIFI_AP_STA_TESTING:
+      if (deadlinePassed(now, phaseDeadline_)) {
+        finishCredentialTest(false, "Timeout pripojeni", now);
+      }
+      break;
+
+    default:
+      break;
   }
 }
 
-bool WifiProvisioning::saveCredentialsAndConnect(const String& ssid, const String& password, String& statusMsg) {
-  if (!config_) {
-    statusMsg = "Interni chyba: config neni inicializovan";
-    return false;
+void WifiProvisioning::startStaConnect(unsigned long now) {
+  stopCaptiveMode();
+
+  state_ = WIFI_STA_CONNECTING;
+  staConnectStartedAt_ = now;
+  lastReconnectAttemptAt_ = now;
+  WiFi.persistent(false);
+  WiFi.mode(WIFI_STA);
+  WiFi.setAutoReconnect(true);
+
+  if (!fastCacheUsable()) {
+    beginScanPhase(now);
+    return;
   }
 
-  AppConfig updated = *config_;
-  updated.wifiSsid = ssid;
-  updated.wifiPassword = password;
+  phase_ = PHASE_FAST;
+  phaseDeadline_ = now + FAST_CONNECT_TIMEOUT_MS;
+  applyIpConfig(true);
+  WiFi.begin(config_->wifiSsid.c_str(), config_->wifiPassword.c_str(), fastCache_.channel, fastCache_.bssid);
+  LOGI(WIFI, "Rychle pripojeni k '%s' (kanal %ld, BSSID %02X:%02X:%02X:%02X:%02X:%02X)",
+       config_->wifiSsid.c_str(), (long)fastCache_.channel,
+       fastCache_.bssid[0], fastCache_.bssid[1], fastCache_.bssid[2],
+       fastCache_.bssid[3], fastCache_.bssid[4], fastCache_.bssid[5]);
+}
 
-  if (updated.wifiSsid.length() == 0) {
-    statusMsg = "SSID nesmi byt prazdne";
-    return false;
+void WifiProvisioning::beginScanPhase(unsigned long now) {
+  // Plný sken a DHCP (pokud není nastavena statická IP)
+  phase_ = PHASE_SCAN;
+  phaseDeadline_ = now + connectTimeoutMs_;
+  applyIpConfig(false);
+  WiFi.begin(config_->wifiSsid.c_str(), config_->wifiPassword.c_str());
+  LOGI(WIFI, "Pripojuji k SSID '%s' (plny sken)", config_->wifiSsid.c_str());
+}
+
+void WifiProvisioning::onStaConnected(unsigned long now) {
+  lastConnectWasFast_ = phase_ == PHASE_FAST;
+  lastConnectDurationMs_ = now - staConnectStartedAt_;
+  state_ = WIFI_STA_CONNECTED;
+  staConnectStartedAt_ = 0;
+  lastReconnectAttemptAt_ = 0;
+  storeFastConnectCache();
+  LOGI(WIFI, "STA pripojeno za %lu ms (%s), IP: %s", lastConnectDurationMs_,
+       lastConnectWasFast_ ? "rychle" : (phase_ == PHASE_RECONNECT ? "reconnect" : "sken"),
+       WiFi.localIP().toString().c_str());
+  if (usingCachedLease_) {
+    // Adresa z cache platí jen pro start; DHCP klient lease u serveru obnoví
+    // (nebo přidělí jinou adresu) a nový lease se uloží při GOT_IP
+    usingCachedLease_ = false;
+    applyIpConfig(false);
+    LOGI(WIFI, "Obnovuji DHCP lease po rychlem pripojeni");
   }
+}
 
-  if (!saveConfig(updated)) {
-    statusMsg = "Nepodarilo se ulozit WiFi konfiguraci";
-    return false;
+uint32_t WifiProvisioning::startCredentialTest(const char* ssid, const char* password, String& statusMsg) {
+  if (!config_) {
+    statusMsg = "Interni chyba: config neni inicializovan";
+    return 0;
+  }
+  if (!ssid || ssid[0] == '\0') {
+    statusMsg = "SSID nesmi byt prazdne";
+    return 0;
+  }
+  if (strlen(ssid) > pendingSsid_.capacity() || (password && strlen(password) > pendingPassword_.capacity())) {
+    statusMsg = "SSID nebo heslo je prilis dlouhe";
+    return 0;
+  }
+  if (state_ == WIFI_AP_STA_TESTING) {
+    statusMsg = "Test jineho pripojeni uz probiha";
+    return 0;
   }
 
-  *config_ = updated;
-  stopCaptiveMode();
+  unsigned long now = millis();
+  pendingSsid_.assign(ssid);
+  pendingPassword_.assign(password);
+  testFromCaptive_ = captiveRunning_;
+  jobId_++;
+  if (jobId_ == 0) jobId_ = 1;
+  jobState_ = WIFI_JOB_RUNNING;
+  jobMessage_.assignf("Zkousim pripojeni k '%s'", ssid);
+
+  state_ = WIFI_AP_STA_TESTING;
+  staConnectStartedAt_ = now;
+  phaseDeadline_ = now + connectTimeoutMs_;
+  apShutdownAt_ = 0;
+
+  // AP + DNS běží dál, portál zůstává dostupný během testu
+  WiFi.mode(testFromCaptive_ ? WIFI_AP_STA : WIFI_STA);
+  WiFi.disconnect(false, false);
+  applyIpConfig(false);
+  WiFi.begin(pendingSsid_.c_str(), pendingPassword_.c_str());
+  LOGI(WIFI, "Job %lu - test SSID '%s' (%s)", (unsigned long)jobId_, pendingSsid_.c_str(),
+       testFromCaptive_ ? "AP+STA" : "STA");
+
+  statusMsg = jobMessage_.c_str();
+  return jobId_;
+}
 
-  bool ok = connectStaBlocking(connectTimeoutMs_);
+void WifiProvisioning::finishCredentialTest(bool ok, const char* message, unsigned long now) {
   if (ok) {
-    statusMsg = "WiFi ulozena, pripojeno";
-    return true;
+    AppConfig updated = *config_;
+    updated.wifiSsid = pendingSsid_;
+    updated.wifiPassword = pendingPassword_;
+    if (saveConfig(updated)) {
+      *config_ = updated;
+      phase_ = PHASE_SCAN;
+      onStaConnected(now);
+      jobState_ = WIFI_JOB_SUCCEEDED;
+      IPAddress ip = WiFi.localIP();
+      jobMessage_.assignf("WiFi ulozena, pripojeno, IP: %u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+      if (captiveRunning_) apShutdownAt_ = now + AP_GRACE_MS;
+    } else {
+      ok = false;
+      message = "Nepodarilo se ulozit WiFi konfiguraci";
+    }
   }
 
-  startCaptiveMode();
-  statusMsg = "WiFi ulozena, ale pripojeni selhalo - AP captive zustava aktivni";
-  return false;
+  if (!ok) {
+    jobState_ = WIFI_JOB_FAILED;
+    jobMessage_.assignf("Pripojeni selhalo: %s", message);
+    WiFi.disconnect(false, false);
+    if (testFromCaptive_) {
+      state_ = WIFI_AP_CAPTIVE;
+      WiFi.mode(WIFI_AP);
+    } else if (hasStoredCredentials()) {
+      // Návrat na původní síť
+      startStaConnect(now);
+    } else {
+      startCaptiveMode();
+    }
+  }
+
+  pendingPassword_.clear();
+  LOGI(WIFI, "Job %lu - %s", (unsigned long)jobId_, jobMessage_.c_str());
+}
+
+WifiJobState WifiProvisioning::getJob(uint32_t jobId, String& message) const {
+  if (jobId == 0 || jobId != jobId_) {
+    message = "Neznama uloha";
+    return WIFI_JOB_NONE;
+  }
+  message = jobMessage_.c_str();
+  return jobState_;
 }
 
 bool WifiProvisioning::forgetCredentials() {
   if (!config_) return false;
 
   AppConfig updated = *config_;
-  updated.wifiSsid = "";
-  updated.wifiPassword = "";
+  updated.wifiSsid.clear();
+  updated.wifiPassword.clear();
   if (!saveConfig(updated)) return false;
 
   *config_ = updated;
+  clearFastConnectCache();
   startCaptiveMode();
   return true;
 }
 
-String WifiProvisioning::getStateText() const {
+const char* WifiProvisioning::getStateText() const {
   switch (state_) {
     case WIFI_STA_CONNECTED:
       return "WIFI_STA_CONNECTED";
     case WIFI_AP_CAPTIVE:
       return "WIFI_AP_CAPTIVE";
+    case WIFI_AP_STA_TESTING:
+      return "WIFI_AP_STA_TESTING";
     case WIFI_STA_CONNECTING:
     default:
       return "WIFI_STA_CONNECTING";
   }
 }
 
-bool WifiProvisioning::connectStaBlocking(unsigned long timeoutMs) {
-  if (!config_ || !hasStoredCredentials()) return false;
+bool WifiProvisioning::fastCacheUsable() const {
+  return fastCacheValid_ && fastCache_.channel > 0 &&
+         fastCache_.credentialsHash == credentialsHash(config_->wifiSsid.c_str(), config_->wifiPassword.c_str());
+}
 
-  stopCaptiveMode();
+bool WifiProvisioning::cachedLeaseUsable() const {
+  if (fastCache_.ip == 0 || fastCache_.gateway == 0 || fastCache_.subnet == 0) return false;
+  uint32_t now = unixNow();
+  if (fastCache_.leaseObtainedAt < UNIX_TIME_VALID || now < fastCache_.leaseObtainedAt) return false;
+  return now - fastCache_.leaseObtainedAt < CACHED_LEASE_MAX_AGE_S;
+}
 
-  state_ = WIFI_STA_CONNECTING;
-  WiFi.mode(WIFI_STA);
-  WiFi.setAutoReconnect(true);
-  WiFi.begin(config_->wifiSsid.c_str(), config_->wifiPassword.c_str());
-  Serial.printf("WIFI PROV: Pripojuji k SSID '%s'\n", config_->wifiSsid.c_str());
+uint32_t WifiProvisioning::unixNow() const {
+  uint32_t now = unixClock_ ? unixClock_() : (uint32_t)time(nullptr);
+  return now >= UNIX_TIME_VALID ? now : 0;
+}
 
-  unsigned long start = millis();
-  while (WiFi.status() != WL_CONNECTED && (millis() - start) < timeoutMs) {
-    delay(250);
+bool WifiProvisioning::isFatalDisconnect(uint16_t reason) {
+  switch (reason) {
+    case WIFI_REASON_AUTH_EXPIRE:
+    case WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT:
+    case WIFI_REASON_NO_AP_FOUND:
+    case WIFI_REASON_AUTH_FAIL:
+    case WIFI_REASON_ASSOC_FAIL:
+    case WIFI_REASON_HANDSHAKE_TIMEOUT:
+      return true;
+    default:
+      return false;
   }
+}
 
-  if (WiFi.status() == WL_CONNECTED) {
-    state_ = WIFI_STA_CONNECTED;
-    staConnectStartedAt_ = 0;
-    lastReconnectAttemptAt_ = 0;
-    Serial.printf("WIFI PROV: STA pripojeno, IP: %s\n", WiFi.localIP().toString().c_str());
-    return true;
+void WifiProvisioning::applyIpConfig(bool allowCachedLease) {
+  usingCachedLease_ = false;
+  if (config_->wifiStaticIp) {
+    IPAddress ip, gateway, subnet, dns;
+    ip.fromString(config_->wifiStaticAddress.c_str());
+    gateway.fromString(config_->wifiGateway.c_str());
+    subnet.fromString(config_->wifiSubnet.c_str());
+    if (config_->wifiDns.length() == 0 || !dns.fromString(config_->wifiDns.c_str())) dns = gateway;
+    WiFi.config(ip, gateway, subnet, dns);
+    return;
   }
 
-  return false;
+  if (allowCachedLease && cachedLeaseUsable()) {
+    WiFi.config(IPAddress(fastCache_.ip), IPAddress(fastCache_.gateway), IPAddress(fastCache_.subnet),
+                IPAddress(fastCache_.dns ? fastCache_.dns : fastCache_.gateway));
+    usingCachedLease_ = true;
+    return;
+  }
+
+  // Nulové adresy znovu zapnou DHCP klienta
+  WiFi.config(IPAddress((uint32_t)0), IPAddress((uint32_t)0), IPAddress((uint32_t)0));
 }
 
 void WifiProvisioning::startCaptiveMode() {
   stopCaptiveMode();
 
   state_ = WIFI_AP_CAPTIVE;
+  apShutdownAt_ = 0;
   WiFi.disconnect(true, true);
   WiFi.mode(WIFI_AP);
 
-  apSsid_ = buildApName();
+  buildApName(apSsid_);
   bool apOk = WiFi.softAP(apSsid_.c_str(), AP_PASSWORD);
   delay(50);
   apIp_ = WiFi.softAPIP();
@@ -169,10 +433,10 @@ void WifiProvisioning::startCaptiveMode() {
   dnsServer_.start(DNS_PORT, "*", apIp_);
   captiveRunning_ = true;
 
-  Serial.printf("WIFI PROV: AP %s (%s), open=%s, dns=%s\n",
-                apSsid_.c_str(), apIp_.toString().c_str(),
-                AP_PASSWORD[0] == '\0' ? "ano" : "ne",
-                apOk ? "ok" : "fail");
+  LOGI(WIFI, "AP %s (%s), open=%s, dns=%s",
+       apSsid_.c_str(), apIp_.toString().c_str(),
+       AP_PASSWORD[0] == '\0' ? "ano" : "ne",
+       apOk ? "ok" : "fail");
 }
 
 void WifiProvisioning::stopCaptiveMode() {
@@ -189,3 +453,61 @@ void WifiProvisioning::stopCaptiveMode() {
 bool WifiProvisioning::hasStoredCredentials() const {
   return config_ && config_->wifiSsid.length() > 0;
 }
+
+uint32_t WifiProvisioning::credentialsHash(const char* ssid, const char* password) const {
+  uint32_t hash = fnv1a(2166136261UL, ssid);
+  hash = fnv1a(hash ^ 0xFF, password);
+  return hash;
+}
+
+void WifiProvisioning::loadFastConnectCache() {
+  fastCacheValid_ = false;
+  Preferences pref;
+  if (!pref.begin(CACHE_NS, true)) return;
+  if (pref.getBytesLength(CACHE_KEY) == sizeof(fastCache_)) {
+    fastCacheValid_ = pref.getBytes(CACHE_KEY, &fastCache_, sizeof(fastCache_)) == sizeof(fastCache_);
+  }
+  pref.end();
+}
+
+void WifiProvisioning::storeFastConnectCache() {
+  WifiFastConnectCache fresh;
+  fresh.credentialsHash = credentialsHash(config_->wifiSsid.c_str(), config_->wifiPassword.c_str());
+  const uint8_t* bssid = WiFi.BSSID();
+  if (bssid) memcpy(fresh.bssid, bssid, sizeof(fresh.bssid));
+  fresh.channel = WiFi.channel();
+  if (usingCachedLease_) {
+    // Adresa je jen převzatá z cache, lease se tím neprodlužuje
+    fresh.ip = fastCache_.ip;
+    fresh.gateway = fastCache_.gateway;
+    fresh.subnet = fastCache_.subnet;
+    fresh.dns = fastCache_.dns;
+    fresh.leaseObtainedAt = fastCache_.leaseObtainedAt;
+  } else if (!config_->wifiStaticIp) {
+    fresh.ip = (uint32_t)WiFi.localIP();
+    fresh.gateway = (uint32_t)WiFi.gatewayIP();
+    fresh.subnet = (uint32_t)WiFi.subnetMask();
+    fresh.dns = (uint32_t)WiFi.dnsIP();
+    fresh.leaseObtainedAt = unixNow();
+  }
+
+  // Zápis do NVS jen při změně (šetří flash)
+  if (fastCacheValid_ && memcmp(&fresh, &fastCache_, sizeof(fresh)) == 0) return;
+
+  Preferences pref;
+  if (!pref.begin(CACHE_NS, false)) return;
+  pref.putBytes(CACHE_KEY, &fresh, sizeof(fresh));
+  pref.end();
+  fastCache_ = fresh;
+  fastCacheValid_ = true;
+}
+
+void WifiProvisioning::clearFastConnectCache() {
+  fastCache_ = WifiFastConnectCache();
+  if (!fastCacheValid_) return;
+  fastCacheValid_ = false;
+  Preferences pref;
+  if (!pref.begin(CACHE_NS, false)) return;
+  pref.remove(CACHE_KEY);
+  pref.end();
+}
@@ -2,7 +2,8 @@
 
 #include <Arduino.h>
 #include <DNSServer.h>
-#include <WebServer.h>
+
+#include <atomic>
 
 #include "config.h"
 
@@ -10,37 +11,127 @@ enum WifiModeState {
   WIFI_STA_CONNECTING = 0,
   WIFI_STA_CONNECTED,
   WIFI_AP_CAPTIVE,
+  WIFI_AP_STA_TESTING,  // AP běží dál, STA zkouší nové přihlašovací údaje
+};
+
+enum WifiJobState {
+  WIFI_JOB_NONE = 0,
+  WIFI_JOB_RUNNING,
+  WIFI_JOB_SUCCEEDED,
+  WIFI_JOB_FAILED,
+};
+
+// Události z Wi-Fi driveru (přichází z event tasku, zpracují se v process())
+enum WifiProvEvent : uint8_t {
+  WIFI_EV_STA_CONNECTED = 0,
+  WIFI_EV_STA_GOT_IP,
+  WIFI_EV_STA_DISCONNECTED,
+  WIFI_EV_STA_LOST_IP,
+};
+
+// Poslední úspěšné připojení - umožní přímý connect bez skenování a DHCP
+struct WifiFastConnectCache {
+  uint32_t credentialsHash = 0;
+  uint8_t bssid[6] = {0};
+  int32_t channel = 0;
+  uint32_t ip = 0;
+  uint32_t gateway = 0;
+  uint32_t subnet = 0;
+  uint32_t dns = 0;
+  uint32_t leaseObtainedAt = 0;  // unixový čas přidělení adresy DHCP, 0 = neznámý
 };
 
 class WifiProvisioning {
  public:
   void begin(AppConfig* config, unsigned long connectTimeoutMs = 20000UL);
+  // Zdroj unixového času pro stáří uloženého lease; výchozí time(nullptr)
+  void setUnixClock(uint32_t (*clock)()) { unixClock_ = clock; }
   void process();
 
-  bool saveCredentialsAndConnect(const String& ssid, const String& password, String& statusMsg);
+  // Neblokující - vrací id úlohy, jejíž stav se dotazuje přes getJob()
+  uint32_t startCredentialTest(const char* ssid, const char* password, String& statusMsg);
+  WifiJobState getJob(uint32_t jobId, String& message) const;
   bool forgetCredentials();
 
+  // Vstup pro události; volá handler registrovaný přes WiFi.onEvent()
+  void postEvent(WifiProvEvent event, uint16_t reason = 0);
+
   WifiModeState getState() const { return state_; }
-  bool isCaptiveMode() const { return state_ == WIFI_AP_CAPTIVE; }
-  String getStateText() const;
-  String getApSsid() const { return apSsid_; }
+  bool isCaptiveMode() const { return captiveRunning_ && (state_ == WIFI_AP_CAPTIVE || state_ == WIFI_AP_STA_TESTING); }
+  const char* getStateText() const;
+  const char* getApSsid() const { return apSsid_.c_str(); }
   String getApIp() const { return apIp_.toString(); }
+  unsigned long getLastConnectDurationMs() const { return lastConnectDurationMs_; }
+  bool lastConnectWasFast() const { return lastConnectWasFast_; }
 
  private:
-  bool connectStaBlocking(unsigned long timeoutMs);
+  enum ConnectPhase : uint8_t {
+    PHASE_FAST = 0,
+    PHASE_SCAN,
+    PHASE_RECONNECT,
+  };
+
+  struct QueuedEvent {
+    WifiProvEvent event;
+    uint16_t reason;
+  };
+
+  void handleEvent(const QueuedEvent& ev, unsigned long now);
+  void handleTimeouts(unsigned long now);
+
+  void startStaConnect(unsigned long now);
+  void beginScanPhase(unsigned long now);
+  void onStaConnected(unsigned long now);
+  void finishCredentialTest(bool ok, const char* message, unsigned long now);
+  void applyIpConfig(bool allowCachedLease);
+  bool fastCacheUsable() const;
+  bool cachedLeaseUsable() const;
+  uint32_t unixNow() const;
+  static bool isFatalDisconnect(uint16_t reason);
+
   void startCaptiveMode();
   void stopCaptiveMode();
   bool hasStoredCredentials() const;
 
+  uint32_t credentialsHash(const char* ssid, const char* password) const;
+  void loadFastConnectCache();
+  void storeFastConnectCache();
+  void clearFastConnectCache();
+
   AppConfig* config_ = nullptr;
   DNSServer dnsServer_;
   WifiModeState state_ = WIFI_STA_CONNECTING;
+  ConnectPhase phase_ = PHASE_SCAN;
+  unsigned long phaseDeadline_ = 0;
 
   bool captiveRunning_ = false;
+  unsigned long apShutdownAt_ = 0;
   IPAddress apIp_ = IPAddress(192, 168, 4, 1);
-  String apSsid_;
+  FixedString<24> apSsid_;
   unsigned long connectTimeoutMs_ = 20000UL;
 
   unsigned long staConnectStartedAt_ = 0;
   unsigned long lastReconnectAttemptAt_ = 0;
+  bool eventHandlerRegistered_ = false;
+
+  static constexpr uint8_t EVENT_QUEUE_SIZE = 8;
+  QueuedEvent events_[EVENT_QUEUE_SIZE];
+  std::atomic<uint8_t> eventHead_{0};
+  std::atomic<uint8_t> eventTail_{0};
+  std::atomic<bool> eventOverflow_{false};
+
+  // Test nových údajů z /api/wifi/save
+  bool testFromCaptive_ = false;
+  FixedString<32> pendingSsid_;
+  FixedString<64> pendingPassword_;
+  uint32_t jobId_ = 0;
+  WifiJobState jobState_ = WIFI_JOB_NONE;
+  FixedString<96> jobMessage_;
+
+  WifiFastConnectCache fastCache_;
+  bool fastCacheValid_ = false;
+  bool usingCachedLease_ = false;  // adresa z cache nastavená staticky, po připojení obnovit DHCP
+  uint32_t (*unixClock_)() = nullptr;
+  unsigned long lastConnectDurationMs_ = 0;
+  bool lastConnectWasFast_ = false;
 };
@@ -1,30 +1,81 @@
 #include "config.h"
 
 #include <Preferences.h>
+#include "AlarmEngine.h"
+#include "MqttTopics.h"
 #include <cmath>
 
 namespace {
 constexpr const char* NS = "appcfg";
+// Perioda střídy musí pojmout okno SEN66 (ustálení ~1 min) i pauzu mezi okny
+constexpr unsigned long SEN66_DUTY_MIN_MS = 120000;
+constexpr unsigned long SEN66_DUTY_MAX_MS = 3600000;
+
+bool validSen66Duty(unsigned long periodMs) {
+  return periodMs == 0 || (periodMs >= SEN66_DUTY_MIN_MS && periodMs <= SEN66_DUTY_MAX_MS);
+}
+
+bool validOtaUrl(const FixedString<159>& url) {
+  return url.isEmpty() || strncmp(url.c_str(), "http://", 7) == 0;
+}
 
 void sanitize(AppConfig& cfg) {
   if (cfg.mqttPort < 1 || cfg.mqttPort > 65535) cfg.mqttPort = 1883;
+  if (cfg.mqttQos > 1) cfg.mqttQos = 1;
   if (cfg.displayRotation > 3) cfg.displayRotation = 2;
   if (cfg.displayRefreshInterval < 500) cfg.displayRefreshInterval = 2000;
   if (cfg.mqttPublishInterval < 1000) cfg.mqttPublishInterval = 10000;
   if (cfg.tmepRequestInterval < 1000) cfg.tmepRequestInterval = 60000;
   if (cfg.mqttWarmupDelay < 1000) cfg.mqttWarmupDelay = 60000;
+  if (cfg.historyInterval != 0 && cfg.historyInterval < 1000) cfg.historyInterval = 10000;
   if (!isfinite(cfg.temperatureOffset)) cfg.temperatureOffset = -2.0f;
+  if (cfg.wakeLatencyMs < 10 || cfg.wakeLatencyMs > 1000) cfg.wakeLatencyMs = 50;
+  if (!validSen66Duty(cfg.sen66DutyPeriod)) cfg.sen66DutyPeriod = 0;
+  if (!AlarmEngine::validate(cfg.alarmRules.c_str())) cfg.alarmRules.clear();
+  if (!validOtaUrl(cfg.otaUrl)) cfg.otaUrl.clear();
+  if (!MqttTopics::validBaseTopic(cfg.mqttBaseTopic.c_str())) cfg.mqttBaseTopic.assign("sharp");
+  if (!MqttTopics::validDeviceId(cfg.mqttDeviceId.c_str())) cfg.mqttDeviceId.clear();
+  if (cfg.wifiStaticIp) {
+    IPAddress ip;
+    if (!ip.fromString(cfg.wifiStaticAddress.c_str()) || !ip.fromString(cfg.wifiGateway.c_str()) ||
+        !ip.fromString(cfg.wifiSubnet.c_str())) {
+      cfg.wifiStaticIp = false;
+    }
+  }
+}
+
+// Bez dočasného String; uložená hodnota delší než kapacita pole (nebo
+// chybějící klíč) ponechá výchozí hodnotu
+template <size_t N>
+void getString(Preferences& pref, const char* key, FixedString<N>& value) {
+  char buffer[N + 1];
+  if (pref.getString(key, buffer, sizeof(buffer)) > 0) value.assign(buffer);
 }
 }  // namespace
 
 bool validateConfig(const AppConfig& cfg) {
   if (cfg.mqttServer.length() == 0) return false;
+  if (cfg.wifiStaticIp) {
+    IPAddress ip;
+    if (!ip.fromString(cfg.wifiStaticAddress.c_str())) return false;
+    if (!ip.fromString(cfg.wifiGateway.c_str())) return false;
+    if (!ip.fromString(cfg.wifiSubnet.c_str())) return false;
+    if (cfg.wifiDns.length() > 0 && !ip.fromString(cfg.wifiDns.c_str())) return false;
+  }
   if (cfg.mqttPort < 1 || cfg.mqttPort > 65535) return false;
+  if (cfg.mqttQos > 1) return false;
   if (cfg.displayRotation > 3) return false;
   if (cfg.displayRefreshInterval < 500) return false;
   if (cfg.mqttPublishInterval < 1000) return false;
   if (cfg.tmepRequestInterval < 1000) return false;
   if (cfg.mqttWarmupDelay < 1000) return false;
+  if (cfg.historyInterval != 0 && cfg.historyInterval < 1000) return false;
+  if (cfg.wakeLatencyMs < 10 || cfg.wakeLatencyMs > 1000) return false;
+  if (!validSen66Duty(cfg.sen66DutyPeriod)) return false;
+  if (!AlarmEngine::validate(cfg.alarmRules.c_str())) return false;
+  if (!validOtaUrl(cfg.otaUrl)) return false;
+  if (!MqttTopics::validBaseTopic(cfg.mqttBaseTopic.c_str())) return false;
+  if (!MqttTopics::validDeviceId(cfg.mqttDeviceId.c_str())) return false;
   return true;
 }
 
@@ -32,29 +83,45 @@ bool loadConfig(AppConfig& config) {
   Preferences pref;
   if (!pref.begin(NS, true)) return false;
 
-  config.wifiSsid = pref.getString("wifi_ssid", config.wifiSsid);
-  config.wifiPassword = pref.getString("wifi_pass", config.wifiPassword);
+  getString(pref, "wifi_ssid", config.wifiSsid);
+  getString(pref, "wifi_pass", config.wifiPassword);
+  config.wifiStaticIp = pref.getBool("wifi_static", config.wifiStaticIp);
+  getString(pref, "wifi_ip", config.wifiStaticAddress);
+  getString(pref, "wifi_gw", config.wifiGateway);
+  getString(pref, "wifi_mask", config.wifiSubnet);
+  getString(pref, "wifi_dns", config.wifiDns);
 
-  config.mqttServer = pref.getString("mqtt_server", config.mqttServer);
+  getString(pref, "mqtt_server", config.mqttServer);
   config.mqttPort = pref.getInt("mqtt_port", config.mqttPort);
-  config.mqttUser = pref.getString("mqtt_user", config.mqttUser);
-  config.mqttPassword = pref.getString("mqtt_pass", config.mqttPassword);
-  config.mqttClientId = pref.getString("mqtt_client", config.mqttClientId);
+  getString(pref, "mqtt_user", config.mqttUser);
+  getString(pref, "mqtt_pass", config.mqttPassword);
+  getString(pref, "mqtt_client", config.mqttClientId);
+  getString(pref, "mqtt_base", config.mqttBaseTopic);
+  getString(pref, "mqtt_dev_id", config.mqttDeviceId);
+  config.mqttQos = pref.getUChar("mqtt_qos", config.mqttQos);
 
-  config.tmepDomain = pref.getString("tmep_domain", config.tmepDomain);
-  config.tmepParams = pref.getString("tmep_params", config.tmepParams);
+  getString(pref, "tmep_domain", config.tmepDomain);
+  getString(pref, "tmep_params", config.tmepParams);
 
   config.mqttPublishInterval = pref.getULong("mqtt_pub_ms", config.mqttPublishInterval);
   config.tmepRequestInterval = pref.getULong("tmep_req_ms", config.tmepRequestInterval);
   config.displayRefreshInterval = pref.getULong("disp_ref_ms", config.displayRefreshInterval);
   config.mqttWarmupDelay = pref.getULong("mqtt_warmup", config.mqttWarmupDelay);
+  config.historyInterval = pref.getULong("hist_ms", config.historyInterval);
 
-  config.tmepBaseUrl = pref.getString("tmep_base", config.tmepBaseUrl);
+  getString(pref, "tmep_base", config.tmepBaseUrl);
   config.temperatureOffset = pref.getFloat("temp_offset", config.temperatureOffset);
+  getString(pref, "sensors", config.extraSensors);
+  getString(pref, "alarm_rules", config.alarmRules);
+  getString(pref, "ota_url", config.otaUrl);
 
   config.displayRotation = pref.getUChar("disp_rot", config.displayRotation);
   config.displayInvertRequested = pref.getBool("disp_inv", config.displayInvertRequested);
 
+  config.powerSaveMode = pref.getBool("power_save", config.powerSaveMode);
+  config.wakeLatencyMs = pref.getULong("wake_lat_ms", config.wakeLatencyMs);
+  config.sen66DutyPeriod = pref.getULong("sen66_duty", config.sen66DutyPeriod);
+
   pref.end();
   sanitize(config);
   return true;
@@ -66,29 +133,45 @@ bool saveConfig(const AppConfig& config) {
   Preferences pref;
   if (!pref.begin(NS, false)) return false;
 
-  pref.putString("wifi_ssid", config.wifiSsid);
-  pref.putString("wifi_pass", config.wifiPassword);
+  pref.putString("wifi_ssid", config.wifiSsid.c_str());
+  pref.putString("wifi_pass", config.wifiPassword.c_str());
+  pref.putBool("wifi_static", config.wifiStaticIp);
+  pref.putString("wifi_ip", config.wifiStaticAddress.c_str());
+  pref.putString("wifi_gw", config.wifiGateway.c_str());
+  pref.putString("wifi_mask", config.wifiSubnet.c_str());
+  pref.putString("wifi_dns", config.wifiDns.c_str());
 
-  pref.putString("mqtt_server", config.mqttServer);
+  pref.putString("mqtt_server", config.mqttServer.c_str());
   pref.putInt("mqtt_port", config.mqttPort);
-  pref.putString("mqtt_user", config.mqttUser);
-  pref.putString("mqtt_pass", config.mqttPassword);
-  pref.putString("mqtt_client", config.mqttClientId);
+  pref.putString("mqtt_user", config.mqttUser.c_str());
+  pref.putString("mqtt_pass", config.mqttPassword.c_str());
+  pref.putString("mqtt_client", config.mqttClientId.c_str());
+  pref.putString("mqtt_base", config.mqttBaseTopic.c_str());
+  pref.putString("mqtt_dev_id", config.mqttDeviceId.c_str());
+  pref.putUChar("mqtt_qos", config.mqttQos);
 
-  pref.putString("tmep_domain", config.tmepDomain);
-  pref.putString("tmep_params", config.tmepParams);
+  pref.putString("tmep_domain", config.tmepDomain.c_str());
+  pref.putString("tmep_params", config.tmepParams.c_str());
 
   pref.putULong("mqtt_pub_ms", config.mqttPublishInterval);
   pref.putULong("tmep_req_ms", config.tmepRequestInterval);
   pref.putULong("disp_ref_ms", config.displayRefreshInterval);
   pref.putULong("mqtt_warmup", config.mqttWarmupDelay);
+  pref.putULong("hist_ms", config.historyInterval);
 
-  pref.putString("tmep_base", config.tmepBaseUrl);
+  pref.putString("tmep_base", config.tmepBaseUrl.c_str());
   pref.putFloat("temp_offset", config.temperatureOffset);
+  pref.putString("sensors", config.extraSensors.c_str());
+  pref.putString("alarm_rules", config.alarmRules.c_str());
+  pref.putString("ota_url", config.otaUrl.c_str());
 
   pref.putUChar("disp_rot", config.displayRotation);
   pref.putBool("disp_inv", config.displayInvertRequested);
 
+  pref.putBool("power_save", config.powerSaveMode);
+  pref.putULong("wake_lat_ms", config.wakeLatencyMs);
+  pref.putULong("sen66_duty", config.sen66DutyPeriod);
+
   pref.end();
   return true;
 }
@@ -2,30 +2,63 @@
 
 #include <Arduino.h>
 
+#include "FixedString.h"
+
+// Řetězce mají pevnou kapacitu (bez alokací); delší hodnotu API odmítne
 struct AppConfig {
-  String wifiSsid = "";
-  String wifiPassword = "";
+  FixedString<32> wifiSsid;
+  FixedString<64> wifiPassword;
+
+  // Statická IP (jinak DHCP, případně znovupoužití posledního leasu)
+  bool wifiStaticIp = false;
+  FixedString<15> wifiStaticAddress;
+  FixedString<15> wifiGateway;
+  FixedString<15> wifiSubnet{"255.255.255.0"};
+  FixedString<15> wifiDns;
 
-  String mqttServer = "192.168.0.X";
+  FixedString<64> mqttServer{"192.168.0.X"};
   int mqttPort = 1883;
-  String mqttUser = "";
-  String mqttPassword = "";
-  String mqttClientId = "sharp";
+  FixedString<64> mqttUser;
+  FixedString<64> mqttPassword;
+  FixedString<32> mqttClientId{"sharp"};
+  // Základ všech topiců zařízení a id pro HA (unique_id, discovery); prázdné id = původní
+  // identifikátory, pro více zařízení na jednom brokeru musí mít každé vlastní základ i id
+  FixedString<31> mqttBaseTopic{"sharp"};
+  FixedString<23> mqttDeviceId;
+  // QoS senzorových dat: 0 = bez potvrzení, 1 = PUBACK s okénkem a opakováním (MqttOutbox)
+  uint8_t mqttQos = 1;
 
-  String tmepDomain = "";
-  String tmepParams = "tempV=*TEMP*&humV=*HUM*&pm1=*PM1*&pm2=*PM2*&pm4=*PM4*&pm10=*PM10*&voc=*VOC*&nox=*NOX*&co2=*CO2*";
+  FixedString<48> tmepDomain;
+  FixedString<256> tmepParams{"tempV=*TEMP*&humV=*HUM*&pm1=*PM1*&pm2=*PM2*&pm4=*PM4*&pm10=*PM10*&voc=*VOC*&nox=*NOX*&co2=*CO2*"};
 
   unsigned long mqttPublishInterval = 10000;
   unsigned long tmepRequestInterval = 60000;
   unsigned long displayRefreshInterval = 2000;
   unsigned long mqttWarmupDelay = 60000;
+  unsigned long historyInterval = 10000;  // zápis do logu na LittleFS, 0 = vypnuto
 
-  String tmepBaseUrl = "";
+  FixedString<96> tmepBaseUrl;
 
   float temperatureOffset = -2.0f;
 
+  // Další senzory vedle primárního SEN66, např. "sen66@1,scd4x,sht4x" (@N = kanál TCA9548A)
+  FixedString<64> extraSensors;
+
+  // Alarmy vyhodnocované v zařízení, např. "co2>1200:1000:60;pm25>35:25:120"
+  // (klíč kanálu, práh[:konec alarmu[:dwell v s]])
+  FixedString<192> alarmRules;
+
+  // Výchozí URL firmware pro OTA (celý image nebo delta), pokud ji trigger neuvede
+  FixedString<159> otaUrl;
+
   uint8_t displayRotation = 2;
   bool displayInvertRequested = false;
+
+  // Úsporný režim: light sleep + modem sleep mezi plánovanou prací
+  bool powerSaveMode = false;
+  unsigned long wakeLatencyMs = 50;
+  // Střída SEN66: měřit jen v okně jednou za periodu (ms), 0 = nepřetržitě
+  unsigned long sen66DutyPeriod = 0;
 };
 
 bool loadConfig(AppConfig& config);
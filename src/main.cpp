@@ -17,13 +17,39 @@
 #include <HTTPClient.h>
 #include <Wire.h>
 #include <PubSubClient.h>
-#include <WebServer.h>
 #include <Adafruit_GFX.h>
-#include <Adafruit_SharpMem.h>
-#include <SensirionI2cSen66.h>
 #include <ArduinoJson.h>
+#include <LittleFS.h>
+#include <time.h>
+#include <esp_timer.h>
 #include "config.h"
+#include "FixedString.h"
 #include "WifiProvisioning.h"
+#include "PowerManager.h"
+#include "SensorRegistry.h"
+#include "SharpDisplay.h"
+#include "DisplayList.h"
+#include "BitmapReceiver.h"
+#include "AlarmEngine.h"
+#include "AirQuality.h"
+#include "SampleLatency.h"
+#include "OtaUpdater.h"
+#include "Sen66Driver.h"
+#include "Scd4xDriver.h"
+#include "Sht4xDriver.h"
+#include "SampleLog.h"
+#include "SensorTrace.h"
+#include "SampleText.h"
+#include "MqttTopics.h"
+#include "MqttOutbox.h"
+#include "MqttClientTap.h"
+#include "MqttPacing.h"
+#include "ResponseCache.h"
+#include "JsonPool.h"
+#include "SamplePayload.h"
+#include "HttpServer.h"
+#include "Log.h"
+#include "WebUiAssets.h"  // generováno z web/ při buildu
 
 // =============================================
 //  KONFIGURACE - UPRAVTE PODLE POTŘEBY
@@ -42,85 +68,129 @@
 // Displej
 #define DISPLAY_WIDTH  400
 #define DISPLAY_HEIGHT 240
+#define DISPLAY_DOUBLE_BUFFER true   // 2 DMA buffery: další snímek se skládá během přenosu (+12 KB RAM)
 #define BLACK 0
 #define WHITE 1
 
 // Intervaly (ms)
 #define SENSOR_READ_INTERVAL   2000   // čtení senzoru každé 2s
-#define MQTT_RECONNECT_INTERVAL  5000
+#define DISPLAY_PAGE_INTERVAL 10000   // střídání dashboardu a seznamu dalších senzorů
+#define ALARM_PAGE_DURATION      30000   // jak dlouho po spuštění alarmu ukazovat stránku s alarmy
+#define MQTT_KEEPALIVE_S         15
+#define MQTT_BUFFER_SIZE         2560    // buffer PubSubClient: HA Discovery JSON a bitmapy v seznamu prvků displeje
+#define MQTT_PUBLISH_OVERHEAD    9       // hlavička PUBLISH (až 5 B), délka topicu (2 B), packet id QoS 1 (2 B)
+#define MQTT_PUBACK_POLL_MS      50      // buzení kvůli PUBACK, dokud outbox QoS 1 něco drží
+#define HISTORY_BUDGET_BYTES     (1024UL * 1024UL)   // kruh segmentů logu na LittleFS
+#define HISTORY_DEFAULT_RANGE_S  86400
+#define OTA_RESTART_DELAY        3000    // po stažení firmware: čas na odeslání stavu do MQTT/webu
 
 // =============================================
 //  MQTT TOPICS
 // =============================================
 
-// Příchozí (subscribe)
-#define TOPIC_TEXT       "sharp/display/text"
-#define TOPIC_CLEAR      "sharp/display/clear"
-#define TOPIC_COMMAND    "sharp/display/command"
-#define TOPIC_BRIGHTNESS "sharp/display/brightness"
-
-// Odchozí (publish)
-#define TOPIC_STATUS     "sharp/status"
-#define TOPIC_SENSOR     "sharp/sensor"     // JSON se všemi hodnotami
-#define TOPIC_TEMP       "sharp/sensor/temperature"
-#define TOPIC_HUMIDITY   "sharp/sensor/humidity"
-#define TOPIC_PM1        "sharp/sensor/pm1"
-#define TOPIC_PM25       "sharp/sensor/pm25"
-#define TOPIC_PM4        "sharp/sensor/pm4"
-#define TOPIC_PM10       "sharp/sensor/pm10"
-#define TOPIC_VOC        "sharp/sensor/voc"
-#define TOPIC_NOX        "sharp/sensor/nox"
-#define TOPIC_CO2        "sharp/sensor/co2"
+// Topicy se skládají z mqttBaseTopic (výchozí "sharp") jednou při startu, viz MqttTopics.h.
+// Příchozí: display/text, display/clear, display/command, display/brightness,
+//   display/bitmap (binární 1bpp snímek/oblast, viz BitmapReceiver.h),
+//   ota ({"url":"http://...","sha256":"...","sig":"..."} spustí podepsanou aktualizaci),
+//   homeassistant/status (birth zpráva HA "online" = znovu poslat discovery)
+// Odchozí: status (LWT), sensor (JSON se všemi hodnotami, kanály v sensor/<key>),
+//   alarm (změna stavu alarmu), log (řádky úrovně LOG_MQTT_LEVEL a vážnější),
+//   ota/status (průběh a výsledek OTA aktualizace)
 
 // =============================================
 //  GLOBÁLNÍ OBJEKTY
 // =============================================
 
-Adafruit_SharpMem display(PIN_SPI_CLK, PIN_SPI_MOSI, PIN_SPI_CS, 
-                           DISPLAY_WIDTH, DISPLAY_HEIGHT);
-SensirionI2cSen66 sen66;
+SharpDisplay display(PIN_SPI_CLK, PIN_SPI_MOSI, PIN_SPI_CS,
+                     DISPLAY_WIDTH, DISPLAY_HEIGHT);
+DisplayList displayList;  // trvalé prvky z MQTT kreslené přes aktuální obrazovku
+BitmapReceiver bitmapReceiver(display);
+AlarmEngine alarms;
+AirQualityEngine airQuality;
+// Přehrávaná stopa má vlastní alarmy a okna kvality vzduchu (od nuly při každém
+// startu) - živý stav ani retained topicy HA se jí nedotknou
+AlarmEngine replayAlarms;
+AirQualityEngine replayAirQuality;
+bool replayPipeline = false;         // poslední vzorek pipeline byl ze stopy
+LatencyTracker latency;  // stáří vzorku při doručení odběratelům
+OtaUpdater otaUpdater;
+SensorRegistry sensors;
+Sen66Driver primarySen66(SENSOR_READ_INTERVAL);
+SensorTrace sensorTrace;  // záznam/přehrávání surových čtení primárního SEN66
+SampleText sampleText;    // hodnoty posledního vzorku naformátované jednou pro všechny odběratele
+MqttTopics mqttTopics;    // všechny topicy zařízení, sestavené po načtení konfigurace
 WiFiClient wifiClient;
-PubSubClient mqtt(wifiClient);
-WebServer webServer(80);
+MqttClientTap mqttTap(wifiClient);  // PubSubClient čte přes něj, PUBACK jde do outboxu
+PubSubClient mqtt(mqttTap);
+MqttOutbox mqttOutbox;              // QoS 1 senzorových dat s okénkem nepotvrzených zpráv
+HttpServer webServer(80);
+SemaphoreHandle_t appStateLock = nullptr;  // sdílený stav mezi loop() a tasky web serveru
 WifiProvisioning wifiProvisioning;
-
-// =============================================
-//  DATA SENZORU
-// =============================================
-
-struct SensorData {
-  float pm1   = 0.0;
-  float pm25  = 0.0;
-  float pm4   = 0.0;
-  float pm10  = 0.0;
-  float temperature = 0.0;
-  float humidity    = 0.0;
-  float voc   = 0.0;
-  float nox   = 0.0;
-  uint16_t co2 = 0;
-  bool valid = false;
-} sensorData;
+PowerManager powerManager;
+SampleLog sampleLog;
+ResponseCache dataCache;
+ResponseCache configCache;
+JsonPool jsonPool;
+
+// Dokumenty odpovědí API v jsonPool místo na heapu (jen se zámkem stavu)
+class JsonPoolAllocator : public ArduinoJson::Allocator {
+ public:
+  void* allocate(size_t size) override { return jsonPool.allocate(size); }
+  void deallocate(void* p) override { jsonPool.deallocate(p); }
+  void* reallocate(void* p, size_t size) override { return jsonPool.reallocate(p, size); }
+};
+JsonPoolAllocator jsonPoolAllocator;
 
 // =============================================
 //  STAV APLIKACE
 // =============================================
 
-unsigned long lastSensorRead = 0;
 unsigned long lastMqttPublish = 0;
 unsigned long lastDisplayRefresh = 0;
-unsigned long lastMqttReconnect = 0;
+uint32_t lastDisplayStamp = 0;         // otisk obsahu při posledním překreslení
+unsigned long lastDisplayPageSwitch = 0;
+uint8_t displayPage = 0;
+ReconnectBackoff mqttBackoff;            // termíny pokusů o připojení (MqttPacing.h)
+unsigned long mqttDisconnectedAt = 0;   // začátek výpadku (0 = připojeno nebo nezahájeno)
+uint32_t mqttConnectAttempts = 0;
+uint32_t mqttConnectFailures = 0;
+uint32_t mqttLastOutageMs = 0;          // délka posledního výpadku až po úspěšné připojení
+DiscoveryPacer haDiscovery;              // kurzor a rozestup discovery zpráv
+uint8_t mqttChannelEntities = 0;         // entity 0..n-1 = kanály senzorů, dál indexy AQI
+bool haDiscoveryPublished = false;      // retained konfigurace už na brokeru jsou (od startu)
+uint32_t haDiscoveryMessages = 0;
 unsigned long lastTmepRequest = 0;
 unsigned long firstValidSensorAt = 0;
+unsigned long lastHistoryAppend = 0;
+uint32_t lastTmepSequence = 0;       // poslední odeslaný vzorek (přeskočit, pokud nepřibyl nový)
+uint32_t lastPublishedSequence = 0;
+
+FixedString<15> lastTmepStatus{"TMEP:---"};
 
-String lastTmepStatus = "TMEP:---";
+// Generace stavu - mění se s Wi-Fi/MQTT/TMEP stavem a spolu s pořadím vzorku
+// určuje verzi cache /api/data; konfigurace se mimo restart mění jen Wi-Fi úlohou
+uint32_t statusGeneration = 0;
+WifiModeState lastWifiState = WIFI_STA_CONNECTING;
+bool lastMqttConnected = false;
+uint32_t lastIdleChannels = 0;  // kanály senzorů mezi okny střídy (zastaralé)
 
 AppConfig appConfig;
 
-bool sen66Ready = false;
-bool displayOverride = false;       // true = zobrazuje custom text z MQTT
+bool displayOverride = false;       // true = zobrazuje custom text nebo bitmapu z MQTT
+bool displayOverrideBitmap = false; // obsah bufferu je bitmapa z MQTT - nepřekreslovat
+bool displayRedrawRequested = false; // změna seznamu prvků - překreslit v nejbližším loop()
+bool tmepSendRequested = false;      // ruční odeslání z webu - provede ho loop()
+bool alarmPageActive = false;        // po spuštění alarmu se místo dashboardu ukazují alarmy
+unsigned long alarmPageUntil = 0;
+uint32_t alarmSequence = 0;          // poslední vyhodnocený vzorek
+uint32_t airQualitySequence = 0;     // poslední vzorek započtený do indexů kvality vzduchu
+AirQualityIndex airQualityIndex;     // indexy z klouzavých oken, přepočet jednou za vzorek
 unsigned long displayOverrideUntil = 0; // kdy přepnout zpět na senzory
+OtaState lastOtaState = OTA_IDLE;     // stav naposledy hlášený do MQTT
+uint8_t lastOtaProgress = 0;          // průběh po 10 % naposledy hlášený do MQTT
+unsigned long otaRestartAt = 0;       // restart do nového firmware, 0 = nenaplánován
 
-String overrideText = "";
+FixedString<255> overrideText;  // delší text z MQTT se ořízne
 int overrideTextSize = 2;
 int overrideX = 10;
 int overrideY = 10;
@@ -133,29 +203,10 @@ int overrideY = 10;
 void applyDisplaySettings() {
   display.setRotation(appConfig.displayRotation % 4);
   if (appConfig.displayInvertRequested) {
-    Serial.println("Display: Inverze je pozadovana, HW inverze neni na Sharp LCD podporovana.");
+    LOGW(DISP, "Inverze je pozadovana, HW inverze neni na Sharp LCD podporovana.");
   }
 }
 
-bool sensorValuesLookValid(const float pm1, const float pm25, const float pm4, const float pm10,
-                           const float hum, const float temp, const float voc, const float nox,
-                           const uint16_t co2) {
-  if (isnan(pm1) || isnan(pm25) || isnan(pm4) || isnan(pm10) || isnan(hum) || isnan(temp) ||
-      isnan(voc) || isnan(nox)) return false;
-
-  if (temp < -40.0f || temp > 85.0f) return false;
-  if (hum < 0.0f || hum > 100.0f) return false;
-  if (pm1 < 0.0f || pm1 > 1000.0f) return false;
-  if (pm25 < 0.0f || pm25 > 1000.0f) return false;
-  if (pm4 < 0.0f || pm4 > 1000.0f) return false;
-  if (pm10 < 0.0f || pm10 > 1000.0f) return false;
-  if (voc < 0.0f || voc > 500.0f) return false;
-  if (nox < 0.0f || nox > 500.0f) return false;
-  if (co2 < 350 || co2 > 10000) return false;
-
-  return true;
-}
-
 void drawCenteredText(const char* text, int y, int textSize) {
   display.setTextSize(textSize);
   int16_t x1, y1;
@@ -201,46 +252,67 @@ void drawDropIcon(int x, int y) {
 //  DISPLAY - HLAVNÍ OBRAZOVKY
 // =============================================
 
-// Hodnocení kvality vzduchu podle PM2.5
-const char* getAirQuality(float pm25) {
-  if (pm25 < 12.0)  return "VYNIKAJICI";
-  if (pm25 < 35.4)  return "DOBRE";
-  if (pm25 < 55.4)  return "PRIJATELNE";
-  if (pm25 < 150.4) return "SPATNE";
-  if (pm25 < 250.4) return "VELMI SPATNE";
-  return "NEBEZPECNE";
+// Hodnota primárního kanálu pro dashboard ("--", pokud ji žádný senzor neměří)
+const char* primaryText(ChannelKind kind) {
+  int8_t index = sensors.primaryIndex(kind);
+  return index >= 0 ? sampleText.display(index) : "--";
 }
 
-// Hlavní obrazovka se senzory
-void drawSensorScreen() {
-  display.clearDisplay();
-  display.setTextColor(BLACK);
-  
+// Kanály, které se na hlavní dashboard nevejdou (další senzory)
+bool hasSecondaryChannels() {
+  for (uint8_t i = 0; i < sensors.channelCount(); i++) {
+    if (!sensors.channel(i).primary) return true;
+  }
+  return false;
+}
+
+// Stáří vzorku od načtení z I2C (millis(), bez ohledu na SNTP)
+uint32_t sampleAgeMs(const SensorSample& sample) {
+  return millis() - sample.timestamp;
+}
+
+// IPAddress::toString() alokuje String - na periodických cestách tisknout přímo
+void formatIp(const IPAddress& ip, char* buf, size_t size) {
+  snprintf(buf, size, "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+}
+
+void drawStatusBar() {
   char buf[64];
-  
-  // === STATUS BAR (y=0..22) ===
   display.setTextSize(1);
   
   // WiFi status
   if (WiFi.status() == WL_CONNECTED) {
-    snprintf(buf, sizeof(buf), "WiFi:%s", WiFi.localIP().toString().c_str());
+    char ip[16];
+    formatIp(WiFi.localIP(), ip, sizeof(ip));
+    snprintf(buf, sizeof(buf), "WiFi:%s", ip);
   } else {
     snprintf(buf, sizeof(buf), "WiFi:---");
   }
   display.setCursor(5, 5);
   display.print(buf);
   
-  // TMEP status
+  // TMEP status, během OTA průběh stahování
   display.setCursor(165, 5);
-  display.print(lastTmepStatus);
+  if (otaUpdater.busy()) {
+    snprintf(buf, sizeof(buf), "OTA:%u%%", otaUpdater.progressPercent());
+    display.print(buf);
+  } else {
+    display.print(lastTmepStatus.c_str());
+  }
 
   // MQTT status
   display.setCursor(240, 5);
   display.print(mqtt.connected() ? "MQTT:OK" : "MQTT:---");
   
-  // SEN66 status
+  // Stav senzorů
   display.setCursor(315, 5);
-  display.print(sen66Ready ? "SEN66:OK" : "SEN66:---");
+  if (sensors.sensorCount() <= 1) {
+    bool ok = sensors.sensorCount() == 1 && sensors.readySensorCount() == 1;
+    snprintf(buf, sizeof(buf), "%s:%s", sensors.sensorCount() ? sensors.sensor(0)->model() : "SENS", ok ? "OK" : "---");
+  } else {
+    snprintf(buf, sizeof(buf), "SENS:%u/%u", sensors.readySensorCount(), sensors.sensorCount());
+  }
+  display.print(buf);
   
   // Uptime
   unsigned long uptimeSec = millis() / 1000;
@@ -250,25 +322,85 @@ void drawSensorScreen() {
   drawRightAlignedText(buf, 5, 1);
   
   drawDividerLine(18);
+}
+
+// Otisk všeho, co obrazovky zobrazují - překresluje se jen při jeho změně
+uint32_t displayContentStamp() {
+  uint32_t stamp = sensors.sampleSequence();
+  stamp = stamp * 31 + statusGeneration;          // Wi-Fi, MQTT, TMEP
+  stamp = stamp * 31 + sensors.readySensorCount();
+  stamp = stamp * 31 + displayPage;
+  stamp = stamp * 31 + (alarmPageActive ? alarms.activeMask() + 1 : 0);
+  stamp = stamp * 31 + millis() / 60000;          // uptime ve stavovém řádku
+  stamp = stamp * 31 + (otaUpdater.busy() ? otaUpdater.progressPercent() + 1 : 0);
+  return stamp;
+}
+
+// Dokreslí prvky ze seznamu a pošle na panel jen změněné řádky
+void presentFrame() {
+  SensorSample sample = sensors.snapshot();
+  displayList.render(display, sensors, sample, sampleText);
+  display.refresh();
+}
+
+// Obecný seznam všech kanálů ze všech senzorů
+void drawChannelListScreen() {
+  display.clearDisplay();
+  display.setTextColor(BLACK);
+  drawStatusBar();
+
+  SensorSample sample = sensors.snapshot();
+  display.setTextSize(1);
+  uint8_t rows = 0;
+  for (uint8_t i = 0; i < sensors.channelCount() && rows < 24; i++) {
+    const SensorChannel& ch = sensors.channel(i);
+    const ChannelKindInfo& info = channelKindInfo(ch.kind);
+    int x = (rows / 12) * 200 + 5;
+    int y = 24 + (rows % 12) * 18;
+    display.setCursor(x, y + 4);
+    display.print(ch.name);
+    display.setCursor(x + 100, y + 4);
+    display.print(sampleText.display(i));
+    if (sample.isValid(i) && info.unit[0]) {
+      display.print(' ');
+      display.print(info.unit);
+    }
+    rows++;
+  }
+  presentFrame();
+  if (sample.anyValid()) latency.record(LAT_DISPLAY, sample.sequence, sampleAgeMs(sample));
+}
+
+// Hlavní obrazovka se senzory
+void drawSensorScreen() {
+  display.clearDisplay();
+  display.setTextColor(BLACK);
+  
+  char buf[64];
+  const char* text;  // hodnoty z sampleText
+  SensorSample sample = sensors.snapshot();
+  
+  // === STATUS BAR (y=0..22) ===
+  drawStatusBar();
   
-  if (!sensorData.valid) {
+  if (!sample.anyValid()) {
     drawCenteredText("Cekam na data", 80, 2);
-    drawCenteredText("ze senzoru SEN66...", 110, 2);
-    display.refresh();
+    drawCenteredText("ze senzoru...", 110, 2);
+    presentFrame();
     return;
   }
   
   // === TEPLOTA & VLHKOST (y=24..80) ===
   // Teplota - velký font
   drawThermIcon(15, 28);
-  snprintf(buf, sizeof(buf), "%.1f", sensorData.temperature);
+  text = primaryText(CH_TEMPERATURE);
   display.setTextSize(4);
   display.setCursor(35, 25);
-  display.print(buf);
+  display.print(text);
   // Stupně C menším fontem
   int16_t x1, y1;
   uint16_t w, h;
-  display.getTextBounds(buf, 35, 25, &x1, &y1, &w, &h);
+  display.getTextBounds(text, 35, 25, &x1, &y1, &w, &h);
   display.setTextSize(2);
   display.setCursor(35 + w + 5, 25);
   display.print("o");
@@ -277,11 +409,11 @@ void drawSensorScreen() {
   
   // Vlhkost - velký font
   drawDropIcon(220, 28);
-  snprintf(buf, sizeof(buf), "%.1f", sensorData.humidity);
+  text = primaryText(CH_HUMIDITY);
   display.setTextSize(4);
   display.setCursor(240, 25);
-  display.print(buf);
-  display.getTextBounds(buf, 240, 25, &x1, &y1, &w, &h);
+  display.print(text);
+  display.getTextBounds(text, 240, 25, &x1, &y1, &w, &h);
   display.setTextSize(2);
   display.setCursor(240 + w + 5, 30);
   display.print("%");
@@ -302,21 +434,21 @@ void drawSensorScreen() {
   
   // Hodnoty - větší font
   display.setTextSize(3);
-  snprintf(buf, sizeof(buf), "%.0f", sensorData.pm1);
+  text = primaryText(CH_PM1);
   display.setCursor(10, 90);
-  display.print(buf);
+  display.print(text);
   
-  snprintf(buf, sizeof(buf), "%.0f", sensorData.pm25);
+  text = primaryText(CH_PM25);
   display.setCursor(110, 90);
-  display.print(buf);
+  display.print(text);
   
-  snprintf(buf, sizeof(buf), "%.0f", sensorData.pm4);
+  text = primaryText(CH_PM4);
   display.setCursor(210, 90);
-  display.print(buf);
+  display.print(text);
   
-  snprintf(buf, sizeof(buf), "%.0f", sensorData.pm10);
+  text = primaryText(CH_PM10);
   display.setCursor(310, 90);
-  display.print(buf);
+  display.print(text);
   
   // Jednotky
   display.setTextSize(1);
@@ -341,17 +473,17 @@ void drawSensorScreen() {
   display.print("CO2");
   
   display.setTextSize(3);
-  snprintf(buf, sizeof(buf), "%.0f", sensorData.voc);
+  text = primaryText(CH_VOC);
   display.setCursor(15, 152);
-  display.print(buf);
+  display.print(text);
   
-  snprintf(buf, sizeof(buf), "%.0f", sensorData.nox);
+  text = primaryText(CH_NOX);
   display.setCursor(155, 152);
-  display.print(buf);
+  display.print(text);
   
-  snprintf(buf, sizeof(buf), "%u", sensorData.co2);
+  text = primaryText(CH_CO2);
   display.setCursor(280, 152);
-  display.print(buf);
+  display.print(text);
   
   display.setTextSize(1);
   display.setCursor(350, 170);
@@ -360,22 +492,52 @@ void drawSensorScreen() {
   drawDividerLine(185);
   
   // === AIR QUALITY BAR (y=190..235) ===
-  const char* quality = getAirQuality(sensorData.pm25);
+  // Nejhorší z klouzavých indexů (NowCast PM2.5, CO2 15 min, VOC 1 h) - neskáče s výkyvy
+  const AirQualityIndex& aq = airQualityIndex;
+  bool haveIndex = aq.dominant != AQ_NONE;
   display.setTextSize(1);
   display.setCursor(15, 192);
   display.print("Kvalita vzduchu:");
+  if (haveIndex) {
+    snprintf(buf, sizeof(buf), "AQI %u (%s)", aq.overall, AirQualityEngine::pollutantName(aq.dominant));
+    display.setCursor(120, 192);
+    display.print(buf);
+  }
   
   display.setTextSize(3);
   display.setCursor(15, 208);
-  display.print(quality);
+  display.print(haveIndex ? AirQualityEngine::categoryLabel(aq.overall) : "---");
   
-  // Indikátor bar
-  float barValue = min(sensorData.pm25 / 150.0f, 1.0f);
+  // Indikátor bar (AQI 0-300)
+  float barValue = haveIndex ? min(aq.overall / 300.0f, 1.0f) : 0.0f;
   int barWidth = (int)(barValue * 120);
   display.drawRect(270, 200, 122, 24, BLACK);
   display.fillRect(271, 201, barWidth, 22, BLACK);
   
-  display.refresh();
+  presentFrame();
+  latency.record(LAT_DISPLAY, sample.sequence, sampleAgeMs(sample));
+}
+
+// Stránka s aktivními alarmy (po spuštění alarmu)
+void drawAlarmScreen() {
+  display.clearDisplay();
+  display.setTextColor(BLACK);
+  drawStatusBar();
+
+  drawCenteredText("! ALARM !", 40, 4);
+  char buf[64];
+  uint8_t row = 0;
+  for (uint8_t i = 0; i < alarms.ruleCount() && row < 5; i++) {
+    const AlarmRule& rule = alarms.rule(i);
+    if (!rule.active) continue;
+    const SensorChannel& ch = sensors.channel(rule.channel);
+    snprintf(buf, sizeof(buf), "%s %.*f %c %g", ch.name, channelKindInfo(ch.kind).displayDecimals,
+             rule.lastValue, rule.above ? '>' : '<', rule.onThreshold);
+    drawCenteredText(buf, 100 + row * 26, 2);
+    row++;
+  }
+  if (row == 0) drawCenteredText("Alarmy skoncily", 110, 2);
+  presentFrame();
 }
 
 // Obrazovka s custom textem (z MQTT)
@@ -384,8 +546,8 @@ void drawCustomTextScreen() {
   display.setTextColor(BLACK);
   display.setTextSize(overrideTextSize);
   display.setCursor(overrideX, overrideY);
-  display.println(overrideText);
-  display.refresh();
+  display.println(overrideText.c_str());
+  presentFrame();
 }
 
 // Boot/splash screen
@@ -401,11 +563,11 @@ void drawSplashScreen() {
   display.setTextSize(1);
   display.setCursor(30, 125);
   display.print("WiFi: ");
-  display.print(appConfig.wifiSsid);
+  display.print(appConfig.wifiSsid.c_str());
   
   display.setCursor(30, 140);
   display.print("MQTT: ");
-  display.print(appConfig.mqttServer);
+  display.print(appConfig.mqttServer.c_str());
   
   display.setCursor(30, 160);
   display.print("Inicializace...");
@@ -414,282 +576,331 @@ void drawSplashScreen() {
 }
 
 // =============================================
-//  SEN66 SENZOR
+//  SENZORY
 // =============================================
 
-#ifdef NO_ERROR
-#undef NO_ERROR
-#endif
-#define NO_ERROR 0
-
-void initSEN66() {
-  Serial.println("SEN66: Inicializace I2C...");
+void setupSensors() {
+  LOGI(SENS, "Inicializace I2C...");
   Wire.begin(PIN_SDA, PIN_SCL);
-  
-  sen66.begin(Wire, SEN66_I2C_ADDR_6B);
-  
-  int16_t error = sen66.deviceReset();
-  if (error != NO_ERROR) {
-    char msg[64];
-    errorToString(error, msg, sizeof(msg));
-    Serial.printf("SEN66: deviceReset() CHYBA: %s\n", msg);
-    sen66Ready = false;
-    return;
-  }
-  
-  delay(1200); // SEN66 potřebuje čas po resetu
-  
-  // Přečíst sériové číslo
-  int8_t serialNumber[32] = {0};
-  error = sen66.getSerialNumber(serialNumber, 32);
-  if (error != NO_ERROR) {
-    char msg[64];
-    errorToString(error, msg, sizeof(msg));
-    Serial.printf("SEN66: getSerialNumber() CHYBA: %s\n", msg);
-  } else {
-    Serial.printf("SEN66: S/N: %s\n", (const char*)serialNumber);
-  }
-  
-  // Spustit měření
-  error = sen66.startContinuousMeasurement();
-  if (error != NO_ERROR) {
-    char msg[64];
-    errorToString(error, msg, sizeof(msg));
-    Serial.printf("SEN66: startContinuousMeasurement() CHYBA: %s\n", msg);
-    sen66Ready = false;
-    return;
-  }
-  
-  sen66Ready = true;
-  Serial.println("SEN66: OK, mereni spusteno!");
-}
 
-void readSEN66() {
-  if (!sen66Ready) return;
-  
-  float pm1, pm25, pm4, pm10, hum, temp, voc, nox;
-  uint16_t co2;
-  
-  int16_t error = sen66.readMeasuredValues(
-    pm1, pm25, pm4, pm10, hum, temp, voc, nox, co2
-  );
-  
-  if (error != NO_ERROR) {
-    char msg[64];
-    errorToString(error, msg, sizeof(msg));
-    Serial.printf("SEN66: readMeasuredValues() CHYBA: %s\n", msg);
-    return;
-  }
-  
-  // Kontrola platnosti (SEN66 vrací NaN/0xFFFF při inicializaci)
-  if (!sensorValuesLookValid(pm1, pm25, pm4, pm10, hum, temp, voc, nox, co2)) {
-    Serial.println("SEN66: namerena neplatna data, preskakuji");
-    return;
+  primarySen66.setTemperatureOffset(appConfig.temperatureOffset);
+  primarySen66.setDutyCycle(appConfig.sen66DutyPeriod);
+  primarySen66.setTrace(&sensorTrace);
+  sensors.add(&primarySen66, I2cBus());
+
+  // Další senzory z konfigurace, např. "sen66@1,scd4x,sht4x" (@N = kanál multiplexeru TCA9548A)
+  const char* list = appConfig.extraSensors.c_str();
+  while (*list) {
+    size_t tokenLength = strcspn(list, ",");
+    FixedString<15> token;
+    for (size_t i = 0; i < tokenLength; i++) {
+      if (!isspace((unsigned char)list[i])) token.append((char)tolower((unsigned char)list[i]));
+    }
+    list += tokenLength;
+    if (*list == ',') list++;
+    if (token.isEmpty()) continue;
+
+    I2cBus bus;
+    const char* at = strchr(token.c_str(), '@');
+    if (at) {
+      bus.muxChannel = (int8_t)constrain(atoi(at + 1), 0, 7);
+      token.assign(token.c_str(), at - token.c_str());
+    }
+
+    SensorDriver* driver = nullptr;
+    if (token == "sen66") {
+      Sen66Driver* sen66 = new Sen66Driver(SENSOR_READ_INTERVAL);
+      sen66->setTemperatureOffset(appConfig.temperatureOffset);
+      sen66->setDutyCycle(appConfig.sen66DutyPeriod);
+      driver = sen66;
+    } else if (token == "scd4x") {
+      driver = new Scd4xDriver();
+    } else if (token == "sht4x") {
+      driver = new Sht4xDriver();
+    } else {
+      LOGW(SENS, "neznamy senzor '%s'", token.c_str());
+      continue;
+    }
+    if (!sensors.add(driver, bus)) {
+      LOGW(SENS, "senzor '%s' nelze pridat (max %u)", token.c_str(), MAX_SENSORS);
+      delete driver;
+    }
   }
-  
-  sensorData.pm1  = pm1;
-  sensorData.pm25 = pm25;
-  sensorData.pm4  = pm4;
-  sensorData.pm10 = pm10;
-  sensorData.temperature = temp + appConfig.temperatureOffset;
-  sensorData.humidity    = hum;
-  sensorData.voc  = voc;
-  sensorData.nox  = nox;
-  sensorData.co2  = co2;
-  sensorData.valid = true;
-  if (firstValidSensorAt == 0) firstValidSensorAt = millis();
-  
-  Serial.printf("SEN66: T(raw)=%.1f T(adj)=%.1f H=%.1f PM2.5=%.1f VOC=%.0f NOx=%.0f CO2=%u\n",
-    temp, sensorData.temperature, hum, pm25, voc, nox, co2);
+
+  sensors.begin();
 }
 
+// =============================================
+//  HISTORIE (LittleFS)
+// =============================================
 
-String formatFloat1(const float value) {
-  char buf[16];
-  snprintf(buf, sizeof(buf), "%.1f", value);
-  return String(buf);
+bool clockValid() {
+  return time(nullptr) > 1600000000;  // SNTP už nastavil čas
 }
 
-String formatFloat0(const float value) {
-  char buf[16];
-  snprintf(buf, sizeof(buf), "%.0f", value);
-  return String(buf);
+void setupHistory() {
+  if (!LittleFS.begin(true)) {
+    LOGE(HIST, "LittleFS nelze pripojit, historie vypnuta");
+    return;
+  }
+  sampleLog.begin(LittleFS, HISTORY_BUDGET_BYTES);
+  sensorTrace.begin(LittleFS);
 }
 
-void replaceAllTokens(String& target, const String& token, const String& value) {
-  target.replace("*" + token + "*", value);
-  target.replace("{" + token + "}", value);
+void appendHistorySample() {
+  if (appConfig.historyInterval == 0 || !clockValid()) return;
+  if (sensorTrace.replaying()) return;  // přehrávaná stopa do historie nepatří
+  SensorSample sample = sensors.snapshot();
+  if (!sample.anyValid()) return;
+  sampleLog.append((uint32_t)time(nullptr), sensors, sample);
 }
 
-String buildTmepQueryParams() {
-  String params = appConfig.tmepParams;
+// Restart s dopsáním rozpracovaného bloku historie
+void restartDevice() {
+  sampleLog.flush();
+  sensorTrace.stop();
+  display.waitIdle();
+  ESP.restart();
+}
 
-  replaceAllTokens(params, "TEMP", formatFloat1(sensorData.temperature));
-  replaceAllTokens(params, "HUM", formatFloat1(sensorData.humidity));
-  replaceAllTokens(params, "PM1", formatFloat1(sensorData.pm1));
-  replaceAllTokens(params, "PM2", formatFloat1(sensorData.pm25));
-  replaceAllTokens(params, "PM4", formatFloat1(sensorData.pm4));
-  replaceAllTokens(params, "PM10", formatFloat1(sensorData.pm10));
-  replaceAllTokens(params, "VOC", formatFloat0(sensorData.voc));
-  replaceAllTokens(params, "NOX", formatFloat0(sensorData.nox));
-  replaceAllTokens(params, "CO2", String(sensorData.co2));
+// Šablona tmepParams s hodnotami vzorku (SamplePayload)
+bool buildTmepRequestUrl(const SensorSample& sample, TmepUrl& url) {
+  return buildTmepUrl(appConfig.tmepDomain.c_str(), appConfig.tmepParams.c_str(), sensors, sample, sampleText, url);
+}
 
-  return params;
+void setTmepStatus(const char* status) {
+  if (lastTmepStatus == status) return;
+  lastTmepStatus.assign(status);
+  statusGeneration++;
 }
 
-String buildTmepRequestUrl() {
-  if (appConfig.tmepDomain.length() == 0 || appConfig.tmepParams.length() == 0 || !sensorData.valid) return "";
-  return "http://" + appConfig.tmepDomain + ".tmep.cz/?" + buildTmepQueryParams();
+void trackStatusGeneration() {
+  WifiModeState wifiState = wifiProvisioning.getState();
+  bool mqttConnected = mqtt.connected();
+  uint32_t idleChannels = sensors.idleChannelMask();
+  if (wifiState != lastWifiState || mqttConnected != lastMqttConnected || idleChannels != lastIdleChannels) {
+    lastWifiState = wifiState;
+    lastMqttConnected = mqttConnected;
+    lastIdleChannels = idleChannels;
+    statusGeneration++;
+  }
 }
 
+// Volá jen loop() se zamčeným appStateLock; po dobu HTTP požadavku zámek pouští
 bool sendTmepRequest(const bool manualTrigger) {
   if (appConfig.tmepDomain.length() == 0 || appConfig.tmepParams.length() == 0) {
-    Serial.println("TMEP: domena nebo parametry nejsou nastaveny, request preskocen");
-    lastTmepStatus = "TMEP:SKIP";
+    LOGD(TMEP, "domena nebo parametry nejsou nastaveny, request preskocen");
+    setTmepStatus("TMEP:SKIP");
     return false;
   }
-  if (!sensorData.valid) {
-    Serial.println("TMEP: nejsou validni data senzoru, request preskocen");
-    lastTmepStatus = "TMEP:SKIP";
+  SensorSample sample = sensors.snapshot();
+  if (!sample.anyValid()) {
+    LOGI(TMEP, "nejsou validni data senzoru, request preskocen");
+    setTmepStatus("TMEP:SKIP");
+    return false;
+  }
+  if (sensorTrace.replaying()) {
+    LOGD(TMEP, "prehrava se stopa senzoru, request preskocen");
+    return false;
+  }
+  if (!manualTrigger && sample.sequence == lastTmepSequence) {
+    LOGD(TMEP, "zadny novy vzorek od posledniho odeslani, request preskocen");
     return false;
   }
   if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("TMEP: WiFi neni pripojena, request preskocen");
-    lastTmepStatus = "TMEP:SKIP";
+    LOGI(TMEP, "WiFi neni pripojena, request preskocen");
+    setTmepStatus("TMEP:SKIP");
     return false;
   }
 
-  String url = buildTmepRequestUrl();
-  if (url.length() == 0) {
-    lastTmepStatus = "TMEP:SKIP";
+  TmepUrl url;
+  if (!buildTmepRequestUrl(sample, url)) {
+    setTmepStatus("TMEP:SKIP");
     return false;
   }
 
+  // HTTP (timeout 5 s) bez zámku stavu, ať web server mezitím odpovídá;
+  // URL i vzorek jsou lokální kopie, stav se mění až po opětovném zamčení
+  xSemaphoreGive(appStateLock);
   HTTPClient http;
   http.setTimeout(5000);
-  if (!http.begin(url)) {
-    Serial.println("TMEP: Nelze inicializovat HTTP request");
-    lastTmepStatus = "TMEP:ERR";
+  bool started = http.begin(url.c_str());
+  int httpCode = started ? http.GET() : 0;
+  // Tělo odpovědi jen pro diagnostiku chyby
+  String response = started && httpCode >= 400 ? http.getString() : String();
+  if (started) http.end();
+  xSemaphoreTake(appStateLock, portMAX_DELAY);
+
+  if (!started) {
+    LOGE(TMEP, "Nelze inicializovat HTTP request");
+    setTmepStatus("TMEP:ERR");
     return false;
   }
-
-  int httpCode = http.GET();
-  String response = http.getString();
-  http.end();
-
   if (httpCode > 0 && httpCode < 400) {
-    Serial.printf("TMEP: %srequest OK, HTTP %d, URL: %s\n", manualTrigger ? "manual " : "", httpCode, url.c_str());
-    lastTmepStatus = "TMEP:OK";
+    LOGI(TMEP, "%srequest OK, HTTP %d, URL: %s", manualTrigger ? "manual " : "", httpCode, url.c_str());
+    setTmepStatus("TMEP:OK");
+    lastTmepSequence = sample.sequence;
+    latency.record(LAT_TMEP, sample.sequence, sampleAgeMs(sample));
     return true;
   }
 
-  Serial.printf("TMEP: %srequest CHYBA, HTTP %d, URL: %s, body: %s\n",
+  LOGE(TMEP, "%srequest CHYBA, HTTP %d, URL: %s, body: %s",
     manualTrigger ? "manual " : "", httpCode, url.c_str(), response.c_str());
-  lastTmepStatus = "TMEP:ERR";
+  setTmepStatus("TMEP:ERR");
   return false;
 }
 
-void handleWebRoot() {
-  const char* html = R"HTML(
-<!doctype html><html lang="cs"><head><meta charset="utf-8"><meta name="viewport" content="width=device-width,initial-scale=1"><title>SEN66 panel</title>
-<style>
-body{font-family:Arial,sans-serif;margin:0;background:#f3f5f7;color:#222}header{background:#0f172a;color:#fff;padding:12px 16px}main{padding:16px;max-width:980px;margin:0 auto}
-.tabs{display:flex;gap:8px;margin-bottom:12px}.tab{padding:10px 14px;border:0;border-radius:8px;background:#dbe2ea;cursor:pointer}.tab.active{background:#2563eb;color:#fff}
-.panel{display:none;background:#fff;padding:16px;border-radius:10px;box-shadow:0 1px 3px rgba(0,0,0,.15)}.panel.active{display:block}
-.grid{display:grid;grid-template-columns:repeat(auto-fit,minmax(170px,1fr));gap:10px}.card{border:1px solid #e5e7eb;border-radius:8px;padding:10px}
-label{display:block;font-size:.9rem;margin-top:8px}input{width:100%;padding:8px;border:1px solid #cbd5e1;border-radius:6px}
-button.save,button.secondary,button.warn{margin-top:12px;padding:10px 14px;color:#fff;border:0;border-radius:8px;cursor:pointer}
-button.save{background:#16a34a}button.secondary{background:#2563eb}button.warn{background:#b91c1c}
-.muted{color:#666;font-size:.85rem}.ok{color:#166534}.err{color:#b91c1c}code.url{display:block;padding:8px;background:#f1f5f9;border-radius:6px;word-break:break-all}
-</style></head><body><header><h2>SEN66 MQTT displej</h2></header><main>
-<div class="tabs"><button class="tab active" data-tab="data">Aktuální data</button><button class="tab" data-tab="cfg">Konfigurace</button></div>
-<section id="data" class="panel active"><div class="grid" id="cards"></div><p class="muted" id="status"></p></section>
-<section id="cfg" class="panel"><form id="cfgForm"><h3>Wi-Fi setup</h3>
-<p class="muted" id="wifiMode"></p><p class="muted" id="wifiConn"></p>
-<label>SSID<input name="wifiSsid" required></label>
-<label>Heslo<input type="password" name="wifiPassword" id="wifiPass"></label>
-<label><input id="showPass" type="checkbox" style="width:auto"> Zobrazit heslo</label>
-<button id="wifiOnlySaveBtn" class="secondary" type="button">Uložit jen Wi-Fi a připojit</button>
-<button id="wifiForgetBtn" class="warn" type="button">Zapomenout Wi-Fi</button><p class="muted" id="wifiMsg"></p>
-<h3>MQTT</h3><label>Server<input name="mqttServer" required></label><label>Port<input type="number" min="1" max="65535" name="mqttPort" required></label><label>Uživatel<input name="mqttUser"></label><label>Heslo<input type="password" name="mqttPassword"></label>
-<h3>TMEP.cz</h3><label>Doména pro zasílání hodnot<input name="tmepDomain" placeholder="xxk4sk-g6rxfh"></label><label>Parametry požadavku<input name="tmepParams" placeholder="tempV=*TEMP*&humV=*HUM*&co2=*CO2*"></label>
-<p class="muted">Použitelné proměnné: *TEMP*, *HUM*, *PM1*, *PM2*, *PM4*, *PM10*, *VOC*, *NOX*, *CO2*.</p><p class="muted">Reálné URL volané na TMEP.cz:</p><code id="tmepUrl" class="url muted">Není dostupné</code>
-<button id="tmepSendBtn" class="secondary" type="button">Odeslat TMEP request ručně</button><p id="tmepMsg" class="muted"></p>
-<h3>Displej</h3><label>Rotace (0-3)<input type="number" min="0" max="3" name="displayRotation" required></label><label>Inverze (0/1)<input type="number" min="0" max="1" name="displayInvertRequested" required></label>
-<h3>Intervaly (ms)</h3><label>Překreslení displeje<input type="number" min="500" name="displayRefreshInterval" required></label><label>MQTT publish<input type="number" min="1000" name="mqttPublishInterval" required></label><label>TMEP request interval<input type="number" min="1000" name="tmepRequestInterval" required></label><label>MQTT warmup delay<input type="number" min="1000" name="mqttWarmupDelay" required></label><label>Temperature offset<input type="number" step="0.1" name="temperatureOffset" required></label><p class="muted">hodnota, kterou přičíst k naměřené teplotě</p>
-<button class="save" type="submit">Uložit plnou konfiguraci</button><p id="cfgMsg" class="muted"></p></form></section></main>
-<script>
-const tabs=document.querySelectorAll('.tab');tabs.forEach(t=>t.onclick=()=>{tabs.forEach(x=>x.classList.remove('active'));document.querySelectorAll('.panel').forEach(p=>p.classList.remove('active'));t.classList.add('active');document.getElementById(t.dataset.tab).classList.add('active')});
-function setMsg(id,text,ok){const m=document.getElementById(id);m.textContent=text;m.className=ok?'ok':'err'}
-async function loadData(){const r=await fetch('/api/data');const d=await r.json();const cards=document.getElementById('cards');cards.innerHTML='';for(const [k,v] of Object.entries(d.values)){const c=document.createElement('div');c.className='card';c.innerHTML=`<strong>${k}</strong><div>${v}</div>`;cards.appendChild(c)}
-document.getElementById('status').textContent=`WiFi: ${d.wifi} | režim: ${d.wifiMode} | TMEP: ${d.tmepStatus} | MQTT: ${d.mqtt} | validní data: ${d.valid} | uptime: ${d.uptime}s`;
-document.getElementById('wifiMode').textContent=`Režim: ${d.wifiMode} ${d.apSsid?('| AP: '+d.apSsid+' @ '+d.apIp):''}`;
-document.getElementById('wifiConn').textContent=`Aktuální SSID: ${d.currentSsid||'-'} | IP: ${d.currentIp||'-'} | RSSI: ${d.rssi||'-'} dBm`;
-const tmepUrlEl=document.getElementById('tmepUrl');tmepUrlEl.textContent=d.tmepUrl||'Není dostupné';tmepUrlEl.className=d.tmepUrl?'url':'url muted'}
-async function loadCfg(){const r=await fetch('/api/config');const c=await r.json();const f=document.getElementById('cfgForm');Object.keys(c).forEach(k=>{if(f[k])f[k].value=c[k]})}
-
-document.getElementById('showPass').onchange=(e)=>{document.getElementById('wifiPass').type=e.target.checked?'text':'password'};
-document.getElementById('cfgForm').onsubmit=async(e)=>{e.preventDefault();const f=e.target;const payload=Object.fromEntries(new FormData(f).entries());const r=await fetch('/api/config',{method:'POST',headers:{'Content-Type':'application/json'},body:JSON.stringify(payload)});setMsg('cfgMsg',await r.text(),r.ok)};
-document.getElementById('wifiOnlySaveBtn').onclick=async()=>{const f=document.getElementById('cfgForm');const payload={wifiSsid:f.wifiSsid.value,wifiPassword:f.wifiPassword.value};const r=await fetch('/api/wifi/save',{method:'POST',headers:{'Content-Type':'application/json'},body:JSON.stringify(payload)});const d=await r.json();setMsg('wifiMsg',d.message||'?',r.ok);await loadData()};
-document.getElementById('wifiForgetBtn').onclick=async()=>{const r=await fetch('/api/wifi/forget',{method:'POST'});const d=await r.json();setMsg('wifiMsg',d.message||'?',r.ok);};
-document.getElementById('tmepSendBtn').onclick=async()=>{const r=await fetch('/api/tmep/send',{method:'POST'});setMsg('tmepMsg',await r.text(),r.ok);await loadData()};
-loadData();loadCfg();setInterval(loadData,2000);
-</script></body></html>)HTML";
-  webServer.send(200, "text/html; charset=utf-8", html);
+// UI z web/ - build krok (scripts/build_web_ui.py) ho minifikuje a gzipuje do flash
+void handleWebAsset(const WebAsset& asset) {
+  webServer.sendHeader("ETag", asset.etag);
+  webServer.sendHeader("Cache-Control", asset.immutable ? "public, max-age=31536000, immutable" : "no-cache");
+  if (webServer.header("If-None-Match") == asset.etag) {
+    webServer.send(304);
+    return;
+  }
+  webServer.sendHeader("Content-Encoding", "gzip");
+  webServer.send_P(200, asset.contentType, (const char*)asset.data, asset.length);
+}
+
+// Hotová odpověď z cache, případně 304 pro podmíněný GET
+void sendCachedResponse(ResponseCache& cache) {
+  webServer.sendHeader("ETag", cache.etag());
+  webServer.sendHeader("Cache-Control", "no-cache");
+  if (cache.matches(webServer.header("If-None-Match"))) {
+    cache.countNotModified();
+    webServer.send(304);
+    return;
+  }
+  webServer.send(200, "application/json", cache.body());
+}
+
+// Serializuje odpověď do cache a pošle ji; tělo větší než cache jde celé mimo ni
+void sendJsonViaCache(ResponseCache& cache, uint64_t version, const JsonDocument& doc, uint32_t startUs) {
+  if (doc.overflowed()) {
+    // Neúplný dokument by dal platný, ale chybějící JSON - raději chyba
+    LOGE(WEB, "JSON pool je plny (%u B), odpoved neodeslana", (unsigned)JsonPool::CAPACITY);
+    webServer.send(500, "text/plain", "JSON pool full");
+    return;
+  }
+  char payload[ResponseCache::MAX_BODY];
+  size_t length = measureJson(doc);
+  if (length < sizeof(payload)) serializeJson(doc, payload, sizeof(payload));
+  if (cache.store(version, payload, length, micros() - startUs)) {
+    sendCachedResponse(cache);
+    return;
+  }
+  LOGW(WEB, "odpoved %u B je vetsi nez cache %u B, posilam bez cache", (unsigned)length,
+       (unsigned)ResponseCache::MAX_BODY);
+  String body;
+  serializeJson(doc, body);
+  webServer.send(200, "application/json", body);
+}
+
+// uptime a RSSI se obnoví s dalším vzorkem (každé ~2 s), dotazy mezi tím jdou z cache
+// Kanály, jejichž hodnota je z minulého okna střídy nebo se ještě neustálila
+void addStaleKeys(JsonDocument& doc, const SensorSample& sample) {
+  uint32_t stale = sensors.staleMask(sample) & sample.validMask;
+  if (!stale) return;
+  JsonArray keys = doc["stale"].to<JsonArray>();
+  for (uint8_t i = 0; i < sensors.channelCount(); i++) {
+    if (stale & (1UL << i)) keys.add(sensors.channel(i).key);
+  }
 }
 
 void handleApiData() {
-  JsonDocument doc;
+  SensorSample sample = sensors.snapshot();
+  if (sample.anyValid()) latency.record(LAT_WEB, sample.sequence, sampleAgeMs(sample));
+  uint64_t version = ((uint64_t)sample.sequence << 32) | statusGeneration;
+  if (dataCache.isFresh(version)) {
+    dataCache.countHit();
+    sendCachedResponse(dataCache);
+    return;
+  }
+
+  uint32_t startUs = micros();
+  JsonDocument doc(&jsonPoolAllocator);
   doc["wifi"] = WiFi.status() == WL_CONNECTED ? "connected" : "disconnected";
   doc["mqtt"] = mqtt.connected() ? "connected" : "disconnected";
-  doc["valid"] = sensorData.valid;
+  doc["valid"] = sample.anyValid();
   doc["uptime"] = millis() / 1000;
-  doc["tmepUrl"] = buildTmepRequestUrl();
-  doc["tmepStatus"] = lastTmepStatus;
+  doc["seq"] = sample.sequence;
+  doc["sampleAgeMs"] = sampleAgeMs(sample);  // v okamžiku sestavení odpovědi (cache)
+  if (sample.unixMs) doc["sampleTs"] = sample.unixMs;
+  TmepUrl tmepUrl;
+  buildTmepRequestUrl(sample, tmepUrl);
+  doc["tmepUrl"] = tmepUrl.c_str();
+  doc["tmepStatus"] = lastTmepStatus.c_str();
   doc["wifiMode"] = wifiProvisioning.getStateText();
   doc["apSsid"] = wifiProvisioning.isCaptiveMode() ? wifiProvisioning.getApSsid() : "";
   doc["apIp"] = wifiProvisioning.isCaptiveMode() ? wifiProvisioning.getApIp() : "";
   doc["currentSsid"] = WiFi.status() == WL_CONNECTED ? WiFi.SSID() : "";
-  doc["currentIp"] = WiFi.status() == WL_CONNECTED ? WiFi.localIP().toString() : "";
+  char currentIp[16] = "";
+  if (WiFi.status() == WL_CONNECTED) formatIp(WiFi.localIP(), currentIp, sizeof(currentIp));
+  doc["currentIp"] = currentIp;
   doc["rssi"] = WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0;
+  doc["wifiConnectMs"] = wifiProvisioning.getLastConnectDurationMs();
+  doc["wifiFastConnect"] = wifiProvisioning.lastConnectWasFast();
 
   JsonObject values = doc["values"].to<JsonObject>();
-  values["temperature"] = round(sensorData.temperature * 10) / 10.0;
-  values["humidity"] = round(sensorData.humidity * 10) / 10.0;
-  values["pm1"] = round(sensorData.pm1 * 10) / 10.0;
-  values["pm25"] = round(sensorData.pm25 * 10) / 10.0;
-  values["pm4"] = round(sensorData.pm4 * 10) / 10.0;
-  values["pm10"] = round(sensorData.pm10 * 10) / 10.0;
-  values["voc"] = round(sensorData.voc);
-  values["nox"] = round(sensorData.nox);
-  values["co2"] = sensorData.co2;
-
-  char payload[1024];
-  serializeJson(doc, payload, sizeof(payload));
-  webServer.send(200, "application/json", payload);
+  for (uint8_t i = 0; i < sensors.channelCount(); i++) {
+    const SensorChannel& ch = sensors.channel(i);
+    values[ch.key] = serialized(sampleText.json(i));
+  }
+  if (airQualityIndex.dominant != AQ_NONE) values["aqi"] = airQualityIndex.overall;
+  if (airQualityIndex.dayValid) values["aqi_24h"] = airQualityIndex.aqiDay;
+  addStaleKeys(doc, sample);
+
+  sendJsonViaCache(dataCache, version, doc, startUs);
 }
 
 void handleApiConfigGet() {
-  JsonDocument doc;
-  doc["wifiSsid"] = appConfig.wifiSsid;
-  doc["wifiPassword"] = appConfig.wifiPassword;
-  doc["mqttServer"] = appConfig.mqttServer;
+  if (configCache.isFresh(statusGeneration)) {
+    configCache.countHit();
+    sendCachedResponse(configCache);
+    return;
+  }
+
+  uint32_t startUs = micros();
+  JsonDocument doc(&jsonPoolAllocator);
+  doc["wifiSsid"] = appConfig.wifiSsid.c_str();
+  doc["wifiPassword"] = appConfig.wifiPassword.c_str();
+  doc["wifiStaticIp"] = appConfig.wifiStaticIp ? 1 : 0;
+  doc["wifiStaticAddress"] = appConfig.wifiStaticAddress.c_str();
+  doc["wifiGateway"] = appConfig.wifiGateway.c_str();
+  doc["wifiSubnet"] = appConfig.wifiSubnet.c_str();
+  doc["wifiDns"] = appConfig.wifiDns.c_str();
+  doc["mqttServer"] = appConfig.mqttServer.c_str();
   doc["mqttPort"] = appConfig.mqttPort;
-  doc["mqttUser"] = appConfig.mqttUser;
-  doc["mqttPassword"] = appConfig.mqttPassword;
-  doc["tmepDomain"] = appConfig.tmepDomain;
-  doc["tmepParams"] = appConfig.tmepParams;
+  doc["mqttUser"] = appConfig.mqttUser.c_str();
+  doc["mqttBaseTopic"] = appConfig.mqttBaseTopic.c_str();
+  doc["mqttDeviceId"] = appConfig.mqttDeviceId.c_str();
+  doc["mqttQos"] = appConfig.mqttQos;
+  doc["mqttPassword"] = appConfig.mqttPassword.c_str();
+  doc["tmepDomain"] = appConfig.tmepDomain.c_str();
+  doc["tmepParams"] = appConfig.tmepParams.c_str();
   doc["displayRotation"] = appConfig.displayRotation;
   doc["displayInvertRequested"] = appConfig.displayInvertRequested ? 1 : 0;
   doc["displayRefreshInterval"] = appConfig.displayRefreshInterval;
   doc["mqttPublishInterval"] = appConfig.mqttPublishInterval;
   doc["tmepRequestInterval"] = appConfig.tmepRequestInterval;
   doc["mqttWarmupDelay"] = appConfig.mqttWarmupDelay;
+  doc["historyInterval"] = appConfig.historyInterval;
   doc["temperatureOffset"] = appConfig.temperatureOffset;
+  doc["extraSensors"] = appConfig.extraSensors.c_str();
+  doc["alarmRules"] = appConfig.alarmRules.c_str();
+  doc["otaUrl"] = appConfig.otaUrl.c_str();
+  doc["powerSaveMode"] = appConfig.powerSaveMode ? 1 : 0;
+  doc["wakeLatencyMs"] = appConfig.wakeLatencyMs;
+  doc["sen66DutyPeriod"] = appConfig.sen66DutyPeriod;
+
+  sendJsonViaCache(configCache, statusGeneration, doc, startUs);
+}
 
-  char payload[1024];
-  serializeJson(doc, payload, sizeof(payload));
-  webServer.send(200, "application/json", payload);
+// Textové pole z JSON (chybějící klíč = beze změny); false = delší než kapacita pole
+template <size_t N>
+bool readJsonString(JsonDocument& doc, const char* key, FixedString<N>& target) {
+  if (!doc[key].is<const char*>()) return true;
+  return target.assign(doc[key].as<const char*>());
 }
 
 void handleApiConfigPost() {
@@ -701,16 +912,29 @@ void handleApiConfigPost() {
   }
 
   AppConfig updated = appConfig;
-  if (doc["wifiSsid"].is<const char*>()) updated.wifiSsid = doc["wifiSsid"].as<String>();
-  if (doc["wifiPassword"].is<const char*>()) updated.wifiPassword = doc["wifiPassword"].as<String>();
-  if (doc["mqttServer"].is<const char*>()) updated.mqttServer = doc["mqttServer"].as<String>();
-  if (doc["mqttUser"].is<const char*>()) updated.mqttUser = doc["mqttUser"].as<String>();
-  if (doc["mqttPassword"].is<const char*>()) updated.mqttPassword = doc["mqttPassword"].as<String>();
-  if (doc["mqttClientId"].is<const char*>()) updated.mqttClientId = doc["mqttClientId"].as<String>();
-  if (doc["tmepDomain"].is<const char*>()) updated.tmepDomain = doc["tmepDomain"].as<String>();
-  if (doc["tmepParams"].is<const char*>()) updated.tmepParams = doc["tmepParams"].as<String>();
+  bool fits = true;
+  fits &= readJsonString(doc, "wifiSsid", updated.wifiSsid);
+  fits &= readJsonString(doc, "wifiPassword", updated.wifiPassword);
+  fits &= readJsonString(doc, "wifiStaticAddress", updated.wifiStaticAddress);
+  fits &= readJsonString(doc, "wifiGateway", updated.wifiGateway);
+  fits &= readJsonString(doc, "wifiSubnet", updated.wifiSubnet);
+  fits &= readJsonString(doc, "wifiDns", updated.wifiDns);
+  fits &= readJsonString(doc, "mqttServer", updated.mqttServer);
+  fits &= readJsonString(doc, "mqttUser", updated.mqttUser);
+  fits &= readJsonString(doc, "mqttPassword", updated.mqttPassword);
+  fits &= readJsonString(doc, "mqttClientId", updated.mqttClientId);
+  fits &= readJsonString(doc, "mqttBaseTopic", updated.mqttBaseTopic);
+  fits &= readJsonString(doc, "mqttDeviceId", updated.mqttDeviceId);
+  fits &= readJsonString(doc, "tmepDomain", updated.tmepDomain);
+  fits &= readJsonString(doc, "tmepParams", updated.tmepParams);
+  fits &= readJsonString(doc, "extraSensors", updated.extraSensors);
+  fits &= readJsonString(doc, "alarmRules", updated.alarmRules);
+  fits &= readJsonString(doc, "otaUrl", updated.otaUrl);
 
   updated.mqttPort = doc["mqttPort"] | updated.mqttPort;
+  updated.mqttQos = (uint8_t)(doc["mqttQos"] | updated.mqttQos);
+  int newStaticIp = doc["wifiStaticIp"] | (updated.wifiStaticIp ? 1 : 0);
+  updated.wifiStaticIp = (newStaticIp == 1);
   updated.displayRotation = (uint8_t)(doc["displayRotation"] | updated.displayRotation);
   int newInvert = doc["displayInvertRequested"] | (updated.displayInvertRequested ? 1 : 0);
   updated.displayInvertRequested = (newInvert == 1);
@@ -718,8 +942,17 @@ void handleApiConfigPost() {
   updated.mqttPublishInterval = doc["mqttPublishInterval"] | updated.mqttPublishInterval;
   updated.tmepRequestInterval = doc["tmepRequestInterval"] | updated.tmepRequestInterval;
   updated.mqttWarmupDelay = doc["mqttWarmupDelay"] | updated.mqttWarmupDelay;
+  updated.historyInterval = doc["historyInterval"] | updated.historyInterval;
   updated.temperatureOffset = doc["temperatureOffset"] | updated.temperatureOffset;
+  int newPowerSave = doc["powerSaveMode"] | (updated.powerSaveMode ? 1 : 0);
+  updated.powerSaveMode = (newPowerSave == 1);
+  updated.wakeLatencyMs = doc["wakeLatencyMs"] | updated.wakeLatencyMs;
+  updated.sen66DutyPeriod = doc["sen66DutyPeriod"] | updated.sen66DutyPeriod;
 
+  if (!fits) {
+    webServer.send(400, "text/plain", "Prilis dlouha textova hodnota konfigurace");
+    return;
+  }
   if (!validateConfig(updated)) {
     webServer.send(400, "text/plain", "Neplatne hodnoty konfigurace");
     return;
@@ -736,7 +969,7 @@ void handleApiConfigPost() {
 
   webServer.send(200, "text/plain", "Konfigurace ulozena, zarizeni se restartuje...");
   delay(300);
-  ESP.restart();
+  restartDevice();
 }
 
 void handleApiWifiSave() {
@@ -747,24 +980,44 @@ void handleApiWifiSave() {
     return;
   }
 
-  String ssid = doc["wifiSsid"].as<String>();
-  String password = doc["wifiPassword"].as<String>();
+  const char* ssid = doc["wifiSsid"] | "";
+  const char* password = doc["wifiPassword"] | "";
 
+  // Test probíhá na pozadí, UI se dotazuje na /api/wifi/status?job=<id>
   String message;
-  bool ok = wifiProvisioning.saveCredentialsAndConnect(ssid, password, message);
+  uint32_t jobId = wifiProvisioning.startCredentialTest(ssid, password, message);
 
   JsonDocument out;
-  out["ok"] = ok;
+  out["ok"] = jobId != 0;
+  out["job"] = jobId;
   out["message"] = message;
   out["wifiMode"] = wifiProvisioning.getStateText();
   String payload;
   serializeJson(out, payload);
-  webServer.send(ok ? 200 : 400, "application/json", payload);
+  webServer.send(jobId != 0 ? 202 : 400, "application/json", payload);
+}
 
-  if (ok) {
-    delay(300);
-    ESP.restart();
+void handleApiWifiStatus() {
+  uint32_t jobId = strtoul(webServer.arg("job").c_str(), nullptr, 10);
+  String message;
+  WifiJobState jobState = wifiProvisioning.getJob(jobId, message);
+
+  JsonDocument out;
+  out["job"] = jobId;
+  switch (jobState) {
+    case WIFI_JOB_RUNNING:   out["state"] = "running"; break;
+    case WIFI_JOB_SUCCEEDED: out["state"] = "ok"; break;
+    case WIFI_JOB_FAILED:    out["state"] = "failed"; break;
+    default:                 out["state"] = "unknown"; break;
   }
+  out["message"] = message;
+  out["wifiMode"] = wifiProvisioning.getStateText();
+  char ip[16] = "";
+  if (WiFi.status() == WL_CONNECTED) formatIp(WiFi.localIP(), ip, sizeof(ip));
+  out["ip"] = ip;
+  String payload;
+  serializeJson(out, payload);
+  webServer.send(jobState == WIFI_JOB_NONE ? 404 : 200, "application/json", payload);
 }
 
 void handleApiWifiForget() {
@@ -779,17 +1032,405 @@ void handleApiWifiForget() {
 
   if (ok) {
     delay(300);
-    ESP.restart();
+    restartDevice();
   }
 }
 
+// Požadavek jen zařadí - HTTP s timeoutem 5 s by v handleru blokoval web server;
+// výsledek se objeví v tmepStatus v /api/data
 void handleApiTmepSend() {
-  bool ok = sendTmepRequest(true);
-  if (ok) {
-    webServer.send(200, "text/plain", "TMEP request byl uspesne odeslan");
+  if (appConfig.tmepDomain.length() == 0 || appConfig.tmepParams.length() == 0) {
+    webServer.send(400, "text/plain", "TMEP domena nebo parametry nejsou nastaveny");
     return;
   }
-  webServer.send(500, "text/plain", "TMEP request se nepodarilo odeslat (zkontrolujte URL, WiFi a data)");
+  tmepSendRequested = true;
+  webServer.send(202, "text/plain", "TMEP request zarazen, vysledek ukaze stav TMEP");
+}
+
+// URL z triggeru, jinak z konfigurace; hash a jeho podpis jsou povinné vždy
+bool startOta(const char* url, const char* sha256, const char* signature, const char*& message) {
+  if (!url || !*url) url = appConfig.otaUrl.c_str();
+  bool ok = otaUpdater.start(url, sha256, signature, message);
+  if (!ok) LOGW(OTA, "odmitnuto: %s", message);
+  return ok;
+}
+
+void handleApiOta() {
+  JsonDocument doc;
+  DeserializationError err = deserializeJson(doc, webServer.arg("plain"));
+  if (err) {
+    webServer.send(400, "application/json", "{\"ok\":false,\"message\":\"Neplatny JSON\"}");
+    return;
+  }
+
+  const char* message = "";
+  bool ok = startOta(doc["url"] | "", doc["sha256"] | "", doc["sig"] | "", message);
+
+  JsonDocument out;
+  out["ok"] = ok;
+  out["message"] = message;
+  char payload[128];
+  serializeJson(out, payload, sizeof(payload));
+  webServer.send(ok ? 202 : 400, "application/json", payload);
+}
+
+// {"action":"record","maxBytes":N} | {"action":"replay","speed":N} | {"action":"stop"}
+void handleApiTracePost() {
+  JsonDocument doc;
+  DeserializationError err = deserializeJson(doc, webServer.arg("plain"));
+  if (err) {
+    webServer.send(400, "application/json", "{\"ok\":false,\"message\":\"Neplatny JSON\"}");
+    return;
+  }
+
+  const char* action = doc["action"] | "";
+  const char* message = "neznama akce";
+  bool ok = false;
+  if (strcmp(action, "record") == 0) {
+    ok = sensorTrace.startRecording(SENSOR_READ_INTERVAL, doc["maxBytes"] | (uint32_t)SensorTrace::DEFAULT_MAX_BYTES,
+                                    clockValid() ? (uint32_t)time(nullptr) : 0, message);
+  } else if (strcmp(action, "replay") == 0) {
+    ok = primarySen66.startReplay(doc["speed"] | 1, message);
+  } else if (strcmp(action, "stop") == 0) {
+    primarySen66.stopTrace();
+    ok = true;
+    message = "zastaveno";
+  }
+
+  JsonDocument out;
+  out["ok"] = ok;
+  out["message"] = message;
+  char payload[128];
+  serializeJson(out, payload, sizeof(payload));
+  webServer.send(ok ? 200 : 400, "application/json", payload);
+}
+
+// Stažení stopy na hostitele (scripts/sensor_trace.py)
+void handleApiTraceGet() {
+  File file = sensorTrace.openForDownload();
+  if (!file) {
+    webServer.send(sensorTrace.recording() ? 409 : 404, "text/plain",
+                   sensorTrace.recording() ? "Zaznam bezi" : "Stopa neexistuje");
+    return;
+  }
+  webServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  webServer.send(200, "application/octet-stream", "");
+  uint8_t chunk[1024];
+  size_t n;
+  while ((n = file.read(chunk, sizeof(chunk))) > 0) {
+    webServer.sendContent((const char*)chunk, n);
+  }
+  file.close();
+  webServer.sendContent("");
+}
+
+// Nahrání stopy po kusech do HttpServer::MAX_BODY; ?offset= navazuje na předchozí kus
+void handleApiTraceUpload() {
+  String body = webServer.arg("plain");
+  uint32_t offset = strtoul(webServer.arg("offset").c_str(), nullptr, 10);
+  const char* message = "";
+  bool ok = body.length() > 0 &&
+            sensorTrace.writeChunk(offset, (const uint8_t*)body.c_str(), body.length(), message);
+  if (body.length() == 0) message = "prazdne telo";
+
+  JsonDocument out;
+  out["ok"] = ok;
+  out["message"] = message;
+  out["size"] = sensorTrace.getStats().fileBytes;
+  char payload[128];
+  serializeJson(out, payload, sizeof(payload));
+  webServer.send(ok ? 200 : 400, "application/json", payload);
+}
+
+void handleApiMetrics() {
+  JsonDocument doc;
+  doc["uptime"] = millis() / 1000;
+  doc["freeHeap"] = ESP.getFreeHeap();
+  doc["maxAllocHeap"] = ESP.getMaxAllocHeap();
+  doc["minFreeHeap"] = ESP.getMinFreeHeap();
+
+  JsonObject mq = doc["mqtt"].to<JsonObject>();
+  mq["connected"] = mqtt.connected();
+  mq["attempts"] = mqttConnectAttempts;
+  mq["failures"] = mqttConnectFailures;
+  mq["backoffMs"] = mqttBackoff.backoffMs();
+  mq["lastOutageMs"] = mqttLastOutageMs;
+  mq["discoveryMessages"] = haDiscoveryMessages;
+  mq["discoveryPending"] = haDiscovery.pending();
+
+  MqttOutboxStats outbox = mqttOutbox.getStats();
+  JsonObject q1 = mq["qos1"].to<JsonObject>();
+  q1["enabled"] = appConfig.mqttQos == 1;
+  q1["accepted"] = outbox.accepted;
+  q1["delivered"] = outbox.delivered;
+  q1["deliveredRate"] = outbox.accepted ? round((float)outbox.delivered / outbox.accepted * 1000) / 1000.0 : 0.0;
+  q1["dropped"] = outbox.dropped;
+  q1["retransmits"] = outbox.retransmits;
+  q1["fastRetransmits"] = outbox.fastRetransmits;
+  q1["inFlight"] = outbox.inFlight;
+  q1["queued"] = outbox.queued;
+  q1["window"] = outbox.window;
+  q1["bytesUsed"] = outbox.bytesUsed;
+  q1["srttMs"] = outbox.srttMs;
+  q1["rtoMs"] = outbox.rtoMs;
+  q1["ackAvgMs"] = outbox.ackAvgMs;
+  q1["ackMaxMs"] = outbox.ackMaxMs;
+
+  PowerStats power = powerManager.getStats();
+  JsonObject pwr = doc["power"].to<JsonObject>();
+  pwr["lowPower"] = power.lowPowerActive;
+  pwr["lightSleep"] = power.lightSleepEnabled;
+  pwr["idleMs"] = power.idleMs;
+  pwr["awakeMs"] = power.awakeMs;
+  pwr["idleRatio"] = (power.idleMs + power.awakeMs) ? (float)power.idleMs / (float)(power.idleMs + power.awakeMs) : 0.0f;
+  pwr["avgCurrentMa"] = round(power.avgCurrentMa * 10) / 10.0;
+  pwr["wakeCount"] = power.wakeCount;
+  pwr["wakeLatencyAvgUs"] = power.wakeLatencyAvgUs;
+  pwr["wakeLatencyMaxUs"] = power.wakeLatencyMaxUs;
+
+  SampleLogStats log = sampleLog.getStats();
+  JsonObject lg = doc["log"].to<JsonObject>();
+  lg["mounted"] = log.mounted;
+  lg["segments"] = log.segments;
+  lg["bytesOnFlash"] = log.bytesOnFlash;
+  lg["samplesWritten"] = log.samplesWritten;
+  lg["compressionRatio"] = log.encodedBytesWritten ? round((float)log.rawBytesWritten / log.encodedBytesWritten * 10) / 10.0 : 0.0;
+  lg["appendAvgUs"] = log.appendAvgUs;
+  lg["appendMaxUs"] = log.appendMaxUs;
+  lg["flushAvgUs"] = log.flushAvgUs;
+  lg["recoveredTornBlocks"] = log.recoveredTornBlocks;
+  lg["lastQuerySamples"] = log.lastQuerySamples;
+  lg["lastQueryUs"] = log.lastQueryUs;
+
+  SampleTextStats st = sampleText.getStats();
+  JsonObject fmt = doc["format"].to<JsonObject>();
+  fmt["samples"] = st.samples;
+  fmt["values"] = st.values;
+  fmt["sampleAvgUs"] = st.formatAvgUs;
+  fmt["sampleMaxUs"] = st.formatMaxUs;
+
+  Sen66DutyStats duty = primarySen66.getDutyStats();
+  JsonObject dc = doc["sen66Duty"].to<JsonObject>();
+  dc["periodMs"] = duty.periodMs;
+  dc["measuring"] = duty.measuring;
+  dc["windows"] = duty.windows;
+  dc["lastWindowMs"] = duty.lastWindowMs;
+  dc["onMs"] = duty.onMs;
+  dc["offMs"] = duty.offMs;
+  dc["onRatio"] = (duty.onMs + duty.offMs) ? round((float)duty.onMs / (duty.onMs + duty.offMs) * 1000) / 1000.0 : 0.0;
+  dc["avgCurrentMa"] = round(duty.avgCurrentMa * 10) / 10.0;
+  dc["savedMwh"] = round(duty.savedMwh * 10) / 10.0;
+  dc["vocStateRestores"] = duty.vocStateRestores;
+  dc["vocStateErrors"] = duty.vocStateErrors;
+
+  SharpDisplayStats ds = display.getStats();
+  JsonObject disp = doc["display"].to<JsonObject>();
+  disp["refreshes"] = ds.refreshes;
+  disp["linesSent"] = ds.linesSent;
+  disp["lastLinesSent"] = ds.lastLinesSent;
+  disp["lastCpuUs"] = ds.lastCpuUs;
+  disp["maxCpuUs"] = ds.maxCpuUs;
+  disp["lastWaitUs"] = ds.lastWaitUs;
+  disp["lastTransferUs"] = ds.lastTransferUs;
+  disp["maxTransferUs"] = ds.maxTransferUs;
+  disp["doubleBuffered"] = ds.doubleBuffered;
+  disp["vcomToggles"] = ds.vcomToggles;
+  disp["elements"] = displayList.size();
+  disp["persistent"] = displayList.persistent();
+  BitmapReceiverStats bs = bitmapReceiver.getStats();
+  JsonObject bmp = disp["bitmap"].to<JsonObject>();
+  bmp["frames"] = bs.frames;
+  bmp["chunks"] = bs.chunks;
+  bmp["errors"] = bs.errors;
+  bmp["bytesReceived"] = bs.bytesReceived;
+  bmp["bytesDecoded"] = bs.bytesDecoded;
+  bmp["lastFrameBytes"] = bs.lastFrameBytes;
+  bmp["lastDecodeUs"] = bs.lastDecodeUs;
+
+  JsonObject http = doc["http"].to<JsonObject>();
+  HttpServerStats hs = webServer.getStats();
+  JsonObject server = http["server"].to<JsonObject>();
+  server["requests"] = hs.requests;
+  server["rejected"] = hs.rejected;
+  server["notFound"] = hs.notFound;
+  server["handlerAvgUs"] = hs.handlerAvgUs;
+  server["handlerMaxUs"] = hs.handlerMaxUs;
+  server["lockWaitMaxUs"] = hs.lockWaitMaxUs;
+  const char* cacheNames[] = {"data", "config"};
+  ResponseCache* caches[] = {&dataCache, &configCache};
+  for (uint8_t i = 0; i < 2; i++) {
+    ResponseCacheStats cs = caches[i]->getStats();
+    JsonObject c = http[cacheNames[i]].to<JsonObject>();
+    c["hits"] = cs.hits;
+    c["misses"] = cs.misses;
+    c["notModified"] = cs.notModified;
+    c["oversized"] = cs.oversized;
+    c["buildAvgUs"] = cs.buildAvgUs;
+  }
+  JsonPoolStats ps = jsonPool.getStats();
+  JsonObject pool = http["jsonPool"].to<JsonObject>();
+  pool["capacity"] = JsonPool::CAPACITY;
+  pool["peakBytes"] = ps.peakBytes;
+  pool["allocations"] = ps.allocations;
+  pool["failures"] = ps.failures;
+
+  AlarmStats as = alarms.getStats();
+  JsonObject al = doc["alarms"].to<JsonObject>();
+  al["rules"] = alarms.ruleCount();
+  al["activeMask"] = alarms.activeMask();
+  al["evaluations"] = as.evaluations;
+  al["transitions"] = as.transitions;
+  al["lastEvalUs"] = as.lastEvalUs;
+  al["maxEvalUs"] = as.maxEvalUs;
+  al["pendingEvents"] = alarms.pendingEvents();
+  al["droppedEvents"] = as.droppedEvents;
+
+  JsonObject lat = doc["latency"].to<JsonObject>();
+  for (uint8_t c = 0; c < LAT_CONSUMER_COUNT; c++) {
+    const LatencyHistogram& h = latency.histogram((LatencyConsumer)c);
+    JsonObject o = lat[LatencyTracker::consumerName((LatencyConsumer)c)].to<JsonObject>();
+    o["deliveries"] = h.deliveries;
+    o["avgMs"] = h.avgMs();
+    o["maxMs"] = h.maxMs;
+    o["lastMs"] = h.lastMs;
+    JsonArray counts = o["histogram"].to<JsonArray>();
+    for (uint8_t b = 0; b < LatencyHistogram::BUCKETS; b++) counts.add(h.counts[b]);
+  }
+
+  AirQualityStats aqs = airQuality.getStats();
+  JsonObject aqm = doc["airQuality"].to<JsonObject>();
+  aqm["samples"] = aqs.samples;
+  aqm["lastUpdateUs"] = aqs.lastUpdateUs;
+  aqm["maxUpdateUs"] = aqs.maxUpdateUs;
+
+  LogStats ls = logger.getStats();
+  JsonObject lgr = doc["logger"].to<JsonObject>();
+  lgr["records"] = ls.records;
+  lgr["dropped"] = ls.dropped;
+  lgr["writeAvgCycles"] = ls.writeAvgCycles;
+  lgr["writeMaxCycles"] = ls.writeMaxCycles;
+  lgr["writeAvgUs"] = round((float)ls.writeAvgCycles / ESP.getCpuFreqMHz() * 100) / 100.0;
+  lgr["drainAvgUs"] = ls.drainAvgUs;
+  lgr["drainMaxUs"] = ls.drainMaxUs;
+
+  OtaStats os = otaUpdater.getStats();
+  JsonObject ota = doc["ota"].to<JsonObject>();
+  ota["state"] = OtaUpdater::stateText(os.state);
+  ota["delta"] = os.delta;
+  ota["pendingVerify"] = os.pendingVerify;
+  ota["received"] = os.received;
+  ota["total"] = os.total;
+  ota["written"] = os.written;
+  ota["copied"] = os.copied;
+  ota["durationMs"] = os.durationMs;
+  ota["attempts"] = os.attempts;
+  ota["failures"] = os.failures;
+  ota["rejectedSignatures"] = os.rejectedSignatures;
+  ota["bufferBytes"] = os.bufferBytes;
+  ota["error"] = os.error.c_str();
+
+  SensorTraceStats ts = sensorTrace.getStats();
+  JsonObject trace = doc["trace"].to<JsonObject>();
+  trace["state"] = ts.state == TRACE_RECORDING ? "recording" : ts.state == TRACE_REPLAYING ? "replaying" : "idle";
+  trace["fileBytes"] = ts.fileBytes;
+  trace["records"] = ts.records;
+  trace["totalRecords"] = ts.totalRecords;
+  trace["errorRecords"] = ts.errorRecords;
+  trace["traceMs"] = ts.traceMs;
+  trace["speed"] = ts.speed;
+  trace["writeFailures"] = ts.writeFailures;
+
+  JsonArray sens = doc["sensors"].to<JsonArray>();
+  for (uint8_t i = 0; i < sensors.sensorCount(); i++) {
+    JsonObject s = sens.add<JsonObject>();
+    s["id"] = sensors.sensorId(i);
+    s["model"] = sensors.sensor(i)->model();
+    s["ready"] = sensors.sensor(i)->isReady();
+    s["samples"] = sensors.sensorSamples(i);
+    s["errors"] = sensors.sensorErrors(i);
+  }
+
+  String payload;
+  serializeJson(doc, payload);
+  webServer.send(200, "application/json", payload);
+}
+
+// Historie z logu: /api/history?from=<unix>&to=<unix>&step=<s>, streamováno po částech
+void handleApiHistory() {
+  uint32_t now = (uint32_t)time(nullptr);
+  uint32_t to = webServer.hasArg("to") ? strtoul(webServer.arg("to").c_str(), nullptr, 10) : now;
+  uint32_t from = webServer.hasArg("from") ? strtoul(webServer.arg("from").c_str(), nullptr, 10)
+                                           : (to > HISTORY_DEFAULT_RANGE_S ? to - HISTORY_DEFAULT_RANGE_S : 0);
+  uint32_t step = webServer.hasArg("step") ? strtoul(webServer.arg("step").c_str(), nullptr, 10) : 0;
+  if (from > to) {
+    webServer.send(400, "text/plain", "Neplatny rozsah");
+    return;
+  }
+
+  webServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  webServer.send(200, "application/json", "");
+
+  char chunk[1024];
+  size_t used = 0;
+  auto emit = [&](const char* text) {
+    size_t len = strlen(text);
+    if (used + len >= sizeof(chunk)) {
+      webServer.sendContent(chunk, used);
+      used = 0;
+    }
+    memcpy(chunk + used, text, len);
+    used += len;
+  };
+
+  // Sloupce podle aktuální sestavy kanálů; vzorky ze segmentu s jinou sestavou mají null.
+  // Řádek jde do chunku po hodnotách, takže jeho délku neomezuje žádný mezibuffer.
+  char text[24];
+  emit("{\"channels\":[");
+  for (uint8_t i = 0; i < sensors.channelCount(); i++) {
+    emit(i ? ",\"" : "\"");
+    emit(sensors.channel(i).key);
+    emit("\"");
+  }
+  emit("],\"samples\":[");
+
+  bool first = true;
+  uint32_t nextTs = from;
+  sampleLog.query(from, to, [&](const LoggedSample& sample) {
+    if (sample.timestamp < nextTs) return true;
+    nextTs = sample.timestamp + step;
+
+    snprintf(text, sizeof(text), "%s[%lu", first ? "" : ",", (unsigned long)sample.timestamp);
+    emit(text);
+    for (uint8_t c = 0; c < sensors.channelCount(); c++) {
+      ChannelKind kind = sensors.channel(c).kind;
+      bool valid = c < sample.channelCount && sample.kinds[c] == kind &&
+                   (sample.validMask & (1UL << (sample.channelCount - 1 - c)));
+      if (valid) {
+        text[0] = ',';
+        formatFixed(sample.values[c], channelKindInfo(kind).decimals, text + 1, sizeof(text) - 1);
+        emit(text);
+      } else {
+        emit(",null");
+      }
+    }
+    emit("]");
+    first = false;
+    return true;
+  });
+  emit("]}");
+
+  webServer.sendContent(chunk, used);
+  webServer.sendContent("");
+}
+
+// Posledních ~4 kB logu jako text (stejné řádky jako na Serial)
+void handleApiLog() {
+  webServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  webServer.send(200, "text/plain", "");
+  logger.readTail([](const char* data, size_t length) {
+    if (length) webServer.sendContent(data, length);
+  });
+  webServer.sendContent("");
 }
 
 void handleCaptiveRedirect() {
@@ -802,19 +1443,30 @@ void handleCaptiveRedirect() {
 }
 
 void setupWebServer() {
-  webServer.on("/", HTTP_GET, handleWebRoot);
+  for (size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+    const WebAsset& asset = WEB_ASSETS[i];
+    webServer.on(asset.path, HTTP_GET, [&asset]() { handleWebAsset(asset); });
+  }
   webServer.on("/api/data", HTTP_GET, handleApiData);
   webServer.on("/api/config", HTTP_GET, handleApiConfigGet);
   webServer.on("/api/config", HTTP_POST, handleApiConfigPost);
   webServer.on("/api/wifi/save", HTTP_POST, handleApiWifiSave);
+  webServer.on("/api/wifi/status", HTTP_GET, handleApiWifiStatus);
   webServer.on("/api/wifi/forget", HTTP_POST, handleApiWifiForget);
   webServer.on("/api/tmep/send", HTTP_POST, handleApiTmepSend);
-
-  webServer.on("/generate_204", HTTP_ANY, handleCaptiveRedirect);
-  webServer.on("/hotspot-detect.html", HTTP_ANY, handleCaptiveRedirect);
-  webServer.on("/connecttest.txt", HTTP_ANY, handleCaptiveRedirect);
-  webServer.on("/ncsi.txt", HTTP_ANY, handleCaptiveRedirect);
-  webServer.on("/redirect", HTTP_ANY, handleCaptiveRedirect);
+  webServer.on("/api/metrics", HTTP_GET, handleApiMetrics);
+  webServer.on("/api/history", HTTP_GET, handleApiHistory);
+  webServer.on("/api/log", HTTP_GET, handleApiLog);
+  webServer.on("/api/ota", HTTP_POST, handleApiOta);
+  webServer.on("/api/trace", HTTP_GET, handleApiTraceGet);
+  webServer.on("/api/trace", HTTP_POST, handleApiTracePost);
+  webServer.on("/api/trace/upload", HTTP_POST, handleApiTraceUpload);
+
+  webServer.onAny("/generate_204", handleCaptiveRedirect);
+  webServer.onAny("/hotspot-detect.html", handleCaptiveRedirect);
+  webServer.onAny("/connecttest.txt", handleCaptiveRedirect);
+  webServer.onAny("/ncsi.txt", handleCaptiveRedirect);
+  webServer.onAny("/redirect", handleCaptiveRedirect);
 
   webServer.onNotFound([]() {
     if (wifiProvisioning.isCaptiveMode()) {
@@ -824,8 +1476,10 @@ void setupWebServer() {
     webServer.send(404, "text/plain", "Not found");
   });
 
-  webServer.begin();
-  Serial.println("WEB: Server bezi na portu 80");
+  webServer.setStateLock(appStateLock);
+  if (webServer.begin()) {
+    LOGI(WEB, "Server bezi na portu 80");
+  }
 }
 
 // =============================================
@@ -833,93 +1487,138 @@ void setupWebServer() {
 // =============================================
 
 void mqttCallback(char* topic, byte* payload, unsigned int length) {
-  String message = "";
-  for (unsigned int i = 0; i < length; i++) {
-    message += (char)payload[i];
+  // Jeden průchod topicem (délka + hash) místo řetězce strcmp
+  int8_t topicId = mqttTopics.match(topic);
+
+  // --- BITMAP: binární data, dekódují se rovnou do bufferu displeje ---
+  if (topicId == MQTT_T_BITMAP) {
+    if (bitmapReceiver.handleChunk(payload, length) == BITMAP_CHUNK_COMPLETE) {
+      uint16_t duration = bitmapReceiver.durationS() ? bitmapReceiver.durationS() : 30;
+      displayOverride = true;
+      displayOverrideBitmap = true;
+      displayOverrideUntil = millis() + duration * 1000UL;
+      display.refresh();  // na panel jdou jen řádky změněné oblasti
+    }
+    return;
+  }
+
+  LOGD(MQTT, "RX [%s]: %u B", topic, length);
+
+  // --- HA restart: discovery znovu, rozložené v čase (jinak celá flotila naráz) ---
+  if (topicId == MQTT_T_HA_STATUS) {
+    if (length == 6 && memcmp(payload, "online", 6) == 0) {
+      haDiscovery.startJittered(millis(), esp_random());
+    }
+    return;
+  }
+
+  // --- OTA: {"url":"http://...","sha256":"...","sig":"..."}, url chybí = z konfigurace ---
+  if (topicId == MQTT_T_OTA) {
+    JsonDocument doc;
+    DeserializationError err = deserializeJson(doc, payload, length);
+    if (err) {
+      LOGW(MQTT, "JSON parse error: %s", err.c_str());
+      return;
+    }
+    const char* message = "";
+    startOta(doc["url"] | "", doc["sha256"] | "", doc["sig"] | "", message);
+    return;
   }
-  
-  Serial.printf("MQTT RX [%s]: %s\n", topic, message.c_str());
   
   // --- TEXT: Zobraz text na displeji ---
-  if (strcmp(topic, TOPIC_TEXT) == 0) {
-    overrideText = message;
+  if (topicId == MQTT_T_TEXT) {
+    overrideText.clear();
+    overrideText.append((const char*)payload, length);
     overrideTextSize = 2;
     overrideX = 10;
     overrideY = 10;
     displayOverride = true;
+    displayOverrideBitmap = false;
     displayOverrideUntil = millis() + 30000; // 30s pak zpět na senzory
     drawCustomTextScreen();
   }
   
   // --- CLEAR: Vyčisti displej / zpět na senzory ---
-  else if (strcmp(topic, TOPIC_CLEAR) == 0) {
+  else if (topicId == MQTT_T_CLEAR) {
     displayOverride = false;
-    display.clearDisplay();
-    display.refresh();
-    Serial.println("Display cleared");
+    displayOverrideBitmap = false;
+    JsonDocument clearCommand;
+    clearCommand["clear_elements"] = true;
+    displayList.apply(clearCommand);  // uložený seznam se smaže taky
+    displayRedrawRequested = true;
+    LOGI(DISP, "Display cleared");
   }
   
   // --- COMMAND: JSON příkazy ---
-  else if (strcmp(topic, TOPIC_COMMAND) == 0) {
+  else if (topicId == MQTT_T_COMMAND) {
     JsonDocument doc;
-    DeserializationError err = deserializeJson(doc, message);
+    DeserializationError err = deserializeJson(doc, payload, length);
     if (err) {
-      Serial.printf("JSON parse error: %s\n", err.c_str());
+      LOGW(MQTT, "JSON parse error: %s", err.c_str());
       return;
     }
     
     // Příkaz: zobraz text s parametry
     // {"text":"Hello","x":10,"y":50,"size":3,"duration":60}
     if (doc.containsKey("text")) {
-      overrideText = doc["text"].as<String>();
+      overrideText.clear();
+      overrideText.append(doc["text"] | "");
       overrideX = doc["x"] | 10;
       overrideY = doc["y"] | 10;
       overrideTextSize = doc["size"] | 2;
       int duration = doc["duration"] | 30; // sekund
       displayOverride = true;
+      displayOverrideBitmap = false;
       displayOverrideUntil = millis() + (duration * 1000UL);
       drawCustomTextScreen();
     }
     
-    // Příkaz: zobraz grafické prvky
+    // Příkaz: seznam prvků (přidat/nahradit podle id, smazat, uložit)
+    // {"elements":[{"id":"t1","type":"value","key":"co2","x":10,"y":200,"size":2,"label":"CO2 ","unit":true}]}
+    // {"remove":["t1"]}, {"clear_elements":true}, {"persist":true}
+    if (displayList.apply(doc)) {
+      displayRedrawRequested = true;
+    }
+
+    // Příkaz: čára (původní formát, přidá se do seznamu prvků)
     // {"line":{"x1":0,"y1":120,"x2":399,"y2":120}}
     if (doc.containsKey("line")) {
       JsonObject line = doc["line"];
-      display.drawLine(
-        line["x1"] | 0, line["y1"] | 0,
-        line["x2"] | 399, line["y2"] | 0, BLACK
-      );
-      display.refresh();
+      JsonDocument element;
+      element["type"] = "line";
+      element["x1"] = line["x1"] | 0;
+      element["y1"] = line["y1"] | 0;
+      element["x2"] = line["x2"] | 399;
+      element["y2"] = line["y2"] | 0;
+      if (displayList.set(element.as<JsonObjectConst>())) displayRedrawRequested = true;
     }
     
-    // Příkaz: obdélník
+    // Příkaz: obdélník (původní formát, přidá se do seznamu prvků)
     // {"rect":{"x":10,"y":10,"w":100,"h":50,"fill":false}}
     if (doc.containsKey("rect")) {
       JsonObject rect = doc["rect"];
-      int x = rect["x"] | 0;
-      int y = rect["y"] | 0;
-      int w = rect["w"] | 50;
-      int h = rect["h"] | 30;
-      bool fill = rect["fill"] | false;
-      if (fill) {
-        display.fillRect(x, y, w, h, BLACK);
-      } else {
-        display.drawRect(x, y, w, h, BLACK);
-      }
-      display.refresh();
+      JsonDocument element;
+      element["type"] = "rect";
+      element["x"] = rect["x"] | 0;
+      element["y"] = rect["y"] | 0;
+      element["w"] = rect["w"] | 50;
+      element["h"] = rect["h"] | 30;
+      element["fill"] = rect["fill"] | false;
+      if (displayList.set(element.as<JsonObjectConst>())) displayRedrawRequested = true;
     }
     
     // Příkaz: inverze displeje
     // {"invert":true}
     if (doc.containsKey("invert")) {
       // Sharp LCD nemá HW inverzi, ale můžeme přepsat barvy
-      Serial.println("Invert command received");
+      LOGW(DISP, "Invert command received");
     }
     
     // Příkaz: přepni zpět na senzorový dashboard
     // {"dashboard":true}
     if (doc.containsKey("dashboard")) {
       displayOverride = false;
+      displayOverrideBitmap = false;
       drawSensorScreen();
     }
     
@@ -933,153 +1632,341 @@ void mqttCallback(char* topic, byte* payload, unsigned int length) {
 //  MQTT - PUBLISH SENSOR DATA
 // =============================================
 
+// JSON zprávy se skládají do jednoho bufferu velikosti bufferu PubSubClient
+// (publikuje jen loop()). Zpráva, která by se nevešla, se nepošle vůbec -
+// useknutý JSON by odběratelé nepřečetli.
+char mqttPayload[MQTT_BUFFER_SIZE];
+
+// Místo pro JSON v mqttPayload vedle topicu a hlavičky PUBLISH (včetně ukončovací nuly)
+size_t mqttPayloadRoom(const char* topic) {
+  size_t overhead = strlen(topic) + MQTT_PUBLISH_OVERHEAD;
+  return overhead < MQTT_BUFFER_SIZE ? MQTT_BUFFER_SIZE - overhead + 1 : 0;
+}
+
+// Délka JSON v mqttPayload; 0 = nevejde se (zalogováno, zprávu přeskočit)
+size_t serializeMqttPayload(const JsonDocument& doc, const char* topic) {
+  size_t length = measureJson(doc);
+  if (length + strlen(topic) + MQTT_PUBLISH_OVERHEAD > MQTT_BUFFER_SIZE) {
+    LOGE(MQTT, "zprava pro %s ma %u B, buffer %u B - preskocena", topic, (unsigned)length, MQTT_BUFFER_SIZE);
+    return 0;
+  }
+  return serializeJson(doc, mqttPayload, sizeof(mqttPayload));
+}
+
+// =============================================
+//  ALARMY
+// =============================================
+
+bool compileAlarms(AlarmEngine& engine) {
+  return engine.compile(appConfig.alarmRules.c_str(), [](const char* key) {
+    for (uint8_t i = 0; i < sensors.channelCount(); i++) {
+      if (strcmp(sensors.channel(i).key, key) == 0) return (int)i;
+    }
+    return -1;
+  });
+}
+
+void setupAlarms() {
+  bool ok = compileAlarms(alarms);
+  LOGI(ALARM, "%u pravidel%s", alarms.ruleCount(), ok ? "" : " (nektera maji neznamy kanal)");
+}
+
+// Začátek přehrávání: alarmy a okna kvality vzduchu stopy začínají od nuly,
+// ať dá stopa stejný výsledek bez ohledu na to, co běželo předtím
+void trackReplayPipeline(const SensorSample& sample) {
+  if (sample.replayed == replayPipeline) return;
+  replayPipeline = sample.replayed;
+  if (!replayPipeline) return;
+  compileAlarms(replayAlarms);
+  replayAirQuality = AirQualityEngine();
+}
+
+// Jednou za nový vzorek; cena je pevná - průchod tabulkou pravidel
+void evaluateAlarms() {
+  if (alarms.ruleCount() == 0) return;
+  if (firstValidSensorAt == 0 || millis() - firstValidSensorAt < appConfig.mqttWarmupDelay) return;
+  SensorSample sample = sensors.snapshot();
+  if (sample.sequence == alarmSequence) return;
+  alarmSequence = sample.sequence;
+
+  uint32_t startUs = micros();
+  AlarmEngine& engine = sample.replayed ? replayAlarms : alarms;
+  uint32_t previousActive = engine.activeMask();
+  uint32_t changed = engine.evaluate(sample.values, sample.validMask, (uint32_t)sample.clockMs);
+  engine.setEvalTime(micros() - startUs);
+  if (!changed) return;
+
+  if (!sample.replayed && (alarms.activeMask() & ~previousActive)) {
+    alarmPageActive = true;
+    alarmPageUntil = millis() + ALARM_PAGE_DURATION;
+    displayRedrawRequested = true;
+  }
+  for (uint8_t i = 0; i < engine.ruleCount(); i++) {
+    if (!(changed & (1UL << i))) continue;
+    const AlarmRule& rule = engine.rule(i);
+    LOGW(ALARM, "%s%s %s (%.1f)", sample.replayed ? "stopa: " : "", rule.key, rule.active ? "ZACATEK" : "KONEC",
+         rule.lastValue);
+  }
+}
+
+// Klouzavá okna kvality vzduchu; jednou za nový vzorek, po zahřátí senzoru
+void updateAirQuality() {
+  if (firstValidSensorAt == 0 || millis() - firstValidSensorAt < appConfig.mqttWarmupDelay) return;
+  SensorSample sample = sensors.snapshot();
+  if (sample.sequence == airQualitySequence) return;
+  airQualitySequence = sample.sequence;
+
+  uint32_t startUs = micros();
+  float pm25 = 0, co2 = 0, voc = 0;
+  bool havePm25 = sensors.primaryValue(sample, CH_PM25, pm25);
+  bool haveCo2 = sensors.primaryValue(sample, CH_CO2, co2);
+  bool haveVoc = sensors.primaryValue(sample, CH_VOC, voc);
+  // Čas pipeline v s (64bit, při přehrávání stopy čas stopy) - millis() po 49 dnech přeteče
+  AirQualityEngine& engine = sample.replayed ? replayAirQuality : airQuality;
+  engine.update((uint32_t)(sample.clockMs / 1000), havePm25 ? &pm25 : nullptr,
+                haveCo2 ? &co2 : nullptr, haveVoc ? &voc : nullptr);
+  airQualityIndex = engine.compute();
+  engine.setUpdateTime(micros() - startUs);
+}
+
+// Přechody čekají ve frontě AlarmEngine, dokud není MQTT připojené - za výpadku
+// sítě se neztratí ani alarm, který mezitím začal i skončil; false = zkusit znovu
+bool publishAlarmQueue(AlarmEngine& engine, MqttTopicId id) {
+  const AlarmEvent* event;
+  while (mqtt.connected() && (event = engine.peekEvent())) {
+    const char* topic = mqttTopics.topic(id);
+    size_t length = buildAlarmJson(engine.rule(event->rule).key, event->active, event->value, event->threshold,
+                                   mqttPayload, mqttPayloadRoom(topic));
+    if (!length) LOGE(MQTT, "prechod alarmu se do bufferu %u B nevejde - preskocen", MQTT_BUFFER_SIZE);
+    if (length && !mqtt.publish(topic, mqttPayload)) return false;
+    engine.popEvent();
+  }
+  return true;
+}
+
+void publishAlarmEvents() {
+  if (publishAlarmQueue(alarms, MQTT_T_ALARM)) publishAlarmQueue(replayAlarms, MQTT_T_REPLAY_ALARM);
+}
+
+// Varování a chyby z logu; bez spojení čekají ve frontě loggeru (přebytek se zahodí)
+void publishLogLines() {
+  char line[128];
+  for (uint8_t i = 0; i < 4 && mqtt.connected() && logger.takeMqttLine(line, sizeof(line)); i++) {
+    mqtt.publish(mqttTopics.topic(MQTT_T_LOG), line);
+  }
+}
+
+// Změna stavu OTA a průběh po 10 %; po úspěchu naplánuje restart do nového firmware
+void publishOtaStatus(unsigned long now) {
+  OtaState state = otaUpdater.state();
+  uint8_t progress = otaUpdater.progressPercent() / 10 * 10;
+  if (state == lastOtaState && (state != OTA_DOWNLOADING || progress == lastOtaProgress)) return;
+  if (state != lastOtaState) statusGeneration++;
+  if (state == OTA_READY && lastOtaState != OTA_READY) otaRestartAt = now + OTA_RESTART_DELAY;
+
+  if (mqtt.connected()) {
+    OtaStats os = otaUpdater.getStats();
+    JsonDocument doc;
+    doc["state"] = OtaUpdater::stateText(state);
+    doc["progress"] = progress;
+    doc["delta"] = os.delta;
+    doc["received"] = os.received;
+    doc["total"] = os.total;
+    if (state == OTA_FAILED) doc["error"] = os.error.c_str();
+    const char* topic = mqttTopics.topic(MQTT_T_OTA_STATUS);
+    if (serializeMqttPayload(doc, topic)) mqtt.publish(topic, mqttPayload);
+  }
+  lastOtaState = state;
+  lastOtaProgress = progress;
+}
+
+// Tabulka topiců: pevné topicy, pak entity HA - kanály senzorů a indexy kvality vzduchu
+void setupMqttTopics() {
+  mqttTopics.begin(appConfig.mqttBaseTopic.c_str(), appConfig.mqttDeviceId.c_str());
+  bool ok = true;
+  for (uint8_t i = 0; ok && i < sensors.channelCount(); i++) {
+    ok = mqttTopics.addEntity(sensors.channel(i).key, sensors.channel(i).uid) >= 0;
+  }
+  mqttChannelEntities = mqttTopics.entityCount();
+  char uid[32];
+  for (uint8_t i = 0; ok && i < AQE_COUNT; i++) {
+    snprintf(uid, sizeof(uid), "sharp_%s", AIR_QUALITY_ENTITIES[i].key);
+    ok = mqttTopics.addEntity(AIR_QUALITY_ENTITIES[i].key, uid) >= 0;
+  }
+  if (!ok) LOGE(MQTT, "tabulka topicu je plna, cast entit chybi");
+  LOGI(MQTT, "topicy %s/..., %u entit (%u B)", appConfig.mqttBaseTopic.c_str(), mqttTopics.entityCount(),
+       (unsigned)mqttTopics.poolUsed());
+}
+
+// Senzorová data: QoS 1 přes outbox (pipelining, opakování po výpadku), jinak přímo QoS 0.
+// Se vzorkem se zapíše LAT_MQTT: u QoS 1 až po PUBACK, u QoS 0 po předání do spojení.
+bool publishSensorMessage(const char* topic, const char* payload, const SensorSample* sample = nullptr) {
+  if (appConfig.mqttQos == 1) {
+    return mqttOutbox.publish(topic, (const uint8_t*)payload, strlen(payload), true, sample ? sample->sequence : 0,
+                              sample ? (uint32_t)sample->timestamp : 0);
+  }
+  if (!mqtt.publish(topic, payload, true)) return false;
+  if (sample) latency.record(LAT_MQTT, sample->sequence, sampleAgeMs(*sample));
+  return true;
+}
+
 void publishSensorData() {
-  if (!mqtt.connected() || !sensorData.valid) return;
+  if (!mqtt.connected()) return;
+  SensorSample sample = sensors.snapshot();
+  if (!sample.anyValid() || sample.sequence == lastPublishedSequence) return;
   if (firstValidSensorAt == 0 || (millis() - firstValidSensorAt) < appConfig.mqttWarmupDelay) {
-    Serial.println("MQTT: warmup delay aktivni, publikace preskocena");
+    LOGD(MQTT, "warmup delay aktivni, publikace preskocena");
     return;
   }
   
-  char buf[16];
-  
-  // Jednotlivé hodnoty
-  snprintf(buf, sizeof(buf), "%.1f", sensorData.temperature);
-  mqtt.publish(TOPIC_TEMP, buf, true);
-  
-  snprintf(buf, sizeof(buf), "%.1f", sensorData.humidity);
-  mqtt.publish(TOPIC_HUMIDITY, buf, true);
-  
-  snprintf(buf, sizeof(buf), "%.1f", sensorData.pm1);
-  mqtt.publish(TOPIC_PM1, buf, true);
-  
-  snprintf(buf, sizeof(buf), "%.1f", sensorData.pm25);
-  mqtt.publish(TOPIC_PM25, buf, true);
-  
-  snprintf(buf, sizeof(buf), "%.1f", sensorData.pm4);
-  mqtt.publish(TOPIC_PM4, buf, true);
-  
-  snprintf(buf, sizeof(buf), "%.1f", sensorData.pm10);
-  mqtt.publish(TOPIC_PM10, buf, true);
-  
-  snprintf(buf, sizeof(buf), "%.0f", sensorData.voc);
-  mqtt.publish(TOPIC_VOC, buf, true);
-  
-  snprintf(buf, sizeof(buf), "%.0f", sensorData.nox);
-  mqtt.publish(TOPIC_NOX, buf, true);
-  
-  snprintf(buf, sizeof(buf), "%u", sensorData.co2);
-  mqtt.publish(TOPIC_CO2, buf, true);
-  
-  // Kompletní JSON
-  JsonDocument doc;
-  doc["temperature"] = round(sensorData.temperature * 10) / 10.0;
-  doc["humidity"]    = round(sensorData.humidity * 10) / 10.0;
-  doc["pm1"]  = round(sensorData.pm1 * 10) / 10.0;
-  doc["pm25"] = round(sensorData.pm25 * 10) / 10.0;
-  doc["pm4"]  = round(sensorData.pm4 * 10) / 10.0;
-  doc["pm10"] = round(sensorData.pm10 * 10) / 10.0;
-  doc["voc"]  = round(sensorData.voc);
-  doc["nox"]  = round(sensorData.nox);
-  doc["co2"]  = sensorData.co2;
-  doc["quality"] = getAirQuality(sensorData.pm25);
-  doc["uptime"]  = millis() / 1000;
-  
-  char jsonBuf[512];
-  serializeJson(doc, jsonBuf, sizeof(jsonBuf));
-  mqtt.publish(TOPIC_SENSOR, jsonBuf, true);
+  // Jednotlivé hodnoty do state topiců HA z předpočítané tabulky, kompletní JSON skládá SamplePayload.
+  // Zastaralé hodnoty (střída SEN66) jdou jen v JSON s označením, state topic zůstane na posledním okně.
+  // Přehrávaná stopa nesmí přepsat retained stavy entit HA - jde jen JSON do <base>/replay/sensor.
+  if (!sample.replayed) {
+    uint32_t stale = sensors.staleMask(sample);
+    for (uint8_t i = 0; i < sensors.channelCount() && i < mqttChannelEntities; i++) {
+      if (sample.isValid(i) && !(stale & (1UL << i))) {
+        publishSensorMessage(mqttTopics.stateTopic(i), sampleText.value(i));
+      }
+    }
+    // Indexy kvality vzduchu (jen platná okna)
+    char buf[16];
+    for (uint8_t id = 0; id < AQE_COUNT; id++) {
+      float value;
+      uint8_t decimals;
+      uint8_t entity = mqttChannelEntities + id;
+      if (entity >= mqttTopics.entityCount()) break;
+      if (!airQualityValue(airQualityIndex, (AirQualityEntityId)id, value, decimals)) continue;
+      formatFixed(value, decimals, buf, sizeof(buf));
+      publishSensorMessage(mqttTopics.stateTopic(entity), buf);
+    }
+  }
+
+  // Vzorek, jehož JSON se nevejde, se zkoušet znovu nemá - vejít se nebude ani příště
+  lastPublishedSequence = sample.sequence;
+  const char* topic = mqttTopics.topic(sample.replayed ? MQTT_T_REPLAY_SENSOR : MQTT_T_SENSOR);
+  if (!buildSensorJson(sensors, sample, sampleText, airQualityIndex, millis() / 1000, sampleAgeMs(sample),
+                       mqttPayload, mqttPayloadRoom(topic))) {
+    LOGE(MQTT, "zprava pro %s se do bufferu %u B nevejde - preskocena", topic, MQTT_BUFFER_SIZE);
+    return;
+  }
+  if (sample.replayed) {
+    mqtt.publish(topic, mqttPayload);  // QoS 0, bez retain
+  } else {
+    publishSensorMessage(topic, mqttPayload, &sample);
+  }
   
-  Serial.println("MQTT: Sensor data published");
-  Serial.printf("MQTT: payload JSON: %s\n", jsonBuf);
+  LOGD(MQTT, "Sensor data published: %s", mqttPayload);
 }
 
 // =============================================
 //  MQTT - HOME ASSISTANT AUTO-DISCOVERY
 // =============================================
 
-void publishHADiscovery() {
-  // Struktura pro jednotlivé senzory
-  struct HASensor {
-    const char* name;
-    const char* uid;
-    const char* topic;
-    const char* unit;
-    const char* devClass;
-    const char* icon;
-  };
-  
-  HASensor sensors[] = {
-    {"Teplota",     "sen66_temp",     TOPIC_TEMP,     "°C",     "temperature",  "mdi:thermometer"},
-    {"Vlhkost",     "sen66_humidity", TOPIC_HUMIDITY,  "%",      "humidity",     "mdi:water-percent"},
-    {"PM1.0",       "sen66_pm1",      TOPIC_PM1,       "µg/m³", "pm1",          "mdi:blur"},
-    {"PM2.5",       "sen66_pm25",     TOPIC_PM25,      "µg/m³", "pm25",         "mdi:blur"},
-    {"PM4.0",       "sen66_pm4",      TOPIC_PM4,       "µg/m³", NULL,           "mdi:blur-radial"},
-    {"PM10",        "sen66_pm10",     TOPIC_PM10,      "µg/m³", "pm10",         "mdi:blur-radial"},
-    {"VOC Index",   "sen66_voc",      TOPIC_VOC,       "",       NULL,           "mdi:air-filter"},
-    {"NOx Index",   "sen66_nox",      TOPIC_NOX,       "",       NULL,           "mdi:molecule"},
-    {"CO2",         "sen66_co2",      TOPIC_CO2,       "ppm",   "carbon_dioxide","mdi:molecule-co2"},
-  };
-  
-  for (auto& s : sensors) {
-    JsonDocument doc;
-    doc["name"] = s.name;
-    doc["unique_id"] = s.uid;
-    doc["state_topic"] = s.topic;
-    doc["unit_of_measurement"] = s.unit;
-    if (s.devClass) doc["device_class"] = s.devClass;
-    if (s.icon) doc["icon"] = s.icon;
-    doc["availability_topic"] = TOPIC_STATUS;
-    doc["payload_available"] = "online";
-    doc["payload_not_available"] = "offline";
-    
-    // Device info
-    JsonObject dev = doc["device"].to<JsonObject>();
-    dev["identifiers"][0] = "sharp_sen66_esp32c3";
+// Topicy i unique_id entity jsou v mqttTopics (s prefixem mqttDeviceId, je-li nastavené)
+bool publishDiscoveryEntity(uint8_t entity, const char* name, const char* unit, const char* devClass,
+                            const char* icon) {
+  JsonDocument doc;
+  doc["name"] = name;
+  doc["unique_id"] = mqttTopics.uniqueId(entity);
+  doc["state_topic"] = mqttTopics.stateTopic(entity);
+  if (unit) doc["unit_of_measurement"] = unit;
+  if (devClass) doc["device_class"] = devClass;
+  if (icon) doc["icon"] = icon;
+  doc["availability_topic"] = mqttTopics.topic(MQTT_T_STATUS);
+  doc["payload_available"] = "online";
+  doc["payload_not_available"] = "offline";
+
+  // Device info
+  JsonObject dev = doc["device"].to<JsonObject>();
+  dev["identifiers"][0] = mqttTopics.deviceIdentifier();
+  if (appConfig.mqttDeviceId.isEmpty()) {
     dev["name"] = "Sharp SEN66 Displej";
-    dev["model"] = "ESP32-C3 + SEN66 + Sharp LCD";
-    dev["manufacturer"] = "DIY";
-    dev["sw_version"] = "2.0.0";
-    
-    char topic[128];
-    snprintf(topic, sizeof(topic), "homeassistant/sensor/%s/config", s.uid);
-    
-    char payload[512];
-    serializeJson(doc, payload, sizeof(payload));
-    mqtt.publish(topic, payload, true);
-    
-    Serial.printf("HA Discovery: %s\n", s.name);
-    delay(50); // malý delay mezi zprávami
+  } else {
+    char deviceName[48];
+    snprintf(deviceName, sizeof(deviceName), "Sharp SEN66 Displej %s", appConfig.mqttDeviceId.c_str());
+    dev["name"] = deviceName;
+  }
+  dev["model"] = "ESP32-C3 + SEN66 + Sharp LCD";
+  dev["manufacturer"] = "DIY";
+  dev["sw_version"] = "2.0.0";
+
+  const char* topic = mqttTopics.discoveryTopic(entity);
+  if (!serializeMqttPayload(doc, topic)) return true;  // nevejde se ani později, pokračovat další entitou
+  if (!mqtt.publish(topic, mqttPayload, true)) return false;
+
+  LOGD(HA, "Discovery: %s", name);
+  return true;
+}
+
+// Jedna entita za průchod loop() s rozestupem - dřív celá dávka s delay()
+// blokovala loop ~1 s a po každém reconnectu zahltila broker. Konfigurace
+// jsou retained, takže stačí jednou od startu a po birth zprávě HA.
+void processHADiscovery(unsigned long now) {
+  if (!mqtt.connected()) return;
+  uint16_t total = mqttTopics.entityCount();
+  int16_t entity = haDiscovery.due(now, total);
+  if (entity < 0) return;
+
+  bool sent;
+  if (entity < mqttChannelEntities) {
+    const SensorChannel& ch = sensors.channel(entity);
+    const ChannelKindInfo& info = channelKindInfo(ch.kind);
+    sent = publishDiscoveryEntity(entity, ch.name, info.unit, info.devClass, info.icon);
+  } else {
+    const AirQualityEntity& aq = AIR_QUALITY_ENTITIES[entity - mqttChannelEntities];
+    sent = publishDiscoveryEntity(entity, aq.name, aq.unit, aq.devClass, aq.icon);
+  }
+  if (sent) haDiscoveryMessages++;
+  if (haDiscovery.sent(now, sent, total)) {
+    haDiscoveryPublished = true;
+    LOGI(HA, "Discovery hotovo (%u entit)", (unsigned)total);
   }
-  
-  Serial.println("HA Discovery: Hotovo!");
 }
 
 // =============================================
 //  MQTT - CONNECT
 // =============================================
 
+// Volá jen loop() se zamčeným appStateLock; po dobu connect() (DNS, TCP,
+// CONNACK - i několik sekund) zámek pouští stejně jako sendTmepRequest
 bool reconnectMQTT() {
-  Serial.print("MQTT: Pripojuji...");
-  
+  LOGI(MQTT, "Pripojuji k %s:%d", appConfig.mqttServer.c_str(), appConfig.mqttPort);
+
+  // Web handler může mezitím uložit konfiguraci a appConfig přepsat:
+  // connect() dostane lokální kopie, ne rozepsané hodnoty
+  auto server = appConfig.mqttServer;
+  auto clientId = appConfig.mqttClientId;
+  auto user = appConfig.mqttUser;
+  auto password = appConfig.mqttPassword;
+  String willTopic = mqttTopics.topic(MQTT_T_STATUS);
+  mqtt.setServer(server.c_str(), appConfig.mqttPort);
+
+  xSemaphoreGive(appStateLock);
   // Last will - offline status
-  if (mqtt.connect(appConfig.mqttClientId.c_str(), appConfig.mqttUser.c_str(), appConfig.mqttPassword.c_str(),
-                    TOPIC_STATUS, 0, true, "offline")) {
-    Serial.println("OK!");
+  bool connected = mqtt.connect(clientId.c_str(), user.c_str(), password.c_str(), willTopic.c_str(), 0, true,
+                                "offline");
+  xSemaphoreTake(appStateLock, portMAX_DELAY);
+  mqtt.setServer(appConfig.mqttServer.c_str(), appConfig.mqttPort);  // ne ukazatel na lokální kopii
+
+  if (connected) {
+    LOGI(MQTT, "Pripojeno");
+    mqttOutbox.onConnected();  // nepotvrzené zprávy z minulého spojení znovu (DUP)
     
     // Status online
-    mqtt.publish(TOPIC_STATUS, "online", true);
+    mqtt.publish(mqttTopics.topic(MQTT_T_STATUS), "online", true);
     
-    // Subscribe
-    mqtt.subscribe(TOPIC_TEXT);
-    mqtt.subscribe(TOPIC_CLEAR);
-    mqtt.subscribe(TOPIC_COMMAND);
-    mqtt.subscribe(TOPIC_BRIGHTNESS);
+    // Subscribe - příchozí topicy jsou v tabulce na začátku
+    for (uint8_t id = 0; id < MQTT_T_SUBSCRIBE_COUNT; id++) {
+      mqtt.subscribe(mqttTopics.topic((MqttTopicId)id));
+    }
     
-    // HA Auto-Discovery
-    publishHADiscovery();
+    // HA Auto-Discovery (po částech v loop)
+    if (!haDiscoveryPublished) haDiscovery.start(millis());
     
     return true;
   } else {
-    Serial.printf("CHYBA rc=%d\n", mqtt.state());
+    LOGW(MQTT, "Pripojeni CHYBA rc=%d", mqtt.state());
     return false;
   }
 }
@@ -1090,48 +1977,69 @@ bool reconnectMQTT() {
 
 void setup() {
   Serial.begin(115200);
-  delay(2000); // ESP32-C3 potřebuje čas na USB Serial
+  // ESP32-C3 potřebuje čas na USB Serial - čekat jen dokud se host nepřipojí
+  unsigned long serialWaitStart = millis();
+  while (!Serial && millis() - serialWaitStart < 2000) {
+    delay(10);
+  }
+  logger.begin();
   
   Serial.println("\n========================================");
   Serial.println("  Sharp LCD + SEN66 + MQTT v2.0.0");
   Serial.println("========================================\n");
   
   bool configLoaded = loadConfig(appConfig);
-  Serial.printf("CFG: load %s\n", configLoaded ? "OK" : "FAILED - defaults");
-  Serial.printf("CFG: MQTT %s:%d, MQTT interval=%lu ms, TMEP interval=%lu ms\n", appConfig.mqttServer.c_str(), appConfig.mqttPort, appConfig.mqttPublishInterval, appConfig.tmepRequestInterval);
-  Serial.printf("CFG: TMEP domena: %s\n", appConfig.tmepDomain.length() ? appConfig.tmepDomain.c_str() : "(nenastaveno)");
-  Serial.printf("CFG: temperature offset=%.2f\n", appConfig.temperatureOffset);
+  LOGI(CFG, "load %s", configLoaded ? "OK" : "FAILED - defaults");
+  LOGI(CFG, "MQTT %s:%d, MQTT interval=%lu ms, TMEP interval=%lu ms", appConfig.mqttServer.c_str(), appConfig.mqttPort, appConfig.mqttPublishInterval, appConfig.tmepRequestInterval);
+  LOGI(CFG, "TMEP domena: %s", appConfig.tmepDomain.length() ? appConfig.tmepDomain.c_str() : "(nenastaveno)");
+  LOGI(CFG, "temperature offset=%.2f", appConfig.temperatureOffset);
+  otaUpdater.begin();
 
   // 1. Displej
-  Serial.println("Display: Inicializace...");
-  display.begin();
+  LOGI(DISP, "Inicializace...");
+  if (!display.begin(DISPLAY_DOUBLE_BUFFER)) {
+    LOGE(DISP, "CHYBA inicializace SPI/DMA");
+  }
   applyDisplaySettings();
   display.clearDisplay();
   display.setTextColor(BLACK);
   drawSplashScreen();
-  Serial.println("Display: OK!");
+  LOGI(DISP, "OK");
   
-  // 2. WiFi provisioning (STA/AP captive)
+  // 2. Úsporný režim (musí předcházet startu Wi-Fi kvůli modem sleep)
+  powerManager.begin(appConfig.powerSaveMode, appConfig.wakeLatencyMs);
+
+  // 3. WiFi provisioning (STA/AP captive) - neblokující, dokončí se v loop()
   wifiProvisioning.begin(&appConfig, 20000UL);
   
-  // 3. MQTT
+  // 4. MQTT
   mqtt.setServer(appConfig.mqttServer.c_str(), appConfig.mqttPort);
   mqtt.setCallback(mqttCallback);
-  mqtt.setBufferSize(1024); // Větší buffer pro HA Discovery JSON
+  mqtt.setBufferSize(MQTT_BUFFER_SIZE);
+  mqtt.setKeepAlive(MQTT_KEEPALIVE_S);
+  mqttTap.onPuback([](uint16_t packetId) { mqttOutbox.onPuback(packetId, millis()); });
+  mqttOutbox.onDelivered([](uint32_t sequence, uint32_t ageMs) { latency.record(LAT_MQTT, sequence, ageMs); });
+  mqttOutbox.begin([](const uint8_t* data, size_t length) {
+    if (mqttTap.write(data, length) == length) return true;
+    mqttTap.stop();  // částečný zápis by rozbil proud paketů; PubSubClient se znovu připojí
+    return false;
+  });
   
-  if (wifiProvisioning.getState() == WIFI_STA_CONNECTED) {
-    reconnectMQTT();
-  }
+  // 5. Senzory
+  setupSensors();
+  setupMqttTopics();
+  setupAlarms();
+
+  // 6. Historie na LittleFS + čas ze SNTP (časové značky vzorků)
+  setupHistory();
+  configTime(0, 0, "pool.ntp.org", "time.google.com");
+  displayList.begin(LittleFS);  // uložené prvky displeje (persist)
 
+  // 7. Web server (vlastní task) - až po inicializaci všeho, co handlery čtou
+  appStateLock = xSemaphoreCreateMutex();
   setupWebServer();
   
-  // 4. SEN66
-  initSEN66();
-  
-  // 5. Splash na 2 sekundy
-  delay(2000);
-  
-  Serial.println("\n=== SETUP HOTOV ===\n");
+  LOGI(MAIN, "=== SETUP HOTOV ===");
 }
 
 // =============================================
@@ -1139,56 +2047,148 @@ void setup() {
 // =============================================
 
 void loop() {
+  // Web handlery běží v tasku serveru; stav měníme jen se zámkem
+  xSemaphoreTake(appStateLock, portMAX_DELAY);
   unsigned long now = millis();
 
   wifiProvisioning.process();
-  webServer.handleClient();
 
-  // --- MQTT reconnect ---
-  if (wifiProvisioning.getState() == WIFI_STA_CONNECTED && !mqtt.connected()) {
-    if (now - lastMqttReconnect > MQTT_RECONNECT_INTERVAL) {
-      lastMqttReconnect = now;
-      reconnectMQTT();
+  // --- MQTT reconnect (backoff s jitterem) ---
+  bool mqttWanted = wifiProvisioning.getState() == WIFI_STA_CONNECTED && !mqtt.connected();
+  if (mqttWanted) {
+    if (mqttDisconnectedAt == 0) {
+      mqttDisconnectedAt = now ? now : 1;
+      mqttBackoff.schedule(now, false, esp_random());
+    }
+    if (mqttBackoff.due(now)) {
+      mqttConnectAttempts++;
+      if (reconnectMQTT()) {
+        mqttLastOutageMs = now - mqttDisconnectedAt;
+        mqttDisconnectedAt = 0;
+        mqttBackoff.reset();
+      } else {
+        mqttConnectFailures++;
+        mqttBackoff.schedule(millis(), true, esp_random());
+      }
     }
   }
 
   // --- MQTT loop ---
   if (mqtt.connected()) {
-    mqtt.loop();
+    // PubSubClient zpracuje jeden příchozí paket za volání; PUBACKy celého okna vybrat najednou
+    for (uint8_t i = 0; i < MqttOutbox::WINDOW && mqtt.loop() && mqttTap.available() > 0; i++) {
+    }
+  }
+  trackStatusGeneration();
+
+  // --- Čtení senzorů (nejvýše jedna I2C transakce za průchod) ---
+  bool windowEnd = false;
+  if (sensors.process(now)) {
+    if (firstValidSensorAt == 0) firstValidSensorAt = now;
+    SensorSample sample = sensors.snapshot();
+    sampleText.update(sensors, sample);
+    trackReplayPipeline(sample);
+    windowEnd = sample.windowEnd;
+  }
+  // Střída SEN66: TMEP jen s koncem okna, kdy jsou ustálené všechny kanály
+  bool tmepOnWindow = appConfig.sen66DutyPeriod > 0 && primarySen66.isReady();
+
+  // --- Zápis do historie ---
+  if (appConfig.historyInterval > 0 && now - lastHistoryAppend >= appConfig.historyInterval) {
+    lastHistoryAppend = now;
+    appendHistorySample();
   }
 
-  // --- Čtení SEN66 ---
-  if (now - lastSensorRead > SENSOR_READ_INTERVAL) {
-    lastSensorRead = now;
-    readSEN66();
+  // --- Alarmy (jednou za nový vzorek) ---
+  evaluateAlarms();
+  updateAirQuality();
+  publishAlarmEvents();
+  publishLogLines();
+  publishOtaStatus(now);
+  processHADiscovery(now);
+  if (alarmPageActive && now > alarmPageUntil) {
+    alarmPageActive = false;
+    displayRedrawRequested = true;
   }
 
-  // --- Publikování do MQTT ---
-  if (now - lastMqttPublish > appConfig.mqttPublishInterval) {
+  // --- Publikování do MQTT (konec okna střídy hned, senzor se pak zastaví) ---
+  if (windowEnd || now - lastMqttPublish > appConfig.mqttPublishInterval) {
     lastMqttPublish = now;
     publishSensorData();
   }
+  mqttOutbox.process(millis(), mqtt.connected());
 
-  // --- Odeslani dat na TMEP ---
-  if (now - lastTmepRequest > appConfig.tmepRequestInterval) {
+  // --- Odeslani dat na TMEP (ruční z webu hned, jinak podle intervalu / okna střídy) ---
+  if (tmepSendRequested) {
+    tmepSendRequested = false;
+    sendTmepRequest(true);
+  } else if (tmepOnWindow ? windowEnd : now - lastTmepRequest > appConfig.tmepRequestInterval) {
     lastTmepRequest = now;
     sendTmepRequest(false);
   }
 
+  // --- OTA: potvrzení nového firmware po zdravém startu, restart po stažení ---
+  otaUpdater.confirmBoot(wifiProvisioning.getState() == WIFI_STA_CONNECTED && firstValidSensorAt != 0, now);
+  if (otaRestartAt && now >= otaRestartAt) {
+    LOGI(OTA, "restart do noveho firmware");
+    restartDevice();
+  }
+
   // --- Override timeout (vrátit se na senzorový dashboard) ---
   if (displayOverride && now > displayOverrideUntil) {
     displayOverride = false;
-    Serial.println("Display: Override expired, zpet na dashboard");
+    displayOverrideBitmap = false;
+    displayRedrawRequested = true;
+    LOGI(DISP, "Override expired, zpet na dashboard");
   }
 
   // --- Refresh displeje ---
-  if (now - lastDisplayRefresh > appConfig.displayRefreshInterval) {
+  // Obsah se překresluje jen při změně (nejvýše jednou za displayRefreshInterval),
+  // VCOM se udržuje samostatně příkazem bez dat. Během příjmu bitmapy po blocích
+  // je v bufferu rozpracovaný snímek.
+  bitmapReceiver.expire(now);
+  if (!displayOverride && hasSecondaryChannels() && now - lastDisplayPageSwitch > DISPLAY_PAGE_INTERVAL) {
+    lastDisplayPageSwitch = now;
+    displayPage ^= 1;
+  }
+  bool redrawAllowed = !bitmapReceiver.receiving() && !displayOverrideBitmap;
+  uint32_t displayStamp = displayContentStamp();
+  bool contentChanged = displayStamp != lastDisplayStamp &&
+                        now - lastDisplayRefresh >= appConfig.displayRefreshInterval;
+  if (redrawAllowed && (displayRedrawRequested || contentChanged)) {
+    displayRedrawRequested = false;
     lastDisplayRefresh = now;
-    if (!displayOverride) {
+    lastDisplayStamp = displayStamp;
+    if (displayOverride) {
+      drawCustomTextScreen();
+    } else if (alarmPageActive) {
+      drawAlarmScreen();
+    } else if (displayPage == 1 && hasSecondaryChannels()) {
+      drawChannelListScreen();
+    } else {
       drawSensorScreen();
     }
   }
-
-  delay(10);
+  display.maintainVcom(now);
+
+  // --- Spánek do nejbližšího termínu ---
+  powerManager.addDeadline(sensors.nextDeadline());
+  powerManager.addDeadline(lastMqttPublish + appConfig.mqttPublishInterval + 1);
+  if (!tmepOnWindow) powerManager.addDeadline(lastTmepRequest + appConfig.tmepRequestInterval + 1);
+  if (appConfig.historyInterval > 0) powerManager.addDeadline(lastHistoryAppend + appConfig.historyInterval);
+  powerManager.addDeadline(display.nextVcomDue());
+  if (redrawAllowed && displayStamp != lastDisplayStamp) powerManager.addDeadline(lastDisplayRefresh + appConfig.displayRefreshInterval);
+  if (!displayOverride) powerManager.addDeadline((now / 60000 + 1) * 60000);  // uptime ve stavovém řádku
+  if (!displayOverride && hasSecondaryChannels()) powerManager.addDeadline(lastDisplayPageSwitch + DISPLAY_PAGE_INTERVAL + 1);
+  if (displayOverride) powerManager.addDeadline(displayOverrideUntil + 1);
+  if (alarmPageActive) powerManager.addDeadline(alarmPageUntil + 1);
+  if (mqtt.connected()) powerManager.addDeadline(now + MQTT_KEEPALIVE_S * 500UL);
+  if (mqtt.connected() && !mqttOutbox.idle()) powerManager.addDeadline(now + MQTT_PUBACK_POLL_MS);
+  if (mqttWanted) powerManager.addDeadline(mqttBackoff.nextAttemptAt());
+  if (haDiscovery.pending()) powerManager.addDeadline(haDiscovery.nextAt());
+  if (otaUpdater.busy()) powerManager.addDeadline(now + 1000);  // průběh na displej a do MQTT
+  if (otaRestartAt) powerManager.addDeadline(otaRestartAt);
+  xSemaphoreGive(appStateLock);
+  powerManager.idle();
 }
 
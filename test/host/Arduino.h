@@ -0,0 +1,212 @@
+#pragma once
+
+// Náhrada Arduino core pro testy na hostiteli (pio test -e native). Jen to,
+// co používají moduly z build_src_filter; čas je simulovaný a posouvá ho test.
+
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+
+#define PROGMEM
+#define IRAM_ATTR
+#define F(x) x
+
+namespace host {
+// Simulovaný čas od "bootu" v µs; delay() ho posouvá, vlákna jen ustoupí
+inline std::atomic<uint64_t> clockUs{0};
+inline void advanceMs(uint32_t ms) { clockUs += (uint64_t)ms * 1000; }
+inline void advanceUs(uint32_t us) { clockUs += us; }
+inline void resetClock() { clockUs = 0; }
+
+// Nástroje v tools/ běží ve skutečném čase: millis()/micros() pak měří
+// steady_clock od zapnutí a delay() opravdu čeká
+inline std::atomic<bool> realClock{false};
+inline std::chrono::steady_clock::time_point realClockStart;
+inline void useRealClock() {
+  realClockStart = std::chrono::steady_clock::now();
+  realClock = true;
+}
+inline uint64_t nowUs() {
+  if (!realClock) return clockUs;
+  return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                                         realClockStart)
+      .count();
+}
+
+inline uint32_t randomState = 0x12345678;
+inline void seedRandom(uint32_t seed) { randomState = seed ? seed : 1; }
+}  // namespace host
+
+// Jako na ESP32: 32bitový čas, přetéká po 49 dnech
+inline unsigned long millis() { return (uint32_t)(host::nowUs() / 1000); }
+inline unsigned long micros() { return (uint32_t)host::nowUs(); }
+inline void delay(unsigned long ms) {
+  if (host::realClock) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    return;
+  }
+  host::advanceMs(ms);
+  std::this_thread::yield();
+}
+inline void delayMicroseconds(uint32_t us) { host::advanceUs(us); }
+inline void yield() { std::this_thread::yield(); }
+
+// xorshift32 - deterministický pro daný seed
+inline uint32_t esp_random() {
+  uint32_t x = host::randomState;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return host::randomState = x;
+}
+inline long random(long howbig) { return howbig > 0 ? (long)(esp_random() % (uint32_t)howbig) : 0; }
+inline long random(long howsmall, long howbig) {
+  return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+template <typename T, typename L, typename H>
+T constrain(T value, L low, H high) {
+  return value < low ? low : (value > high ? high : value);
+}
+
+class String {
+ public:
+  String() {}
+  String(const char* s) : s_(s ? s : "") {}
+  String(const std::string& s) : s_(s) {}
+  explicit String(int v) : s_(std::to_string(v)) {}
+  explicit String(unsigned v) : s_(std::to_string(v)) {}
+  explicit String(long v) : s_(std::to_string(v)) {}
+  explicit String(unsigned long v) : s_(std::to_string(v)) {}
+
+  const char* c_str() const { return s_.c_str(); }
+  unsigned length() const { return s_.size(); }
+  bool isEmpty() const { return s_.empty(); }
+  bool reserve(unsigned size) {
+    s_.reserve(size);
+    return true;
+  }
+  bool concat(const char* s, unsigned length) {
+    s_.append(s, length);
+    return true;
+  }
+  int indexOf(char c) const {
+    size_t i = s_.find(c);
+    return i == std::string::npos ? -1 : (int)i;
+  }
+  String substring(unsigned from, unsigned to) const { return from < to ? String(s_.substr(from, to - from)) : String(); }
+  String& operator=(const char* s) {
+    s_ = s ? s : "";
+    return *this;
+  }
+  String& operator+=(const String& o) {
+    s_ += o.s_;
+    return *this;
+  }
+  String& operator+=(const char* o) {
+    s_ += o;
+    return *this;
+  }
+  friend String operator+(const String& a, const String& b) { return String(a.s_ + b.s_); }
+  bool operator==(const String& o) const { return s_ == o.s_; }
+  bool operator==(const char* o) const { return s_ == o; }
+  bool operator!=(const char* o) const { return s_ != o; }
+
+ private:
+  std::string s_;
+};
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t) = 0;
+  virtual size_t write(const uint8_t* buf, size_t size) {
+    size_t n = 0;
+    while (n < size && write(buf[n])) n++;
+    return n;
+  }
+  size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t print(const char* s) { return write(s); }
+};
+
+class Stream : public Print {
+ public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  virtual void flush() {}
+};
+
+// Výstup na stdout jen s HOST_SERIAL=1 (ladění testu)
+class HostSerial : public Stream {
+ public:
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* buf, size_t size) override {
+    if (getenv("HOST_SERIAL")) fwrite(buf, 1, size, stdout);
+    return size;
+  }
+  using Print::write;
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  void begin(unsigned long) {}
+  operator bool() const { return true; }
+};
+inline HostSerial Serial;
+
+class IPAddress {
+ public:
+  IPAddress() {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : bytes_{a, b, c, d} {}
+  IPAddress(uint32_t address) { memcpy(bytes_, &address, 4); }
+  operator uint32_t() const {
+    uint32_t address;
+    memcpy(&address, bytes_, 4);
+    return address;
+  }
+  uint8_t operator[](int i) const { return bytes_[i]; }
+  bool operator==(const IPAddress& o) const { return memcmp(bytes_, o.bytes_, 4) == 0; }
+  bool fromString(const char* s) {
+    unsigned a, b, c, d;
+    char tail;
+    if (!s || sscanf(s, "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) != 4 || a > 255 || b > 255 || c > 255 || d > 255) {
+      return false;
+    }
+    *this = IPAddress(a, b, c, d);
+    return true;
+  }
+  String toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", bytes_[0], bytes_[1], bytes_[2], bytes_[3]);
+    return String(buf);
+  }
+
+ private:
+  uint8_t bytes_[4] = {0, 0, 0, 0};
+};
+
+class EspClass {
+ public:
+  // 160 MHz jako ESP32-C3, odvozené ze simulovaného času
+  uint32_t getCycleCount() { return (uint32_t)(host::clockUs * 160); }
+  uint32_t getFreeHeap() { return 200000; }
+  uint32_t getMaxAllocHeap() { return 100000; }
+  uint32_t getMinFreeHeap() { return 150000; }
+  void restart() {}
+};
+inline EspClass ESP;
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <Arduino.h>
+
+enum class DNSReplyCode { NoError = 0, ServerFailure = 2, NonExistentDomain = 3 };
+
+class DNSServer {
+ public:
+  void setErrorReplyCode(DNSReplyCode) {}
+  bool start(uint16_t, const char*, const IPAddress&) {
+    running_ = true;
+    return true;
+  }
+  void stop() { running_ = false; }
+  void processNextRequest() {}
+  bool running() const { return running_; }
+
+ private:
+  bool running_ = false;
+};
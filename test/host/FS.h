@@ -0,0 +1,124 @@
+#pragma once
+
+// Souborový systém na hostiteli: cesty firmwaru ("/trace.bin") se mapují do
+// adresáře zadaného v konstruktoru FS. File se kopíruje jako v Arduino core
+// (sdílí otevřený soubor); otevřený adresář vrací položky přes openNextFile().
+
+#include <Arduino.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File : public Stream {
+ public:
+  File() {}
+  File(FILE* f, const std::string& name) : f_(f, [](FILE* p) { fclose(p); }), name_(name) {}
+  // Adresář: hostPath je skutečná cesta, name cesta z pohledu firmwaru
+  static File directory(const std::string& hostPath, const std::string& name) {
+    File dir;
+    dir.name_ = name;
+    dir.hostPath_ = hostPath;
+    dir.entries_ = std::make_shared<std::vector<std::string>>();
+    if (DIR* d = opendir(hostPath.c_str())) {
+      while (dirent* e = readdir(d)) {
+        if (e->d_name[0] != '.') dir.entries_->push_back(e->d_name);
+      }
+      closedir(d);
+    }
+    return dir;
+  }
+
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* buf, size_t size) override { return f_ ? fwrite(buf, 1, size, f_.get()) : 0; }
+  using Print::write;
+  size_t read(uint8_t* buf, size_t size) { return f_ ? fread(buf, 1, size, f_.get()) : 0; }
+  int read() override {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+  }
+  int peek() override {
+    int b = read();
+    if (b >= 0) fseek(f_.get(), -1, SEEK_CUR);
+    return b;
+  }
+  int available() override { return f_ ? (int)(size() - position()) : 0; }
+  bool seek(uint32_t pos, SeekMode mode = SeekSet) {
+    return f_ && fseek(f_.get(), pos, mode == SeekSet ? SEEK_SET : (mode == SeekCur ? SEEK_CUR : SEEK_END)) == 0;
+  }
+  size_t position() const { return f_ ? (size_t)ftell(f_.get()) : 0; }
+  size_t size() const {
+    if (!f_) return 0;
+    long pos = ftell(f_.get());
+    fseek(f_.get(), 0, SEEK_END);
+    long end = ftell(f_.get());
+    fseek(f_.get(), pos, SEEK_SET);
+    return (size_t)end;
+  }
+  void flush() override {
+    if (f_) fflush(f_.get());
+  }
+  void close() {
+    f_.reset();
+    entries_.reset();
+  }
+  operator bool() const { return f_ || entries_; }
+  const char* name() const { return name_.c_str(); }
+  bool isDirectory() const { return (bool)entries_; }
+  File openNextFile() {
+    if (!entries_ || nextEntry_ >= entries_->size()) return File();
+    const std::string& entry = (*entries_)[nextEntry_++];
+    FILE* f = fopen((hostPath_ + "/" + entry).c_str(), "rb");
+    return f ? File(f, name_ + "/" + entry) : File();
+  }
+
+ private:
+  std::shared_ptr<FILE> f_;
+  std::string name_;
+  std::string hostPath_;
+  std::shared_ptr<std::vector<std::string>> entries_;
+  size_t nextEntry_ = 0;
+};
+
+class FS {
+ public:
+  explicit FS(const std::string& root) : root_(root) {}
+
+  File open(const char* path, const char* mode = FILE_READ, bool = false) {
+    struct stat st;
+    if (strcmp(mode, FILE_READ) == 0 && stat((root_ + path).c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+      return File::directory(root_ + path, path);
+    }
+    std::string m = std::string(mode) + "b";
+    FILE* f = fopen((root_ + path).c_str(), m.c_str());
+    return f ? File(f, path) : File();
+  }
+  bool exists(const char* path) {
+    struct stat st;
+    return stat((root_ + path).c_str(), &st) == 0;
+  }
+  bool mkdir(const char* path) { return ::mkdir((root_ + path).c_str(), 0755) == 0; }
+  bool remove(const char* path) { return ::remove((root_ + path).c_str()) == 0; }
+  bool rename(const char* from, const char* to) { return ::rename((root_ + from).c_str(), (root_ + to).c_str()) == 0; }
+
+ private:
+  std::string root_;
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
+using fs::SeekCur;
+using fs::SeekEnd;
+using fs::SeekSet;
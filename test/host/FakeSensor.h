@@ -0,0 +1,39 @@
+#pragma once
+
+// Ovladač senzoru pro testy: pevná sestava kanálů, poll() vrací hodnoty,
+// které test nastaví ve values (bez I2C).
+
+#include <SensorDriver.h>
+
+#include <vector>
+
+class FakeSensor : public SensorDriver {
+ public:
+  FakeSensor(const char* model, std::vector<ChannelKind> kinds, unsigned long intervalMs = 2000)
+      : model_(model), kinds_(kinds), intervalMs_(intervalMs), values(kinds.size(), 0.0f) {}
+
+  const char* model() const override { return model_; }
+  bool begin() override {
+    ready_ = true;
+    return true;
+  }
+  uint8_t channelCount() const override { return (uint8_t)kinds_.size(); }
+  ChannelKind channelKind(uint8_t index) const override { return kinds_[index]; }
+  unsigned long sampleIntervalMs() const override { return intervalMs_; }
+  SensorPollResult poll(float* out) override {
+    polls++;
+    if (fail) return SENSOR_POLL_ERROR;
+    for (size_t i = 0; i < values.size(); i++) out[i] = values[i];
+    return SENSOR_POLL_SAMPLE;
+  }
+
+ private:
+  const char* model_;
+  std::vector<ChannelKind> kinds_;
+  unsigned long intervalMs_;
+
+ public:
+  std::vector<float> values;
+  bool fail = false;
+  uint32_t polls = 0;
+};
@@ -0,0 +1,94 @@
+#pragma once
+
+// NVS v paměti: hodnoty sdílí všechny instance (jako flash), test je maže přes
+// Preferences::wipeAll(). Každá hodnota se ukládá jako bajty.
+
+#include <Arduino.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+class Preferences {
+ public:
+  bool begin(const char* name, bool readOnly = false) {
+    ns_ = name;
+    readOnly_ = readOnly;
+    open_ = true;
+    return true;
+  }
+  void end() { open_ = false; }
+
+  static void wipeAll() { store().clear(); }
+  static size_t writes() { return writeCount(); }
+
+  size_t putBytes(const char* key, const void* value, size_t length) {
+    if (!open_ || readOnly_) return 0;
+    const uint8_t* bytes = (const uint8_t*)value;
+    store()[ns_][key].assign(bytes, bytes + length);
+    writeCount()++;
+    return length;
+  }
+  size_t getBytesLength(const char* key) {
+    const std::vector<uint8_t>* v = find(key);
+    return v ? v->size() : 0;
+  }
+  size_t getBytes(const char* key, void* buf, size_t maxLength) {
+    const std::vector<uint8_t>* v = find(key);
+    if (!v || v->size() > maxLength) return 0;
+    memcpy(buf, v->data(), v->size());
+    return v->size();
+  }
+  bool remove(const char* key) {
+    if (!open_ || readOnly_) return false;
+    return store()[ns_].erase(key) > 0;
+  }
+  bool isKey(const char* key) { return find(key) != nullptr; }
+
+  size_t putString(const char* key, const char* value) { return putBytes(key, value, strlen(value) + 1); }
+  // Jako NVS: délka včetně nuly, 0 = klíč chybí nebo se nevejde
+  size_t getString(const char* key, char* value, size_t maxLength) { return getBytes(key, value, maxLength); }
+
+  size_t putBool(const char* key, bool value) { return putValue(key, (uint8_t)value); }
+  size_t putUChar(const char* key, uint8_t value) { return putValue(key, value); }
+  size_t putInt(const char* key, int32_t value) { return putValue(key, value); }
+  size_t putULong(const char* key, uint32_t value) { return putValue(key, value); }
+  size_t putFloat(const char* key, float value) { return putValue(key, value); }
+  bool getBool(const char* key, bool fallback = false) { return getValue(key, (uint8_t)fallback) != 0; }
+  uint8_t getUChar(const char* key, uint8_t fallback = 0) { return getValue(key, fallback); }
+  int32_t getInt(const char* key, int32_t fallback = 0) { return getValue(key, fallback); }
+  uint32_t getULong(const char* key, uint32_t fallback = 0) { return getValue(key, fallback); }
+  float getFloat(const char* key, float fallback = 0) { return getValue(key, fallback); }
+
+ private:
+  typedef std::map<std::string, std::map<std::string, std::vector<uint8_t>>> Store;
+  static Store& store() {
+    static Store s;
+    return s;
+  }
+  static size_t& writeCount() {
+    static size_t n = 0;
+    return n;
+  }
+
+  const std::vector<uint8_t>* find(const char* key) {
+    if (!open_) return nullptr;
+    auto ns = store().find(ns_);
+    if (ns == store().end()) return nullptr;
+    auto it = ns->second.find(key);
+    return it == ns->second.end() ? nullptr : &it->second;
+  }
+  template <typename T>
+  size_t putValue(const char* key, T value) {
+    return putBytes(key, &value, sizeof(value));
+  }
+  template <typename T>
+  T getValue(const char* key, T fallback) {
+    T value;
+    return getBytes(key, &value, sizeof(value)) == sizeof(value) ? value : fallback;
+  }
+
+  std::string ns_;
+  bool readOnly_ = false;
+  bool open_ = false;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+// SEN66 na hostiteli: readMeasuredValues() vrací SensirionI2cSen66::next,
+// který nastavuje test (sdílený všemi instancemi). Stav VOC algoritmu se
+// čte a zapisuje přes Wire (příkaz 0x6181) jako v knihovně, takže test vidí
+// jeho pořadí vůči start/stop příkazům posílaným driverem přímo.
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define SEN66_I2C_ADDR_6B 0x6B
+#define NO_ERROR 0
+
+inline void errorToString(int16_t error, char* msg, size_t size) { snprintf(msg, size, "chyba %d", error); }
+
+class SensirionI2cSen66 {
+ public:
+  struct Reading {
+    int16_t error = 0;
+    float pm1 = 3.0f, pm25 = 5.0f, pm4 = 6.0f, pm10 = 7.0f;
+    float hum = 45.0f, temp = 22.5f, voc = 100.0f, nox = 1.0f;
+    uint16_t co2 = 600;
+  };
+  static Reading next;
+  static inline unsigned reads = 0;
+  static inline uint8_t vocState[8] = {0};
+  static inline int16_t vocStateError = NO_ERROR;
+
+  void begin(TwoWire&, uint8_t) {}
+  int16_t deviceReset() { return NO_ERROR; }
+  int16_t getSerialNumber(int8_t* serial, uint16_t size) {
+    snprintf((char*)serial, size, "HOST0001");
+    return NO_ERROR;
+  }
+  int16_t startContinuousMeasurement() { return NO_ERROR; }
+  int16_t stopMeasurement() { return NO_ERROR; }
+  int16_t readMeasuredValues(float& pm1, float& pm25, float& pm4, float& pm10, float& hum, float& temp,
+                             float& voc, float& nox, uint16_t& co2) {
+    reads++;
+    pm1 = next.pm1;
+    pm25 = next.pm25;
+    pm4 = next.pm4;
+    pm10 = next.pm10;
+    hum = next.hum;
+    temp = next.temp;
+    voc = next.voc;
+    nox = next.nox;
+    co2 = next.co2;
+    return next.error;
+  }
+  int16_t getVocAlgorithmState(uint8_t state[], uint16_t stateSize) {
+    vocStateCommand(nullptr, 0);
+    if (vocStateError != NO_ERROR) return vocStateError;
+    memcpy(state, vocState, stateSize < sizeof(vocState) ? stateSize : sizeof(vocState));
+    return NO_ERROR;
+  }
+  int16_t setVocAlgorithmState(const uint8_t state[], uint16_t stateSize) {
+    uint16_t n = stateSize < sizeof(vocState) ? stateSize : sizeof(vocState);
+    vocStateCommand(state, n);
+    if (vocStateError != NO_ERROR) return vocStateError;
+    memcpy(vocState, state, n);
+    return NO_ERROR;
+  }
+
+ private:
+  static void vocStateCommand(const uint8_t* data, uint16_t length) {
+    Wire.beginTransmission(SEN66_I2C_ADDR_6B);
+    Wire.write(0x61);
+    Wire.write(0x81);
+    for (uint16_t i = 0; i < length; i++) Wire.write(data[i]);
+    Wire.endTransmission();
+  }
+};
+
+inline SensirionI2cSen66::Reading SensirionI2cSen66::next;
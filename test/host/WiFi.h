@@ -0,0 +1,176 @@
+#pragma once
+
+// Wi-Fi driver na hostiteli: zaznamenává volání a události posílá test
+// (connectTo/drop/emit) stejnou cestou jako event task ESP32 přes onEvent().
+
+#include <Arduino.h>
+
+#include <functional>
+#include <vector>
+
+typedef enum {
+  WL_IDLE_STATUS = 0,
+  WL_NO_SSID_AVAIL,
+  WL_SCAN_COMPLETED,
+  WL_CONNECTED,
+  WL_CONNECT_FAILED,
+  WL_CONNECTION_LOST,
+  WL_DISCONNECTED,
+} wl_status_t;
+
+typedef enum { WIFI_OFF = 0, WIFI_STA, WIFI_AP, WIFI_AP_STA } wifi_mode_t;
+
+typedef enum {
+  ARDUINO_EVENT_WIFI_STA_START = 0,
+  ARDUINO_EVENT_WIFI_STA_CONNECTED,
+  ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+  ARDUINO_EVENT_WIFI_STA_GOT_IP,
+  ARDUINO_EVENT_WIFI_STA_LOST_IP,
+  ARDUINO_EVENT_MAX,
+} arduino_event_id_t;
+
+typedef struct {
+  uint16_t reason;
+} wifi_event_sta_disconnected_t;
+
+typedef union {
+  wifi_event_sta_disconnected_t wifi_sta_disconnected;
+} arduino_event_info_t;
+
+enum {
+  WIFI_REASON_AUTH_EXPIRE = 2,
+  WIFI_REASON_ASSOC_LEAVE = 8,
+  WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT = 15,
+  WIFI_REASON_BEACON_TIMEOUT = 200,
+  WIFI_REASON_NO_AP_FOUND = 201,
+  WIFI_REASON_AUTH_FAIL = 202,
+  WIFI_REASON_ASSOC_FAIL = 203,
+  WIFI_REASON_HANDSHAKE_TIMEOUT = 204,
+};
+
+class WiFiClass {
+ public:
+  typedef std::function<void(arduino_event_id_t, arduino_event_info_t)> EventHandler;
+
+  // Poslední WiFi.begin()
+  struct BeginCall {
+    std::string ssid;
+    std::string password;
+    int32_t channel = 0;
+    bool withBssid = false;
+    uint8_t bssid[6] = {0};
+  };
+
+  // --- API používané firmwarem ---
+  wl_status_t status() { return status_; }
+  bool mode(wifi_mode_t mode) {
+    mode_ = mode;
+    return true;
+  }
+  wifi_mode_t getMode() { return mode_; }
+  bool persistent(bool) { return true; }
+  void setAutoReconnect(bool) {}
+
+  wl_status_t begin(const char* ssid, const char* password = nullptr, int32_t channel = 0,
+                    const uint8_t* bssid = nullptr, bool = true) {
+    BeginCall call;
+    call.ssid = ssid ? ssid : "";
+    call.password = password ? password : "";
+    call.channel = channel;
+    call.withBssid = bssid != nullptr;
+    if (bssid) memcpy(call.bssid, bssid, 6);
+    begins.push_back(call);
+    status_ = WL_DISCONNECTED;
+    return status_;
+  }
+  bool config(IPAddress ip, IPAddress gateway, IPAddress subnet, IPAddress dns = IPAddress()) {
+    configIp = ip;
+    configGateway = gateway;
+    configSubnet = subnet;
+    configDns = dns;
+    configCalls++;
+    return true;
+  }
+  bool disconnect(bool = false, bool = false) {
+    status_ = WL_DISCONNECTED;
+    disconnects++;
+    return true;
+  }
+  bool reconnect() {
+    reconnects++;
+    return true;
+  }
+
+  IPAddress localIP() { return status_ == WL_CONNECTED ? ip_ : IPAddress(); }
+  IPAddress gatewayIP() { return gateway_; }
+  IPAddress subnetMask() { return subnet_; }
+  IPAddress dnsIP(uint8_t = 0) { return dns_; }
+  uint8_t* BSSID() { return status_ == WL_CONNECTED ? bssid_ : nullptr; }
+  int32_t channel() { return channel_; }
+  uint8_t* macAddress(uint8_t* mac) {
+    static const uint8_t MAC[6] = {0x24, 0x0A, 0xC4, 0x12, 0x34, 0x56};
+    memcpy(mac, MAC, 6);
+    return mac;
+  }
+
+  bool softAP(const char*, const char* = nullptr) {
+    apRunning = true;
+    return true;
+  }
+  IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+  bool softAPdisconnect(bool = false) {
+    apRunning = false;
+    return true;
+  }
+
+  void onEvent(EventHandler handler, arduino_event_id_t = ARDUINO_EVENT_MAX) { handlers_.push_back(handler); }
+
+  // --- Řízení z testu ---
+  void reset() {
+    *this = WiFiClass();
+  }
+
+  void emit(arduino_event_id_t event, uint16_t reason = 0) {
+    arduino_event_info_t info;
+    info.wifi_sta_disconnected.reason = reason;
+    for (auto& handler : handlers_) handler(event, info);
+  }
+
+  // AP odpověděl a DHCP přidělil adresu: CONNECTED + GOT_IP
+  void connectTo(const IPAddress& ip, const uint8_t* bssid, int32_t channel) {
+    ip_ = ip;
+    gateway_ = IPAddress(ip[0], ip[1], ip[2], 1);
+    subnet_ = IPAddress(255, 255, 255, 0);
+    dns_ = gateway_;
+    memcpy(bssid_, bssid, 6);
+    channel_ = channel;
+    status_ = WL_CONNECTED;
+    emit(ARDUINO_EVENT_WIFI_STA_CONNECTED);
+    emit(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  }
+
+  void drop(uint16_t reason) {
+    status_ = WL_DISCONNECTED;
+    emit(ARDUINO_EVENT_WIFI_STA_DISCONNECTED, reason);
+  }
+
+  // Stav driveru bez události (ztracené události při přetečení fronty)
+  void setStatus(wl_status_t status) { status_ = status; }
+
+  std::vector<BeginCall> begins;
+  unsigned configCalls = 0;
+  IPAddress configIp, configGateway, configSubnet, configDns;
+  unsigned disconnects = 0;
+  unsigned reconnects = 0;
+  bool apRunning = false;
+
+ private:
+  std::vector<EventHandler> handlers_;
+  wl_status_t status_ = WL_IDLE_STATUS;
+  wifi_mode_t mode_ = WIFI_OFF;
+  IPAddress ip_, gateway_, subnet_, dns_;
+  uint8_t bssid_[6] = {0};
+  int32_t channel_ = 0;
+};
+
+inline WiFiClass WiFi;
@@ -0,0 +1,38 @@
+#pragma once
+
+// I2C na hostiteli: zaznamenává zapsané bajty, endTransmission vrací
+// nastavený výsledek (0 = ACK)
+
+#include <Arduino.h>
+
+#include <vector>
+
+class TwoWire {
+ public:
+  bool begin(int = -1, int = -1, uint32_t = 0) { return true; }
+  void beginTransmission(uint8_t address) {
+    address_ = address;
+    pending_.clear();
+  }
+  size_t write(uint8_t b) {
+    pending_.push_back(b);
+    return 1;
+  }
+  uint8_t endTransmission(bool = true) {
+    transactions.push_back({address_, pending_});
+    return nextResult;
+  }
+
+  struct Transaction {
+    uint8_t address;
+    std::vector<uint8_t> bytes;
+  };
+  std::vector<Transaction> transactions;
+  uint8_t nextResult = 0;
+
+ private:
+  uint8_t address_ = 0;
+  std::vector<uint8_t> pending_;
+};
+
+inline TwoWire Wire;
@@ -0,0 +1,24 @@
+#pragma once
+
+// Mutex jako std::timed_mutex; testy bez xSemaphoreCreateMutex() dostanou
+// nullptr a zamykání je no-op. Jako ve FreeRTOS ho uvolňuje vlákno, které ho drží.
+
+#include <chrono>
+#include <mutex>
+
+#include "FreeRTOS.h"
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() { return new std::timed_mutex(); }
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t lock, TickType_t ticks) {
+  if (!lock) return pdTRUE;
+  auto* mutex = (std::timed_mutex*)lock;
+  if (ticks == portMAX_DELAY) {
+    mutex->lock();
+    return pdTRUE;
+  }
+  return mutex->try_lock_for(std::chrono::milliseconds(ticks)) ? pdTRUE : pdFALSE;
+}
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t lock) {
+  if (lock) ((std::timed_mutex*)lock)->unlock();
+  return pdTRUE;
+}
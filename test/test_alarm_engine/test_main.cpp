@@ -0,0 +1,224 @@
+// AlarmEngine nad skriptovanými průběhy hodnot: překlad a validace pravidel,
+// hystereze, dwell a fronta přechodů, která čeká na MQTT.
+
+#include <unity.h>
+
+#include <string.h>
+
+#include <vector>
+
+#include "AlarmEngine.h"
+
+namespace {
+const char* const KEYS[] = {"co2", "pm25", "temperature"};
+
+int resolve(const char* key) {
+  for (int i = 0; i < 3; i++) {
+    if (strcmp(KEYS[i], key) == 0) return i;
+  }
+  return -1;
+}
+
+struct Step {
+  uint32_t atMs;
+  float value;
+};
+
+// Průběh jednoho kanálu; vrací masky změn po krocích
+std::vector<uint32_t> run(AlarmEngine& engine, uint8_t channel, const std::vector<Step>& trace) {
+  std::vector<uint32_t> changes;
+  float values[3] = {0, 0, 0};
+  for (const Step& step : trace) {
+    values[channel] = step.value;
+    changes.push_back(engine.evaluate(values, 1UL << channel, step.atMs));
+  }
+  return changes;
+}
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_compile_parses_rules_and_resolves_channels() {
+  AlarmEngine engine;
+  TEST_ASSERT_TRUE(engine.compile("co2>1200:1000:60; pm25 > 35 : 25 : 120, temperature<16", resolve));
+  TEST_ASSERT_EQUAL(3, engine.ruleCount());
+
+  const AlarmRule& co2 = engine.rule(0);
+  TEST_ASSERT_EQUAL_STRING("co2", co2.key);
+  TEST_ASSERT_EQUAL(0, co2.channel);
+  TEST_ASSERT_TRUE(co2.above);
+  TEST_ASSERT_EQUAL_FLOAT(1200, co2.onThreshold);
+  TEST_ASSERT_EQUAL_FLOAT(1000, co2.offThreshold);
+  TEST_ASSERT_EQUAL(60000, co2.dwellMs);
+
+  const AlarmRule& pm25 = engine.rule(1);
+  TEST_ASSERT_EQUAL_STRING("pm25", pm25.key);
+  TEST_ASSERT_EQUAL(1, pm25.channel);
+  TEST_ASSERT_EQUAL(120000, pm25.dwellMs);
+
+  // Bez konce a dwell: konec na stejném prahu, přechod hned
+  const AlarmRule& temp = engine.rule(2);
+  TEST_ASSERT_FALSE(temp.above);
+  TEST_ASSERT_EQUAL_FLOAT(16, temp.offThreshold);
+  TEST_ASSERT_EQUAL(0, temp.dwellMs);
+}
+
+void test_unknown_channel_keeps_rule_but_never_fires() {
+  AlarmEngine engine;
+  TEST_ASSERT_FALSE(engine.compile("co2>1200; radon>300", resolve));
+  TEST_ASSERT_EQUAL(2, engine.ruleCount());
+  TEST_ASSERT_EQUAL(-1, engine.rule(1).channel);
+
+  float values[3] = {1500, 0, 0};
+  TEST_ASSERT_EQUAL(1, engine.evaluate(values, 0x7, 0));
+  TEST_ASSERT_EQUAL(1, engine.activeMask());
+}
+
+void test_validate_rejects_malformed_rules() {
+  TEST_ASSERT_TRUE(AlarmEngine::validate(""));
+  TEST_ASSERT_TRUE(AlarmEngine::validate(" ; "));
+  TEST_ASSERT_TRUE(AlarmEngine::validate("co2>1200:1000:60;temperature<16:17"));
+
+  TEST_ASSERT_FALSE(AlarmEngine::validate("co2>1200:1300"));       // hystereze po směru alarmu
+  TEST_ASSERT_FALSE(AlarmEngine::validate("temperature<16:15"));
+  TEST_ASSERT_FALSE(AlarmEngine::validate("co2>abc"));
+  TEST_ASSERT_FALSE(AlarmEngine::validate("co2>1200x"));
+  TEST_ASSERT_FALSE(AlarmEngine::validate(">1200"));
+  TEST_ASSERT_FALSE(AlarmEngine::validate("co2=1200"));
+  TEST_ASSERT_FALSE(AlarmEngine::validate("co2>1200:1000:-1"));
+  TEST_ASSERT_FALSE(AlarmEngine::validate("co2>1200:1000:60:5"));
+  TEST_ASSERT_FALSE(AlarmEngine::validate("a_very_long_channel_key_name>1"));
+  TEST_ASSERT_FALSE(AlarmEngine::validate("co2>1;co2>2;co2>3;co2>4;co2>5;co2>6;co2>7;co2>8;co2>9"));
+}
+
+void test_hysteresis_trace() {
+  AlarmEngine engine;
+  engine.compile("co2>1200:1000", resolve);
+  std::vector<uint32_t> changes = run(engine, 0, {
+      {0, 1100}, {10000, 1250}, {20000, 1150}, {30000, 1050}, {40000, 1210}, {50000, 990}, {60000, 1100},
+      {70000, 1201}});
+  std::vector<uint32_t> expected = {0, 1, 0, 0, 0, 1, 0, 1};
+  for (size_t i = 0; i < expected.size(); i++) TEST_ASSERT_EQUAL_MESSAGE(expected[i], changes[i], "krok");
+  TEST_ASSERT_EQUAL(1, engine.activeMask());
+  TEST_ASSERT_EQUAL(3, engine.getStats().transitions);
+}
+
+void test_below_rule_with_hysteresis() {
+  AlarmEngine engine;
+  engine.compile("temperature<16:17", resolve);
+  std::vector<uint32_t> changes = run(engine, 2, {{0, 18}, {1000, 15.9f}, {2000, 16.5f}, {3000, 17.1f}});
+  TEST_ASSERT_EQUAL(0, changes[0]);
+  TEST_ASSERT_EQUAL(1, changes[1]);
+  TEST_ASSERT_EQUAL(0, changes[2]);
+  TEST_ASSERT_EQUAL(1, changes[3]);
+  TEST_ASSERT_EQUAL(0, engine.activeMask());
+}
+
+void test_dwell_resets_when_condition_breaks() {
+  AlarmEngine engine;
+  engine.compile("co2>1200:1000:60", resolve);
+  // 50 s nad prahem, pak propad - dwell začíná znovu
+  std::vector<Step> trace;
+  for (uint32_t t = 0; t <= 50000; t += 10000) trace.push_back({t, 1300});
+  trace.push_back({60000, 1150});
+  for (uint32_t t = 70000; t <= 130000; t += 10000) trace.push_back({t, 1300});
+  std::vector<uint32_t> changes = run(engine, 0, trace);
+
+  for (size_t i = 0; i + 1 < changes.size(); i++) TEST_ASSERT_EQUAL_MESSAGE(0, changes[i], "pred dwell");
+  TEST_ASSERT_EQUAL(1, changes.back());  // přesně 60 s od 70 s
+  TEST_ASSERT_TRUE(engine.rule(0).active);
+
+  // Konec taky čeká na dwell
+  changes = run(engine, 0, {{140000, 900}, {190000, 900}, {199999, 900}, {200000, 900}});
+  TEST_ASSERT_EQUAL(0, changes[0]);
+  TEST_ASSERT_EQUAL(0, changes[1]);
+  TEST_ASSERT_EQUAL(0, changes[2]);
+  TEST_ASSERT_EQUAL(1, changes[3]);
+  TEST_ASSERT_FALSE(engine.rule(0).active);
+}
+
+void test_invalid_samples_are_skipped() {
+  AlarmEngine engine;
+  engine.compile("co2>1200", resolve);
+  float values[3] = {5000, 0, 0};
+  TEST_ASSERT_EQUAL(0, engine.evaluate(values, 0x2, 0));  // CO2 neplatné
+  TEST_ASSERT_EQUAL(0, engine.activeMask());
+  TEST_ASSERT_NULL(engine.peekEvent());
+}
+
+void test_transitions_during_outage_are_queued_in_order() {
+  AlarmEngine engine;
+  engine.compile("co2>1200:1000; pm25>35:25", resolve);
+  float values[3] = {1300, 10, 0};
+  engine.evaluate(values, 0x3, 0);   // co2 on
+  values[1] = 40;
+  engine.evaluate(values, 0x3, 1000);  // pm25 on
+  values[0] = 900;
+  engine.evaluate(values, 0x3, 2000);  // co2 off - maska by ukázala jen "off"
+  TEST_ASSERT_EQUAL(2, engine.activeMask());
+  TEST_ASSERT_EQUAL(3, engine.pendingEvents());
+
+  const AlarmEvent* event = engine.peekEvent();
+  TEST_ASSERT_EQUAL(0, event->rule);
+  TEST_ASSERT_TRUE(event->active);
+  TEST_ASSERT_EQUAL_FLOAT(1300, event->value);
+  TEST_ASSERT_EQUAL_FLOAT(1200, event->threshold);
+  // Nepovedené odeslání: bez pop zůstává událost na řadě
+  TEST_ASSERT_EQUAL(event, engine.peekEvent());
+  engine.popEvent();
+
+  event = engine.peekEvent();
+  TEST_ASSERT_EQUAL(1, event->rule);
+  TEST_ASSERT_TRUE(event->active);
+  engine.popEvent();
+
+  event = engine.peekEvent();
+  TEST_ASSERT_EQUAL(0, event->rule);
+  TEST_ASSERT_FALSE(event->active);
+  TEST_ASSERT_EQUAL_FLOAT(900, event->value);
+  TEST_ASSERT_EQUAL_FLOAT(1000, event->threshold);
+  engine.popEvent();
+  TEST_ASSERT_NULL(engine.peekEvent());
+  TEST_ASSERT_EQUAL(0, engine.getStats().droppedEvents);
+}
+
+void test_full_event_queue_drops_oldest() {
+  AlarmEngine engine;
+  engine.compile("co2>1200", resolve);
+  float values[3] = {0, 0, 0};
+  // Kmitání kolem prahu: 20 přechodů, ve frontě se vejde 16
+  for (uint32_t i = 0; i < 20; i++) {
+    values[0] = i % 2 ? 1000 : 1300;
+    engine.evaluate(values, 0x1, i * 1000);
+  }
+  TEST_ASSERT_EQUAL(AlarmEngine::EVENT_QUEUE, engine.pendingEvents());
+  TEST_ASSERT_EQUAL(4, engine.getStats().droppedEvents);
+
+  // Zbyly posledních 16, poslední odpovídá aktuálnímu stavu
+  bool lastActive = true;
+  uint8_t count = 0;
+  while (const AlarmEvent* event = engine.peekEvent()) {
+    lastActive = event->active;
+    engine.popEvent();
+    count++;
+  }
+  TEST_ASSERT_EQUAL(16, count);
+  TEST_ASSERT_FALSE(lastActive);
+  TEST_ASSERT_EQUAL(0, engine.activeMask());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_compile_parses_rules_and_resolves_channels);
+  RUN_TEST(test_unknown_channel_keeps_rule_but_never_fires);
+  RUN_TEST(test_validate_rejects_malformed_rules);
+  RUN_TEST(test_hysteresis_trace);
+  RUN_TEST(test_below_rule_with_hysteresis);
+  RUN_TEST(test_dwell_resets_when_condition_breaks);
+  RUN_TEST(test_invalid_samples_are_skipped);
+  RUN_TEST(test_transitions_during_outage_are_queued_in_order);
+  RUN_TEST(test_full_event_queue_drops_oldest);
+  return UNITY_END();
+}
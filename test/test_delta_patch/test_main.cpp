@@ -0,0 +1,290 @@
+// DeltaPatcher nad delty sestavenými v testu (formát viz src/DeltaPatch.h):
+// stejný cíl při libovolném dělení vstupu, odmítnutý zdroj, COPY mimo zdroj,
+// cíl delší i kratší než hlavička a data za END. Po chybě se nic dalšího
+// nezapíše.
+
+#include <unity.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <random>
+#include <vector>
+
+#include "DeltaPatch.h"
+
+namespace {
+typedef std::vector<uint8_t> Bytes;
+
+const uint8_t OP_END = 0x00;
+const uint8_t OP_COPY = 0x01;
+const uint8_t OP_DATA = 0x02;
+
+Bytes source;
+uint8_t sourceHash[32];
+
+void putU32(Bytes& out, uint32_t v) {
+  for (int i = 0; i < 4; i++) out.push_back((uint8_t)(v >> (8 * i)));
+}
+
+// Delta jako ze scripts/make_delta.py, operace se přidávají ručně
+struct Delta {
+  Bytes bytes;
+
+  Delta(uint32_t sourceSize, uint32_t targetSize, const uint8_t* hash = sourceHash) {
+    const uint8_t magic[] = {'S', 'D', 'L', 'T', DeltaPatcher::VERSION, 0, 0, 0};
+    bytes.assign(magic, magic + sizeof(magic));
+    putU32(bytes, sourceSize);
+    putU32(bytes, targetSize);
+    bytes.insert(bytes.end(), hash, hash + 32);
+  }
+  Delta& copy(uint32_t offset, uint32_t length) {
+    bytes.push_back(OP_COPY);
+    putU32(bytes, offset);
+    putU32(bytes, length);
+    return *this;
+  }
+  Delta& data(const Bytes& literal) {
+    bytes.push_back(OP_DATA);
+    putU32(bytes, literal.size());
+    bytes.insert(bytes.end(), literal.begin(), literal.end());
+    return *this;
+  }
+  Delta& end() {
+    bytes.push_back(OP_END);
+    return *this;
+  }
+};
+
+// Zařízení: běžící image = source, cíl se skládá do target
+struct Device {
+  Bytes target;
+  uint32_t sourceChecks = 0;
+  uint32_t sourceReads = 0;
+  uint32_t readableBytes = UINT32_MAX;  // za touto hranicí čtení flash selže
+  bool failWrites = false;
+  DeltaPatcher patcher;
+
+  Device()
+      : patcher(
+            [this](uint32_t size, const uint8_t* hash) {
+              sourceChecks++;
+              return size == source.size() && memcmp(hash, sourceHash, sizeof(sourceHash)) == 0;
+            },
+            [this](uint32_t offset, uint8_t* out, size_t length) {
+              sourceReads++;
+              if (offset + length > source.size() || offset + length > readableBytes) return false;
+              memcpy(out, source.data() + offset, length);
+              return true;
+            },
+            [this](const uint8_t* in, size_t length) {
+              if (failWrites) return false;
+              target.insert(target.end(), in, in + length);
+              return true;
+            }) {}
+
+  bool feedAll(const Bytes& delta) { return patcher.feed(delta.data(), delta.size()); }
+};
+
+Bytes randomBytes(std::mt19937& rng, size_t length) {
+  Bytes out(length);
+  for (uint8_t& b : out) b = (uint8_t)rng();
+  return out;
+}
+
+// Nový image: části zdroje přeházené, mezi nimi nová data
+void buildUpdate(std::mt19937& rng, Delta& delta, Bytes& expected) {
+  const uint32_t copies[][2] = {{4096, 10000}, {0, 300}, {60000, 5000}, {17, 1}, {65535, 1}};
+  for (const auto& c : copies) {
+    Bytes literal = randomBytes(rng, 1 + rng() % 700);
+    delta.data(literal);
+    expected.insert(expected.end(), literal.begin(), literal.end());
+    delta.copy(c[0], c[1]);
+    expected.insert(expected.end(), source.begin() + c[0], source.begin() + c[0] + c[1]);
+  }
+  delta.data(Bytes());  // prázdný DATA je platný
+}
+
+Delta updateDelta(std::mt19937& rng, Bytes& expected) {
+  Delta probe(source.size(), 0);
+  buildUpdate(rng, probe, expected);
+  Delta delta(source.size(), expected.size());
+  delta.bytes.insert(delta.bytes.end(), probe.bytes.begin() + DeltaPatcher::HEADER_BYTES, probe.bytes.end());
+  delta.end();
+  return delta;
+}
+
+void assertFailsWith(Device& device, const char* error) {
+  TEST_ASSERT_FALSE(device.patcher.finished());
+  TEST_ASSERT_EQUAL_STRING(error, device.patcher.error());
+  // Po chybě se další vstup ignoruje a nic se nezapíše
+  size_t written = device.target.size();
+  const uint8_t more[] = {OP_DATA, 1, 0, 0, 0, 0xAA};
+  TEST_ASSERT_FALSE(device.patcher.feed(more, sizeof(more)));
+  TEST_ASSERT_EQUAL(written, device.target.size());
+  TEST_ASSERT_EQUAL_STRING(error, device.patcher.error());
+}
+}  // namespace
+
+void setUp() {
+  std::mt19937 rng(44);
+  source = randomBytes(rng, 65536);
+  for (int i = 0; i < 32; i++) sourceHash[i] = (uint8_t)(0xA0 + i);
+}
+
+void tearDown() {}
+
+void test_any_chunk_split_gives_same_target() {
+  std::mt19937 rng(1);
+  Bytes expected;
+  Delta delta = updateDelta(rng, expected);
+  TEST_ASSERT_TRUE(DeltaPatcher::isDelta(delta.bytes.data(), delta.bytes.size()));
+
+  // Celá delta najednou, po bajtech a náhodné kusy (hranice uvnitř hlavičky,
+  // argumentů operací i dat)
+  for (int round = 0; round < 200; round++) {
+    Device device;
+    size_t pos = 0;
+    while (pos < delta.bytes.size()) {
+      size_t n = round == 0 ? delta.bytes.size() : (round == 1 ? 1 : 1 + rng() % 97);
+      if (n > delta.bytes.size() - pos) n = delta.bytes.size() - pos;
+      TEST_ASSERT_TRUE_MESSAGE(device.patcher.feed(delta.bytes.data() + pos, n), device.patcher.error());
+      pos += n;
+    }
+    TEST_ASSERT_TRUE(device.patcher.finished());
+    TEST_ASSERT_EQUAL(expected.size(), device.patcher.written());
+    TEST_ASSERT_EQUAL(15302, device.patcher.copiedBytes());
+    TEST_ASSERT_TRUE(device.target == expected);
+  }
+}
+
+void test_finished_only_after_end() {
+  std::mt19937 rng(2);
+  Bytes expected;
+  Delta delta = updateDelta(rng, expected);
+  Device device;
+  TEST_ASSERT_TRUE(device.patcher.feed(delta.bytes.data(), delta.bytes.size() - 1));
+  TEST_ASSERT_FALSE(device.patcher.finished());  // chybí END, ačkoli cíl je celý
+  TEST_ASSERT_EQUAL(expected.size(), device.patcher.written());
+  TEST_ASSERT_TRUE(device.patcher.feed(delta.bytes.data() + delta.bytes.size() - 1, 1));
+  TEST_ASSERT_TRUE(device.patcher.finished());
+}
+
+void test_source_hash_or_size_mismatch_rejected() {
+  uint8_t otherHash[32];
+  memcpy(otherHash, sourceHash, sizeof(otherHash));
+  otherHash[31] ^= 1;
+  Device device;
+  TEST_ASSERT_FALSE(device.feedAll(Delta(source.size(), 4, otherHash).data({1, 2, 3, 4}).end().bytes));
+  assertFailsWith(device, "delta: bezici firmware neodpovida zdroji delty");
+  TEST_ASSERT_EQUAL(1, device.sourceChecks);
+  TEST_ASSERT_EQUAL(0, device.target.size());
+
+  Device shorter;
+  TEST_ASSERT_FALSE(shorter.feedAll(Delta(source.size() - 1, 4).data({1, 2, 3, 4}).end().bytes));
+  assertFailsWith(shorter, "delta: bezici firmware neodpovida zdroji delty");
+}
+
+void test_bad_header_rejected() {
+  Delta wrongMagic(source.size(), 1);
+  wrongMagic.bytes[0] = 'X';
+  TEST_ASSERT_FALSE(DeltaPatcher::isDelta(wrongMagic.bytes.data(), wrongMagic.bytes.size()));
+  Device a;
+  TEST_ASSERT_FALSE(a.feedAll(wrongMagic.bytes));
+  assertFailsWith(a, "delta: spatna hlavicka");
+
+  Delta wrongVersion(source.size(), 1);
+  wrongVersion.bytes[4] = DeltaPatcher::VERSION + 1;
+  Device b;
+  TEST_ASSERT_FALSE(b.feedAll(wrongVersion.bytes));
+  assertFailsWith(b, "delta: nepodporovana verze");
+
+  Device c;
+  TEST_ASSERT_FALSE(c.feedAll(Delta(source.size(), 0).end().bytes));
+  assertFailsWith(c, "delta: prazdny cil");
+
+  Delta unknownOp(source.size(), 1);
+  unknownOp.bytes.push_back(0x7F);
+  Device d;
+  TEST_ASSERT_FALSE(d.feedAll(unknownOp.bytes));
+  assertFailsWith(d, "delta: neznama operace");
+}
+
+void test_copy_out_of_source_range_rejected() {
+  const uint32_t size = source.size();
+  // Za koncem, přes konec a offset+délka přetékající 32 bitů
+  const uint32_t bad[][2] = {{size, 1}, {size - 10, 11}, {size + 1, 0}, {16, 0xFFFFFFF8u}, {0xFFFFFFF0u, 0x20}};
+  for (const auto& b : bad) {
+    Device device;
+    TEST_ASSERT_FALSE(device.feedAll(Delta(size, 100).copy(b[0], b[1]).end().bytes));
+    assertFailsWith(device, "delta: COPY mimo zdroj");
+    TEST_ASSERT_EQUAL(0, device.sourceReads);
+  }
+
+  // Poslední bajt zdroje a prázdné COPY na konci ještě platí
+  Device edge;
+  TEST_ASSERT_TRUE(edge.feedAll(Delta(size, 1).copy(size - 1, 1).copy(size, 0).end().bytes));
+  TEST_ASSERT_TRUE(edge.patcher.finished());
+  TEST_ASSERT_EQUAL(source.back(), edge.target[0]);
+}
+
+void test_target_longer_than_header_rejected() {
+  // DATA přes deklarovanou velikost: nic z přesahu se nezapíše
+  Device data;
+  TEST_ASSERT_FALSE(data.feedAll(Delta(source.size(), 10).data(Bytes(8, 1)).data(Bytes(3, 2)).end().bytes));
+  assertFailsWith(data, "delta: cil delsi nez hlavicka");
+  TEST_ASSERT_EQUAL(8, data.target.size());
+
+  Device copy;
+  TEST_ASSERT_FALSE(copy.feedAll(Delta(source.size(), 1000).copy(0, 1001).end().bytes));
+  assertFailsWith(copy, "delta: cil delsi nez hlavicka");
+  TEST_ASSERT_LESS_OR_EQUAL(1000, copy.target.size());
+}
+
+void test_target_shorter_than_header_rejected() {
+  Device device;
+  TEST_ASSERT_FALSE(device.feedAll(Delta(source.size(), 100).data(Bytes(99, 1)).end().bytes));
+  assertFailsWith(device, "delta: cil kratsi nez hlavicka");
+}
+
+void test_trailing_data_after_end_rejected() {
+  Bytes delta = Delta(source.size(), 4).data({1, 2, 3, 4}).end().bytes;
+  delta.push_back(OP_END);
+  Device together;
+  TEST_ASSERT_FALSE(together.feedAll(delta));
+  assertFailsWith(together, "delta: data za koncem");
+
+  // Přebytek v dalším kusu
+  Device split;
+  TEST_ASSERT_TRUE(split.patcher.feed(delta.data(), delta.size() - 1));
+  TEST_ASSERT_TRUE(split.patcher.finished());
+  TEST_ASSERT_FALSE(split.patcher.feed(delta.data() + delta.size() - 1, 1));
+  assertFailsWith(split, "delta: data za koncem");
+}
+
+void test_source_read_and_write_errors_stop_patching() {
+  Device write;
+  write.failWrites = true;
+  TEST_ASSERT_FALSE(write.feedAll(Delta(source.size(), 4).data({1, 2, 3, 4}).end().bytes));
+  assertFailsWith(write, "delta: zapis selhal");
+
+  Device read;
+  read.readableBytes = 1000;
+  TEST_ASSERT_FALSE(read.feedAll(Delta(source.size(), 2000).copy(0, 2000).end().bytes));
+  assertFailsWith(read, "delta: cteni zdroje selhalo");
+  TEST_ASSERT_EQUAL(768, read.target.size());  // celé kusy po 256 B před chybou
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_any_chunk_split_gives_same_target);
+  RUN_TEST(test_finished_only_after_end);
+  RUN_TEST(test_source_hash_or_size_mismatch_rejected);
+  RUN_TEST(test_bad_header_rejected);
+  RUN_TEST(test_copy_out_of_source_range_rejected);
+  RUN_TEST(test_target_longer_than_header_rejected);
+  RUN_TEST(test_target_shorter_than_header_rejected);
+  RUN_TEST(test_trailing_data_after_end_rejected);
+  RUN_TEST(test_source_read_and_write_errors_stop_patching);
+  return UNITY_END();
+}
@@ -0,0 +1,267 @@
+// Flotila panelů nad modelem brokeru: každé zařízení plánuje připojení a HA
+// discovery stejným kódem jako firmware (MqttPacing), broker přijme jen
+// omezený počet CONNECT za sekundu. Scénář: výpadek brokeru na minutu,
+// po obnovení čekání na připojení všech, pak restart Home Assistantu (birth
+// zpráva všem naráz). Pro srovnání běží i dřívější chování: pevný pokus
+// každých 5 s a celá dávka discovery hned po připojení i po birth zprávě.
+
+#include <unity.h>
+
+#include <stdio.h>
+
+#include <random>
+#include <vector>
+
+#include "MqttPacing.h"
+
+namespace {
+constexpr uint32_t STEP_MS = 10;              // průchod loop() zařízení
+constexpr uint16_t ENTITIES = 18;             // SEN66 + indexy kvality vzduchu
+constexpr uint32_t OUTAGE_AT_MS = 10000;
+constexpr uint32_t OUTAGE_MS = 62500;         // ne násobek 5 s, pevný interval by trefil obnovení přesně
+constexpr uint32_t HA_RESTART_DELAY_MS = 10000;  // po připojení posledního zařízení
+constexpr uint32_t END_LIMIT_MS = 1200000;
+constexpr uint32_t BROKER_CONNECTS_PER_S = 200;  // model: CONNECT (TLS, autentizace) je drahý
+constexpr uint32_t BROKER_CONNECT_BURST = 20;
+constexpr uint32_t FIXED_RETRY_MS = 5000;
+
+enum Policy { POLICY_FIRMWARE, POLICY_FIXED };
+
+struct Broker {
+  bool up = true;
+  double tokens = BROKER_CONNECT_BURST;
+  uint32_t refilledAt = 0;
+  std::vector<uint32_t> attemptsPerS;
+  std::vector<uint32_t> messagesPerS;  // příchozí PUBLISH (discovery)
+  uint32_t attempts = 0;
+  uint32_t refused = 0;
+
+  static void bump(std::vector<uint32_t>& perS, uint32_t now) {
+    uint32_t s = now / 1000;
+    if (perS.size() <= s) perS.resize(s + 1, 0);
+    perS[s]++;
+  }
+
+  bool connect(uint32_t now) {
+    bump(attemptsPerS, now);
+    attempts++;
+    tokens += (now - refilledAt) * BROKER_CONNECTS_PER_S / 1000.0;
+    if (tokens > BROKER_CONNECT_BURST) tokens = BROKER_CONNECT_BURST;
+    refilledAt = now;
+    if (!up || tokens < 1) {
+      refused++;
+      return false;
+    }
+    tokens -= 1;
+    return true;
+  }
+
+  void publish(uint32_t now) { bump(messagesPerS, now); }
+};
+
+struct Device {
+  bool connected = true;
+  bool discoveryPublished = true;
+  uint32_t disconnectedAt = 0;
+  ReconnectBackoff backoff;
+  DiscoveryPacer discovery;
+  uint32_t fixedNextAt = 0;
+  uint16_t fixedBurst = 0;  // dřívější dávka discovery: zbývající entity
+};
+
+struct Result {
+  uint32_t reconnectAllMs = 0;     // od obnovení brokeru po připojení posledního zařízení
+  uint32_t peakAttemptsPerS = 0;
+  uint32_t attempts = 0;
+  uint32_t refused = 0;
+  uint32_t peakDiscoveryPerS = 0;  // po restartu HA
+  uint32_t discoveryAllMs = 0;     // od birth zprávy po poslední entitu
+};
+
+uint32_t peak(const std::vector<uint32_t>& perS, uint32_t fromS) {
+  uint32_t best = 0;
+  for (size_t s = fromS; s < perS.size(); s++) best = perS[s] > best ? perS[s] : best;
+  return best;
+}
+
+// Jeden průchod loop() zařízení - stejné pořadí jako v main.cpp
+void stepDevice(Device& d, Policy policy, Broker& broker, uint32_t now, std::mt19937& rng) {
+  if (!d.connected) {
+    if (d.disconnectedAt == 0) {
+      d.disconnectedAt = now ? now : 1;
+      if (policy == POLICY_FIRMWARE) {
+        d.backoff.schedule(now, false, rng());
+      } else {
+        d.fixedNextAt = now + FIXED_RETRY_MS;
+      }
+    }
+    bool due = policy == POLICY_FIRMWARE ? d.backoff.due(now) : (int32_t)(now - d.fixedNextAt) >= 0;
+    if (due) {
+      if (broker.connect(now)) {
+        d.connected = true;
+        d.disconnectedAt = 0;
+        if (policy == POLICY_FIRMWARE) {
+          d.backoff.reset();
+          if (!d.discoveryPublished) d.discovery.start(now);
+        } else {
+          d.fixedBurst = ENTITIES;  // dřív discovery po každém připojení
+        }
+      } else if (policy == POLICY_FIRMWARE) {
+        d.backoff.schedule(now, true, rng());
+      } else {
+        d.fixedNextAt = now + FIXED_RETRY_MS;
+      }
+    }
+  }
+  if (!d.connected) return;
+
+  if (policy == POLICY_FIRMWARE) {
+    if (d.discovery.due(now, ENTITIES) >= 0) {
+      broker.publish(now);
+      if (d.discovery.sent(now, true, ENTITIES)) d.discoveryPublished = true;
+    }
+  } else {
+    for (; d.fixedBurst > 0; d.fixedBurst--) broker.publish(now);
+  }
+}
+
+Result simulate(uint16_t count, Policy policy) {
+  std::mt19937 rng(count * 2 + policy);
+  Broker broker;
+  std::vector<Device> devices(count);
+  Result result;
+
+  uint32_t now = 0;
+  uint32_t allConnectedAt = 0;
+  uint32_t haRestartAt = 0;
+  for (; now < END_LIMIT_MS; now += STEP_MS) {
+    if (now == OUTAGE_AT_MS) {
+      broker.up = false;
+      for (Device& d : devices) d.connected = false;  // broker zavřel spojení všem
+    }
+    if (now == OUTAGE_AT_MS + OUTAGE_MS) broker.up = true;
+    if (haRestartAt && now == haRestartAt) {
+      for (Device& d : devices) {
+        if (policy == POLICY_FIRMWARE) {
+          d.discovery.startJittered(now, rng());
+        } else {
+          d.fixedBurst = ENTITIES;
+        }
+      }
+    }
+
+    for (Device& d : devices) stepDevice(d, policy, broker, now, rng);
+
+    if (!allConnectedAt && now > OUTAGE_AT_MS + OUTAGE_MS) {
+      bool all = true;
+      for (const Device& d : devices) all &= d.connected;
+      if (all) {
+        allConnectedAt = now;
+        haRestartAt = now + HA_RESTART_DELAY_MS;
+        haRestartAt -= haRestartAt % STEP_MS;
+      }
+    }
+    if (haRestartAt && now > haRestartAt) {
+      bool done = true;
+      for (const Device& d : devices) done &= !d.discovery.pending() && d.fixedBurst == 0;
+      if (done) break;
+    }
+  }
+
+  result.reconnectAllMs = allConnectedAt ? allConnectedAt - (OUTAGE_AT_MS + OUTAGE_MS) : UINT32_MAX;
+  result.peakAttemptsPerS = peak(broker.attemptsPerS, 0);
+  result.attempts = broker.attempts;
+  result.refused = broker.refused;
+  result.peakDiscoveryPerS = haRestartAt ? peak(broker.messagesPerS, haRestartAt / 1000) : 0;
+  result.discoveryAllMs = haRestartAt ? now - haRestartAt : UINT32_MAX;
+  return result;
+}
+
+void report(uint16_t count, const char* name, const Result& r) {
+  char line[256];
+  snprintf(line, sizeof(line),
+           "%4u zarizeni %-8s: vsechna pripojena za %6.1f s, pokusu %5u (odmitnuto %5u, max %4u/s), "
+           "discovery po restartu HA max %5u zprav/s, hotovo za %5.1f s",
+           count, name, r.reconnectAllMs / 1000.0, r.attempts, r.refused, r.peakAttemptsPerS, r.peakDiscoveryPerS,
+           r.discoveryAllMs / 1000.0);
+  TEST_MESSAGE(line);
+}
+
+void runFleet(uint16_t count) {
+  Result firmware = simulate(count, POLICY_FIRMWARE);
+  Result fixed = simulate(count, POLICY_FIXED);
+  report(count, "firmware", firmware);
+  report(count, "pevny 5s", fixed);
+
+  // Všechna zařízení se vrátí a discovery doběhne
+  TEST_ASSERT_NOT_EQUAL(UINT32_MAX, firmware.reconnectAllMs);
+  TEST_ASSERT_LESS_OR_EQUAL(ReconnectBackoff::MAX_MS + 5000, firmware.reconnectAllMs);
+  TEST_ASSERT_LESS_THAN(DiscoveryPacer::JITTER_MS + ENTITIES * DiscoveryPacer::PACE_MS + 1000,
+                        firmware.discoveryAllMs);
+  // Jitter nikdy nepošle celou flotilu v jedné sekundě, pevný interval ano
+  TEST_ASSERT_LESS_OR_EQUAL(fixed.peakAttemptsPerS, firmware.peakAttemptsPerS);
+  TEST_ASSERT_LESS_OR_EQUAL(fixed.peakDiscoveryPerS, firmware.peakDiscoveryPerS);
+  // Discovery: nejvýš 10 zpráv/s na zařízení (PACE_MS) a rozprostřeno přes JITTER_MS
+  TEST_ASSERT_LESS_OR_EQUAL(count * (1000 / DiscoveryPacer::PACE_MS), firmware.peakDiscoveryPerS);
+}
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_backoff_window_doubles_up_to_cap() {
+  ReconnectBackoff backoff;
+  backoff.schedule(1000, false, 0);
+  TEST_ASSERT_EQUAL(1000 + ReconnectBackoff::BASE_MS / 2, backoff.nextAttemptAt());
+  backoff.schedule(1000, false, UINT32_MAX - 1);
+  TEST_ASSERT_LESS_OR_EQUAL(1000 + ReconnectBackoff::BASE_MS, backoff.nextAttemptAt());
+
+  uint32_t expected = ReconnectBackoff::BASE_MS;
+  for (int i = 0; i < 10; i++) {
+    backoff.schedule(0, true, 0);
+    expected = expected * 2 > ReconnectBackoff::MAX_MS ? ReconnectBackoff::MAX_MS : expected * 2;
+    TEST_ASSERT_EQUAL(expected, backoff.backoffMs());
+    TEST_ASSERT_EQUAL(expected / 2, backoff.nextAttemptAt());
+  }
+  TEST_ASSERT_FALSE(backoff.due(ReconnectBackoff::MAX_MS / 2 - 1));
+  TEST_ASSERT_TRUE(backoff.due(ReconnectBackoff::MAX_MS / 2));
+  backoff.reset();
+  TEST_ASSERT_EQUAL(ReconnectBackoff::BASE_MS, backoff.backoffMs());
+}
+
+void test_discovery_pacer_spaces_entities_and_retries_failed_send() {
+  DiscoveryPacer pacer;
+  TEST_ASSERT_EQUAL(-1, pacer.due(0, 3));
+  pacer.start(500);
+  TEST_ASSERT_EQUAL(-1, pacer.due(499, 3));
+  TEST_ASSERT_EQUAL(0, pacer.due(500, 3));
+  TEST_ASSERT_FALSE(pacer.sent(500, false, 3));  // plný buffer
+  TEST_ASSERT_EQUAL(-1, pacer.due(599, 3));
+  TEST_ASSERT_EQUAL(0, pacer.due(600, 3));
+  TEST_ASSERT_FALSE(pacer.sent(600, true, 3));
+  TEST_ASSERT_EQUAL(1, pacer.due(700, 3));
+  TEST_ASSERT_FALSE(pacer.sent(700, true, 3));
+  TEST_ASSERT_EQUAL(2, pacer.due(800, 3));
+  TEST_ASSERT_TRUE(pacer.sent(800, true, 3));
+  TEST_ASSERT_FALSE(pacer.pending());
+
+  pacer.startJittered(1000, 12345);
+  TEST_ASSERT_EQUAL(1000 + 12345 % DiscoveryPacer::JITTER_MS, pacer.nextAt());
+}
+
+void test_fleet_10() { runFleet(10); }
+
+void test_fleet_100() { runFleet(100); }
+
+void test_fleet_1000() { runFleet(1000); }
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_backoff_window_doubles_up_to_cap);
+  RUN_TEST(test_discovery_pacer_spaces_entities_and_retries_failed_send);
+  RUN_TEST(test_fleet_10);
+  RUN_TEST(test_fleet_100);
+  RUN_TEST(test_fleet_1000);
+  return UNITY_END();
+}
@@ -0,0 +1,249 @@
+// Ustálený běh bez alokací: po zahřátí se miliony průchodů loop() po 10 ms
+// (den provozu, vzorek za sekundu) volají cesty, které loop() prochází
+// s každým vzorkem: registr senzorů, texty hodnot, alarmy, kvalita vzduchu,
+// latence, topicy MQTT, payloady MQTT a URL pro TMEP (SamplePayload),
+// outbox QoS 1 s PUBACKy, cache /api/data, FixedString a Wi-Fi ve stavu
+// připojeno. Počítá se každé malloc/calloc/realloc (glibc), jinde aspoň
+// každé operator new.
+
+#include <FakeSensor.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <unity.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+
+#include "AirQuality.h"
+#include "AlarmEngine.h"
+#include "FixedString.h"
+#include "MqttOutbox.h"
+#include "MqttTopics.h"
+#include "ResponseCache.h"
+#include "SampleLatency.h"
+#include "SamplePayload.h"
+#include "SampleText.h"
+#include "SensorRegistry.h"
+#include "WifiProvisioning.h"
+
+namespace {
+bool counting = false;
+size_t allocations = 0;
+}  // namespace
+
+#ifdef __GLIBC__
+// Všechny cesty na heap včetně knihoven C (operator new volá malloc)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size) {
+  if (counting) allocations++;
+  return __libc_malloc(size);
+}
+void* calloc(size_t count, size_t size) {
+  if (counting) allocations++;
+  return __libc_calloc(count, size);
+}
+void* realloc(void* p, size_t size) {
+  if (counting) allocations++;
+  return __libc_realloc(p, size);
+}
+void* memalign(size_t alignment, size_t size) {
+  if (counting) allocations++;
+  return __libc_memalign(alignment, size);
+}
+void* aligned_alloc(size_t alignment, size_t size) { return memalign(alignment, size); }
+int posix_memalign(void** out, size_t alignment, size_t size) {
+  void* p = memalign(alignment, size);
+  if (!p) return ENOMEM;
+  *out = p;
+  return 0;
+}
+}
+#else
+namespace {
+void* allocate(size_t size) {
+  if (counting) allocations++;
+  void* p = malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+}  // namespace
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+#endif
+
+namespace {
+const IPAddress LEASE(192, 168, 1, 77);
+const uint8_t AP_BSSID[6] = {0x10, 0x20, 0x30, 0x40, 0x50, 0x60};
+constexpr uint32_t LOOP_MS = 10;
+constexpr uint32_t WARMUP = 20000;    // 200 s
+constexpr uint32_t SOAK = 8640000;    // 24 h průchodů loop() po 10 ms
+constexpr size_t PAYLOAD_SIZE = 2560;  // MQTT_BUFFER_SIZE
+
+FakeSensor sensor("SEN66", {CH_TEMPERATURE, CH_HUMIDITY, CH_PM25, CH_VOC, CH_CO2}, 1000);
+SensorRegistry sensors;
+SampleText sampleText;
+AlarmEngine alarms;
+AirQualityEngine airQuality;
+LatencyTracker latency;
+MqttTopics topics;
+AppConfig config;
+WifiProvisioning wifi;
+MqttOutbox outbox;
+ResponseCache dataCache;
+char payload[PAYLOAD_SIZE];
+uint16_t acks[MqttOutbox::WINDOW * 2];  // PUBACKy odeslaných paketů pro další průchod
+uint8_t ackCount = 0;
+uint32_t published = 0;
+
+// Broker: z PUBLISH paketu vezme packet id a potvrdí ho v dalším průchodu
+bool writePacket(const uint8_t* data, size_t length) {
+  size_t i = 1;
+  while (data[i++] & 0x80) {
+  }
+  i += 2 + ((data[i] << 8) | data[i + 1]);
+  TEST_ASSERT_LESS_THAN(length, i + 1);
+  if (ackCount < sizeof(acks) / sizeof(acks[0])) acks[ackCount++] = (data[i] << 8) | data[i + 1];
+  return true;
+}
+
+// Odběratelé nového vzorku jako v loop() a handleApiData()
+void onSample(uint32_t n, const SensorSample& sample) {
+  sampleText.update(sensors, sample);
+
+  alarms.evaluate(sample.values, sample.validMask, (uint32_t)sample.clockMs);
+  while (const AlarmEvent* event = alarms.peekEvent()) {
+    size_t length = buildAlarmJson(alarms.rule(event->rule).key, event->active, event->value, event->threshold,
+                                   payload, sizeof(payload));
+    TEST_ASSERT_GREATER_THAN(0, length);
+    alarms.popEvent();
+  }
+
+  float pm25 = 0, co2 = 0, voc = 0;
+  bool havePm25 = sensors.primaryValue(sample, CH_PM25, pm25);
+  bool haveCo2 = sensors.primaryValue(sample, CH_CO2, co2);
+  bool haveVoc = sensors.primaryValue(sample, CH_VOC, voc);
+  airQuality.update((uint32_t)(sample.clockMs / 1000), havePm25 ? &pm25 : nullptr, haveCo2 ? &co2 : nullptr,
+                    haveVoc ? &voc : nullptr);
+  AirQualityIndex index = airQuality.compute();
+  latency.record(LAT_MQTT, sample.sequence, n % 100);
+
+  // MQTT: state topicy kanálů a JSON vzorku přes outbox (QoS 1)
+  for (uint8_t c = 0; c < sensors.channelCount(); c++) {
+    const char* value = sampleText.value(c);
+    TEST_ASSERT_TRUE(outbox.publish(topics.stateTopic(c), (const uint8_t*)value, strlen(value), true));
+  }
+  size_t length = buildSensorJson(sensors, sample, sampleText, index, millis() / 1000, 5, payload, sizeof(payload));
+  TEST_ASSERT_GREATER_THAN(0, length);
+  TEST_ASSERT_TRUE(outbox.publish(topics.topic(MQTT_T_SENSOR), (const uint8_t*)payload, length, true,
+                                  sample.sequence, (uint32_t)sample.timestamp));
+  published++;
+
+  // TMEP a cache /api/data
+  TmepUrl url;
+  TEST_ASSERT_TRUE(buildTmepUrl("xyz", "tempV=*TEMP*&humV=*HUM*&pm25=*PM2*&co2=*CO2*", sensors, sample, sampleText, url));
+  TEST_ASSERT_TRUE(dataCache.store(sample.sequence, payload, length, 0));
+  TEST_ASSERT_TRUE(dataCache.matches(dataCache.etag()));
+
+  // Texty pro displej a stavové topicy
+  FixedString<64> line;
+  line.appendf("AQI %u %s", index.overall, AirQualityEngine::categoryLabel(index.overall));
+  for (uint8_t c = 0; c < sensors.channelCount(); c++) {
+    line.assign(sampleText.display(c));
+    line.append(' ');
+    line.append(sensors.channel(c).name);
+    TEST_ASSERT_NOT_NULL(topics.stateTopic(c));
+  }
+  TEST_ASSERT_EQUAL(MQTT_T_TEXT, topics.match(topics.topic(MQTT_T_TEXT)));
+  TEST_ASSERT_EQUAL(MQTT_T_UNKNOWN, topics.match("other/device/display/text"));
+}
+
+// Jeden průchod loop(): vzorek jen jednou za interval senzoru, ostatní
+// průchody jen zkontrolují termíny, outbox a Wi-Fi
+void loopPass(uint32_t n) {
+  uint32_t second = n / (1000 / LOOP_MS);
+  sensor.values[0] = 21.0f + (second % 50) / 10.0f;
+  sensor.values[1] = 40.0f + (second % 30);
+  sensor.values[2] = (float)((second * 7) % 60);
+  sensor.values[3] = 100.0f + (second % 200);
+  sensor.values[4] = 800.0f + (second * 13) % 900;  // CO2 kmitá přes práh alarmu
+  host::advanceMs(LOOP_MS);
+  if (sensors.process(millis())) onSample(second, sensors.snapshot());
+
+  for (uint8_t i = 0; i < ackCount; i++) outbox.onPuback(acks[i], millis());
+  ackCount = 0;
+  outbox.process(millis(), true);
+  wifi.process();
+}
+}  // namespace
+
+void setUp() { host::resetClock(); }
+
+void tearDown() {}
+
+void test_steady_state_loop_does_not_allocate() {
+  Preferences::wipeAll();
+  WiFi.reset();
+  config.wifiSsid.assign("home");
+  config.wifiPassword.assign("secret");
+  wifi.begin(&config);
+  WiFi.connectTo(LEASE, AP_BSSID, 6);
+  wifi.process();
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTED, wifi.getState());
+
+  sensors.add(&sensor, I2cBus());
+  sensors.begin();
+  TEST_ASSERT_TRUE(alarms.compile("co2>1500:1200:5; pm25>50:40; temperature<10", [](const char* key) {
+    for (uint8_t i = 0; i < sensors.channelCount(); i++) {
+      if (strcmp(sensors.channel(i).key, key) == 0) return (int)i;
+    }
+    return -1;
+  }));
+  outbox.begin(writePacket);
+  TEST_ASSERT_TRUE(topics.begin("sharp", ""));
+  for (uint8_t c = 0; c < sensors.channelCount(); c++) {
+    TEST_ASSERT_GREATER_OR_EQUAL(0, topics.addEntity(sensors.channel(c).key, sensors.channel(c).key));
+  }
+
+  // Zahřátí: první vzorky, naplnění oken a první přechody alarmů
+  for (uint32_t n = 0; n < WARMUP; n++) loopPass(n);
+
+  uint32_t samplesBefore = sampleText.getStats().samples;
+  uint32_t publishedBefore = published;
+  counting = true;
+  for (uint32_t n = WARMUP; n < WARMUP + SOAK; n++) loopPass(n);
+  counting = false;
+
+  uint32_t samples = sampleText.getStats().samples - samplesBefore;
+  MqttOutboxStats os = outbox.getStats();
+  char info[128];
+  snprintf(info, sizeof(info), "%lu pruchodu loop(), %lu vzorku, %lu zprav QoS 1, %u prechodu alarmu",
+           (unsigned long)SOAK, (unsigned long)samples, (unsigned long)os.delivered,
+           (unsigned)alarms.getStats().transitions);
+  TEST_MESSAGE(info);
+  TEST_ASSERT_EQUAL(SOAK / (1000 / LOOP_MS), samples);
+  TEST_ASSERT_EQUAL(samples, published - publishedBefore);
+  TEST_ASSERT_GREATER_THAN(published * (sensors.channelCount() + 1) - MqttOutbox::MAX_MESSAGES, os.delivered);
+  TEST_ASSERT_EQUAL(0, os.dropped);
+  TEST_ASSERT_GREATER_THAN(1000, alarms.getStats().transitions);
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTED, wifi.getState());
+  TEST_ASSERT_EQUAL(0, allocations);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_steady_state_loop_does_not_allocate);
+  return UNITY_END();
+}
@@ -0,0 +1,115 @@
+// JsonPool: přidělování jako ArduinoJson (pooly slotů, řetězce rostoucí
+// a zkracované přes reallocate), plný pool, uvolnění posledního bloku
+// a celého poolu, když nic nežije.
+
+#include <unity.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#include <memory>
+
+#include "JsonPool.h"
+
+namespace {
+std::unique_ptr<JsonPool> pool;
+}
+
+void setUp() { pool.reset(new JsonPool()); }
+
+void tearDown() {}
+
+void test_blocks_are_aligned_and_distinct() {
+  uint8_t* a = (uint8_t*)pool->allocate(3);
+  uint8_t* b = (uint8_t*)pool->allocate(17);
+  TEST_ASSERT_NOT_NULL(a);
+  TEST_ASSERT_NOT_NULL(b);
+  TEST_ASSERT_EQUAL(0, (uintptr_t)a % 8);
+  TEST_ASSERT_EQUAL(0, (uintptr_t)b % 8);
+  TEST_ASSERT_TRUE(b >= a + 3);
+  memset(a, 0xAA, 3);
+  memset(b, 0xBB, 17);
+  TEST_ASSERT_EQUAL_HEX8(0xAA, a[2]);
+  TEST_ASSERT_EQUAL(2, pool->live());
+}
+
+void test_last_block_grows_and_shrinks_in_place() {
+  char* text = (char*)pool->allocate(8);
+  memcpy(text, "abcdefg", 8);
+  size_t used = pool->used();
+  char* grown = (char*)pool->reallocate(text, 100);
+  TEST_ASSERT_EQUAL_PTR(text, grown);
+  TEST_ASSERT_EQUAL_STRING("abcdefg", grown);
+  TEST_ASSERT_GREATER_THAN(used, pool->used());
+  TEST_ASSERT_EQUAL_PTR(text, pool->reallocate(grown, 8));  // shrinkToFit
+  TEST_ASSERT_EQUAL(used, pool->used());
+}
+
+void test_inner_block_moves_on_growth() {
+  char* first = (char*)pool->allocate(16);
+  memcpy(first, "retezec", 8);
+  void* second = pool->allocate(32);
+  char* moved = (char*)pool->reallocate(first, 64);
+  TEST_ASSERT_NOT_NULL(moved);
+  TEST_ASSERT_TRUE(moved != first);
+  TEST_ASSERT_EQUAL_STRING("retezec", moved);
+  TEST_ASSERT_EQUAL(2, pool->live());
+  pool->deallocate(second);
+  pool->deallocate(moved);
+  TEST_ASSERT_EQUAL(0, pool->live());
+  TEST_ASSERT_EQUAL(0, pool->used());
+}
+
+void test_full_pool_fails_and_keeps_old_block() {
+  void* big = pool->allocate(JsonPool::CAPACITY / 2);
+  TEST_ASSERT_NOT_NULL(big);
+  void* other = pool->allocate(64);
+  TEST_ASSERT_NOT_NULL(other);
+  TEST_ASSERT_NULL(pool->allocate(JsonPool::CAPACITY));
+  TEST_ASSERT_NULL(pool->allocate((size_t)-1));
+  TEST_ASSERT_NULL(pool->allocate(0));
+  // Přesun se nevejde; původní blok zůstává platný a živý
+  TEST_ASSERT_NULL(pool->reallocate(big, JsonPool::CAPACITY / 2 + 8));
+  TEST_ASSERT_EQUAL(2, pool->live());
+  TEST_ASSERT_NULL(pool->reallocate(other, JsonPool::CAPACITY));
+  TEST_ASSERT_EQUAL(5, pool->getStats().failures);
+}
+
+void test_pool_is_reused_once_everything_is_freed() {
+  // Jako dokument ArduinoJson: pooly slotů, pole poolů a řetězce; pak destruktor
+  for (int round = 0; round < 1000; round++) {
+    void* slots = pool->allocate(1024);
+    void* list = pool->allocate(16);
+    char* key = (char*)pool->allocate(12);
+    key = (char*)pool->reallocate(key, 40);
+    key = (char*)pool->reallocate(key, 9);
+    void* slots2 = pool->allocate(1024);
+    slots2 = pool->reallocate(slots2, 200);
+    TEST_ASSERT_NOT_NULL(slots);
+    TEST_ASSERT_NOT_NULL(list);
+    TEST_ASSERT_NOT_NULL(key);
+    TEST_ASSERT_NOT_NULL(slots2);
+    pool->deallocate(slots);
+    pool->deallocate(key);
+    pool->deallocate(list);
+    pool->deallocate(slots2);
+    TEST_ASSERT_EQUAL(0, pool->used());
+  }
+  JsonPoolStats stats = pool->getStats();
+  TEST_ASSERT_EQUAL(4000, stats.allocations);
+  TEST_ASSERT_EQUAL(0, stats.failures);
+  TEST_ASSERT_LESS_THAN(4096, stats.peakBytes);
+  pool->deallocate(nullptr);
+  pool->deallocate(pool.get());  // nic nežije - ignorovat
+  TEST_ASSERT_EQUAL(0, pool->live());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_blocks_are_aligned_and_distinct);
+  RUN_TEST(test_last_block_grows_and_shrinks_in_place);
+  RUN_TEST(test_inner_block_moves_on_growth);
+  RUN_TEST(test_full_pool_fails_and_keeps_old_block);
+  RUN_TEST(test_pool_is_reused_once_everything_is_freed);
+  return UNITY_END();
+}
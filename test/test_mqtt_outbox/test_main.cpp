@@ -0,0 +1,332 @@
+// QoS 1 outbox a MqttClientTap nad modelem brokeru za ztrátovou linkou:
+// broker dostává pakety, které outbox zapíše přes tap, a potvrzuje je
+// v pořadí příjmu po RTT; PUBLISH i PUBACK se dají ztrácet. Tap čte proud
+// po bajtech jako PubSubClient a vytahuje z něj PUBACK pro outbox.
+
+#include <Client.h>
+#include <unity.h>
+
+#include <stdio.h>
+
+#include <deque>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "MqttClientTap.h"
+#include "MqttOutbox.h"
+#include "SampleLatency.h"
+
+namespace {
+struct Received {
+  uint16_t packetId;
+  bool dup;
+  bool retain;
+  std::string topic;
+  std::string payload;
+};
+
+// Broker za linkou: odchozí pakety parsuje, příchozí bajty vydává, až uplyne RTT
+class FakeBroker : public Client {
+ public:
+  uint32_t rttMs = 50;
+  uint32_t publishLossPermille = 0;  // PUBLISH se k brokeru nedostane
+  uint32_t pubackLossPermille = 0;   // PUBACK se nevrátí
+  std::mt19937 rng{1};
+  std::vector<Received> received;
+  std::vector<std::vector<uint8_t>> packets;  // odchozí pakety tak, jak přišly
+
+  void tick(uint32_t now) {
+    now_ = now;
+    while (!inbound_.empty() && (int32_t)(now - inbound_.front().first) >= 0) {
+      readable_.insert(readable_.end(), inbound_.front().second.begin(), inbound_.front().second.end());
+      inbound_.pop_front();
+    }
+  }
+
+  // Bajty od brokeru hned k přečtení (CONNACK, SUBACK, příchozí PUBLISH)
+  void inject(const std::vector<uint8_t>& bytes) { readable_.insert(readable_.end(), bytes.begin(), bytes.end()); }
+
+  int connect(IPAddress, uint16_t) override { return 1; }
+  int connect(const char*, uint16_t) override { return 1; }
+  size_t write(uint8_t b) override { return write(&b, 1); }
+  size_t write(const uint8_t* buf, size_t size) override {
+    packets.emplace_back(buf, buf + size);
+    if (lost(publishLossPermille)) return size;
+    Received r;
+    size_t i = 1;
+    uint32_t remaining = 0, multiplier = 1;
+    do {
+      remaining += (buf[i] & 0x7F) * multiplier;
+      multiplier *= 128;
+    } while (buf[i++] & 0x80);
+    TEST_ASSERT_EQUAL(size, i + remaining);
+    uint16_t topicLength = (buf[i] << 8) | buf[i + 1];
+    i += 2;
+    r.topic.assign((const char*)buf + i, topicLength);
+    i += topicLength;
+    r.packetId = (buf[i] << 8) | buf[i + 1];
+    i += 2;
+    r.payload.assign((const char*)buf + i, size - i);
+    r.dup = buf[0] & 0x08;
+    r.retain = buf[0] & 0x01;
+    received.push_back(r);
+    if (!lost(pubackLossPermille)) {
+      inbound_.push_back({now_ + rttMs, {0x40, 0x02, (uint8_t)(r.packetId >> 8), (uint8_t)(r.packetId & 0xFF)}});
+    }
+    return size;
+  }
+  int available() override { return (int)readable_.size(); }
+  int read() override {
+    if (readable_.empty()) return -1;
+    uint8_t b = readable_.front();
+    readable_.pop_front();
+    return b;
+  }
+  int read(uint8_t* buf, size_t size) override {
+    size_t n = 0;
+    while (n < size && !readable_.empty()) buf[n++] = (uint8_t)read();
+    return (int)n;
+  }
+  int peek() override { return readable_.empty() ? -1 : readable_.front(); }
+  void flush() override {}
+  void stop() override {
+    inbound_.clear();
+    readable_.clear();
+  }
+  uint8_t connected() override { return 1; }
+  operator bool() override { return true; }
+
+ private:
+  bool lost(uint32_t permille) { return permille && rng() % 1000 < permille; }
+
+  uint32_t now_ = 0;
+  std::deque<std::pair<uint32_t, std::vector<uint8_t>>> inbound_;
+  std::deque<uint8_t> readable_;
+};
+
+// Zapojení jako v main.cpp: PubSubClient čte přes tap, outbox zapisuje přes tap
+struct Link {
+  FakeBroker broker;
+  MqttClientTap tap{broker};
+  MqttOutbox outbox;
+  uint32_t now = 0;
+
+  Link() {
+    tap.onPuback([this](uint16_t packetId) { outbox.onPuback(packetId, now); });
+    outbox.begin([this](const uint8_t* data, size_t length) { return tap.write(data, length) == length; });
+  }
+
+  void step(uint32_t ms) {
+    now += ms;
+    broker.tick(now);
+    while (tap.available() > 0) tap.read();
+    outbox.process(now, true);
+  }
+
+  bool publish(const char* payload, uint32_t sequence = 0, uint32_t sampleAt = 0) {
+    return outbox.publish("sharp/sensor", (const uint8_t*)payload, strlen(payload), true, sequence, sampleAt);
+  }
+};
+
+// Příchozí proud s rámci, které PUBACK jen připomínají, a dvěma skutečnými
+std::vector<uint8_t> mixedStream() {
+  std::vector<uint8_t> s = {0x20, 0x02, 0x00, 0x00};  // CONNACK
+  // PUBLISH QoS 0 se 200 B payloadem (dvoubajtová délka), uvnitř bajty jako PUBACK
+  s.push_back(0x30);
+  s.push_back(0xCE);  // 2 + 4 + 200 = 206
+  s.push_back(0x01);
+  s.insert(s.end(), {0x00, 0x04, 'c', 'm', 'd', 's'});
+  for (int i = 0; i < 50; i++) s.insert(s.end(), {0x40, 0x02, 0x80, 0x09});
+  s.insert(s.end(), {0x40, 0x02, 0x80, 0x05});        // PUBACK
+  s.insert(s.end(), {0x90, 0x03, 0x00, 0x01, 0x00});  // SUBACK
+  s.insert(s.end(), {0xD0, 0x00});                    // PINGRESP
+  s.insert(s.end(), {0x40, 0x02, 0x80, 0x06});        // PUBACK
+  return s;
+}
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_tap_extracts_puback_from_mixed_stream() {
+  FakeBroker broker;
+  MqttClientTap tap(broker);
+  std::vector<uint16_t> acks;
+  tap.onPuback([&](uint16_t packetId) { acks.push_back(packetId); });
+
+  // Po bajtech jako PubSubClient::readByte()
+  broker.inject(mixedStream());
+  while (tap.available() > 0) tap.read();
+  TEST_ASSERT_EQUAL(2, acks.size());
+  TEST_ASSERT_EQUAL_HEX16(0x8005, acks[0]);
+  TEST_ASSERT_EQUAL_HEX16(0x8006, acks[1]);
+
+  // Po kusech, které dělí rámce kdekoli
+  acks.clear();
+  broker.inject(mixedStream());
+  uint8_t buf[7];
+  while (tap.available() > 0) tap.read(buf, sizeof(buf));
+  TEST_ASSERT_EQUAL(2, acks.size());
+  TEST_ASSERT_EQUAL_HEX16(0x8006, acks[1]);
+
+  // Nové spojení uprostřed rámce začne parsovat od hlavičky
+  acks.clear();
+  broker.inject({0x30, 0x10, 0x00, 0x04});
+  while (tap.available() > 0) tap.read();
+  tap.connect("broker", 1883);
+  broker.inject({0x40, 0x02, 0x80, 0x07});
+  while (tap.available() > 0) tap.read();
+  TEST_ASSERT_EQUAL(1, acks.size());
+  TEST_ASSERT_EQUAL_HEX16(0x8007, acks[0]);
+}
+
+void test_outbox_encodes_publish_and_resends_with_dup() {
+  Link link;
+  link.broker.rttMs = 100000;  // PUBACK nepřijde
+  TEST_ASSERT_TRUE(link.publish("{}"));
+  link.step(10);
+
+  const uint8_t expected[] = {0x33, 0x12, 0x00, 0x0C, 's', 'h', 'a', 'r', 'p', '/', 's', 'e',
+                              'n', 's', 'o', 'r', 0x80, 0x01, '{', '}'};
+  TEST_ASSERT_EQUAL(1, link.broker.packets.size());
+  TEST_ASSERT_EQUAL(sizeof(expected), link.broker.packets[0].size());
+  TEST_ASSERT_EQUAL_MEMORY(expected, link.broker.packets[0].data(), sizeof(expected));
+
+  // Reconnect: nepotvrzená zpráva jde znovu se stejným id a DUP
+  link.outbox.onConnected();
+  link.step(10);
+  TEST_ASSERT_EQUAL(2, link.broker.received.size());
+  TEST_ASSERT_TRUE(link.broker.received[1].dup);
+  TEST_ASSERT_TRUE(link.broker.received[1].retain);
+  TEST_ASSERT_EQUAL_HEX16(0x8001, link.broker.received[1].packetId);
+  TEST_ASSERT_EQUAL(1, link.outbox.getStats().retransmits);
+}
+
+void test_window_limits_messages_in_flight() {
+  Link link;
+  link.broker.rttMs = 100000;
+  for (int i = 0; i < 20; i++) TEST_ASSERT_TRUE(link.publish("{\"co2\":800}"));
+  link.step(10);
+  MqttOutboxStats stats = link.outbox.getStats();
+  TEST_ASSERT_EQUAL(MqttOutbox::WINDOW, link.broker.received.size());
+  TEST_ASSERT_EQUAL(MqttOutbox::WINDOW, stats.inFlight);
+  TEST_ASSERT_EQUAL(20 - MqttOutbox::WINDOW, stats.queued);
+
+  // Plná fronta a příliš velká zpráva se zahodí
+  for (int i = 20; i < MqttOutbox::MAX_MESSAGES; i++) TEST_ASSERT_TRUE(link.publish("{}"));
+  TEST_ASSERT_FALSE(link.publish("{}"));
+  std::string big(MqttOutbox::BUFFER_BYTES, 'x');
+  TEST_ASSERT_FALSE(link.publish(big.c_str()));
+  TEST_ASSERT_EQUAL(2, link.outbox.getStats().dropped);
+}
+
+void test_pipelining_keeps_window_full() {
+  Link link;
+  link.broker.rttMs = 50;
+  uint32_t produced = 0;
+  char payload[24];
+  for (int i = 0; i < 1000; i++) {  // 10 s po 10 ms
+    while (link.outbox.getStats().queued < 4) {
+      snprintf(payload, sizeof(payload), "{\"n\":%lu}", (unsigned long)produced++);
+      link.publish(payload);
+    }
+    link.step(10);
+  }
+  MqttOutboxStats stats = link.outbox.getStats();
+  char info[96];
+  snprintf(info, sizeof(info), "RTT 50 ms: %lu zprav/s (jedna po druhe by bylo 20/s)",
+           (unsigned long)(stats.delivered / 10));
+  TEST_MESSAGE(info);
+  TEST_ASSERT_GREATER_THAN(1300, stats.delivered);  // ~8 zpráv za RTT + krok smyčky
+  TEST_ASSERT_EQUAL(0, stats.retransmits);
+  TEST_ASSERT_UINT32_WITHIN(20, 60, stats.srttMs);
+}
+
+void test_lossy_link_delivers_every_message() {
+  Link link;
+  link.broker.rttMs = 80;
+  link.broker.publishLossPermille = 200;
+  link.broker.pubackLossPermille = 100;
+  const uint32_t MESSAGES = 300;
+  uint32_t produced = 0;
+  char payload[24];
+  for (uint32_t i = 0; i < 60000 && !(produced == MESSAGES && link.outbox.idle()); i++) {
+    if (produced < MESSAGES && i % 10 == 0) {  // 10 zpráv/s
+      snprintf(payload, sizeof(payload), "{\"n\":%lu}", (unsigned long)produced);
+      if (link.publish(payload)) produced++;
+    }
+    link.step(10);
+  }
+
+  MqttOutboxStats stats = link.outbox.getStats();
+  std::set<std::string> unique;
+  uint32_t duplicates = 0;
+  for (const Received& r : link.broker.received) {
+    if (!unique.insert(r.payload).second) {
+      duplicates++;
+      TEST_ASSERT_TRUE_MESSAGE(r.dup, "opakovani bez DUP");
+    }
+  }
+  char info[128];
+  snprintf(info, sizeof(info), "%lu zprav: %lu opakovani (%lu rychlych), %lu duplikatu u brokeru, PUBACK max %lu ms",
+           (unsigned long)MESSAGES, (unsigned long)stats.retransmits, (unsigned long)stats.fastRetransmits,
+           (unsigned long)duplicates, (unsigned long)stats.ackMaxMs);
+  TEST_MESSAGE(info);
+  TEST_ASSERT_TRUE(link.outbox.idle());
+  TEST_ASSERT_EQUAL(MESSAGES, stats.accepted);
+  TEST_ASSERT_EQUAL(MESSAGES, stats.delivered);
+  TEST_ASSERT_EQUAL(0, stats.dropped);
+  TEST_ASSERT_EQUAL(MESSAGES, unique.size());
+  TEST_ASSERT_GREATER_THAN(0, stats.retransmits);
+  TEST_ASSERT_GREATER_THAN(0, stats.fastRetransmits);
+  TEST_ASSERT_GREATER_THAN(0, duplicates);  // ztracený PUBACK = broker má zprávu dvakrát
+}
+
+void test_delivery_latency_is_taken_at_puback() {
+  Link link;
+  LatencyTracker latency;
+  std::vector<std::pair<uint32_t, uint32_t>> delivered;
+  link.outbox.onDelivered([&](uint32_t sequence, uint32_t ageMs) {
+    delivered.push_back({sequence, ageMs});
+    latency.record(LAT_MQTT, sequence, ageMs);
+  });
+  link.broker.rttMs = 300;
+
+  // Vzorek přečtený v 1000 ms, zařazený ve 1200 ms: stáří až při PUBACK
+  link.step(1190);
+  TEST_ASSERT_TRUE(link.publish("{\"seq\":7}", 7, 1000));
+  TEST_ASSERT_TRUE(link.publish("{\"state\":1}"));  // stavový topic bez vzorku
+  link.step(10);
+  TEST_ASSERT_EQUAL(0, delivered.size());  // zařazení ani odeslání se nepočítá
+  TEST_ASSERT_EQUAL(0, latency.histogram(LAT_MQTT).deliveries);
+  for (int i = 0; i < 40; i++) link.step(10);
+  TEST_ASSERT_EQUAL(1, delivered.size());
+  TEST_ASSERT_EQUAL(7, delivered[0].first);
+  TEST_ASSERT_EQUAL(500, delivered[0].second);  // 1500 ms PUBACK - 1000 ms přečtení
+
+  // Ztracený první PUBLISH: stáří zahrne i opakování po RTO
+  link.broker.publishLossPermille = 1000;
+  TEST_ASSERT_TRUE(link.publish("{\"seq\":8}", 8, link.now));
+  link.step(10);
+  link.broker.publishLossPermille = 0;
+  uint32_t sentAt = link.now;
+  while (delivered.size() < 2 && link.now - sentAt < 60000) link.step(10);
+  TEST_ASSERT_EQUAL(2, delivered.size());
+  TEST_ASSERT_EQUAL(8, delivered[1].first);
+  TEST_ASSERT_GREATER_OR_EQUAL(link.outbox.getStats().rtoMs, delivered[1].second);
+  TEST_ASSERT_EQUAL(2, latency.histogram(LAT_MQTT).deliveries);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_tap_extracts_puback_from_mixed_stream);
+  RUN_TEST(test_outbox_encodes_publish_and_resends_with_dup);
+  RUN_TEST(test_window_limits_messages_in_flight);
+  RUN_TEST(test_pipelining_keeps_window_full);
+  RUN_TEST(test_lossy_link_delivers_every_message);
+  RUN_TEST(test_delivery_latency_is_taken_at_puback);
+  return UNITY_END();
+}
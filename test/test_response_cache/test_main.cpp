@@ -0,0 +1,201 @@
+// ResponseCache: verze, ETag a odmítnutí těla, které se do bufferu nevejde.
+// Na konci měření propustnosti /api/data s 1, 5 a 20 pollery ve skutečných
+// vláknech: sestavení při každém dotazu proti cache bez a s If-None-Match.
+
+#include <unity.h>
+
+#include <stdio.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ResponseCache.h"
+
+namespace {
+ResponseCache cache;
+
+constexpr uint32_t REQUESTS = 200000;
+constexpr uint32_t REQUESTS_PER_SAMPLE = 100;  // nový vzorek po tolika dotazech (poller 1 s, vzorek 2 s, 50 pollerů)
+
+enum PollMode { POLL_REBUILD = 0, POLL_CACHED, POLL_CONDITIONAL };
+
+struct PollResult {
+  double requestsPerSecond = 0;
+  uint32_t full = 0;         // 200 s tělem
+  uint32_t notModified = 0;  // 304
+  ResponseCacheStats stats;
+};
+
+// Tělo jako z handleApiData(): stav spojení, vzorek a hodnoty kanálů (~600 B)
+size_t buildData(uint32_t sequence, char* out, size_t size) {
+  return snprintf(out, size,
+                  "{\"wifi\":\"connected\",\"mqtt\":\"connected\",\"valid\":true,\"uptime\":%lu,\"seq\":%lu,"
+                  "\"sampleAgeMs\":%lu,\"sampleTs\":%llu,\"tmepUrl\":\"http://xyz.tmep.cz/?temp=%.1f&humV=%.1f&"
+                  "pm25=%.1f&co2=%u\",\"tmepStatus\":\"200\",\"wifiMode\":\"STA\",\"apSsid\":\"\",\"apIp\":\"\","
+                  "\"currentSsid\":\"domaci-sit\",\"currentIp\":\"192.168.1.57\",\"rssi\":-61,"
+                  "\"wifiConnectMs\":412,\"wifiFastConnect\":true,\"values\":{\"temperature\":%.1f,"
+                  "\"humidity\":%.1f,\"pm1\":%.1f,\"pm25\":%.1f,\"pm4\":%.1f,\"pm10\":%.1f,\"voc\":%u,"
+                  "\"nox\":%u,\"co2\":%u,\"aqi\":%u,\"aqi_24h\":%u}}",
+                  (unsigned long)(sequence * 2), (unsigned long)sequence, (unsigned long)(sequence % 2000),
+                  1760000000000ULL + sequence * 2000ULL, 21.0 + (sequence % 50) * 0.1, 40.0 + (sequence % 30) * 0.1,
+                  (sequence % 300) * 0.1, 400 + sequence % 1500, 21.0 + (sequence % 50) * 0.1,
+                  40.0 + (sequence % 30) * 0.1, (sequence % 200) * 0.1, (sequence % 300) * 0.1,
+                  (sequence % 350) * 0.1, (sequence % 400) * 0.1, 100 + sequence % 300, 1 + sequence % 20,
+                  400 + sequence % 1500, 1 + sequence % 5, 1 + sequence % 5);
+}
+
+// Pollery jako tasky serveru: handler drží zámek stavu, zápis těla do
+// socketu (tady jen kopie do String) běží už bez něj
+PollResult poll(uint8_t pollers, PollMode mode) {
+  cache = ResponseCache();
+  std::mutex stateLock;
+  uint32_t sequence = 1;
+  uint32_t served = 0;
+  std::atomic<uint32_t> full(0);
+  std::atomic<uint32_t> notModified(0);
+  std::atomic<size_t> sink(0);
+
+  auto poller = [&](uint32_t requests) {
+    std::string etag;  // klient si pamatuje ETag poslední odpovědi 200
+    char payload[ResponseCache::MAX_BODY];
+    for (uint32_t r = 0; r < requests; r++) {
+      String ifNoneMatch(mode == POLL_CONDITIONAL ? etag.c_str() : "");
+      String body;
+      bool unchanged = false;
+      {
+        std::lock_guard<std::mutex> lock(stateLock);
+        if (++served % REQUESTS_PER_SAMPLE == 0) sequence++;
+        if (mode == POLL_REBUILD) {
+          size_t length = buildData(sequence, payload, sizeof(payload));
+          body = String(std::string(payload, length));
+        } else {
+          if (cache.isFresh(sequence)) {
+            cache.countHit();
+          } else {
+            size_t length = buildData(sequence, payload, sizeof(payload));
+            TEST_ASSERT_TRUE(cache.store(sequence, payload, length, 0));
+          }
+          unchanged = cache.matches(ifNoneMatch);
+          if (unchanged) {
+            cache.countNotModified();
+          } else {
+            body = cache.body();
+            etag = cache.etag();
+          }
+        }
+      }
+      if (unchanged) {
+        notModified++;
+      } else {
+        full++;
+        sink += body.length();
+      }
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (uint8_t i = 0; i < pollers; i++) threads.emplace_back(poller, REQUESTS / pollers);
+  for (std::thread& t : threads) t.join();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  PollResult result;
+  uint32_t requests = REQUESTS / pollers * pollers;
+  result.requestsPerSecond = requests / seconds;
+  result.full = full;
+  result.notModified = notModified;
+  result.stats = cache.getStats();
+  TEST_ASSERT_EQUAL(requests, result.full + result.notModified);
+  TEST_ASSERT_GREATER_THAN(0, sink.load());
+  return result;
+}
+}  // namespace
+
+void setUp() { cache = ResponseCache(); }
+
+void tearDown() {}
+
+void test_store_keeps_body_and_version() {
+  const char* body = "{\"valid\":true}";
+  TEST_ASSERT_TRUE(cache.store(7, body, strlen(body), 120));
+  TEST_ASSERT_TRUE(cache.isFresh(7));
+  TEST_ASSERT_FALSE(cache.isFresh(8));
+  TEST_ASSERT_EQUAL_STRING(body, cache.body());
+  TEST_ASSERT_EQUAL(strlen(body), cache.length());
+  TEST_ASSERT_EQUAL(1, cache.getStats().misses);
+  TEST_ASSERT_EQUAL(120, cache.getStats().buildAvgUs);
+}
+
+void test_etag_depends_on_content_only() {
+  cache.store(1, "{\"a\":1}", 7, 0);
+  std::string first = cache.etag();
+  cache.store(2, "{\"a\":1}", 7, 0);
+  TEST_ASSERT_EQUAL_STRING(first.c_str(), cache.etag());
+  cache.store(3, "{\"a\":2}", 7, 0);
+  TEST_ASSERT_TRUE(first != cache.etag());
+}
+
+void test_if_none_match() {
+  cache.store(1, "{}", 2, 0);
+  TEST_ASSERT_TRUE(cache.matches(cache.etag()));
+  TEST_ASSERT_TRUE(cache.matches((std::string("W/\"x\", ") + cache.etag()).c_str()));
+  TEST_ASSERT_TRUE(cache.matches("*"));
+  TEST_ASSERT_FALSE(cache.matches(""));
+  TEST_ASSERT_FALSE(cache.matches("\"00000000-0\""));
+}
+
+void test_oversized_body_is_rejected_and_invalidates() {
+  cache.store(1, "{}", 2, 0);
+  std::string etag = cache.etag();
+
+  std::string big(ResponseCache::MAX_BODY, 'x');
+  TEST_ASSERT_FALSE(cache.store(2, big.c_str(), big.size(), 0));
+  TEST_ASSERT_FALSE(cache.isFresh(2));
+  TEST_ASSERT_FALSE(cache.isFresh(1));
+  TEST_ASSERT_FALSE(cache.matches(etag.c_str()));  // starý ETag už nesmí dát 304
+  TEST_ASSERT_EQUAL(1, cache.getStats().oversized);
+  TEST_ASSERT_EQUAL(1, cache.getStats().misses);
+
+  // Největší tělo, které se vejde (s ukončovací nulou)
+  TEST_ASSERT_TRUE(cache.store(3, big.c_str(), ResponseCache::MAX_BODY - 1, 0));
+  TEST_ASSERT_EQUAL(ResponseCache::MAX_BODY - 1, strlen(cache.body()));
+}
+
+void test_pollers_throughput_with_and_without_if_none_match() {
+  const uint8_t pollerCounts[] = {1, 5, 20};
+  for (uint8_t pollers : pollerCounts) {
+    PollResult rebuild = poll(pollers, POLL_REBUILD);
+    PollResult cached = poll(pollers, POLL_CACHED);
+    PollResult conditional = poll(pollers, POLL_CONDITIONAL);
+    uint32_t requests = REQUESTS / pollers * pollers;
+
+    // Sestavuje se jen jednou za vzorek, ostatní dotazy jdou z bufferu
+    TEST_ASSERT_EQUAL(requests, cached.stats.hits + cached.stats.misses);
+    TEST_ASSERT_LESS_OR_EQUAL(requests / REQUESTS_PER_SAMPLE + 1, cached.stats.misses);
+    TEST_ASSERT_EQUAL(0, cached.notModified);
+    // S If-None-Match dostane každý poller celé tělo jen jednou za vzorek
+    TEST_ASSERT_EQUAL(conditional.notModified, conditional.stats.notModified);
+    TEST_ASSERT_LESS_OR_EQUAL(conditional.stats.misses * pollers, conditional.full);
+
+    char info[128];
+    snprintf(info, sizeof(info), "vlakna %2u: sestaveni %.0f/s, cache %.0f/s, cache + If-None-Match %.0f/s (%lu x 304)",
+             pollers, rebuild.requestsPerSecond, cached.requestsPerSecond, conditional.requestsPerSecond,
+             (unsigned long)conditional.notModified);
+    TEST_MESSAGE(info);
+    if (pollers == 1) TEST_ASSERT_GREATER_THAN(rebuild.requestsPerSecond, cached.requestsPerSecond);
+  }
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_store_keeps_body_and_version);
+  RUN_TEST(test_etag_depends_on_content_only);
+  RUN_TEST(test_if_none_match);
+  RUN_TEST(test_oversized_body_is_rejected_and_invalidates);
+  RUN_TEST(test_pollers_throughput_with_and_without_if_none_match);
+  return UNITY_END();
+}
@@ -0,0 +1,294 @@
+// SampleLog na souborovém systému hostitele: zápis a čtení přes bloky a
+// segmenty a dotaz, během kterého loop() připisuje vzorky a maže nejstarší
+// segmenty (web server během odesílání pouští zámek stavu). Na konci týden
+// vzorků SEN66 po 10 s z referenčních stop: bajty na vzorek, čas zápisu
+// a dotazů a rozpočet 1 MB.
+
+#include <FS.h>
+#include <FakeSensor.h>
+#include <unity.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <vector>
+
+#include "SampleLog.h"
+#include "SensorTrace.h"
+
+namespace {
+const uint32_t T0 = 1700000000;
+const uint32_t SEGMENT_BYTES = 32 * 1024;
+
+std::string root;
+FakeSensor sensor("SEN66", {CH_TEMPERATURE, CH_HUMIDITY, CH_PM25, CH_VOC, CH_CO2});
+SensorRegistry registry;
+
+// Hodnota kanálu c vzorku n - kvantovaná na přesnost logu, ať jde porovnat přesně
+float valueAt(uint32_t n, uint8_t c) {
+  switch (c) {
+    case 0: return (float)(200 + (n * 7) % 50) / 10.0f;
+    case 1: return (float)(400 + (n * 13) % 300) / 10.0f;
+    case 2: return (float)((n * 37) % 900);
+    case 3: return (float)(50 + (n * 11) % 400);
+    default: return (float)(400 + (n * 101) % 4000);
+  }
+}
+
+void appendSamples(SampleLog& log, uint32_t first, uint32_t count) {
+  SensorSample sample;
+  sample.validMask = 0x1F;
+  for (uint32_t n = first; n < first + count; n++) {
+    for (uint8_t c = 0; c < 5; c++) sample.values[c] = valueAt(n, c);
+    TEST_ASSERT_TRUE(log.append(T0 + n * 10, registry, sample));
+  }
+}
+
+struct Visited {
+  std::vector<uint32_t> timestamps;
+  bool ordered = true;
+  bool valuesMatch = true;
+};
+
+void record(Visited& v, const LoggedSample& sample) {
+  if (!v.timestamps.empty() && sample.timestamp <= v.timestamps.back()) v.ordered = false;
+  v.timestamps.push_back(sample.timestamp);
+  uint32_t n = (sample.timestamp - T0) / 10;
+  for (uint8_t c = 0; c < 5; c++) {
+    if (fabsf(sample.values[c] - valueAt(n, c)) > 0.01f) v.valuesMatch = false;
+  }
+}
+
+// Čtení SEN66 ze stop v traces/ za sebou (bez záznamů s chybou) jako
+// kanály v pořadí ovladače; NaN a 0xFFFF u CO2 = neplatný kanál
+std::vector<SensorSample> traceSamples() {
+  std::vector<SensorSample> samples;
+  for (const char* name : {"traces/cooking.bin", "traces/window.bin", "traces/fault.bin"}) {
+    FILE* f = fopen(name, "rb");
+    TEST_ASSERT_NOT_NULL_MESSAGE(f, name);
+    uint8_t buf[SensorTrace::RECORD_BYTES];
+    fseek(f, 16, SEEK_SET);  // hlavička stopy
+    while (fread(buf, 1, sizeof(buf), f) == sizeof(buf)) {
+      SensorTraceRecord rec;
+      SensorTrace::decodeRecord(buf, rec);
+      if (rec.error) continue;
+      SensorSample sample;
+      const float values[] = {rec.temp, rec.hum, rec.pm1, rec.pm25, rec.pm4, rec.pm10, rec.voc, rec.nox,
+                              rec.co2 == 0xFFFF ? NAN : (float)rec.co2};
+      for (uint8_t c = 0; c < 9; c++) {
+        sample.values[c] = values[c];
+        if (!isnan(values[c])) sample.validMask |= 1UL << c;
+      }
+      samples.push_back(sample);
+    }
+    fclose(f);
+  }
+  return samples;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point since) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+fs::FS freshFs() {
+  char tmpl[] = "/tmp/samplelogXXXXXX";
+  root = mkdtemp(tmpl);
+  return fs::FS(root);
+}
+}  // namespace
+
+void setUp() {
+  host::resetClock();
+  static bool registryReady = false;
+  if (!registryReady) {
+    registry.add(&sensor, I2cBus());
+    registry.begin();
+    registryReady = true;
+  }
+}
+
+void tearDown() {
+  std::string cmd = "rm -rf " + root;
+  TEST_ASSERT_EQUAL(0, system(cmd.c_str()));
+}
+
+void test_round_trip_across_blocks_and_ram_tail() {
+  fs::FS fs = freshFs();
+  SampleLog log;
+  TEST_ASSERT_TRUE(log.begin(fs, 4 * SEGMENT_BYTES));
+  appendSamples(log, 0, 95);  // 3 plné bloky na flash, 5 vzorků v RAM
+
+  Visited v;
+  size_t n = log.query(0, UINT32_MAX, [&](const LoggedSample& s) {
+    record(v, s);
+    return true;
+  });
+  TEST_ASSERT_EQUAL(95, n);
+  TEST_ASSERT_EQUAL(95, v.timestamps.size());
+  TEST_ASSERT_TRUE(v.ordered);
+  TEST_ASSERT_TRUE(v.valuesMatch);
+
+  // Rozsah uprostřed bloku
+  v = Visited();
+  log.query(T0 + 400, T0 + 700, [&](const LoggedSample& s) {
+    record(v, s);
+    return true;
+  });
+  TEST_ASSERT_EQUAL(31, v.timestamps.size());
+  TEST_ASSERT_EQUAL(T0 + 400, v.timestamps.front());
+}
+
+void test_reopen_keeps_flushed_blocks() {
+  fs::FS fs = freshFs();
+  {
+    SampleLog log;
+    log.begin(fs, 4 * SEGMENT_BYTES);
+    appendSamples(log, 0, 65);
+    log.flush();
+  }
+  SampleLog log;
+  TEST_ASSERT_TRUE(log.begin(fs, 4 * SEGMENT_BYTES));
+  appendSamples(log, 65, 10);
+
+  Visited v;
+  log.query(0, UINT32_MAX, [&](const LoggedSample& s) {
+    record(v, s);
+    return true;
+  });
+  TEST_ASSERT_EQUAL(75, v.timestamps.size());
+  TEST_ASSERT_TRUE(v.ordered);
+}
+
+void test_appends_and_flushes_during_query_are_not_visited_twice() {
+  fs::FS fs = freshFs();
+  SampleLog log;
+  log.begin(fs, 4 * SEGMENT_BYTES);
+  appendSamples(log, 0, 50);  // 1 blok na flash, 20 vzorků v RAM
+
+  Visited v;
+  uint32_t appended = 50;
+  log.query(0, UINT32_MAX, [&](const LoggedSample& s) {
+    record(v, s);
+    // loop() mezitím dopíše blok z RAM a začne další
+    appendSamples(log, appended, 15);
+    appended += 15;
+    return true;
+  });
+  TEST_ASSERT_EQUAL(50, v.timestamps.size());
+  TEST_ASSERT_TRUE(v.ordered);
+  TEST_ASSERT_TRUE(v.valuesMatch);
+
+  // Další dotaz vidí všechno
+  v = Visited();
+  log.query(0, UINT32_MAX, [&](const LoggedSample& s) {
+    record(v, s);
+    return true;
+  });
+  TEST_ASSERT_EQUAL(appended, v.timestamps.size());
+  TEST_ASSERT_TRUE(v.ordered);
+  TEST_ASSERT_TRUE(v.valuesMatch);
+}
+
+void test_segment_removed_during_query_is_skipped() {
+  fs::FS fs = freshFs();
+  SampleLog log;
+  log.begin(fs, 2 * SEGMENT_BYTES);
+  uint32_t appended = 0;
+  while (log.getStats().segments < 2) {
+    appendSamples(log, appended, 30);
+    appended += 30;
+  }
+
+  Visited v;
+  bool rolled = false;
+  log.query(0, UINT32_MAX, [&](const LoggedSample& s) {
+    record(v, s);
+    if (!rolled) {
+      // Rozpočet dva segmenty: zaplnění dalšího smaže ten, který se právě čte
+      uint32_t before = log.getStats().bytesOnFlash;
+      while (log.getStats().bytesOnFlash >= before) {
+        appendSamples(log, appended, 30);
+        appended += 30;
+      }
+      rolled = true;
+    }
+    return true;
+  });
+  TEST_ASSERT_TRUE(rolled);
+  TEST_ASSERT_TRUE(v.ordered);
+  TEST_ASSERT_TRUE(v.valuesMatch);
+  TEST_ASSERT_LESS_THAN(appended, v.timestamps.size());
+  TEST_ASSERT_EQUAL(2, log.getStats().segments);
+}
+
+void test_week_of_sen66_samples_fits_budget() {
+  FakeSensor sen66("SEN66", {CH_TEMPERATURE, CH_HUMIDITY, CH_PM1, CH_PM25, CH_PM4, CH_PM10, CH_VOC, CH_NOX, CH_CO2});
+  SensorRegistry sensors;
+  sensors.add(&sen66, I2cBus());
+  sensors.begin();
+
+  // Stopy jsou čtené po 2 s: jako vzorky po 10 s se hodnoty mění rychleji
+  // než ve skutečnosti, takže odhad velikosti je spíš horní
+  std::vector<SensorSample> trace = traceSamples();
+  TEST_ASSERT_GREATER_THAN(3000, trace.size());
+  const uint32_t WEEK = 7 * 24 * 360;
+  const uint32_t BUDGET = 1024 * 1024;
+
+  fs::FS fs = freshFs();
+  SampleLog log;
+  TEST_ASSERT_TRUE(log.begin(fs, BUDGET));
+  auto started = std::chrono::steady_clock::now();
+  for (uint32_t n = 0; n < WEEK; n++) {
+    TEST_ASSERT_TRUE(log.append(T0 + n * 10, sensors, trace[n % trace.size()]));
+  }
+  log.flush();
+  double appendMs = elapsedMs(started);
+  SampleLogStats stats = log.getStats();
+
+  // Celý týden se vejde do rozpočtu - nic se nesmazalo
+  TEST_ASSERT_LESS_OR_EQUAL(BUDGET, stats.bytesOnFlash);
+  uint32_t mismatches = 0;
+  started = std::chrono::steady_clock::now();
+  size_t weekSamples = log.query(0, UINT32_MAX, [&](const LoggedSample& s) {
+    const SensorSample& in = trace[((s.timestamp - T0) / 10) % trace.size()];
+    uint32_t loggedMask = 0;  // maska logu má první kanál v nejvyšším bitu
+    for (uint8_t c = 0; c < 9; c++) {
+      if (in.isValid(c)) loggedMask |= 1UL << (8 - c);
+    }
+    if (s.validMask != loggedMask) mismatches++;
+    for (uint8_t c = 0; c < 9; c++) {
+      if (!in.isValid(c)) continue;
+      float step = channelKindInfo((ChannelKind)s.kinds[c]).decimals == 1 ? 0.1f : 1.0f;
+      if (fabsf(s.values[c] - in.values[c]) > step * 0.51f) mismatches++;
+    }
+    return true;
+  });
+  double weekQueryMs = elapsedMs(started);
+  TEST_ASSERT_EQUAL(WEEK, weekSamples);
+  TEST_ASSERT_EQUAL(0, mismatches);
+
+  started = std::chrono::steady_clock::now();
+  uint32_t dayFrom = T0 + (WEEK - 8640) * 10;
+  size_t daySamples = log.query(dayFrom, UINT32_MAX, [](const LoggedSample&) { return true; });
+  double dayQueryMs = elapsedMs(started);
+  TEST_ASSERT_EQUAL(8640, daySamples);
+
+  char info[200];
+  snprintf(info, sizeof(info),
+           "tyden %lu vzorku: %lu B na flash (%.1f B/vzorek, bez komprese %.1f), append %.2f us, "
+           "dotaz tyden %.0f ms, den %.0f ms",
+           (unsigned long)WEEK, (unsigned long)stats.bytesOnFlash, (double)stats.bytesOnFlash / WEEK,
+           (double)stats.rawBytesWritten / WEEK, appendMs * 1000 / WEEK, weekQueryMs, dayQueryMs);
+  TEST_MESSAGE(info);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip_across_blocks_and_ram_tail);
+  RUN_TEST(test_reopen_keeps_flushed_blocks);
+  RUN_TEST(test_appends_and_flushes_during_query_are_not_visited_twice);
+  RUN_TEST(test_segment_removed_during_query_is_skipped);
+  RUN_TEST(test_week_of_sen66_samples_fits_budget);
+  return UNITY_END();
+}
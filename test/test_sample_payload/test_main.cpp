@@ -0,0 +1,138 @@
+// SamplePayload: JSON senzorových dat a přechodu alarmu a URL pro TMEP
+// skládané do pevného bufferu - přesný text, escapování, přetečení bufferu
+// a nahrazení tokenů šablony jen platnými kanály.
+
+#include <FakeSensor.h>
+#include <unity.h>
+
+#include <string.h>
+
+#include <string>
+
+#include "SamplePayload.h"
+
+namespace {
+FakeSensor sen66("SEN66", {CH_TEMPERATURE, CH_HUMIDITY, CH_PM25, CH_VOC, CH_CO2});
+SensorRegistry sensors;
+SampleText text;
+
+SensorSample sampleWith(uint32_t validMask) {
+  SensorSample sample;
+  sample.sequence = 42;
+  sample.validMask = validMask;
+  const float values[] = {21.34f, 45.06f, 12.0f, 101.0f, 812.0f};
+  for (uint8_t i = 0; i < 5; i++) sample.values[i] = values[i];
+  text.update(sensors, sample);
+  return sample;
+}
+}  // namespace
+
+void setUp() {
+  static bool registryReady = false;
+  if (!registryReady) {
+    sensors.add(&sen66, I2cBus());
+    sensors.begin();
+    registryReady = true;
+  }
+  text = SampleText();
+}
+
+void tearDown() {}
+
+void test_sensor_json_with_channels_and_stamp() {
+  SensorSample sample = sampleWith(0x1F & ~(1UL << 3));  // VOC neplatné
+  sample.unixMs = 1760000000123ULL;
+  AirQualityIndex aq;
+  char out[512];
+  size_t length = buildSensorJson(sensors, sample, text, aq, 3600, 250, out, sizeof(out));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"temperature\":21.3,\"humidity\":45.1,\"pm25\":12.0,\"co2\":812,"
+      "\"uptime\":3600,\"seq\":42,\"ts\":1760000000123,\"age_ms\":250}",
+      out);
+  TEST_ASSERT_EQUAL(strlen(out), length);
+}
+
+void test_sensor_json_with_air_quality_replay_and_stale() {
+  SensorSample sample = sampleWith(0x1F);
+  sample.replayed = true;
+  sample.staleMask = (1UL << 2) | (1UL << 4);
+  AirQualityIndex aq;
+  aq.nowCastValid = true;
+  aq.pm25NowCast = 12.34f;
+  aq.aqiNowCast = 57;
+  aq.co2Valid = true;
+  aq.co2Mean = 799.6f;
+  aq.co2Index = 40;
+  aq.overall = 57;
+  aq.dominant = AQ_PM25;
+  char out[512];
+  TEST_ASSERT_GREATER_THAN(0, buildSensorJson(sensors, sample, text, aq, 7, 0, out, sizeof(out)));
+
+  std::string json(out);
+  std::string expectedAq = std::string("\"quality\":\"") + AirQualityEngine::categoryLabel(57) +
+                           "\",\"quality_pollutant\":\"" + AirQualityEngine::pollutantName(AQ_PM25) +
+                           "\",\"aqi\":57,\"aqi_nowcast\":57,\"pm25_nowcast\":12.3,\"co2_15m\":800,\"co2_aqi\":40,";
+  TEST_ASSERT_TRUE_MESSAGE(json.find(expectedAq) != std::string::npos, out);
+  TEST_ASSERT_TRUE(json.find("\"aqi_24h\"") == std::string::npos);  // okno bez dat se neposílá
+  TEST_ASSERT_TRUE(json.find("\"ts\"") == std::string::npos);       // hodiny nenastavené
+  TEST_ASSERT_TRUE(json.find(",\"replay\":true,\"stale\":[\"pm25\",\"co2\"]}") != std::string::npos);
+}
+
+void test_sensor_json_that_does_not_fit_returns_zero() {
+  SensorSample sample = sampleWith(0x1F);
+  AirQualityIndex aq;
+  char full[512];
+  size_t length = buildSensorJson(sensors, sample, text, aq, 1, 1, full, sizeof(full));
+  TEST_ASSERT_GREATER_THAN(0, length);
+
+  // Přesně na míru (text + nula) projde, o bajt méně ne
+  char out[512];
+  memset(out, 'x', sizeof(out));
+  TEST_ASSERT_EQUAL(length, buildSensorJson(sensors, sample, text, aq, 1, 1, out, length + 1));
+  TEST_ASSERT_EQUAL_STRING(full, out);
+  memset(out, 'x', sizeof(out));
+  TEST_ASSERT_EQUAL(0, buildSensorJson(sensors, sample, text, aq, 1, 1, out, length));
+  TEST_ASSERT_EQUAL('x', out[length]);  // za buffer se nepíše
+  TEST_ASSERT_EQUAL(0, buildSensorJson(sensors, sample, text, aq, 1, 1, out, 0));
+}
+
+void test_alarm_json_and_escaping() {
+  char out[128];
+  TEST_ASSERT_GREATER_THAN(0, buildAlarmJson("co2", true, 1234.56f, 1200, out, sizeof(out)));
+  TEST_ASSERT_EQUAL_STRING("{\"key\":\"co2\",\"state\":\"on\",\"value\":1234.6,\"threshold\":1200}", out);
+  TEST_ASSERT_GREATER_THAN(0, buildAlarmJson("pm25", false, 20.0f, 35.5f, out, sizeof(out)));
+  TEST_ASSERT_EQUAL_STRING("{\"key\":\"pm25\",\"state\":\"off\",\"value\":20.0,\"threshold\":35.5}", out);
+
+  JsonWriter json(out, sizeof(out));
+  json.string("t", "a\"b\\c\n");
+  json.beginArray("e");
+  json.endArray();
+  TEST_ASSERT_GREATER_THAN(0, json.finish());
+  TEST_ASSERT_EQUAL_STRING("{\"t\":\"a\\\"b\\\\c\\u000a\",\"e\":[]}", out);
+}
+
+void test_tmep_url_replaces_valid_channels_only() {
+  SensorSample sample = sampleWith(0x1F & ~(1UL << 1));  // vlhkost neplatná
+  TmepUrl url;
+  TEST_ASSERT_TRUE(buildTmepUrl("xyz", "tempV=*TEMP*&humV={HUM}&co2=*CO2*&x=*NEZNAMY*", sensors, sample, text, url));
+  TEST_ASSERT_EQUAL_STRING("http://xyz.tmep.cz/?tempV=21.3&humV={HUM}&co2=812&x=*NEZNAMY*", url.c_str());
+
+  TEST_ASSERT_FALSE(buildTmepUrl("", "tempV=*TEMP*", sensors, sample, text, url));
+  TEST_ASSERT_FALSE(buildTmepUrl("xyz", "tempV=*TEMP*", sensors, sampleWith(0), text, url));
+  TEST_ASSERT_TRUE(url.isEmpty());
+
+  // Delší než buffer URL: nic useknutého
+  std::string params(TmepUrl::capacity(), 'a');
+  TEST_ASSERT_FALSE(buildTmepUrl("xyz", params.c_str(), sensors, sample, text, url));
+  TEST_ASSERT_TRUE(url.isEmpty());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_sensor_json_with_channels_and_stamp);
+  RUN_TEST(test_sensor_json_with_air_quality_replay_and_stale);
+  RUN_TEST(test_sensor_json_that_does_not_fit_returns_zero);
+  RUN_TEST(test_alarm_json_and_escaping);
+  RUN_TEST(test_tmep_url_replaces_valid_channels_only);
+  return UNITY_END();
+}
@@ -0,0 +1,215 @@
+// formatFixed proti snprintf("%.*f"): vybrané hraniční hodnoty (přesné
+// půlky, záporné, -0, hranice 1e6 a cesta přes snprintf) a náhodné floaty
+// ve všech přesnostech. Na konci měření jednoho vzorku SEN66: dřívější
+// formátování každým odběratelem zvlášť proti jednomu průchodu SampleText.
+
+#include <FakeSensor.h>
+#include <unity.h>
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <random>
+
+#include "SampleText.h"
+
+namespace {
+FakeSensor sen66("SEN66", {CH_TEMPERATURE, CH_HUMIDITY, CH_PM1, CH_PM25, CH_PM4, CH_PM10, CH_VOC, CH_NOX, CH_CO2});
+SensorRegistry sensors;
+
+void assertLikeSnprintf(float value, uint8_t decimals, size_t size = 32) {
+  char expected[32];
+  char actual[32];
+  int n = snprintf(expected, size, "%.*f", decimals, value);
+  size_t length = formatFixed(value, decimals, actual, size);
+  char message[96];
+  snprintf(message, sizeof(message), "%.9g s %u mist (buffer %u)", value, decimals, (unsigned)size);
+  TEST_ASSERT_EQUAL_STRING_MESSAGE(expected, actual, message);
+  TEST_ASSERT_EQUAL_MESSAGE((size_t)n < size ? (size_t)n : size - 1, length, message);
+}
+
+void assertAllDecimals(float value) {
+  for (uint8_t d = 0; d <= 4; d++) assertLikeSnprintf(value, d);
+}
+
+// Vzorek n s hodnotami jako ze SEN66, každý jiný
+void fillSample(SensorSample& sample, uint32_t n) {
+  sample.sequence = n + 1;
+  sample.validMask = 0x1FF;
+  sample.values[0] = 18.0f + (n % 997) * 0.0137f;
+  sample.values[1] = 30.0f + (n % 701) * 0.051f;
+  sample.values[2] = (n % 503) * 0.17f;
+  sample.values[3] = (n % 509) * 0.19f;
+  sample.values[4] = (n % 521) * 0.21f;
+  sample.values[5] = (n % 523) * 0.23f;
+  sample.values[6] = 1.0f + (n % 499);
+  sample.values[7] = 1.0f + (n % 97);
+  sample.values[8] = 400.0f + (n % 3001);
+}
+
+// Před společnou cache: displej, stavový topic MQTT a TMEP každý snprintf,
+// JSON pro MQTT a /api/data round() a tisk čísla (tady %g místo ArduinoJson)
+size_t formatBefore(const SensorSample& sample) {
+  char buf[24];
+  size_t total = 0;
+  for (uint8_t i = 0; i < sensors.channelCount(); i++) {
+    const ChannelKindInfo& info = channelKindInfo(sensors.channel(i).kind);
+    float value = sample.values[i];
+    total += snprintf(buf, sizeof(buf), "%.*f", info.displayDecimals, value);
+    total += snprintf(buf, sizeof(buf), "%.*f", info.decimals, value);
+    total += snprintf(buf, sizeof(buf), "%.*f", info.decimals, value);
+    for (int json = 0; json < 2; json++) {
+      double rounded = info.decimals == 1 ? round(value * 10) / 10.0 : round(value);
+      total += snprintf(buf, sizeof(buf), "%g", rounded);
+    }
+  }
+  return total;
+}
+
+template <typename Fn>
+double nsPerSample(uint32_t samples, Fn fn) {
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t n = 0; n < samples; n++) fn(n);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / samples;
+}
+}  // namespace
+
+void setUp() {
+  static bool registryReady = false;
+  if (!registryReady) {
+    sensors.add(&sen66, I2cBus());
+    sensors.begin();
+    registryReady = true;
+  }
+}
+
+void tearDown() {}
+
+void test_exact_halves_round_like_printf() {
+  const float halves[] = {0.5f, 1.5f, 2.5f, 3.5f, 0.25f, 0.75f, 21.25f, 21.75f, 0.125f, 0.375f,
+                          1.0625f, 2.4375f, 0.0625f, 999.5f, 1000.5f, 12345.5f, 999999.5f};
+  for (float h : halves) {
+    assertAllDecimals(h);
+    assertAllDecimals(-h);
+  }
+  // Půlka, která ve floatu přesně není: rozhoduje skutečná hodnota (1.005f < 1.005)
+  assertAllDecimals(1.005f);
+  assertAllDecimals(2.675f);
+  assertAllDecimals(0.15f);
+  assertAllDecimals(-0.15f);
+}
+
+void test_negatives_and_negative_zero() {
+  assertAllDecimals(-0.0f);
+  assertAllDecimals(0.0f);
+  assertAllDecimals(-0.04f);   // zaokrouhlí se na nulu, znaménko zůstane
+  assertAllDecimals(-0.0004f);
+  assertAllDecimals(-1.0f);
+  assertAllDecimals(-12.34f);
+  assertAllDecimals(-40.0f);
+  assertAllDecimals(-FLT_MIN);
+  char buf[16];
+  formatFixed(-0.04f, 1, buf, sizeof(buf));
+  TEST_ASSERT_EQUAL_STRING("-0.0", buf);
+}
+
+void test_large_values_and_fallback() {
+  // Hranice rychlé cesty: těsně pod 1e6 ještě pevná řádová čárka, od 1e6 snprintf
+  assertAllDecimals(999999.9f);
+  assertAllDecimals(999999.94f);
+  assertAllDecimals(nextafterf(1e6f, 0));
+  assertAllDecimals(1e6f);
+  assertAllDecimals(-1e6f);
+  assertAllDecimals(1234567.0f);
+  assertAllDecimals(2147483648.0f);
+  assertAllDecimals(-2147483648.0f);
+  assertAllDecimals(1e20f);
+  assertAllDecimals(FLT_MAX);
+  assertAllDecimals(INFINITY);
+  assertAllDecimals(-INFINITY);
+  assertAllDecimals(NAN);
+  for (uint8_t d = 5; d <= 8; d++) assertLikeSnprintf(3.14159265f, d);
+}
+
+void test_truncated_buffer_like_snprintf() {
+  for (size_t size = 1; size <= 12; size++) {
+    assertLikeSnprintf(-123.456f, 2, size);
+    assertLikeSnprintf(5000000.0f, 1, size);
+  }
+  char buf[4] = {'x', 'x', 'x', 'x'};
+  TEST_ASSERT_EQUAL(0, formatFixed(1.0f, 1, buf, 0));
+  TEST_ASSERT_EQUAL('x', buf[0]);
+}
+
+void test_random_values_match_snprintf() {
+  std::mt19937 rng(49);
+  std::uniform_real_distribution<float> wide(-2e6f, 2e6f);
+  std::uniform_real_distribution<float> sensor(-50.0f, 5000.0f);
+  for (uint32_t i = 0; i < 200000; i++) {
+    uint8_t d = i % 4;
+    assertLikeSnprintf(wide(rng), d);
+    assertLikeSnprintf(sensor(rng), d);
+    // Násobky 1/1024: hodně přesných půlek ve všech přesnostech
+    assertLikeSnprintf((int32_t)(rng() % 4000000 - 2000000) / 1024.0f, d);
+    // Libovolný bitový vzor floatu včetně subnormálních, NaN a nekonečen
+    uint32_t bits = rng();
+    float any;
+    memcpy(&any, &bits, sizeof(any));
+    assertLikeSnprintf(any, d, 24);
+  }
+}
+
+void test_sample_text_matches_and_is_faster_than_per_consumer_printf() {
+  SampleText text;
+  SensorSample sample;
+  fillSample(sample, 123);
+  sample.validMask &= ~(1UL << 7);  // NOx neplatné
+  TEST_ASSERT_TRUE(text.update(sensors, sample));
+  TEST_ASSERT_FALSE(text.update(sensors, sample));  // stejný vzorek se nepřepočítá
+  char expected[16];
+  for (uint8_t i = 0; i < sensors.channelCount(); i++) {
+    const ChannelKindInfo& info = channelKindInfo(sensors.channel(i).kind);
+    if (i == 7) {
+      TEST_ASSERT_EQUAL_STRING("", text.value(i));
+      TEST_ASSERT_EQUAL_STRING("null", text.json(i));
+      TEST_ASSERT_EQUAL_STRING("--", text.display(i));
+      continue;
+    }
+    snprintf(expected, sizeof(expected), "%.*f", info.decimals, sample.values[i]);
+    TEST_ASSERT_EQUAL_STRING(expected, text.value(i));
+    snprintf(expected, sizeof(expected), "%.*f", info.displayDecimals, sample.values[i]);
+    TEST_ASSERT_EQUAL_STRING(expected, text.display(i));
+  }
+
+  const uint32_t SAMPLES = 100000;
+  volatile size_t sink = 0;
+  double before = nsPerSample(SAMPLES, [&](uint32_t n) {
+    fillSample(sample, n);
+    sink = sink + formatBefore(sample);
+  });
+  double after = nsPerSample(SAMPLES, [&](uint32_t n) {
+    fillSample(sample, n);
+    text.update(sensors, sample);
+    sink = sink + text.value(n % 9)[0];
+  });
+  char info[96];
+  snprintf(info, sizeof(info), "vzorek SEN66: pred %.0f ns (27x snprintf, 18x round+tisk), SampleText %.0f ns", before,
+           after);
+  TEST_MESSAGE(info);
+  TEST_ASSERT_LESS_THAN((uint32_t)(before / 5), (uint32_t)after);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_exact_halves_round_like_printf);
+  RUN_TEST(test_negatives_and_negative_zero);
+  RUN_TEST(test_large_values_and_fallback);
+  RUN_TEST(test_truncated_buffer_like_snprintf);
+  RUN_TEST(test_random_values_match_snprintf);
+  RUN_TEST(test_sample_text_matches_and_is_faster_than_per_consumer_printf);
+  return UNITY_END();
+}
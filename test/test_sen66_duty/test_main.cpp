@@ -0,0 +1,165 @@
+// Střída SEN66 v registru senzorů proti náhradě senzoru (test/host): okno
+// měření, zastavení a start přímými I2C příkazy a stav algoritmu VOC indexu,
+// který se před stopem přečte a před dalším startem vrátí. Každý poll smí
+// poslat nejvýše jednu I2C transakci.
+
+#include <SensirionI2cSen66.h>
+#include <Wire.h>
+#include <unity.h>
+
+#include <memory>
+#include <vector>
+
+#include "Sen66Driver.h"
+#include "SensorRegistry.h"
+
+namespace {
+const unsigned long PERIOD_MS = 300000;
+const uint8_t LEARNED[8] = {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0};
+
+enum Command { CMD_OTHER = 0, CMD_START, CMD_STOP, CMD_VOC_GET, CMD_VOC_SET };
+
+struct Step {
+  Command command;
+  uint32_t atMs;
+  std::vector<uint8_t> payload;  // data za příkazem (stav VOC při zápisu)
+};
+
+struct Panel {
+  Sen66Driver sen66;
+  SensorRegistry sensors;
+};
+
+Command decode(const TwoWire::Transaction& t) {
+  if (t.address != SEN66_I2C_ADDR_6B || t.bytes.size() < 2) return CMD_OTHER;
+  uint16_t command = (t.bytes[0] << 8) | t.bytes[1];
+  if (command == 0x0021) return CMD_START;
+  if (command == 0x0104) return CMD_STOP;
+  if (command == 0x6181) return t.bytes.size() > 2 ? CMD_VOC_SET : CMD_VOC_GET;
+  return CMD_OTHER;
+}
+
+std::unique_ptr<Panel> boot() {
+  std::unique_ptr<Panel> p(new Panel());
+  p->sen66.setDutyCycle(PERIOD_MS);
+  p->sensors.add(&p->sen66, I2cBus());
+  p->sensors.begin();
+  return p;
+}
+
+// loop() po termínech registru; příkazy senzoru v pořadí, jak odešly
+std::vector<Step> runFor(Panel& p, uint32_t ms, uint32_t* samples = nullptr) {
+  std::vector<Step> steps;
+  uint32_t until = millis() + ms;
+  while ((long)(millis() - until) < 0) {
+    long wait = (long)(p.sensors.nextDeadline() - millis());
+    long left = (long)(until - millis());
+    host::advanceMs(wait <= 0 ? 1 : (wait < left ? wait : left));
+    size_t before = Wire.transactions.size();
+    if (p.sensors.process(millis()) && samples) (*samples)++;
+    TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(1, Wire.transactions.size() - before, "vice I2C transakci v jednom pollu");
+    for (size_t i = before; i < Wire.transactions.size(); i++) {
+      const TwoWire::Transaction& t = Wire.transactions[i];
+      Command command = decode(t);
+      if (command == CMD_OTHER) continue;
+      steps.push_back({command, (uint32_t)millis(), std::vector<uint8_t>(t.bytes.begin() + 2, t.bytes.end())});
+      // Senzor po stopu stav VOC algoritmu zapomene
+      if (command == CMD_STOP) memset(SensirionI2cSen66::vocState, 0, sizeof(SensirionI2cSen66::vocState));
+    }
+  }
+  return steps;
+}
+
+int indexOf(const std::vector<Step>& steps, Command command, size_t from = 0) {
+  for (size_t i = from; i < steps.size(); i++) {
+    if (steps[i].command == command) return (int)i;
+  }
+  return -1;
+}
+}  // namespace
+
+void setUp() {
+  host::resetClock();
+  Wire = TwoWire();
+  SensirionI2cSen66::next = SensirionI2cSen66::Reading();
+  SensirionI2cSen66::vocStateError = NO_ERROR;
+  memcpy(SensirionI2cSen66::vocState, LEARNED, sizeof(LEARNED));
+}
+
+void tearDown() {}
+
+void test_voc_state_saved_before_stop_and_restored_before_start() {
+  std::unique_ptr<Panel> p = boot();
+  uint32_t samples = 0;
+  std::vector<Step> steps = runFor(*p, 2 * PERIOD_MS + 90000, &samples);
+
+  // Dvě zastavení a dva starty; stav se čte za měření a zapisuje v idle
+  int get1 = indexOf(steps, CMD_VOC_GET);
+  int stop1 = indexOf(steps, CMD_STOP);
+  int set1 = indexOf(steps, CMD_VOC_SET);
+  int start1 = indexOf(steps, CMD_START);
+  TEST_ASSERT_TRUE(get1 >= 0 && stop1 == get1 + 1);
+  TEST_ASSERT_TRUE(set1 > stop1 && start1 == set1 + 1);
+  TEST_ASSERT_GREATER_OR_EQUAL(1000, steps[set1].atMs - steps[stop1].atMs);  // stop se dokončil
+  TEST_ASSERT_EQUAL(8, steps[set1].payload.size());
+  TEST_ASSERT_EQUAL_MEMORY(LEARNED, steps[set1].payload.data(), sizeof(LEARNED));
+
+  int stop2 = indexOf(steps, CMD_STOP, start1);
+  int start2 = indexOf(steps, CMD_START, stop2 > 0 ? stop2 : start1 + 1);
+  TEST_ASSERT_TRUE(stop2 > 0 && steps[stop2 - 1].command == CMD_VOC_GET);
+  TEST_ASSERT_TRUE(start2 > 0 && steps[start2 - 1].command == CMD_VOC_SET);
+  TEST_ASSERT_EQUAL(PERIOD_MS, steps[start2].atMs - steps[start1].atMs);
+
+  Sen66DutyStats stats = p->sen66.getDutyStats();
+  TEST_ASSERT_EQUAL(2, stats.vocStateRestores);
+  TEST_ASSERT_EQUAL(0, stats.vocStateErrors);
+  TEST_ASSERT_GREATER_OR_EQUAL(2, stats.windows);
+  TEST_ASSERT_GREATER_THAN(0, samples);
+}
+
+void test_failed_state_read_skips_restore() {
+  std::unique_ptr<Panel> p = boot();
+  SensirionI2cSen66::vocStateError = 1;
+  std::vector<Step> steps = runFor(*p, PERIOD_MS + 30000);
+
+  int stop = indexOf(steps, CMD_STOP);
+  int start = indexOf(steps, CMD_START);
+  TEST_ASSERT_TRUE(stop > 0 && steps[stop - 1].command == CMD_VOC_GET);
+  TEST_ASSERT_TRUE(start > stop);
+  TEST_ASSERT_EQUAL(-1, indexOf(steps, CMD_VOC_SET));  // nic k obnovení, jen start
+  TEST_ASSERT_EQUAL(1, p->sen66.getDutyStats().vocStateErrors);
+  TEST_ASSERT_EQUAL(0, p->sen66.getDutyStats().vocStateRestores);
+}
+
+void test_failed_restore_still_starts_measurement() {
+  std::unique_ptr<Panel> p = boot();
+  std::vector<Step> steps = runFor(*p, PERIOD_MS - 20000);
+  TEST_ASSERT_TRUE(indexOf(steps, CMD_STOP) > 0);
+  TEST_ASSERT_FALSE(p->sen66.measuring());
+
+  SensirionI2cSen66::vocStateError = 1;
+  steps = runFor(*p, 30000);
+  int set = indexOf(steps, CMD_VOC_SET);
+  TEST_ASSERT_TRUE(set >= 0 && indexOf(steps, CMD_START) == set + 1);
+  TEST_ASSERT_TRUE(p->sen66.measuring());
+  TEST_ASSERT_EQUAL(1, p->sen66.getDutyStats().vocStateErrors);
+}
+
+void test_continuous_mode_never_touches_voc_state() {
+  std::unique_ptr<Panel> p(new Panel());
+  p->sensors.add(&p->sen66, I2cBus());
+  p->sensors.begin();
+  uint32_t samples = 0;
+  std::vector<Step> steps = runFor(*p, 600000, &samples);
+  TEST_ASSERT_EQUAL(0, steps.size());
+  TEST_ASSERT_GREATER_THAN(250, samples);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_voc_state_saved_before_stop_and_restored_before_start);
+  RUN_TEST(test_failed_state_read_skips_restore);
+  RUN_TEST(test_failed_restore_still_starts_measurement);
+  RUN_TEST(test_continuous_mode_never_touches_voc_state);
+  return UNITY_END();
+}
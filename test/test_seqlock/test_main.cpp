@@ -0,0 +1,119 @@
+// SeqLock pod zátěží: jeden zapisovatel a několik čtenářů ve skutečných
+// vláknech. Každý přečtený snímek musí být celý z jednoho zápisu a jeho
+// pořadí nesmí u žádného čtenáře jít zpět.
+
+#include <unity.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "SensorRegistry.h"
+#include "SeqLock.h"
+
+namespace {
+constexpr uint32_t WRITES = 300000;
+constexpr uint8_t READERS = 4;
+
+// Všechna pole snímku odvozená z pořadí zápisu - smíchaný snímek se pozná
+void fill(SensorSample& sample, uint32_t n) {
+  sample.sequence = n;
+  sample.timestamp = n;
+  sample.unixMs = (uint64_t)n * 1000 + 7;
+  sample.clockMs = (uint64_t)n * 2;
+  sample.validMask = n;
+  sample.staleMask = ~n;
+  for (uint8_t c = 0; c < MAX_CHANNELS; c++) sample.values[c] = (float)(n & 0xFFFF) + c;
+}
+
+bool consistent(const SensorSample& sample) {
+  uint32_t n = sample.sequence;
+  if (sample.timestamp != n || sample.unixMs != (uint64_t)n * 1000 + 7 || sample.clockMs != (uint64_t)n * 2 ||
+      sample.validMask != n || sample.staleMask != ~n) {
+    return false;
+  }
+  for (uint8_t c = 0; c < MAX_CHANNELS; c++) {
+    if (sample.values[c] != (float)(n & 0xFFFF) + c) return false;
+  }
+  return true;
+}
+}  // namespace
+
+void setUp() { host::resetClock(); }
+
+void tearDown() {}
+
+void test_read_returns_last_write_and_counts_versions() {
+  SeqLock<SensorSample> lock;
+  SensorSample sample;
+  TEST_ASSERT_EQUAL(0, lock.version());
+  for (uint32_t n = 1; n <= 3; n++) {
+    fill(sample, n);
+    lock.write(sample);
+  }
+  SensorSample out;
+  lock.read(out);
+  TEST_ASSERT_TRUE(consistent(out));
+  TEST_ASSERT_EQUAL(3, out.sequence);
+  TEST_ASSERT_EQUAL(3, lock.version());
+}
+
+void test_concurrent_readers_never_see_torn_or_older_snapshots() {
+  SeqLock<SensorSample> lock;
+  SensorSample initial;
+  fill(initial, 0);
+  lock.write(initial);
+
+  std::atomic<bool> done{false};
+  std::atomic<uint32_t> torn{0};
+  std::atomic<uint32_t> backwards{0};
+  std::atomic<uint64_t> reads{0};
+  std::vector<uint32_t> lastSeen(READERS, 0);
+
+  std::vector<std::thread> readers;
+  for (uint8_t r = 0; r < READERS; r++) {
+    readers.emplace_back([&, r]() {
+      SensorSample sample;
+      uint32_t last = 0;
+      uint64_t count = 0;
+      while (!done.load(std::memory_order_acquire)) {
+        lock.read(sample);
+        count++;
+        if (!consistent(sample)) torn++;
+        if (sample.sequence < last) backwards++;
+        last = sample.sequence;
+      }
+      lock.read(sample);
+      lastSeen[r] = sample.sequence;
+      reads += count;
+    });
+  }
+
+  std::thread writer([&]() {
+    SensorSample sample;
+    for (uint32_t n = 1; n <= WRITES; n++) {
+      fill(sample, n);
+      lock.write(sample);
+    }
+    done.store(true, std::memory_order_release);
+  });
+
+  writer.join();
+  for (auto& t : readers) t.join();
+
+  char info[96];
+  snprintf(info, sizeof(info), "%lu zapisu, %llu cteni", (unsigned long)WRITES, (unsigned long long)reads.load());
+  TEST_MESSAGE(info);
+  TEST_ASSERT_EQUAL(0, torn.load());
+  TEST_ASSERT_EQUAL(0, backwards.load());
+  TEST_ASSERT_GREATER_THAN(0, reads.load());
+  TEST_ASSERT_EQUAL(WRITES + 1, lock.version());
+  for (uint8_t r = 0; r < READERS; r++) TEST_ASSERT_EQUAL(WRITES, lastSeen[r]);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_read_returns_last_write_and_counts_versions);
+  RUN_TEST(test_concurrent_readers_never_see_torn_or_older_snapshots);
+  return UNITY_END();
+}
@@ -0,0 +1,250 @@
+// Referenční stopy z traces/ přehrané skutečnou pipeline: nahrání po kusech
+// jako přes /api/trace/upload, Sen66Driver místo I2C čte záznamy, registr
+// senzorů posouvá čas vzorků podle stopy, za ním texty hodnot, alarmy a okna
+// kvality vzduchu. Stejná stopa musí dát stejné přechody a indexy při
+// jakékoli rychlosti a žádný vzorek nesmí vypadat jako živý.
+
+#include <FS.h>
+#include <unity.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AirQuality.h"
+#include "AlarmEngine.h"
+#include "MqttTopics.h"
+#include "SampleText.h"
+#include "Sen66Driver.h"
+#include "SensorRegistry.h"
+#include "SensorTrace.h"
+
+namespace {
+const char* const RULES = "pm25>35:25:60; co2>1200:1000:60; temperature<18:19:60";
+constexpr uint8_t RULE_PM25 = 0;
+constexpr uint8_t RULE_CO2 = 1;
+constexpr uint8_t RULE_TEMP = 2;
+
+std::string root;
+
+struct Transition {
+  uint8_t rule;
+  bool active;
+  uint32_t traceMs;  // čas vzorku od prvního vzorku stopy
+
+  bool operator==(const Transition& o) const {
+    return rule == o.rule && active == o.active && traceMs == o.traceMs;
+  }
+};
+
+struct Run {
+  std::vector<Transition> transitions;
+  uint32_t samples = 0;
+  uint32_t liveSamples = 0;    // vzorky bez příznaku replayed
+  uint32_t spanMs = 0;         // čas stopy mezi prvním a posledním vzorkem
+  uint32_t elapsedMs = 0;      // millis() za celé přehrávání
+  uint32_t sensorErrors = 0;   // odmítnutá čtení (chybový kód, neplatné hodnoty)
+  SensorTraceStats trace;
+  AirQualityIndex index;
+  float maxPm25 = 0;
+};
+
+// Pipeline jako v loop(): jeden registr s SEN66 napojeným na stopu
+struct Pipeline {
+  SensorTrace trace;
+  Sen66Driver sen66;
+  SensorRegistry sensors;
+  SampleText sampleText;
+  AlarmEngine alarms;
+  AirQualityEngine airQuality;
+};
+
+void upload(SensorTrace& trace, const char* name) {
+  std::string path = std::string("traces/") + name;
+  FILE* f = fopen(path.c_str(), "rb");
+  TEST_ASSERT_NOT_NULL_MESSAGE(f, path.c_str());
+  uint8_t chunk[4096];
+  uint32_t offset = 0;
+  size_t length;
+  while ((length = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+    const char* message = nullptr;
+    TEST_ASSERT_TRUE_MESSAGE(trace.writeChunk(offset, chunk, length, message), message);
+    offset += length;
+  }
+  fclose(f);
+}
+
+Run replay(const char* name, uint16_t speed) {
+  char tmpl[] = "/tmp/tracereplayXXXXXX";
+  root = mkdtemp(tmpl);
+  fs::FS fs(root);
+  host::resetClock();
+
+  std::unique_ptr<Pipeline> p(new Pipeline());
+  p->trace.begin(fs);
+  upload(p->trace, name);
+  p->sen66.setTrace(&p->trace);
+  p->sensors.add(&p->sen66, I2cBus());
+  p->sensors.begin();
+  TEST_ASSERT_TRUE(p->alarms.compile(RULES, [&](const char* key) {
+    for (uint8_t i = 0; i < p->sensors.channelCount(); i++) {
+      if (strcmp(p->sensors.channel(i).key, key) == 0) return (int)i;
+    }
+    return -1;
+  }));
+  const char* message = nullptr;
+  TEST_ASSERT_TRUE_MESSAGE(p->sen66.startReplay(speed, message), message);
+
+  Run run;
+  uint64_t firstClockMs = 0;
+  uint32_t startedAt = millis();
+  while (p->trace.replaying()) {
+    long wait = (long)(p->sensors.nextDeadline() - millis());
+    host::advanceMs(wait > 0 ? wait : 1);
+    if (!p->sensors.process(millis())) continue;
+
+    SensorSample sample = p->sensors.snapshot();
+    p->sampleText.update(p->sensors, sample);
+    if (!sample.replayed) {
+      run.liveSamples++;
+      continue;
+    }
+    if (run.samples++ == 0) firstClockMs = sample.clockMs;
+    uint32_t traceMs = (uint32_t)(sample.clockMs - firstClockMs);
+    run.spanMs = traceMs;
+
+    uint32_t changed = p->alarms.evaluate(sample.values, sample.validMask, (uint32_t)sample.clockMs);
+    for (uint8_t i = 0; i < p->alarms.ruleCount(); i++) {
+      if (changed & (1UL << i)) run.transitions.push_back({i, p->alarms.rule(i).active, traceMs});
+    }
+    while (p->alarms.peekEvent()) p->alarms.popEvent();
+
+    float pm25 = 0, co2 = 0, voc = 0;
+    bool havePm25 = p->sensors.primaryValue(sample, CH_PM25, pm25);
+    bool haveCo2 = p->sensors.primaryValue(sample, CH_CO2, co2);
+    bool haveVoc = p->sensors.primaryValue(sample, CH_VOC, voc);
+    p->airQuality.update((uint32_t)(sample.clockMs / 1000), havePm25 ? &pm25 : nullptr,
+                         haveCo2 ? &co2 : nullptr, haveVoc ? &voc : nullptr);
+    if (havePm25 && pm25 > run.maxPm25) run.maxPm25 = pm25;
+  }
+  run.elapsedMs = millis() - startedAt;
+  run.sensorErrors = p->sensors.sensorErrors(0);
+  run.trace = p->trace.getStats();
+  run.index = p->airQuality.compute();
+
+  char info[128];
+  snprintf(info, sizeof(info), "%s x%u: %lu vzorku, %lu chyb, %u prechodu, stopa %lu s za %lu s", name, speed,
+           (unsigned long)run.samples, (unsigned long)run.sensorErrors, (unsigned)run.transitions.size(),
+           (unsigned long)(run.spanMs / 1000), (unsigned long)(run.elapsedMs / 1000));
+  TEST_MESSAGE(info);
+  return run;
+}
+
+const Transition* find(const Run& run, uint8_t rule, bool active) {
+  for (const Transition& t : run.transitions) {
+    if (t.rule == rule && t.active == active) return &t;
+  }
+  return nullptr;
+}
+
+void assertSameResult(const Run& a, const Run& b) {
+  TEST_ASSERT_EQUAL(a.samples, b.samples);
+  TEST_ASSERT_EQUAL(a.spanMs, b.spanMs);
+  TEST_ASSERT_EQUAL(a.transitions.size(), b.transitions.size());
+  for (size_t i = 0; i < a.transitions.size(); i++) {
+    TEST_ASSERT_TRUE_MESSAGE(a.transitions[i] == b.transitions[i], "prechod");
+  }
+  TEST_ASSERT_EQUAL(a.index.overall, b.index.overall);
+  TEST_ASSERT_EQUAL(a.index.dominant, b.index.dominant);
+  TEST_ASSERT_EQUAL(a.index.co2Valid, b.index.co2Valid);
+  TEST_ASSERT_EQUAL_FLOAT(a.index.co2Mean, b.index.co2Mean);
+  TEST_ASSERT_EQUAL(a.index.vocValid, b.index.vocValid);
+  TEST_ASSERT_EQUAL_FLOAT(a.index.vocMean, b.index.vocMean);
+}
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {
+  if (root.empty()) return;
+  std::string cmd = "rm -rf " + root;
+  TEST_ASSERT_EQUAL(0, system(cmd.c_str()));
+  root.clear();
+}
+
+void test_cooking_same_alarms_and_indices_at_any_speed() {
+  Run slow = replay("cooking.bin", 1);
+  tearDown();
+  Run fast = replay("cooking.bin", 100);
+
+  // Každý vzorek ze stopy, čas vzorků běží stopou, ne hodinami
+  TEST_ASSERT_EQUAL(0, slow.liveSamples);
+  TEST_ASSERT_EQUAL(slow.trace.totalRecords, slow.samples);
+  TEST_ASSERT_UINT32_WITHIN(2000, 45 * 60000, slow.spanMs + 2000);
+  TEST_ASSERT_LESS_THAN(slow.elapsedMs / 50, fast.elapsedMs);
+  assertSameResult(slow, fast);
+
+  // Smažení od 10. do 18. minuty: PM2.5 alarm po minutě nad prahem, konec po poklesu
+  TEST_ASSERT_GREATER_THAN(150, slow.maxPm25);
+  const Transition* on = find(slow, RULE_PM25, true);
+  const Transition* off = find(slow, RULE_PM25, false);
+  TEST_ASSERT_NOT_NULL(on);
+  TEST_ASSERT_NOT_NULL(off);
+  TEST_ASSERT_UINT32_WITHIN(120000, 11 * 60000, on->traceMs);
+  TEST_ASSERT_GREATER_THAN(18 * 60000, off->traceMs);
+  TEST_ASSERT_NULL(find(slow, RULE_CO2, true));  // CO2 při vaření nepřekročí 1200
+  TEST_ASSERT_TRUE(slow.index.co2Valid);
+}
+
+void test_window_clears_co2_alarm() {
+  Run run = replay("window.bin", 20);
+  TEST_ASSERT_EQUAL(0, run.liveSamples);
+
+  // Vydýchaná místnost: alarm minutu po začátku, okno ho ukončí
+  const Transition* on = find(run, RULE_CO2, true);
+  const Transition* off = find(run, RULE_CO2, false);
+  TEST_ASSERT_NOT_NULL(on);
+  TEST_ASSERT_NOT_NULL(off);
+  TEST_ASSERT_EQUAL(60000, on->traceMs);
+  TEST_ASSERT_GREATER_THAN(5 * 60000, off->traceMs);
+  TEST_ASSERT_LESS_THAN(12 * 60000, off->traceMs);
+  TEST_ASSERT_NOT_NULL(find(run, RULE_TEMP, true));  // otevřené okno ochladí místnost
+  TEST_ASSERT_NULL(find(run, RULE_PM25, true));
+}
+
+void test_fault_trace_rejects_bad_reads_and_keeps_real_event() {
+  Run run = replay("fault.bin", 50);
+  TEST_ASSERT_EQUAL(0, run.liveSamples);
+
+  // NACK a CRC chyby i NaN/mimo rozsah skončí jako chyba senzoru, ne jako vzorek
+  TEST_ASSERT_GREATER_THAN(0, run.trace.errorRecords);
+  TEST_ASSERT_GREATER_THAN(run.trace.errorRecords, run.sensorErrors);
+  TEST_ASSERT_EQUAL(run.trace.totalRecords, run.samples + run.sensorErrors);
+  TEST_ASSERT_LESS_THAN(1000, run.maxPm25);
+
+  // Skutečná událost PM na konci alarm spustí
+  const Transition* on = find(run, RULE_PM25, true);
+  TEST_ASSERT_NOT_NULL(on);
+  TEST_ASSERT_GREATER_THAN(8 * 60000, on->traceMs);  // od prvního platného vzorku po NaN ze startu
+}
+
+void test_replay_topics_stay_off_live_state() {
+  MqttTopics topics;
+  TEST_ASSERT_TRUE(topics.begin("sharp", ""));
+  TEST_ASSERT_EQUAL_STRING("sharp/replay/sensor", topics.topic(MQTT_T_REPLAY_SENSOR));
+  TEST_ASSERT_EQUAL_STRING("sharp/replay/alarm", topics.topic(MQTT_T_REPLAY_ALARM));
+  TEST_ASSERT_EQUAL_STRING("sharp/sensor", topics.topic(MQTT_T_SENSOR));
+  TEST_ASSERT_EQUAL_STRING("sharp/alarm", topics.topic(MQTT_T_ALARM));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_cooking_same_alarms_and_indices_at_any_speed);
+  RUN_TEST(test_window_clears_co2_alarm);
+  RUN_TEST(test_fault_trace_rejects_bad_reads_and_keeps_real_event);
+  RUN_TEST(test_replay_topics_stay_off_live_state);
+  return UNITY_END();
+}
@@ -0,0 +1,237 @@
+// Stavový automat WifiProvisioning řízený skriptovanými sekvencemi událostí:
+// test nových údajů z captive portálu i z běžícího STA, ztráta spojení,
+// reconnect a přetečení fronty událostí.
+
+#include <Preferences.h>
+#include <WiFi.h>
+#include <unity.h>
+
+#include <string.h>
+
+#include "WifiProvisioning.h"
+
+namespace {
+const uint8_t AP_BSSID[6] = {0x10, 0x20, 0x30, 0x40, 0x50, 0x60};
+const IPAddress LEASE(192, 168, 1, 77);
+
+AppConfig homeConfig() {
+  AppConfig config;
+  config.wifiSsid.assign("home");
+  config.wifiPassword.assign("secret");
+  return config;
+}
+
+void runFor(WifiProvisioning& wifi, uint32_t ms, uint32_t stepMs = 10) {
+  for (uint32_t t = 0; t < ms; t += stepMs) {
+    host::advanceMs(stepMs);
+    wifi.process();
+  }
+}
+
+// Zařízení bez údajů: rovnou captive portál
+void startCaptive(WifiProvisioning& wifi, AppConfig& config) {
+  wifi.begin(&config);
+  TEST_ASSERT_EQUAL(WIFI_AP_CAPTIVE, wifi.getState());
+  TEST_ASSERT_TRUE(WiFi.apRunning);
+}
+
+void connectHome(WifiProvisioning& wifi, AppConfig& config) {
+  wifi.begin(&config);
+  runFor(wifi, 200);
+  WiFi.connectTo(LEASE, AP_BSSID, 6);
+  wifi.process();
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTED, wifi.getState());
+}
+}  // namespace
+
+void setUp() {
+  host::resetClock();
+  WiFi.reset();
+  Preferences::wipeAll();
+}
+
+void tearDown() {}
+
+void test_captive_credential_test_succeeds_and_ap_shuts_down_after_grace() {
+  AppConfig config;
+  WifiProvisioning wifi;
+  startCaptive(wifi, config);
+
+  String message;
+  unsigned long before = millis();
+  uint32_t id = wifi.startCredentialTest("office", "pw12345678", message);
+  TEST_ASSERT_NOT_EQUAL(0, id);
+  TEST_ASSERT_EQUAL(before, millis());  // handler neblokuje
+  TEST_ASSERT_EQUAL(WIFI_AP_STA_TESTING, wifi.getState());
+  TEST_ASSERT_EQUAL(WIFI_AP_STA, WiFi.getMode());
+  TEST_ASSERT_TRUE(wifi.isCaptiveMode());
+  TEST_ASSERT_EQUAL_STRING("office", WiFi.begins.back().ssid.c_str());
+  TEST_ASSERT_EQUAL(WIFI_JOB_RUNNING, wifi.getJob(id, message));
+
+  runFor(wifi, 1500);
+  TEST_ASSERT_EQUAL(WIFI_JOB_RUNNING, wifi.getJob(id, message));
+  WiFi.connectTo(LEASE, AP_BSSID, 1);
+  wifi.process();
+
+  TEST_ASSERT_EQUAL(WIFI_JOB_SUCCEEDED, wifi.getJob(id, message));
+  TEST_ASSERT_NOT_NULL(strstr(message.c_str(), "192.168.1.77"));
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTED, wifi.getState());
+  TEST_ASSERT_EQUAL_STRING("office", config.wifiSsid.c_str());
+
+  AppConfig stored;
+  TEST_ASSERT_TRUE(loadConfig(stored));
+  TEST_ASSERT_EQUAL_STRING("office", stored.wifiSsid.c_str());
+
+  // UI si výsledek přečte přes AP, ten pak do 15 s zmizí
+  runFor(wifi, 14990);
+  TEST_ASSERT_TRUE(WiFi.apRunning);
+  runFor(wifi, 20);
+  TEST_ASSERT_FALSE(WiFi.apRunning);
+  TEST_ASSERT_EQUAL(WIFI_STA, WiFi.getMode());
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTED, wifi.getState());
+}
+
+void test_captive_credential_test_auth_failure_returns_to_captive() {
+  AppConfig config;
+  WifiProvisioning wifi;
+  startCaptive(wifi, config);
+
+  String message;
+  uint32_t id = wifi.startCredentialTest("office", "wrong", message);
+  runFor(wifi, 800);
+  WiFi.drop(WIFI_REASON_AUTH_FAIL);
+  wifi.process();
+
+  TEST_ASSERT_EQUAL(WIFI_JOB_FAILED, wifi.getJob(id, message));
+  TEST_ASSERT_NOT_NULL(strstr(message.c_str(), "heslo"));
+  TEST_ASSERT_EQUAL(WIFI_AP_CAPTIVE, wifi.getState());
+  TEST_ASSERT_EQUAL(WIFI_AP, WiFi.getMode());
+  TEST_ASSERT_TRUE(WiFi.apRunning);
+  TEST_ASSERT_EQUAL(0, config.wifiSsid.length());
+}
+
+void test_captive_credential_test_missing_ssid_and_timeout() {
+  AppConfig config;
+  WifiProvisioning wifi;
+  startCaptive(wifi, config);
+
+  String message;
+  uint32_t id = wifi.startCredentialTest("nowhere", "pw", message);
+  WiFi.drop(WIFI_REASON_NO_AP_FOUND);
+  wifi.process();
+  TEST_ASSERT_EQUAL(WIFI_JOB_FAILED, wifi.getJob(id, message));
+  TEST_ASSERT_NOT_NULL(strstr(message.c_str(), "SSID nenalezeno"));
+
+  // Druhý pokus: AP neodpovídá vůbec, rozhodne timeout
+  id = wifi.startCredentialTest("silent", "pw", message);
+  TEST_ASSERT_NOT_EQUAL(0, id);
+  WiFi.drop(WIFI_REASON_BEACON_TIMEOUT);  // přechodná chyba test neukončí
+  runFor(wifi, 19990);
+  TEST_ASSERT_EQUAL(WIFI_JOB_RUNNING, wifi.getJob(id, message));
+  runFor(wifi, 20);
+  TEST_ASSERT_EQUAL(WIFI_JOB_FAILED, wifi.getJob(id, message));
+  TEST_ASSERT_NOT_NULL(strstr(message.c_str(), "Timeout"));
+  TEST_ASSERT_EQUAL(WIFI_AP_CAPTIVE, wifi.getState());
+}
+
+void test_second_credential_test_is_rejected_while_running() {
+  AppConfig config;
+  WifiProvisioning wifi;
+  startCaptive(wifi, config);
+
+  String message;
+  uint32_t first = wifi.startCredentialTest("office", "pw", message);
+  uint32_t second = wifi.startCredentialTest("other", "pw", message);
+  TEST_ASSERT_NOT_EQUAL(0, first);
+  TEST_ASSERT_EQUAL(0, second);
+  TEST_ASSERT_NOT_NULL(strstr(message.c_str(), "probiha"));
+  TEST_ASSERT_EQUAL(WIFI_JOB_RUNNING, wifi.getJob(first, message));
+  TEST_ASSERT_EQUAL(WIFI_JOB_NONE, wifi.getJob(first + 1, message));
+}
+
+void test_failed_test_from_sta_returns_to_stored_network() {
+  AppConfig config = homeConfig();
+  WifiProvisioning wifi;
+  connectHome(wifi, config);
+
+  String message;
+  uint32_t id = wifi.startCredentialTest("office", "wrong", message);
+  TEST_ASSERT_EQUAL(WIFI_STA, WiFi.getMode());  // AP se kvůli testu nezapíná
+  TEST_ASSERT_FALSE(WiFi.apRunning);
+  WiFi.drop(WIFI_REASON_AUTH_FAIL);
+  wifi.process();
+
+  TEST_ASSERT_EQUAL(WIFI_JOB_FAILED, wifi.getJob(id, message));
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTING, wifi.getState());
+  TEST_ASSERT_EQUAL_STRING("home", WiFi.begins.back().ssid.c_str());
+  TEST_ASSERT_EQUAL_STRING("home", config.wifiSsid.c_str());
+}
+
+void test_lost_connection_kicks_reconnect_then_falls_back_to_captive() {
+  AppConfig config = homeConfig();
+  WifiProvisioning wifi;
+  connectHome(wifi, config);
+
+  WiFi.drop(WIFI_REASON_BEACON_TIMEOUT);
+  wifi.process();
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTING, wifi.getState());
+
+  runFor(wifi, 4990);
+  TEST_ASSERT_EQUAL(0, WiFi.reconnects);
+  runFor(wifi, 20);
+  TEST_ASSERT_EQUAL(1, WiFi.reconnects);
+  runFor(wifi, 10000);
+  TEST_ASSERT_EQUAL(3, WiFi.reconnects);
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTING, wifi.getState());
+
+  runFor(wifi, 5000);
+  TEST_ASSERT_EQUAL(WIFI_AP_CAPTIVE, wifi.getState());
+  TEST_ASSERT_TRUE(WiFi.apRunning);
+}
+
+void test_reconnect_restores_connection() {
+  AppConfig config = homeConfig();
+  WifiProvisioning wifi;
+  connectHome(wifi, config);
+
+  WiFi.emit(ARDUINO_EVENT_WIFI_STA_LOST_IP);
+  wifi.process();
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTING, wifi.getState());
+
+  runFor(wifi, 6000);
+  WiFi.connectTo(LEASE, AP_BSSID, 6);
+  wifi.process();
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTED, wifi.getState());
+  TEST_ASSERT_EQUAL(6000, wifi.getLastConnectDurationMs());
+}
+
+void test_event_queue_overflow_resyncs_from_driver_status() {
+  AppConfig config = homeConfig();
+  WifiProvisioning wifi;
+  wifi.begin(&config);
+
+  // Event task předběhne loop(): přechodné výpadky zaplní frontu a GOT_IP se ztratí
+  for (int i = 0; i < 10; i++) WiFi.drop(WIFI_REASON_BEACON_TIMEOUT);
+  WiFi.connectTo(LEASE, AP_BSSID, 6);
+  wifi.process();
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTED, wifi.getState());
+
+  // Stejně tak ztracený DISCONNECTED
+  for (int i = 0; i < 10; i++) WiFi.emit(ARDUINO_EVENT_WIFI_STA_CONNECTED);
+  WiFi.setStatus(WL_CONNECTION_LOST);
+  wifi.process();
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTING, wifi.getState());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_captive_credential_test_succeeds_and_ap_shuts_down_after_grace);
+  RUN_TEST(test_captive_credential_test_auth_failure_returns_to_captive);
+  RUN_TEST(test_captive_credential_test_missing_ssid_and_timeout);
+  RUN_TEST(test_second_credential_test_is_rejected_while_running);
+  RUN_TEST(test_failed_test_from_sta_returns_to_stored_network);
+  RUN_TEST(test_lost_connection_kicks_reconnect_then_falls_back_to_captive);
+  RUN_TEST(test_reconnect_restores_connection);
+  RUN_TEST(test_event_queue_overflow_resyncs_from_driver_status);
+  return UNITY_END();
+}
@@ -0,0 +1,299 @@
+// WifiProvisioning proti náhradě Wi-Fi driveru (test/host/WiFi.h): rychlé
+// připojení z cache, stáří uloženého lease, záložní sken, statická IP a pád
+// do captive portálu.
+
+#include <Preferences.h>
+#include <WiFi.h>
+#include <unity.h>
+
+#include "WifiProvisioning.h"
+
+namespace {
+const uint8_t AP_BSSID[6] = {0x10, 0x20, 0x30, 0x40, 0x50, 0x60};
+const int32_t AP_CHANNEL = 6;
+const IPAddress LEASE(192, 168, 1, 77);
+
+// Unixový čas pro WifiProvisioning (jako RTC po SNTP), posouvá ho test
+uint32_t unixS = 0;
+uint32_t unixClock() { return unixS; }
+
+AppConfig homeConfig() {
+  AppConfig config;
+  config.wifiSsid.assign("home");
+  config.wifiPassword.assign("secret");
+  return config;
+}
+
+// Smyčka jako v loop(): process() po krocích simulovaného času
+void runFor(WifiProvisioning& wifi, uint32_t ms, uint32_t stepMs = 10) {
+  for (uint32_t t = 0; t < ms; t += stepMs) {
+    host::advanceMs(stepMs);
+    wifi.process();
+  }
+}
+
+WifiFastConnectCache storedCache() {
+  WifiFastConnectCache cache;
+  Preferences pref;
+  pref.begin("wificache", true);
+  pref.getBytes("last", &cache, sizeof(cache));
+  pref.end();
+  return cache;
+}
+
+bool cacheStored() {
+  Preferences pref;
+  pref.begin("wificache", true);
+  bool stored = pref.getBytesLength("last") == sizeof(WifiFastConnectCache);
+  pref.end();
+  return stored;
+}
+
+// První boot: sken, DHCP, po připojení se uloží cache
+void bootAndConnect(AppConfig& config) {
+  WifiProvisioning wifi;
+  wifi.setUnixClock(unixClock);
+  wifi.begin(&config);
+  runFor(wifi, 500);
+  WiFi.connectTo(LEASE, AP_BSSID, AP_CHANNEL);
+  wifi.process();
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTED, wifi.getState());
+  WiFi.reset();
+}
+}  // namespace
+
+void setUp() {
+  host::resetClock();
+  unixS = 1700000000;
+  WiFi.reset();
+  Preferences::wipeAll();
+}
+
+void tearDown() {}
+
+void test_first_boot_scans_and_stores_cache() {
+  AppConfig config = homeConfig();
+  WifiProvisioning wifi;
+  wifi.setUnixClock(unixClock);
+  wifi.begin(&config);
+
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTING, wifi.getState());
+  TEST_ASSERT_EQUAL(1, WiFi.begins.size());
+  TEST_ASSERT_FALSE(WiFi.begins[0].withBssid);
+  TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)WiFi.configIp);  // DHCP
+
+  runFor(wifi, 2500);
+  WiFi.connectTo(LEASE, AP_BSSID, AP_CHANNEL);
+  wifi.process();
+
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTED, wifi.getState());
+  TEST_ASSERT_FALSE(wifi.lastConnectWasFast());
+  TEST_ASSERT_EQUAL(2500, wifi.getLastConnectDurationMs());
+  TEST_ASSERT_TRUE(cacheStored());
+  TEST_ASSERT_EQUAL_UINT32(1700000000, storedCache().leaseObtainedAt);
+}
+
+void test_fast_connect_uses_cached_bssid_channel_and_lease() {
+  AppConfig config = homeConfig();
+  bootAndConnect(config);
+
+  host::resetClock();
+  unixS += 600;  // reboot po 10 minutách
+  WifiProvisioning wifi;
+  wifi.setUnixClock(unixClock);
+  wifi.begin(&config);
+
+  TEST_ASSERT_EQUAL(1, WiFi.begins.size());
+  TEST_ASSERT_TRUE(WiFi.begins[0].withBssid);
+  TEST_ASSERT_EQUAL_MEMORY(AP_BSSID, WiFi.begins[0].bssid, 6);
+  TEST_ASSERT_EQUAL(AP_CHANNEL, WiFi.begins[0].channel);
+  TEST_ASSERT_TRUE(WiFi.configIp == LEASE);  // bez čekání na DHCP
+
+  runFor(wifi, 300);
+  WiFi.connectTo(LEASE, AP_BSSID, AP_CHANNEL);
+  wifi.process();
+
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTED, wifi.getState());
+  TEST_ASSERT_TRUE(wifi.lastConnectWasFast());
+  TEST_ASSERT_LESS_THAN(2000, wifi.getLastConnectDurationMs());
+
+  // Po připojení se znovu zapne DHCP; převzatá adresa lease neprodlouží
+  TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)WiFi.configIp);
+  TEST_ASSERT_EQUAL_UINT32(1700000000, storedCache().leaseObtainedAt);
+
+  // DHCP server lease potvrdil: uloží se s novým časem
+  runFor(wifi, 200);
+  WiFi.emit(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  wifi.process();
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTED, wifi.getState());
+  TEST_ASSERT_EQUAL_UINT32(1700000600, storedCache().leaseObtainedAt);
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)LEASE, storedCache().ip);
+}
+
+void test_expired_lease_fast_connects_with_dhcp() {
+  AppConfig config = homeConfig();
+  bootAndConnect(config);
+
+  // Přes noc vypnuto: BSSID a kanál platí dál, adresa už ne
+  host::resetClock();
+  unixS += 8 * 3600;
+  WifiProvisioning wifi;
+  wifi.setUnixClock(unixClock);
+  wifi.begin(&config);
+  TEST_ASSERT_TRUE(WiFi.begins[0].withBssid);
+  TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)WiFi.configIp);
+  unsigned configCalls = WiFi.configCalls;
+
+  const IPAddress other(192, 168, 1, 90);  // server mezitím adresu přidělil jinému
+  runFor(wifi, 400);
+  WiFi.connectTo(other, AP_BSSID, AP_CHANNEL);
+  wifi.process();
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTED, wifi.getState());
+  TEST_ASSERT_TRUE(wifi.lastConnectWasFast());
+  TEST_ASSERT_EQUAL(configCalls, WiFi.configCalls);  // DHCP už běží, žádný restart klienta
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)other, storedCache().ip);
+  TEST_ASSERT_EQUAL_UINT32(1700000000 + 8 * 3600, storedCache().leaseObtainedAt);
+
+  // Těsně za hranicí stáří (30 min) také DHCP
+  WiFi.reset();
+  host::resetClock();
+  unixS += 1800;
+  WifiProvisioning late;
+  late.setUnixClock(unixClock);
+  late.begin(&config);
+  TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)WiFi.configIp);
+}
+
+void test_lease_without_valid_clock_is_not_reused() {
+  // Studený start bez SNTP: stáří lease nejde ověřit
+  unixS = 0;
+  AppConfig config = homeConfig();
+  bootAndConnect(config);
+  TEST_ASSERT_EQUAL_UINT32(0, storedCache().leaseObtainedAt);
+
+  unixS = 1700000000;
+  WifiProvisioning wifi;
+  wifi.setUnixClock(unixClock);
+  wifi.begin(&config);
+  TEST_ASSERT_TRUE(WiFi.begins[0].withBssid);
+  TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)WiFi.configIp);
+
+  // Hodiny jdou pozpátku (RTC po výpadku napájení): adresa z cache také ne
+  unixS = 1700000000;
+  bootAndConnect(config);
+  unixS = 1600000000;
+  WifiProvisioning back;
+  back.setUnixClock(unixClock);
+  back.begin(&config);
+  TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)WiFi.configIp);
+}
+
+void test_fast_connect_timeout_falls_back_to_scan() {
+  AppConfig config = homeConfig();
+  bootAndConnect(config);
+
+  host::resetClock();
+  WifiProvisioning wifi;
+  wifi.begin(&config);
+  runFor(wifi, 2990);
+  TEST_ASSERT_EQUAL(1, WiFi.begins.size());
+
+  // AP změnil kanál: rychlý pokus do 3 s neprojde
+  runFor(wifi, 20);
+  TEST_ASSERT_EQUAL(2, WiFi.begins.size());
+  TEST_ASSERT_FALSE(WiFi.begins[1].withBssid);
+  TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)WiFi.configIp);
+  TEST_ASSERT_FALSE(cacheStored());
+
+  WiFi.connectTo(LEASE, AP_BSSID, 11);
+  wifi.process();
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTED, wifi.getState());
+  TEST_ASSERT_FALSE(wifi.lastConnectWasFast());
+  TEST_ASSERT_TRUE(cacheStored());
+}
+
+void test_fast_connect_rejected_falls_back_immediately() {
+  AppConfig config = homeConfig();
+  bootAndConnect(config);
+
+  host::resetClock();
+  WifiProvisioning wifi;
+  wifi.begin(&config);
+  runFor(wifi, 100);
+  WiFi.drop(WIFI_REASON_NO_AP_FOUND);
+  wifi.process();
+
+  TEST_ASSERT_EQUAL(2, WiFi.begins.size());
+  TEST_ASSERT_FALSE(WiFi.begins[1].withBssid);
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTING, wifi.getState());
+}
+
+void test_changed_credentials_ignore_cache() {
+  AppConfig config = homeConfig();
+  bootAndConnect(config);
+
+  config.wifiPassword.assign("changed");
+  WifiProvisioning wifi;
+  wifi.begin(&config);
+  TEST_ASSERT_FALSE(WiFi.begins[0].withBssid);
+}
+
+void test_static_ip_is_applied_and_not_cached_as_lease() {
+  AppConfig config = homeConfig();
+  config.wifiStaticIp = true;
+  config.wifiStaticAddress.assign("192.168.1.50");
+  config.wifiGateway.assign("192.168.1.1");
+  bootAndConnect(config);
+
+  WifiProvisioning wifi;
+  wifi.begin(&config);
+  TEST_ASSERT_TRUE(WiFi.begins[0].withBssid);
+  TEST_ASSERT_TRUE(WiFi.configIp == IPAddress(192, 168, 1, 50));
+  TEST_ASSERT_TRUE(WiFi.configDns == IPAddress(192, 168, 1, 1));  // bez DNS = brána
+
+  Preferences pref;
+  pref.begin("wificache", true);
+  WifiFastConnectCache cache;
+  pref.getBytes("last", &cache, sizeof(cache));
+  pref.end();
+  TEST_ASSERT_EQUAL_UINT32(0, cache.ip);
+}
+
+void test_scan_timeout_opens_captive_portal() {
+  AppConfig config = homeConfig();
+  WifiProvisioning wifi;
+  wifi.begin(&config, 20000);
+
+  runFor(wifi, 19990);
+  TEST_ASSERT_EQUAL(WIFI_STA_CONNECTING, wifi.getState());
+  runFor(wifi, 20);
+  TEST_ASSERT_EQUAL(WIFI_AP_CAPTIVE, wifi.getState());
+  TEST_ASSERT_TRUE(wifi.isCaptiveMode());
+  TEST_ASSERT_TRUE(WiFi.apRunning);
+  TEST_ASSERT_EQUAL(WIFI_AP, WiFi.getMode());
+}
+
+void test_missing_credentials_start_captive_portal() {
+  AppConfig config;
+  WifiProvisioning wifi;
+  wifi.begin(&config);
+
+  TEST_ASSERT_EQUAL(WIFI_AP_CAPTIVE, wifi.getState());
+  TEST_ASSERT_EQUAL(0, WiFi.begins.size());
+  TEST_ASSERT_EQUAL_STRING("SharpDisplay-123456", wifi.getApSsid());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_first_boot_scans_and_stores_cache);
+  RUN_TEST(test_fast_connect_uses_cached_bssid_channel_and_lease);
+  RUN_TEST(test_expired_lease_fast_connects_with_dhcp);
+  RUN_TEST(test_lease_without_valid_clock_is_not_reused);
+  RUN_TEST(test_fast_connect_timeout_falls_back_to_scan);
+  RUN_TEST(test_fast_connect_rejected_falls_back_immediately);
+  RUN_TEST(test_changed_credentials_ignore_cache);
+  RUN_TEST(test_static_ip_is_applied_and_not_cached_as_lease);
+  RUN_TEST(test_scan_timeout_opens_captive_portal);
+  RUN_TEST(test_missing_credentials_start_captive_portal);
+  return UNITY_END();
+}
@@ -0,0 +1,170 @@
+#include "MqttLink.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+constexpr int WRITE_TIMEOUT_MS = 2000;
+
+void appendLength(std::vector<uint8_t>& out, size_t length) {
+  do {
+    uint8_t b = length % 128;
+    length /= 128;
+    out.push_back(length ? b | 0x80 : b);
+  } while (length);
+}
+}  // namespace
+
+void appendString(std::vector<uint8_t>& out, const char* s) {
+  size_t length = strlen(s);
+  out.push_back(length >> 8);
+  out.push_back(length & 0xFF);
+  out.insert(out.end(), s, s + length);
+}
+
+bool MqttLink::open(const char* host, uint16_t port) {
+  close();
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* addresses = nullptr;
+  char service[8];
+  snprintf(service, sizeof(service), "%u", port);
+  if (getaddrinfo(host, service, &hints, &addresses) != 0) return false;
+  for (addrinfo* a = addresses; a && fd_ < 0; a = a->ai_next) {
+    fd_ = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (fd_ < 0) continue;
+    if (connect(fd_, a->ai_addr, a->ai_addrlen) != 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+  }
+  freeaddrinfo(addresses);
+  if (fd_ < 0) return false;
+  int one = 1;
+  setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));  // jako lwIP: malé pakety hned
+  fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+  in_.clear();
+  return true;
+}
+
+void MqttLink::close() {
+  if (fd_ >= 0) ::close(fd_);
+  fd_ = -1;
+  in_.clear();
+}
+
+bool MqttLink::write(const uint8_t* data, size_t length) {
+  if (fd_ < 0) return false;
+  while (length > 0) {
+    ssize_t n = send(fd_, data, length, MSG_NOSIGNAL);
+    if (n > 0) {
+      data += n;
+      length -= n;
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      // Broker nestíhá číst - počkat jako blokující zápis WiFiClient
+      pollfd p = {fd_, POLLOUT, 0};
+      if (poll(&p, 1, WRITE_TIMEOUT_MS) > 0) continue;
+    } else if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    close();
+    return false;
+  }
+  return true;
+}
+
+bool MqttLink::receive() {
+  if (fd_ < 0) return false;
+  uint8_t buf[4096];
+  for (;;) {
+    ssize_t n = recv(fd_, buf, sizeof(buf), 0);
+    if (n > 0) {
+      in_.insert(in_.end(), buf, buf + n);
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+    if (n < 0 && errno == EINTR) continue;
+    close();
+    return false;
+  }
+}
+
+bool MqttLink::next(Packet& packet) {
+  if (in_.size() < 2) return false;
+  size_t i = 1;
+  size_t length = 0;
+  uint32_t multiplier = 1;
+  for (;;) {
+    if (i >= in_.size() || i > 4) return false;
+    length += (in_[i] & 0x7F) * multiplier;
+    multiplier *= 128;
+    if (!(in_[i++] & 0x80)) break;
+  }
+  if (in_.size() < i + length) return false;
+  packet.header = in_[0];
+  packet.body.assign(in_.begin() + i, in_.begin() + i + length);
+  in_.erase(in_.begin(), in_.begin() + i + length);
+  return true;
+}
+
+bool MqttLink::sendPacket(uint8_t header, const std::vector<uint8_t>& body) {
+  std::vector<uint8_t> packet;
+  packet.reserve(body.size() + 5);
+  packet.push_back(header);
+  appendLength(packet, body.size());
+  packet.insert(packet.end(), body.begin(), body.end());
+  return write(packet.data(), packet.size());
+}
+
+bool MqttLink::sendConnect(const char* clientId, uint16_t keepAliveS) {
+  std::vector<uint8_t> body;
+  appendString(body, "MQTT");
+  body.push_back(4);     // MQTT 3.1.1
+  body.push_back(0x02);  // clean session, jako PubSubClient
+  body.push_back(keepAliveS >> 8);
+  body.push_back(keepAliveS & 0xFF);
+  appendString(body, clientId);
+  return sendPacket(0x10, body);
+}
+
+bool MqttLink::sendSubscribe(uint16_t packetId, const char* topic, uint8_t qos) {
+  std::vector<uint8_t> body;
+  body.push_back(packetId >> 8);
+  body.push_back(packetId & 0xFF);
+  appendString(body, topic);
+  body.push_back(qos);
+  return sendPacket(0x82, body);
+}
+
+bool MqttLink::sendPublish(const char* topic, const char* payload, size_t length, bool retain) {
+  std::vector<uint8_t> body;
+  appendString(body, topic);
+  body.insert(body.end(), payload, payload + length);
+  return sendPacket(retain ? 0x31 : 0x30, body);
+}
+
+bool MqttLink::sendPing() { return sendPacket(0xC0, {}); }
+
+bool MqttLink::sendDisconnect() { return sendPacket(0xE0, {}); }
+
+bool parsePublish(const MqttLink::Packet& packet, std::string& topic, std::string& payload) {
+  if ((packet.header & 0xF0) != 0x30 || packet.body.size() < 2) return false;
+  size_t topicLength = (packet.body[0] << 8) | packet.body[1];
+  size_t start = 2 + topicLength + ((packet.header & 0x06) ? 2 : 0);  // packet id u QoS > 0
+  if (packet.body.size() < start) return false;
+  topic.assign((const char*)packet.body.data() + 2, topicLength);
+  payload.assign((const char*)packet.body.data() + start, packet.body.size() - start);
+  return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+// Jedno TCP spojení na broker pro zátěžový nástroj: blokující connect,
+// neblokující čtení rozdělené na celé MQTT pakety a kódování těch paketů,
+// které firmware posílá přes PubSubClient (CONNECT, SUBSCRIBE, PUBLISH
+// QoS 0, PINGREQ, DISCONNECT). QoS 1 PUBLISH kóduje MqttOutbox.
+class MqttLink {
+ public:
+  struct Packet {
+    uint8_t header = 0;  // typ v horních 4 bitech, příznaky v dolních
+    std::vector<uint8_t> body;
+  };
+
+  ~MqttLink() { close(); }
+
+  bool open(const char* host, uint16_t port);
+  void close();
+  bool isOpen() const { return fd_ >= 0; }
+  int fd() const { return fd_; }
+
+  // Celý paket do socketu; false = spojení spadlo (zavře se)
+  bool write(const uint8_t* data, size_t length);
+  // Přečte, co je k dispozici; false = spojení zavřel broker nebo chyba
+  bool receive();
+  // Další celý paket z přijatých dat
+  bool next(Packet& packet);
+
+  bool sendConnect(const char* clientId, uint16_t keepAliveS);
+  bool sendSubscribe(uint16_t packetId, const char* topic, uint8_t qos);
+  bool sendPublish(const char* topic, const char* payload, size_t length, bool retain);
+  bool sendPing();
+  bool sendDisconnect();
+
+  uint32_t lastWriteAt = 0;  // pro PINGREQ (keepalive), plní volající
+
+ private:
+  bool sendPacket(uint8_t header, const std::vector<uint8_t>& body);
+
+  int fd_ = -1;
+  std::vector<uint8_t> in_;
+};
+
+void appendString(std::vector<uint8_t>& out, const char* s);
+// Topic a payload příchozího PUBLISH (QoS 0 i 1)
+bool parsePublish(const MqttLink::Packet& packet, std::string& topic, std::string& payload);
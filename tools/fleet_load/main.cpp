@@ -0,0 +1,601 @@
+// Zátěž brokeru flotilou panelů: N virtuálních zařízení v jednom procesu,
+// každé se skutečným TCP spojením na broker (Mosquitto), vlastní fází hodin
+// a vlastním místem v referenčních stopách traces/. Připojení a HA discovery
+// plánují ReconnectBackoff a DiscoveryPacer, topicy skládá MqttTopics, JSON
+// vzorku SamplePayload a senzorová data jdou přes MqttOutbox (QoS 1 s okénkem)
+// - stejný kód jako firmware. Pozorovatel na dalším spojení odebírá JSON
+// všech zařízení (latence od razítka vzorku) a $SYS brokeru.
+//
+// Scénář: start celé flotily, výpadek sítě (všechna spojení spadnou a po
+// dobu výpadku se nikdo nepřipojí), návrat, restart Home Assistantu (birth
+// zpráva všem naráz). Topicy jsou pod sim/, discovery pod sim-homeassistant/,
+// takže skutečné panely ani HA na stejném brokeru nic nezachytí.
+//
+//   pio run -e fleet_load
+//   .pio/build/fleet_load/program --devices 100 --duration 240 --outage-at 60 --outage-for 60 --ha-restart-at 180
+
+#include <FakeSensor.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "MqttLink.h"
+#include "MqttOutbox.h"
+#include "MqttPacing.h"
+#include "MqttTopics.h"
+#include "SamplePayload.h"
+#include "SampleText.h"
+#include "SensorRegistry.h"
+#include "SensorTrace.h"
+
+namespace {
+constexpr uint32_t STEP_MS = 10;             // průchod loop() zařízení
+constexpr uint16_t KEEPALIVE_S = 15;         // MQTT_KEEPALIVE_S
+constexpr uint32_t CONNACK_TIMEOUT_MS = 5000;
+constexpr uint32_t REPORT_EVERY_MS = 5000;
+constexpr const char* HA_PREFIX = "homeassistant/";
+constexpr const char* SIM_HA_PREFIX = "sim-homeassistant/";
+
+struct Options {
+  std::string host = "127.0.0.1";
+  uint16_t port = 1883;
+  uint16_t devices = 10;
+  uint32_t durationS = 120;
+  uint32_t intervalMs = 10000;  // mqttPublishInterval
+  uint32_t outageAtS = 0;       // 0 = bez výpadku
+  uint32_t outageForS = 60;
+  uint32_t haRestartAtS = 0;    // 0 = bez restartu HA
+  bool keepRetained = false;
+};
+
+// Čítače za jednu sekundu běhu
+struct Second {
+  uint32_t attempts = 0;
+  uint32_t published = 0;  // PUBLISH od zařízení (data i discovery)
+  uint32_t discovery = 0;
+  uint32_t pubacks = 0;
+  uint32_t observed = 0;   // JSON vzorků, které dostal pozorovatel
+};
+
+struct Stats {
+  std::vector<Second> seconds;
+  uint32_t attempts = 0;
+  uint32_t refused = 0;        // TCP odmítnuto, CONNACK s chybou nebo bez odpovědi
+  uint32_t drops = 0;          // spojení spadlo mimo simulovaný výpadek
+  std::vector<uint32_t> latencyMs;  // razítko vzorku -> pozorovatel
+  std::string sysReceived = "-";    // $SYS/broker/load/messages/received/1min
+  std::string sysSent = "-";
+  std::string sysClients = "-";
+
+  Second& at(uint32_t now) {
+    uint32_t s = now / 1000;
+    if (seconds.size() <= s) seconds.resize(s + 1);
+    return seconds[s];
+  }
+};
+
+Options options;
+Stats stats;
+std::mt19937 rng(45);
+SensorRegistry sensors;
+FakeSensor sen66("SEN66", {CH_TEMPERATURE, CH_HUMIDITY, CH_PM1, CH_PM25, CH_PM4, CH_PM10, CH_VOC, CH_NOX, CH_CO2});
+std::vector<SensorSample> trace;
+std::chrono::steady_clock::time_point startedAt;
+volatile sig_atomic_t interrupted = 0;
+
+uint32_t nowMs() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startedAt)
+      .count();
+}
+
+uint64_t wallMs() {
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// discovery firmware jde do homeassistant/, simulace do sim-homeassistant/
+std::string simTopic(const char* topic) {
+  size_t length = strlen(HA_PREFIX);
+  if (strncmp(topic, HA_PREFIX, length) == 0) return std::string(SIM_HA_PREFIX) + (topic + length);
+  return topic;
+}
+
+struct Device {
+  char clientId[24];
+  MqttLink link;
+  MqttTopics topics;
+  MqttOutbox outbox;
+  ReconnectBackoff backoff;
+  DiscoveryPacer discovery;
+  SampleText text;
+
+  bool connected = false;
+  bool awaitingConnack = false;
+  bool discoveryPublished = false;
+  uint32_t connectSentAt = 0;
+  uint32_t disconnectedAt = 0;
+  uint32_t connectedAt = 0;    // poslední úspěšné připojení
+  uint32_t nextPublishAt = 0;
+  uint32_t sequence = 0;
+  size_t traceIndex = 0;
+  uint32_t discoveryDoneAt = 0;
+
+  void drop() {
+    link.close();
+    connected = false;
+    awaitingConnack = false;
+  }
+};
+
+std::vector<std::unique_ptr<Device>> devices;
+
+bool outageActive(uint32_t now) {
+  uint32_t at = options.outageAtS * 1000;
+  return options.outageAtS && now >= at && now < at + options.outageForS * 1000;
+}
+
+// Discovery entity jako publishDiscoveryEntity() ve firmware
+bool publishDiscovery(Device& d, uint8_t entity) {
+  const char* name;
+  const char* unit;
+  const char* devClass;
+  const char* icon;
+  if (entity < sensors.channelCount()) {
+    const SensorChannel& ch = sensors.channel(entity);
+    const ChannelKindInfo& info = channelKindInfo(ch.kind);
+    name = ch.name;
+    unit = info.unit;
+    devClass = info.devClass;
+    icon = info.icon;
+  } else {
+    const AirQualityEntity& aq = AIR_QUALITY_ENTITIES[entity - sensors.channelCount()];
+    name = aq.name;
+    unit = aq.unit;
+    devClass = aq.devClass;
+    icon = aq.icon;
+  }
+  // Stejná velikost zprávy jako publishDiscoveryEntity() včetně bloku zařízení
+  char device[160];
+  JsonWriter dev(device, sizeof(device));
+  dev.beginArray("identifiers");
+  dev.arrayString(d.topics.deviceIdentifier());
+  dev.endArray();
+  dev.string("name", d.clientId);
+  dev.string("model", "ESP32-C3 + SEN66 + Sharp LCD");
+  dev.string("manufacturer", "DIY");
+  dev.string("sw_version", "2.0.0");
+  if (!dev.finish()) return true;
+
+  char payload[1024];
+  JsonWriter json(payload, sizeof(payload));
+  json.string("name", name);
+  json.string("unique_id", d.topics.uniqueId(entity));
+  json.string("state_topic", d.topics.stateTopic(entity));
+  if (unit && *unit) json.string("unit_of_measurement", unit);
+  if (devClass) json.string("device_class", devClass);
+  if (icon) json.string("icon", icon);
+  json.string("availability_topic", d.topics.topic(MQTT_T_STATUS));
+  json.string("payload_available", "online");
+  json.string("payload_not_available", "offline");
+  json.raw("device", device);
+  size_t length = json.finish();
+  if (!length) return true;
+  std::string topic = simTopic(d.topics.discoveryTopic(entity));
+  return d.link.sendPublish(topic.c_str(), payload, length, true);
+}
+
+// Vzorek ze stopy jako publishSensorData(): state topicy kanálů a JSON, QoS 1 přes outbox
+void publishSample(Device& d, uint32_t now) {
+  SensorSample sample = trace[d.traceIndex];
+  d.traceIndex = (d.traceIndex + 1) % trace.size();
+  sample.sequence = ++d.sequence;
+  sample.unixMs = wallMs();
+  d.text.update(sensors, sample);
+  for (uint8_t i = 0; i < sensors.channelCount(); i++) {
+    if (!sample.isValid(i)) continue;
+    const char* value = d.text.value(i);
+    d.outbox.publish(d.topics.stateTopic(i), (const uint8_t*)value, strlen(value), true);
+  }
+  char payload[1024];
+  AirQualityIndex aq;
+  size_t length = buildSensorJson(sensors, sample, d.text, aq, now / 1000, 0, payload, sizeof(payload));
+  if (length) d.outbox.publish(d.topics.topic(MQTT_T_SENSOR), (const uint8_t*)payload, length, true, sample.sequence, now);
+}
+
+void onConnected(Device& d, uint32_t now) {
+  d.connected = true;
+  d.awaitingConnack = false;
+  d.connectedAt = now;
+  d.disconnectedAt = 0;
+  d.backoff.reset();
+  std::string status = simTopic(d.topics.topic(MQTT_T_HA_STATUS));
+  d.link.sendSubscribe(1, status.c_str(), 0);
+  d.link.lastWriteAt = now;
+  d.outbox.onConnected();
+  if (!d.discoveryPublished) d.discovery.start(now);
+}
+
+void receive(Device& d, uint32_t now) {
+  if (!d.link.isOpen()) return;
+  if (!d.link.receive()) {
+    if (d.connected) stats.drops++;
+    d.drop();
+    return;
+  }
+  MqttLink::Packet packet;
+  std::string topic, payload;
+  while (d.link.next(packet)) {
+    uint8_t type = packet.header >> 4;
+    if (type == 2 && d.awaitingConnack) {
+      if (packet.body.size() == 2 && packet.body[1] == 0) {
+        onConnected(d, now);
+      } else {
+        stats.refused++;
+        d.drop();
+        d.backoff.schedule(now, true, rng());
+        return;
+      }
+    } else if (type == 4 && packet.body.size() == 2) {
+      d.outbox.onPuback((packet.body[0] << 8) | packet.body[1], now);
+      stats.at(now).pubacks++;
+    } else if (type == 3 && parsePublish(packet, topic, payload) && payload == "online") {
+      d.discovery.startJittered(now, rng());  // birth zpráva HA
+    }
+  }
+}
+
+// Jeden průchod loop() zařízení - stejné pořadí jako v main.cpp
+void step(Device& d, uint32_t now) {
+  receive(d, now);
+
+  if (!d.connected && !d.awaitingConnack) {
+    if (d.disconnectedAt == 0) {
+      d.disconnectedAt = now ? now : 1;
+      d.backoff.schedule(now, false, rng());
+    }
+    if (d.backoff.due(now)) {
+      stats.attempts++;
+      stats.at(now).attempts++;
+      if (!outageActive(now) && d.link.open(options.host.c_str(), options.port) &&
+          d.link.sendConnect(d.clientId, KEEPALIVE_S)) {
+        d.awaitingConnack = true;
+        d.connectSentAt = now;
+      } else {
+        stats.refused++;
+        d.drop();
+        d.backoff.schedule(now, true, rng());
+      }
+    }
+  }
+  if (d.awaitingConnack && now - d.connectSentAt > CONNACK_TIMEOUT_MS) {
+    stats.refused++;
+    d.drop();
+    d.backoff.schedule(now, true, rng());
+  }
+
+  if (d.connected) {
+    uint16_t total = d.topics.entityCount();
+    int16_t entity = d.discovery.due(now, total);
+    if (entity >= 0) {
+      bool sent = publishDiscovery(d, (uint8_t)entity);
+      if (sent) {
+        stats.at(now).published++;
+        stats.at(now).discovery++;
+      }
+      if (d.discovery.sent(now, sent, total)) {
+        d.discoveryPublished = true;
+        d.discoveryDoneAt = now;
+      }
+    }
+    if ((int32_t)(now - d.nextPublishAt) >= 0) {
+      d.nextPublishAt += options.intervalMs;
+      if ((int32_t)(now - d.nextPublishAt) >= 0) d.nextPublishAt = now + options.intervalMs;
+      publishSample(d, now);
+    }
+  }
+  uint32_t before = d.outbox.getStats().retransmits + d.outbox.getStats().delivered + d.outbox.getStats().inFlight;
+  d.outbox.process(now, d.connected);
+  MqttOutboxStats os = d.outbox.getStats();
+  stats.at(now).published += os.retransmits + os.delivered + os.inFlight - before;
+  if (d.connected && !d.link.isOpen()) {
+    stats.drops++;
+    d.drop();
+  }
+  if (d.connected && now - d.link.lastWriteAt > KEEPALIVE_S * 500UL) {
+    d.link.sendPing();
+    d.link.lastWriteAt = now;
+  }
+}
+
+// Pozorovatel: JSON vzorků všech zařízení a zatížení brokeru z $SYS
+struct Monitor {
+  MqttLink link;
+
+  bool open() {
+    if (!link.open(options.host.c_str(), options.port) || !link.sendConnect("sim-monitor", 60)) return false;
+    link.sendSubscribe(1, "sim/+/sensor", 0);
+    link.sendSubscribe(2, "$SYS/broker/load/messages/+/1min", 0);
+    link.sendSubscribe(3, "$SYS/broker/clients/connected", 0);
+    return true;
+  }
+
+  void poll(uint32_t now) {
+    if (!link.isOpen() || !link.receive()) return;
+    MqttLink::Packet packet;
+    std::string topic, payload;
+    while (link.next(packet)) {
+      if (!parsePublish(packet, topic, payload)) continue;
+      if (topic.compare(0, 4, "$SYS") == 0) {
+        if (topic.find("/received/") != std::string::npos) stats.sysReceived = payload;
+        if (topic.find("/sent/") != std::string::npos) stats.sysSent = payload;
+        if (topic.find("/clients/connected") != std::string::npos) stats.sysClients = payload;
+        continue;
+      }
+      size_t ts = payload.find("\"ts\":");
+      if (ts == std::string::npos) continue;
+      uint64_t stamp = strtoull(payload.c_str() + ts + 5, nullptr, 10);
+      uint64_t wall = wallMs();
+      stats.latencyMs.push_back(wall > stamp ? (uint32_t)(wall - stamp) : 0);
+      stats.at(now).observed++;
+    }
+  }
+
+  void haRestart() {
+    std::string topic = std::string(SIM_HA_PREFIX) + "status";
+    link.sendPublish(topic.c_str(), "online", 6, false);
+  }
+};
+
+uint32_t percentile(std::vector<uint32_t> values, double p) {
+  if (values.empty()) return 0;
+  size_t index = (size_t)(p * (values.size() - 1));
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+  return values[index];
+}
+
+uint32_t peak(uint32_t Second::*field, uint32_t fromS, uint32_t toS) {
+  uint32_t best = 0;
+  for (uint32_t s = fromS; s < toS && s < stats.seconds.size(); s++) best = std::max(best, stats.seconds[s].*field);
+  return best;
+}
+
+void loadTrace() {
+  for (const char* name : {"traces/cooking.bin", "traces/window.bin"}) {
+    FILE* f = fopen(name, "rb");
+    if (!f) continue;
+    uint8_t buf[SensorTrace::RECORD_BYTES];
+    fseek(f, 16, SEEK_SET);  // hlavička stopy
+    while (fread(buf, 1, sizeof(buf), f) == sizeof(buf)) {
+      SensorTraceRecord rec;
+      SensorTrace::decodeRecord(buf, rec);
+      if (rec.error) continue;
+      SensorSample sample;
+      const float values[] = {rec.temp, rec.hum, rec.pm1, rec.pm25, rec.pm4, rec.pm10, rec.voc, rec.nox,
+                              rec.co2 == 0xFFFF ? NAN : (float)rec.co2};
+      for (uint8_t c = 0; c < 9; c++) {
+        sample.values[c] = values[c];
+        if (!isnan(values[c])) sample.validMask |= 1UL << c;
+      }
+      trace.push_back(sample);
+    }
+    fclose(f);
+  }
+}
+
+bool parseOptions(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (arg == "--keep-retained") {
+      options.keepRetained = true;
+      continue;
+    }
+    if (!value) return false;
+    i++;
+    if (arg == "--host") {
+      options.host = value;
+    } else if (arg == "--port") {
+      options.port = (uint16_t)atoi(value);
+    } else if (arg == "--devices") {
+      options.devices = (uint16_t)atoi(value);
+    } else if (arg == "--duration") {
+      options.durationS = (uint32_t)atoi(value);
+    } else if (arg == "--interval-ms") {
+      options.intervalMs = (uint32_t)atoi(value);
+    } else if (arg == "--outage-at") {
+      options.outageAtS = (uint32_t)atoi(value);
+    } else if (arg == "--outage-for") {
+      options.outageForS = (uint32_t)atoi(value);
+    } else if (arg == "--ha-restart-at") {
+      options.haRestartAtS = (uint32_t)atoi(value);
+    } else {
+      return false;
+    }
+  }
+  return options.devices > 0 && options.intervalMs > 0;
+}
+
+// Smazat retained stavy a discovery, ať po simulaci na brokeru nic nezůstane
+void clearRetained() {
+  for (auto& d : devices) {
+    if (!d->connected) continue;
+    for (uint8_t e = 0; e < d->topics.entityCount(); e++) {
+      d->link.sendPublish(d->topics.stateTopic(e), "", 0, true);
+      d->link.sendPublish(simTopic(d->topics.discoveryTopic(e)).c_str(), "", 0, true);
+    }
+    d->link.sendPublish(d->topics.topic(MQTT_T_SENSOR), "", 0, true);
+    d->link.sendDisconnect();
+    d->link.close();
+  }
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (!parseOptions(argc, argv)) {
+    fprintf(stderr,
+            "pouziti: %s [--host 127.0.0.1] [--port 1883] [--devices N] [--duration S] [--interval-ms MS]\n"
+            "          [--outage-at S] [--outage-for S] [--ha-restart-at S] [--keep-retained]\n",
+            argv[0]);
+    return 2;
+  }
+  signal(SIGINT, [](int) { interrupted = 1; });
+  signal(SIGPIPE, SIG_IGN);
+
+  loadTrace();
+  if (trace.empty()) {
+    fprintf(stderr, "stopy traces/*.bin nenalezeny (spoustet z korene repozitare)\n");
+    return 1;
+  }
+  sensors.add(&sen66, I2cBus());
+  sensors.begin();
+
+  startedAt = std::chrono::steady_clock::now();
+  for (uint16_t i = 0; i < options.devices; i++) {
+    std::unique_ptr<Device> d(new Device());
+    Device* raw = d.get();
+    snprintf(d->clientId, sizeof(d->clientId), "sim-%04u", i);
+    char base[24];
+    snprintf(base, sizeof(base), "sim/%04u", i);
+    d->topics.begin(base, d->clientId);
+    for (uint8_t c = 0; c < sensors.channelCount(); c++) d->topics.addEntity(sensors.channel(c).key, sensors.channel(c).uid);
+    char uid[32];
+    for (uint8_t a = 0; a < AQE_COUNT; a++) {
+      snprintf(uid, sizeof(uid), "sharp_%s", AIR_QUALITY_ENTITIES[a].key);
+      d->topics.addEntity(AIR_QUALITY_ENTITIES[a].key, uid);
+    }
+    d->outbox.begin([raw](const uint8_t* data, size_t length) {
+      raw->link.lastWriteAt = nowMs();
+      return raw->link.write(data, length);
+    });
+    // Vlastní fáze hodin a místo ve stopě; první pokus o připojení plánuje backoff jako po zapnutí (2.5-5 s)
+    d->nextPublishAt = rng() % options.intervalMs;
+    d->traceIndex = rng() % trace.size();
+    devices.push_back(std::move(d));
+  }
+
+  Monitor monitor;
+  if (!monitor.open()) {
+    fprintf(stderr, "broker %s:%u nedostupny\n", options.host.c_str(), options.port);
+    return 1;
+  }
+
+  printf("%u zarizeni, broker %s:%u, vzorek po %lu ms, %lu s\n", options.devices, options.host.c_str(), options.port,
+         (unsigned long)options.intervalMs, (unsigned long)options.durationS);
+  printf("%7s %9s %9s %9s %9s %9s %9s\n", "cas s", "spojeno", "pokusy/s", "publ/s", "puback/s", "prijato/s",
+         "disc/s");
+
+  uint32_t endMs = options.durationS * 1000;
+  uint32_t outageEndMs = (options.outageAtS + options.outageForS) * 1000;
+  uint32_t haRestartMs = options.haRestartAtS * 1000;
+  bool outageStarted = false;
+  bool haRestarted = false;
+  uint32_t allConnectedAt = 0;        // po startu
+  uint32_t allReconnectedAt = 0;      // po výpadku
+  uint32_t lastReport = 0;
+  uint32_t next = 0;
+
+  while (!interrupted) {
+    uint32_t now = nowMs();
+    if (now >= endMs) break;
+    if (options.outageAtS && !outageStarted && now >= options.outageAtS * 1000) {
+      outageStarted = true;
+      for (auto& d : devices) d->drop();  // síť spadla: broker i zařízení spojení ztratí
+    }
+    if (options.haRestartAtS && !haRestarted && now >= haRestartMs) {
+      haRestarted = true;
+      monitor.haRestart();
+    }
+
+    for (auto& d : devices) step(*d, now);
+    monitor.poll(now);
+
+    uint16_t connected = 0;
+    for (auto& d : devices) connected += d->connected;
+    if (connected == options.devices) {
+      if (!allConnectedAt) allConnectedAt = now;
+      if (outageStarted && !allReconnectedAt && now >= outageEndMs) allReconnectedAt = now;
+    }
+    if (now - lastReport >= REPORT_EVERY_MS && now / 1000 > 0) {
+      lastReport = now - now % REPORT_EVERY_MS;
+      const Second& s = stats.at(now - 1000);
+      printf("%7lu %9u %9u %9u %9u %9u %9u\n", (unsigned long)(now / 1000), connected, s.attempts, s.published,
+             s.pubacks, s.observed, s.discovery);
+      fflush(stdout);
+    }
+
+    next += STEP_MS;
+    uint32_t after = nowMs();
+    if ((int32_t)(next - after) > 0) {
+      usleep((next - after) * 1000);
+    } else {
+      next = after;  // průchod všech zařízení trval déle než STEP_MS
+    }
+  }
+
+  uint32_t runMs = nowMs();
+  if (!options.keepRetained) clearRetained();
+
+  // Souhrn
+  uint64_t delivered = 0, accepted = 0, retransmits = 0;
+  std::vector<uint32_t> ackAvg, ackMax, deviceLatency;
+  uint32_t discoveryDone = 0;
+  for (auto& d : devices) {
+    MqttOutboxStats os = d->outbox.getStats();
+    delivered += os.delivered;
+    accepted += os.accepted;
+    retransmits += os.retransmits;
+    if (os.delivered) {
+      ackAvg.push_back(os.ackAvgMs);
+      ackMax.push_back(os.ackMaxMs);
+    }
+    if (haRestarted && d->discoveryDoneAt >= haRestartMs) discoveryDone = std::max(discoveryDone, d->discoveryDoneAt);
+  }
+  uint32_t runS = std::max<uint32_t>(1, runMs / 1000);
+  uint64_t published = 0, observed = 0;
+  for (const Second& s : stats.seconds) {
+    published += s.published;
+    observed += s.observed;
+  }
+
+  printf("\n== %u zarizeni, %lu s\n", options.devices, (unsigned long)(runMs / 1000));
+  printf("zpravy od zarizeni: %llu (%.0f/s, max %u/s), QoS 1 prijato %llu, potvrzeno %llu, opakovano %llu\n",
+         (unsigned long long)published, (double)published / runS, peak(&Second::published, 0, runS),
+         (unsigned long long)accepted, (unsigned long long)delivered, (unsigned long long)retransmits);
+  printf("pozorovatel: %llu JSON vzorku (%.0f/s); $SYS zprav/min prijato %s, odeslano %s, klientu %s\n",
+         (unsigned long long)observed, (double)observed / runS, stats.sysReceived.c_str(), stats.sysSent.c_str(),
+         stats.sysClients.c_str());
+  printf("pripojeni: pokusu %lu, odmitnuto %lu, spadlo %lu, max %u pokusu/s; vsichni pripojeni po startu za %.1f s\n",
+         (unsigned long)stats.attempts, (unsigned long)stats.refused, (unsigned long)stats.drops,
+         peak(&Second::attempts, 0, runS), allConnectedAt / 1000.0);
+  if (options.outageAtS) {
+    if (allReconnectedAt) {
+      printf("vypadek %lu s: vsichni znovu pripojeni %.1f s po obnoveni, max %u pokusu/s\n",
+             (unsigned long)options.outageForS, (allReconnectedAt - outageEndMs) / 1000.0,
+             peak(&Second::attempts, outageEndMs / 1000, runS));
+    } else {
+      printf("vypadek %lu s: do konce behu se nepripojili vsichni\n", (unsigned long)options.outageForS);
+    }
+  }
+  if (haRestarted) {
+    printf("restart HA: discovery max %u zprav/s, hotovo za %.1f s\n",
+           peak(&Second::discovery, haRestartMs / 1000, runS),
+           discoveryDone ? (discoveryDone - haRestartMs) / 1000.0 : -1.0);
+  }
+  printf("PUBLISH->PUBACK na zarizeni: prumer p50 %u ms, p95 %u ms; maximum p95 %u ms, nejhorsi %u ms\n",
+         percentile(ackAvg, 0.5), percentile(ackAvg, 0.95), percentile(ackMax, 0.95), percentile(ackMax, 1.0));
+  printf("vzorek->pozorovatel: p50 %u ms, p95 %u ms, p99 %u ms, max %u ms\n", percentile(stats.latencyMs, 0.5),
+         percentile(stats.latencyMs, 0.95), percentile(stats.latencyMs, 0.99), percentile(stats.latencyMs, 1.0));
+  return 0;
+}
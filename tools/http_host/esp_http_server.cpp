@@ -0,0 +1,419 @@
+#include "esp_http_server.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr size_t MAX_HEADER_BYTES = 1024;  // CONFIG_HTTPD_MAX_REQ_HDR_LEN
+
+struct Session {
+  int fd = -1;
+  std::string in;  // přijato, ještě nezpracováno (další požadavek keep-alive)
+  uint64_t lastUsed = 0;
+};
+
+// Stav jednoho požadavku (httpd_req_t::aux)
+struct RequestState {
+  Session* session = nullptr;
+  std::string query;
+  std::vector<std::pair<std::string, std::string>> headers;
+  size_t bodyLeft = 0;
+  const char* status = "200 OK";
+  const char* type = "text/html";
+  std::vector<std::pair<const char*, const char*>> respHeaders;  // jako IDF jen ukazatele
+  bool chunkStarted = false;
+  bool failed = false;
+  bool close = false;
+};
+
+struct Server {
+  httpd_config_t config;
+  int listenFd = -1;
+  std::thread thread;
+  std::atomic<bool> stop{false};
+  std::vector<httpd_uri_t> handlers;
+  httpd_err_handler_func_t errHandlers[HTTPD_ERR_CODE_MAX] = {};
+  std::vector<Session*> sessions;
+  uint64_t useCounter = 0;
+};
+
+RequestState& stateOf(httpd_req_t* req) { return *(RequestState*)req->aux; }
+
+bool sendAll(RequestState& state, const struct iovec* parts, int count) {
+  if (state.failed) return false;
+  std::vector<struct iovec> iov(parts, parts + count);
+  size_t index = 0;
+  while (index < iov.size()) {
+    msghdr msg = {};
+    msg.msg_iov = iov.data() + index;
+    msg.msg_iovlen = iov.size() - index;
+    ssize_t n = sendmsg(state.session->fd, &msg, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      state.failed = true;  // timeout odeslání nebo zavřené spojení
+      return false;
+    }
+    while (index < iov.size() && (size_t)n >= iov[index].iov_len) n -= iov[index++].iov_len;
+    if (index < iov.size()) {
+      iov[index].iov_base = (char*)iov[index].iov_base + n;
+      iov[index].iov_len -= n;
+    }
+  }
+  return true;
+}
+
+std::string responseHeader(const RequestState& state, const char* framing) {
+  std::string header = std::string("HTTP/1.1 ") + state.status + "\r\nContent-Type: " + state.type + "\r\n" + framing;
+  for (const auto& h : state.respHeaders) header += std::string(h.first) + ": " + h.second + "\r\n";
+  header += "\r\n";
+  return header;
+}
+
+void closeSession(Server& server, Session* session) {
+  for (size_t i = 0; i < server.sessions.size(); i++) {
+    if (server.sessions[i] == session) {
+      server.sessions.erase(server.sessions.begin() + i);
+      break;
+    }
+  }
+  ::close(session->fd);
+  delete session;
+}
+
+int methodOf(const std::string& name) {
+  if (name == "GET") return HTTP_GET;
+  if (name == "POST") return HTTP_POST;
+  if (name == "HEAD") return HTTP_HEAD;
+  if (name == "PUT") return HTTP_PUT;
+  if (name == "DELETE") return HTTP_DELETE;
+  return -1;
+}
+
+void sendError(httpd_req_t* req, Server& server, httpd_err_code_t error) {
+  if (server.errHandlers[error]) {
+    if (server.errHandlers[error](req, error) != ESP_OK) stateOf(req).close = true;
+    return;
+  }
+  httpd_resp_send_err(req, error, nullptr);
+}
+
+// Jeden požadavek z bufferu spojení; false = spojení zavřít
+bool handleRequest(Server& server, Session* session, size_t headerEnd) {
+  std::string head = session->in.substr(0, headerEnd);
+  session->in.erase(0, headerEnd + 4);
+
+  httpd_req_t req = {};
+  RequestState state;
+  state.session = session;
+  req.handle = &server;
+  req.aux = &state;
+
+  size_t lineEnd = head.find("\r\n");
+  std::string line = head.substr(0, lineEnd);
+  size_t sp1 = line.find(' ');
+  size_t sp2 = line.find(' ', sp1 + 1);
+  if (sp1 == std::string::npos || sp2 == std::string::npos || sp2 - sp1 - 1 > HTTPD_MAX_URI_LEN) {
+    httpd_resp_send_err(&req, HTTPD_400_BAD_REQUEST, nullptr);
+    return false;
+  }
+  req.method = methodOf(line.substr(0, sp1));
+  std::string target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+  memcpy(req.uri, target.c_str(), target.size() + 1);
+  size_t q = target.find('?');
+  std::string path = target.substr(0, q);
+  if (q != std::string::npos) state.query = target.substr(q + 1);
+
+  size_t pos = lineEnd == std::string::npos ? head.size() : lineEnd + 2;
+  while (pos < head.size()) {
+    size_t end = head.find("\r\n", pos);
+    if (end == std::string::npos) end = head.size();
+    std::string field = head.substr(pos, end - pos);
+    size_t colon = field.find(':');
+    if (colon != std::string::npos) {
+      size_t valueStart = field.find_first_not_of(" \t", colon + 1);
+      state.headers.emplace_back(field.substr(0, colon),
+                                 valueStart == std::string::npos ? "" : field.substr(valueStart));
+    }
+    pos = end + 2;
+  }
+  for (const auto& h : state.headers) {
+    if (strcasecmp(h.first.c_str(), "Content-Length") == 0) req.content_len = strtoul(h.second.c_str(), nullptr, 10);
+    if (strcasecmp(h.first.c_str(), "Connection") == 0 && strcasecmp(h.second.c_str(), "close") == 0) {
+      state.close = true;
+    }
+  }
+  state.bodyLeft = req.content_len;
+
+  const httpd_uri_t* match = nullptr;
+  bool pathKnown = false;
+  for (const httpd_uri_t& uri : server.handlers) {
+    if (path != uri.uri) continue;
+    pathKnown = true;
+    if (uri.method == req.method) {
+      match = &uri;
+      break;
+    }
+  }
+  if (match) {
+    req.user_ctx = match->user_ctx;
+    if (match->handler(&req) != ESP_OK) state.close = true;
+  } else {
+    sendError(&req, server, pathKnown ? HTTPD_405_METHOD_NOT_ALLOWED : HTTPD_404_NOT_FOUND);
+  }
+  if (state.failed || state.close) return false;
+
+  // Nepřečtený zbytek těla zahodit, ať další požadavek začne na hranici
+  char discard[512];
+  while (state.bodyLeft > 0) {
+    int n = httpd_req_recv(&req, discard, sizeof(discard));
+    if (n <= 0) return false;
+  }
+  return true;
+}
+
+void acceptSession(Server& server) {
+  int fd = accept(server.listenFd, nullptr, nullptr);
+  if (fd < 0) return;
+  if (server.sessions.size() >= server.config.max_open_sockets) {
+    if (!server.config.lru_purge_enable) {
+      ::close(fd);
+      return;
+    }
+    Session* oldest = server.sessions[0];
+    for (Session* s : server.sessions) {
+      if (s->lastUsed < oldest->lastUsed) oldest = s;
+    }
+    closeSession(server, oldest);
+  }
+  timeval recvTimeout = {server.config.recv_wait_timeout, 0};
+  timeval sendTimeout = {server.config.send_wait_timeout, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &recvTimeout, sizeof(recvTimeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &sendTimeout, sizeof(sendTimeout));
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  Session* session = new Session();
+  session->fd = fd;
+  session->lastUsed = ++server.useCounter;
+  server.sessions.push_back(session);
+}
+
+// Jako task httpd: čeká na sockety a požadavky obsluhuje jeden po druhém
+void serverTask(Server* server) {
+  std::vector<pollfd> fds;
+  std::vector<Session*> polled;
+  while (!server->stop) {
+    fds.assign(1, pollfd{server->listenFd, POLLIN, 0});
+    polled.assign(server->sessions.begin(), server->sessions.end());
+    for (Session* s : polled) fds.push_back(pollfd{s->fd, POLLIN, 0});
+    if (poll(fds.data(), fds.size(), 100) <= 0) continue;
+
+    for (size_t i = 0; i < polled.size(); i++) {
+      if (!fds[i + 1].revents) continue;
+      Session* session = polled[i];
+      char buf[2048];
+      ssize_t n = recv(session->fd, buf, sizeof(buf), 0);
+      if (n <= 0) {
+        closeSession(*server, session);
+        continue;
+      }
+      session->in.append(buf, n);
+      session->lastUsed = ++server->useCounter;
+      bool keep = true;
+      size_t headerEnd;
+      while (keep && (headerEnd = session->in.find("\r\n\r\n")) != std::string::npos) {
+        keep = handleRequest(*server, session, headerEnd);
+      }
+      if (keep && session->in.size() > MAX_HEADER_BYTES) keep = false;
+      if (!keep) closeSession(*server, session);
+    }
+    if (fds[0].revents & POLLIN) acceptSession(*server);
+  }
+}
+}  // namespace
+
+const char* esp_err_to_name(esp_err_t err) {
+  switch (err) {
+    case ESP_OK: return "ESP_OK";
+    case ESP_FAIL: return "ESP_FAIL";
+    case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_HTTPD_RESULT_TRUNC: return "ESP_ERR_HTTPD_RESULT_TRUNC";
+    default: return "ERROR";
+  }
+}
+
+esp_err_t httpd_start(httpd_handle_t* handle, const httpd_config_t* config) {
+  int fd = socket(AF_INET6, SOCK_STREAM, 0);
+  if (fd < 0) return ESP_FAIL;
+  int one = 1;
+  int zero = 0;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+  sockaddr_in6 address = {};
+  address.sin6_family = AF_INET6;
+  address.sin6_addr = in6addr_any;
+  address.sin6_port = htons(config->server_port);
+  if (bind(fd, (sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 8) != 0) {
+    ::close(fd);
+    return ESP_FAIL;
+  }
+  Server* server = new Server();
+  server->config = *config;
+  server->listenFd = fd;
+  server->thread = std::thread(serverTask, server);
+  *handle = server;
+  return ESP_OK;
+}
+
+esp_err_t httpd_stop(httpd_handle_t handle) {
+  Server* server = (Server*)handle;
+  server->stop = true;
+  server->thread.join();
+  while (!server->sessions.empty()) closeSession(*server, server->sessions.back());
+  ::close(server->listenFd);
+  delete server;
+  return ESP_OK;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t* uri) {
+  Server* server = (Server*)handle;
+  if (server->handlers.size() >= server->config.max_uri_handlers) return ESP_FAIL;
+  server->handlers.push_back(*uri);
+  return ESP_OK;
+}
+
+esp_err_t httpd_register_err_handler(httpd_handle_t handle, httpd_err_code_t error, httpd_err_handler_func_t handler) {
+  if (error >= HTTPD_ERR_CODE_MAX) return ESP_ERR_INVALID_ARG;
+  ((Server*)handle)->errHandlers[error] = handler;
+  return ESP_OK;
+}
+
+size_t httpd_req_get_url_query_len(httpd_req_t* req) { return stateOf(req).query.size(); }
+
+esp_err_t httpd_req_get_url_query_str(httpd_req_t* req, char* buf, size_t size) {
+  const std::string& query = stateOf(req).query;
+  if (query.empty()) return ESP_ERR_NOT_FOUND;
+  snprintf(buf, size, "%s", query.c_str());
+  return query.size() < size ? ESP_OK : ESP_ERR_HTTPD_RESULT_TRUNC;
+}
+
+esp_err_t httpd_query_key_value(const char* query, const char* key, char* value, size_t size) {
+  size_t keyLength = strlen(key);
+  const char* p = query;
+  while (p && *p) {
+    const char* end = strchr(p, '&');
+    if (!end) end = p + strlen(p);
+    if (strncmp(p, key, keyLength) == 0 && p[keyLength] == '=') {
+      const char* start = p + keyLength + 1;
+      size_t length = end - start;
+      if (size == 0) return ESP_ERR_HTTPD_RESULT_TRUNC;
+      size_t copied = length < size - 1 ? length : size - 1;
+      memcpy(value, start, copied);
+      value[copied] = '\0';
+      return copied == length ? ESP_OK : ESP_ERR_HTTPD_RESULT_TRUNC;
+    }
+    p = *end ? end + 1 : end;
+  }
+  return ESP_ERR_NOT_FOUND;
+}
+
+size_t httpd_req_get_hdr_value_len(httpd_req_t* req, const char* field) {
+  for (const auto& h : stateOf(req).headers) {
+    if (strcasecmp(h.first.c_str(), field) == 0) return h.second.size();
+  }
+  return 0;
+}
+
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t* req, const char* field, char* value, size_t size) {
+  for (const auto& h : stateOf(req).headers) {
+    if (strcasecmp(h.first.c_str(), field) != 0) continue;
+    snprintf(value, size, "%s", h.second.c_str());
+    return h.second.size() < size ? ESP_OK : ESP_ERR_HTTPD_RESULT_TRUNC;
+  }
+  return ESP_ERR_NOT_FOUND;
+}
+
+int httpd_req_recv(httpd_req_t* req, char* buf, size_t size) {
+  RequestState& state = stateOf(req);
+  if (state.bodyLeft == 0) return 0;
+  if (size > state.bodyLeft) size = state.bodyLeft;
+  std::string& in = state.session->in;
+  if (!in.empty()) {
+    size_t n = size < in.size() ? size : in.size();
+    memcpy(buf, in.data(), n);
+    in.erase(0, n);
+    state.bodyLeft -= n;
+    return (int)n;
+  }
+  ssize_t n = recv(state.session->fd, buf, size, 0);
+  if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return HTTPD_SOCK_ERR_TIMEOUT;
+  if (n <= 0) return HTTPD_SOCK_ERR_FAIL;
+  state.bodyLeft -= n;
+  return (int)n;
+}
+
+esp_err_t httpd_resp_set_status(httpd_req_t* req, const char* status) {
+  stateOf(req).status = status;
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_type(httpd_req_t* req, const char* type) {
+  stateOf(req).type = type;
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_set_hdr(httpd_req_t* req, const char* field, const char* value) {
+  stateOf(req).respHeaders.emplace_back(field, value);
+  return ESP_OK;
+}
+
+esp_err_t httpd_resp_send(httpd_req_t* req, const char* buf, ssize_t length) {
+  RequestState& state = stateOf(req);
+  if (length == HTTPD_RESP_USE_STRLEN) length = buf ? strlen(buf) : 0;
+  char framing[48];
+  snprintf(framing, sizeof(framing), "Content-Length: %zd\r\n", length);
+  std::string header = responseHeader(state, framing);
+  struct iovec parts[2] = {{(void*)header.data(), header.size()}, {(void*)buf, (size_t)length}};
+  return sendAll(state, parts, length ? 2 : 1) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t httpd_resp_send_chunk(httpd_req_t* req, const char* buf, ssize_t length) {
+  RequestState& state = stateOf(req);
+  if (length == HTTPD_RESP_USE_STRLEN) length = buf ? strlen(buf) : 0;
+  if (!buf) length = 0;
+  std::string header;
+  if (!state.chunkStarted) {
+    header = responseHeader(state, "Transfer-Encoding: chunked\r\n");
+    state.chunkStarted = true;
+  }
+  char size[16];
+  snprintf(size, sizeof(size), "%zx\r\n", length);
+  header += size;
+  struct iovec parts[3] = {{(void*)header.data(), header.size()}, {(void*)buf, (size_t)length}, {(void*)"\r\n", 2}};
+  return sendAll(state, parts, 3) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t httpd_resp_send_err(httpd_req_t* req, httpd_err_code_t error, const char* message) {
+  static const char* const STATUS[HTTPD_ERR_CODE_MAX] = {"500 Internal Server Error", "400 Bad Request",
+                                                         "404 Not Found", "405 Method Not Allowed",
+                                                         "408 Request Timeout"};
+  RequestState& state = stateOf(req);
+  state.status = STATUS[error];
+  state.type = "text/html";
+  if (error != HTTPD_404_NOT_FOUND && error != HTTPD_405_METHOD_NOT_ALLOWED) state.close = true;
+  return httpd_resp_send(req, message ? message : state.status, HTTPD_RESP_USE_STRLEN);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+// esp_http_server na hostiteli nad POSIX sockety, pro zátěžový běh
+// HttpServer (tools/http_host). Chová se jako ESP-IDF v tom, co HttpServer
+// využívá: jeden task serveru, který handlery volá postupně, keep-alive
+// spojení, omezený počet slotů s LRU uvolněním, timeouty příjmu a odeslání,
+// tělo čtené handlerem po kusech a chunked odpověď. Ne-IDF funkce nemá.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_NOT_FOUND 0x105
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_HTTPD_RESULT_TRUNC 0xb003
+
+const char* esp_err_to_name(esp_err_t err);
+
+typedef void* httpd_handle_t;
+
+enum httpd_method_t { HTTP_DELETE = 0, HTTP_GET = 1, HTTP_HEAD = 2, HTTP_POST = 3, HTTP_PUT = 4 };
+
+enum httpd_err_code_t {
+  HTTPD_500_INTERNAL_SERVER_ERROR = 0,
+  HTTPD_400_BAD_REQUEST,
+  HTTPD_404_NOT_FOUND,
+  HTTPD_405_METHOD_NOT_ALLOWED,
+  HTTPD_408_REQ_TIMEOUT,
+  HTTPD_ERR_CODE_MAX,
+};
+
+#define HTTPD_RESP_USE_STRLEN -1
+#define HTTPD_SOCK_ERR_FAIL -1
+#define HTTPD_SOCK_ERR_INVALID -2
+#define HTTPD_SOCK_ERR_TIMEOUT -3
+#define HTTPD_MAX_URI_LEN 512
+
+struct httpd_req_t {
+  httpd_handle_t handle;
+  int method;
+  char uri[HTTPD_MAX_URI_LEN + 1];
+  size_t content_len;
+  void* aux;  // stav spojení serveru
+  void* user_ctx;
+};
+
+struct httpd_uri_t {
+  const char* uri;
+  httpd_method_t method;
+  esp_err_t (*handler)(httpd_req_t* req);
+  void* user_ctx;
+};
+
+typedef esp_err_t (*httpd_err_handler_func_t)(httpd_req_t* req, httpd_err_code_t error);
+
+struct httpd_config_t {
+  uint16_t server_port;
+  size_t stack_size;
+  uint16_t max_open_sockets;
+  uint16_t max_uri_handlers;
+  bool lru_purge_enable;
+  uint16_t recv_wait_timeout;  // s
+  uint16_t send_wait_timeout;  // s
+};
+
+#define HTTPD_DEFAULT_CONFIG()                                                                               \
+  httpd_config_t {                                                                                          \
+    80, 4096, 7, 8, false, 5, 5                                                                              \
+  }
+
+esp_err_t httpd_start(httpd_handle_t* handle, const httpd_config_t* config);
+esp_err_t httpd_stop(httpd_handle_t handle);
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t* uri);
+esp_err_t httpd_register_err_handler(httpd_handle_t handle, httpd_err_code_t error, httpd_err_handler_func_t handler);
+
+size_t httpd_req_get_url_query_len(httpd_req_t* req);
+esp_err_t httpd_req_get_url_query_str(httpd_req_t* req, char* buf, size_t size);
+esp_err_t httpd_query_key_value(const char* query, const char* key, char* value, size_t size);
+size_t httpd_req_get_hdr_value_len(httpd_req_t* req, const char* field);
+esp_err_t httpd_req_get_hdr_value_str(httpd_req_t* req, const char* field, char* value, size_t size);
+int httpd_req_recv(httpd_req_t* req, char* buf, size_t size);
+
+esp_err_t httpd_resp_set_status(httpd_req_t* req, const char* status);
+esp_err_t httpd_resp_set_type(httpd_req_t* req, const char* type);
+esp_err_t httpd_resp_set_hdr(httpd_req_t* req, const char* field, const char* value);
+esp_err_t httpd_resp_send(httpd_req_t* req, const char* buf, ssize_t length);
+esp_err_t httpd_resp_send_chunk(httpd_req_t* req, const char* buf, ssize_t length);
+esp_err_t httpd_resp_send_err(httpd_req_t* req, httpd_err_code_t error, const char* message);
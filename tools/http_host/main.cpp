@@ -0,0 +1,287 @@
+// Web server panelu na hostiteli pro scripts/http_load.py: skutečný
+// HttpServer (src/HttpServer.cpp) nad esp_http_server z POSIX socketů,
+// ResponseCache, SampleText a SamplePayload jako ve firmware, stejný zámek
+// stavu mezi tasky serveru a loop(). loop() čte FakeSensor přes
+// SensorRegistry a ruční odeslání na TMEP (POST /api/tmep/send) simuluje
+// čekáním --tmep-ms bez zámku jako sendTmepRequest(); s --tmep-holds-lock
+// drží zámek po celou dobu jako firmware před oddělením TMEP od zámku.
+//
+// Měří se tím plánování (zámek, jeden task serveru, keep-alive, cache a 304),
+// ne ESP32: JSON /api/data a /api/config skládá JsonWriter místo ArduinoJson
+// a čas handlerů je čas PC.
+//
+//   pio run -e http_host
+//   .pio/build/http_host/program --port 8080 &
+//   python scripts/http_load.py --host 127.0.0.1 --port 8080 --clients 4 --seconds 30 --tmep-every 5
+
+#include <FakeSensor.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <thread>
+
+#include "HttpServer.h"
+#include "ResponseCache.h"
+#include "SamplePayload.h"
+#include "SampleText.h"
+#include "SensorRegistry.h"
+#include "WebUiAssets.h"  // generováno z web/ při buildu
+
+namespace {
+constexpr uint32_t LOOP_IDLE_MS = 10;  // powerManager.idle() mezi průchody loop()
+
+uint16_t port = 8080;
+uint32_t tmepMs = 5000;  // HTTPClient timeout = nejhorší případ
+bool tmepHoldsLock = false;
+
+SemaphoreHandle_t appStateLock;
+HttpServer* webServer;
+SensorRegistry sensors;
+FakeSensor sen66("SEN66", {CH_TEMPERATURE, CH_HUMIDITY, CH_PM1, CH_PM25, CH_PM4, CH_PM10, CH_VOC, CH_NOX, CH_CO2});
+SampleText sampleText;
+ResponseCache dataCache;
+ResponseCache configCache;
+uint32_t statusGeneration = 0;
+bool tmepSendRequested = false;
+uint32_t tmepUploads = 0;
+const char* lastTmepStatus = "TMEP:---";
+volatile sig_atomic_t interrupted = 0;
+
+uint32_t sampleAgeMs(const SensorSample& sample) { return sample.timestamp ? millis() - sample.timestamp : 0; }
+
+// --- handlery jako v main.cpp ---
+
+void handleWebAsset(const WebAsset& asset) {
+  webServer->sendHeader("ETag", asset.etag);
+  webServer->sendHeader("Cache-Control", asset.immutable ? "public, max-age=31536000, immutable" : "no-cache");
+  if (webServer->header("If-None-Match") == asset.etag) {
+    webServer->send(304);
+    return;
+  }
+  webServer->sendHeader("Content-Encoding", "gzip");
+  webServer->send_P(200, asset.contentType, (const char*)asset.data, asset.length);
+}
+
+void sendCachedResponse(ResponseCache& cache) {
+  webServer->sendHeader("ETag", cache.etag());
+  webServer->sendHeader("Cache-Control", "no-cache");
+  if (cache.matches(webServer->header("If-None-Match"))) {
+    cache.countNotModified();
+    webServer->send(304);
+    return;
+  }
+  webServer->send(200, "application/json", cache.body());
+}
+
+void sendJsonViaCache(ResponseCache& cache, uint64_t version, const char* body, size_t length, uint32_t startUs) {
+  if (!length) {
+    webServer->send(500, "text/plain", "JSON buffer full");
+    return;
+  }
+  if (cache.store(version, body, length, micros() - startUs)) {
+    sendCachedResponse(cache);
+    return;
+  }
+  webServer->send(200, "application/json", body);
+}
+
+void handleApiData() {
+  SensorSample sample = sensors.snapshot();
+  uint64_t version = ((uint64_t)sample.sequence << 32) | statusGeneration;
+  if (dataCache.isFresh(version)) {
+    dataCache.countHit();
+    sendCachedResponse(dataCache);
+    return;
+  }
+
+  uint32_t startUs = micros();
+  char values[512];
+  JsonWriter channels(values, sizeof(values));
+  for (uint8_t i = 0; i < sensors.channelCount(); i++) channels.raw(sensors.channel(i).key, sampleText.json(i));
+  channels.finish();
+
+  TmepUrl tmepUrl;
+  buildTmepUrl("xyz", "tempV=*TEMP*&humV=*HUM*&pm25=*PM2*&co2=*CO2*", sensors, sample, sampleText, tmepUrl);
+  char body[ResponseCache::MAX_BODY];
+  JsonWriter json(body, sizeof(body));
+  json.string("wifi", "connected");
+  json.string("mqtt", "connected");
+  json.boolean("valid", sample.anyValid());
+  json.integer("uptime", millis() / 1000);
+  json.integer("seq", sample.sequence);
+  json.integer("sampleAgeMs", sampleAgeMs(sample));
+  json.string("tmepUrl", tmepUrl.c_str());
+  json.string("tmepStatus", lastTmepStatus);
+  json.string("wifiMode", "STA");
+  json.string("apSsid", "");
+  json.string("apIp", "");
+  json.string("currentSsid", "domaci-sit");
+  json.string("currentIp", "192.168.1.50");
+  json.integer("rssi", 0);
+  json.integer("wifiConnectMs", 850);
+  json.boolean("wifiFastConnect", true);
+  json.raw("values", values);
+  sendJsonViaCache(dataCache, version, body, json.finish(), startUs);
+}
+
+void handleApiConfigGet() {
+  if (configCache.isFresh(statusGeneration)) {
+    configCache.countHit();
+    sendCachedResponse(configCache);
+    return;
+  }
+
+  uint32_t startUs = micros();
+  char body[ResponseCache::MAX_BODY];
+  JsonWriter json(body, sizeof(body));
+  json.string("wifiSsid", "domaci-sit");
+  json.string("wifiPassword", "********");
+  json.integer("wifiStaticIp", 0);
+  json.string("mqttServer", "192.168.1.10");
+  json.integer("mqttPort", 1883);
+  json.string("mqttUser", "panel");
+  json.string("mqttBaseTopic", "sharp");
+  json.string("mqttDeviceId", "");
+  json.integer("mqttQos", 1);
+  json.string("tmepDomain", "xyz");
+  json.string("tmepParams", "tempV=*TEMP*&humV=*HUM*&pm25=*PM2*&co2=*CO2*");
+  json.integer("displayRotation", 0);
+  json.integer("displayRefreshInterval", 2000);
+  json.integer("mqttPublishInterval", 10000);
+  json.integer("tmepRequestInterval", 300000);
+  json.integer("historyInterval", 60000);
+  json.fixed("temperatureOffset", 0.0f, 1);
+  json.string("alarmRules", "co2>1200;pm25>35");
+  json.integer("powerSaveMode", 0);
+  json.integer("sen66DutyPeriod", 0);
+  sendJsonViaCache(configCache, statusGeneration, body, json.finish(), startUs);
+}
+
+void handleApiMetrics() {
+  HttpServerStats http = webServer->getStats();
+  char server[256];
+  JsonWriter srv(server, sizeof(server));
+  srv.integer("requests", http.requests);
+  srv.integer("rejected", http.rejected);
+  srv.integer("notFound", http.notFound);
+  srv.integer("handlerAvgUs", http.handlerAvgUs);
+  srv.integer("handlerMaxUs", http.handlerMaxUs);
+  srv.integer("lockWaitMaxUs", http.lockWaitMaxUs);
+  srv.finish();
+
+  ResponseCacheStats cache = dataCache.getStats();
+  char data[160];
+  JsonWriter dc(data, sizeof(data));
+  dc.integer("hits", cache.hits);
+  dc.integer("misses", cache.misses);
+  dc.integer("notModified", cache.notModified);
+  dc.integer("buildAvgUs", cache.buildAvgUs);
+  dc.finish();
+
+  char httpObject[512];
+  JsonWriter h(httpObject, sizeof(httpObject));
+  h.raw("server", server);
+  h.raw("dataCache", data);
+  h.finish();
+
+  char body[768];
+  JsonWriter json(body, sizeof(body));
+  json.integer("uptime", millis() / 1000);
+  json.raw("http", httpObject);
+  json.integer("tmepUploads", tmepUploads);
+  json.finish();
+  webServer->send(200, "application/json", body);
+}
+
+void handleApiTmepSend() {
+  tmepSendRequested = true;
+  webServer->send(202, "text/plain", "TMEP request zarazen, vysledek ukaze stav TMEP");
+}
+
+// Volá jen loop() se zamčeným appStateLock; HTTP požadavek nahrazuje čekání
+void sendTmepRequest() {
+  if (!tmepHoldsLock) xSemaphoreGive(appStateLock);
+  delay(tmepMs);
+  if (!tmepHoldsLock) xSemaphoreTake(appStateLock, portMAX_DELAY);
+  tmepUploads++;
+  lastTmepStatus = "TMEP:OK";
+  statusGeneration++;
+}
+
+void loopPass() {
+  xSemaphoreTake(appStateLock, portMAX_DELAY);
+  unsigned long now = millis();
+  // Pomalu se měnící hodnoty, ať se text vzorku mění
+  float t = now / 60000.0f;
+  const float values[] = {22.0f + sinf(t), 45.0f + 5 * sinf(t / 3), 4.0f, 8.0f + 3 * sinf(t * 2), 9.0f, 10.0f,
+                          100.0f, 1.0f, 800.0f + 200 * sinf(t / 2)};
+  for (size_t i = 0; i < sen66.values.size(); i++) sen66.values[i] = values[i];
+  if (sensors.process(now)) sampleText.update(sensors, sensors.snapshot());
+
+  if (tmepSendRequested) {
+    tmepSendRequested = false;
+    sendTmepRequest();
+  }
+  xSemaphoreGive(appStateLock);
+  delay(LOOP_IDLE_MS);
+}
+
+bool parseOptions(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--tmep-holds-lock") {
+      tmepHoldsLock = true;
+    } else if (arg == "--port" && i + 1 < argc) {
+      port = (uint16_t)atoi(argv[++i]);
+    } else if (arg == "--tmep-ms" && i + 1 < argc) {
+      tmepMs = (uint32_t)atoi(argv[++i]);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (!parseOptions(argc, argv)) {
+    fprintf(stderr, "pouziti: %s [--port 8080] [--tmep-ms 5000] [--tmep-holds-lock]\n", argv[0]);
+    return 2;
+  }
+  signal(SIGINT, [](int) { interrupted = 1; });
+  signal(SIGTERM, [](int) { interrupted = 1; });
+  host::useRealClock();
+
+  appStateLock = xSemaphoreCreateMutex();
+  sensors.add(&sen66, I2cBus());
+  sensors.begin();
+
+  webServer = new HttpServer(port);
+  webServer->setStateLock(appStateLock);
+  for (size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+    const WebAsset& asset = WEB_ASSETS[i];
+    webServer->on(asset.path, HTTP_GET, [&asset]() { handleWebAsset(asset); });
+  }
+  webServer->on("/api/data", HTTP_GET, handleApiData);
+  webServer->on("/api/config", HTTP_GET, handleApiConfigGet);
+  webServer->on("/api/metrics", HTTP_GET, handleApiMetrics);
+  webServer->on("/api/tmep/send", HTTP_POST, handleApiTmepSend);
+  // Server startuje se zamčeným stavem jako v setup()
+  xSemaphoreTake(appStateLock, portMAX_DELAY);
+  bool started = webServer->begin();
+  xSemaphoreGive(appStateLock);
+  if (!started) {
+    fprintf(stderr, "port %u je obsazeny\n", port);
+    return 1;
+  }
+  printf("http://127.0.0.1:%u/, TMEP %lu ms %s\n", port, (unsigned long)tmepMs,
+         tmepHoldsLock ? "se zamkem (puvodni chovani)" : "bez zamku");
+  fflush(stdout);
+
+  while (!interrupted) loopPass();
+  return 0;
+}